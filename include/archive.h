@@ -0,0 +1,55 @@
+/**
+ * CleanRip - archive.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stdio.h>
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+
+#if defined(__CYGWIN__) || defined(__linux__)
+#include <unistd.h>
+
+// An image in one of the formats CleanRip writes, as its reader hands it
+// out a block at a time; imgsrc caches the blocks and reads ahead of them
+typedef struct archive archive;
+
+struct archive {
+	void *ctx;
+	u64 size;			// of the image
+	int size_known;		// 0 if the format doesn't keep it, size is where the last block ends
+	u32 block_size;
+	u32 blocks;
+	u32 scratch_size;	// a block's data as it is in the file is read into this much
+	int (*block)(archive *a, u32 block, u8 *dst, u8 *scratch);	// 0 on success, from any thread
+	void (*close)(archive *a);
+};
+
+// Reads the whole of len or fails, from any thread
+static inline int archive_pread(FILE *fp, void *dst, u32 len, u64 offset) {
+	return pread(fileno(fp), dst, len, (off_t)offset) != (ssize_t)len;
+}
+#endif
+
+#endif
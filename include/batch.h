@@ -0,0 +1,141 @@
+/**
+ * CleanRip - batch.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#ifdef __CYGWIN__
+
+#include <stdio.h>
+#include <pthread.h>
+#include "host_ogc.h"
+#include "engine.h"
+
+#define BATCH_MAX_JOBS		8
+#define BATCH_MAX_HASHERS	8
+#define BATCH_BLOCK_SIZE	(1024*1024)
+#define BATCH_BLOCKS		8			// per job, each one is being hashed and/or written
+#define BATCH_WRITE_SLICE	(256*1024)	// writes from different jobs interleave at this size
+
+// same values as IS_NGC_DISC / IS_WII_DISC
+enum {
+	BATCH_NGC = 0,
+	BATCH_WII
+};
+
+enum {
+	BATCH_WAITING = 0,	// drive is empty
+	BATCH_READING,
+	BATCH_FINISHING,	// reading done, hashing/writing draining
+	BATCH_DONE,			// waiting for the disc to be taken out
+	BATCH_FAILED,
+	BATCH_STOPPED
+};
+
+typedef struct {
+	int (*present)(int drive);			// 1 when a disc is in and ready
+	int (*read)(int drive, void *dst, u32 len, u64 offset);
+	void (*eject)(int drive);
+	// dat lookup, fills in the redump name when the MD5 is known
+	int (*verify)(const char *md5, int disc_type, char *name, int name_size);
+	// the BCA and the dumpinfo next to the image, as an interactive dump writes them
+	void (*bca)(int drive, const char *out_path, const char *name);
+	void (*info)(const char *out_path, const char *name, const u8 *header, const char *md5, const char *sha1,
+				 u32 crc32, int verified, u32 seconds);
+} batch_drive_ops;
+
+struct _batch;
+struct _batch_job;
+
+typedef struct _batch_block {
+	struct _batch_block *next;
+	struct _batch_job *job;
+	u8 *data;
+	u32 lba;
+	u32 length;
+	vu32 refs;					// hashing + writing
+} batch_block;
+
+typedef struct _batch_job {
+	struct _batch *owner;
+	int drive;
+	char drive_name[8];
+	vu32 state;
+	char name[64];				// output name from the disc ID
+	char message[128];
+	int disc_type;
+	u64 total;
+	volatile u64 done;
+	u32 discs;
+	u128 start_time;
+	u8 header[0x400];			// the disc header, for the dumpinfo
+	// reads and checksums go through the engine, which only one pool thread
+	// at a time hashes with, in order
+	dump_engine engine;
+	tuner tune;
+	batch_block *hash_head, *hash_tail;
+	u32 hash_pending;
+	int hash_queued;
+	struct _batch_job *run_next;
+	// writing
+	FILE *fp;
+	vu32 write_failed;
+	mqbox_t freeq;
+	mqbox_t writeq;
+	lwp_t writer;
+	batch_block blocks[BATCH_BLOCKS];
+	u8 *memory;
+	lwp_t thread;
+} batch_job;
+
+typedef struct _batch {
+	const batch_drive_ops *ops;
+	char out_path[512];
+	int auto_eject;
+	vu32 stop;
+	int job_count;
+	batch_job jobs[BATCH_MAX_JOBS];
+	// shared hashing pool
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	pthread_cond_t idle;
+	batch_job *run_head, *run_tail;
+	int hash_stop;
+	int hasher_count;
+	lwp_t hashers[BATCH_MAX_HASHERS];
+	// global write arbiter, jobs take turns a slice at a time
+	pthread_mutex_t write_lock;
+	pthread_cond_t write_turn;
+	u32 next_ticket, serving;
+	u64 write_limit;			// bytes per second, 0 for no limit
+	u64 window_bytes;			// written since window_start
+	u128 window_start;
+} batch;
+
+int batch_start(batch *b, const batch_drive_ops *ops, const char *out_path, const char *drive_names,
+				int drives, int hashers, u64 write_limit, int auto_eject);
+void batch_stop(batch *b);
+void batch_end(batch *b);
+int batch_busy(batch *b);
+const char *batch_state_str(int state);
+
+#endif
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * CleanRip - bytes.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef BYTES_H
+#define BYTES_H
+
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+
+// The fields of the formats' headers and tables, in whichever order the format keeps them
+
+static inline u16 get_le16(const u8 *p) {
+	return p[0] | (p[1] << 8);
+}
+static inline u32 get_le32(const u8 *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24);
+}
+static inline u64 get_le64(const u8 *p) {
+	return get_le32(p) | ((u64)get_le32(p + 4) << 32);
+}
+static inline void put_le16(u8 *p, u16 value) {
+	p[0] = value & 0xFF;
+	p[1] = value >> 8;
+}
+static inline void put_le32(u8 *p, u32 value) {
+	p[0] = value & 0xFF;
+	p[1] = (value >> 8) & 0xFF;
+	p[2] = (value >> 16) & 0xFF;
+	p[3] = value >> 24;
+}
+static inline void put_le64(u8 *p, u64 value) {
+	put_le32(p, (u32)value);
+	put_le32(p + 4, (u32)(value >> 32));
+}
+
+static inline u16 get_be16(const u8 *p) {
+	return (p[0] << 8) | p[1];
+}
+static inline u32 get_be24(const u8 *p) {
+	return ((u32)p[0] << 16) | ((u32)p[1] << 8) | p[2];
+}
+static inline u32 get_be32(const u8 *p) {
+	return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | p[3];
+}
+static inline u64 get_be64(const u8 *p) {
+	return ((u64)get_be32(p) << 32) | get_be32(p + 4);
+}
+static inline void put_be16(u8 *p, u16 value) {
+	p[0] = value >> 8;
+	p[1] = value & 0xFF;
+}
+static inline void put_be24(u8 *p, u32 value) {
+	p[0] = (value >> 16) & 0xFF;
+	p[1] = (value >> 8) & 0xFF;
+	p[2] = value & 0xFF;
+}
+static inline void put_be32(u8 *p, u32 value) {
+	p[0] = value >> 24;
+	p[1] = (value >> 16) & 0xFF;
+	p[2] = (value >> 8) & 0xFF;
+	p[3] = value & 0xFF;
+}
+static inline void put_be64(u8 *p, u64 value) {
+	put_be32(p, (u32)(value >> 32));
+	put_be32(p + 4, (u32)value);
+}
+
+#endif
@@ -0,0 +1,47 @@
+/**
+ * CleanRip - chd.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef CHD_H
+#define CHD_H
+
+#include "sink.h"
+
+// MAME's compressed image, version 5: a header, the hunks, metadata and
+// a compressed map of the hunks, all big endian. A CD is stored as frames
+// of a raw sector and its subcode, audio big endian, each track padded out.
+#define CHD_HEADER_SIZE		124
+#define CHD_VERSION			5
+#define CHD_CD_SECTOR_SIZE	2352
+#define CHD_CD_FRAME_SIZE	2448			// a sector and 96 bytes of subcode
+#define CHD_CD_HUNK_FRAMES	8
+#define CHD_CD_TRACK_PAD	4				// a track takes a multiple of this many frames
+#define CHD_DVD_SECTOR_SIZE	2048
+#define CHD_DVD_HUNK_SIZE	(16 * CHD_DVD_SECTOR_SIZE)
+#define CHD_MAX_TRACKS		99
+
+typedef struct {
+	u32 start;			// first sector of the track in the image
+	int data;			// a mode 1 track read raw, otherwise audio
+} chd_track;
+
+int sink_chd_cd(sink *s, sink *next, const chd_track *tracks, int count, u64 data_size);
+int sink_chd_dvd(sink *s, sink *next, u64 data_size);
+
+#endif
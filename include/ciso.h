@@ -0,0 +1,38 @@
+/**
+ * CleanRip - ciso.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef CISO_H
+#define CISO_H
+
+#include "sink.h"
+#include "archive.h"
+
+// "CISO", the block size (LE) and a byte per block, 1 if it's in the file
+#define CISO_HEADER_SIZE	0x8000
+#define CISO_MAP_SIZE		(CISO_HEADER_SIZE - 8)
+#define CISO_BLOCK_SIZE		(2*1024*1024)
+
+int sink_ciso(sink *s, sink *next, u32 block_size);
+
+#if defined(__CYGWIN__) || defined(__linux__)
+int ciso_archive(archive *a, const char *path);
+#endif
+
+#endif
@@ -0,0 +1,52 @@
+/**
+ * CleanRip - delta.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef DELTA_H
+#define DELTA_H
+
+#include "sink.h"
+#include "archive.h"
+
+// An image as the differences from a reference image, all little endian:
+// a header with the sizes, the image's MD5 and SHA-1 and the reference's
+// name, then ops until an end op. A copy op is a u64 offset in the reference
+// and a u32 length, a data op a u32 length and that many bytes of the image.
+#define DELTA_HEADER_SIZE	0x200
+#define DELTA_MAGIC			"CRDL"
+#define DELTA_VERSION		1
+#define DELTA_NAME_OFFSET	0x60
+#define DELTA_NAME_MAX		256
+#define DELTA_BLOCK_SIZE	0x4000			// the reference is hashed in blocks of this
+#define DELTA_READ_BLOCK	0x40000			// what a delta is read back in
+
+enum {
+	DELTA_OP_END = 0,
+	DELTA_OP_COPY,
+	DELTA_OP_DATA
+};
+
+int sink_delta(sink *s, sink *next, const char *reference);
+
+#if defined(__CYGWIN__) || defined(__linux__)
+int delta_archive(archive *a, const char *path);
+int delta_digest(const char *path, char *md5, char *sha1);
+#endif
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * CleanRip - engine.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+#include <stdio.h>
+#include "md5.h"
+#include "sha1.h"
+#include "tuner.h"
+
+#define DATEL_CHECK_OFFSET	0x100000	// the CRC this far in identifies a Datel disc
+
+enum engineProfiles
+{
+	PROFILE_GAMECUBE=0,
+	PROFILE_WII,
+	PROFILE_DATEL,
+	PROFILE_DVD_VIDEO,
+	PROFILE_AUDIO_CD,
+	PROFILE_COUNT
+};
+
+// Reads len bytes at offset from the source, 0 on success. isKnownDatel is
+// only looked at by the Datel read.
+typedef int (*engine_read_fn)(void *dst, u32 len, u64 offset, int isKnownDatel);
+
+// What the platform plugs in, picked once for the disc being dumped
+typedef struct {
+	engine_read_fn read;
+	u32 (*error)(void);					// last drive error, for the log
+	// after the first MB of a Datel disc: looks the CRC up, tells the user, 1 if known
+	int (*datel_check)(u32 crc100000);
+} engine_ops;
+
+typedef struct _dump_engine dump_engine;
+
+struct _dump_engine {
+	const engine_ops *ops;
+	int profile;
+	u32 sector_size;
+	int checksums;
+	int attempts;				// reads of an audio block before it is zero-filled
+	FILE *badfp;				// zero-filled ranges, audio only
+	int known_datel;
+	// checksums of everything passed to engine_account
+	u32 crc32;
+	u32 crc100000;
+	md5_state_t md5;
+	SHA1Context sha;
+	// counters
+	u32 retries;
+	u32 sectors;
+	u32 sectors_failed;		// zero-filled, audio only
+	u64 paused;				// time spent waiting on the user, leave it out of the duration
+	// strategies, picked by engine_init so the block loop never tests the profile
+	int (*read)(dump_engine *e, u8 *dst, u32 len, u64 offset);
+	int (*recover)(dump_engine *e, u8 *dst, u32 lba, u32 sectors, int ret);
+	void (*hash)(dump_engine *e, const u8 *data, u32 len);
+	void (*check)(dump_engine *e, u32 lba, u32 len);
+};
+
+void engine_init(dump_engine *e, const engine_ops *ops, int profile, u32 sector_size, int checksums);
+void engine_set_audio(dump_engine *e, int attempts, int sector_recovery, FILE *badfp);
+int engine_read(dump_engine *e, tuner *t, u8 *dst, u32 lba, u32 sectors);
+void engine_account(dump_engine *e, const u8 *data, u32 lba, u32 sectors);
+int engine_all_failed(dump_engine *e);
+void engine_finish(dump_engine *e, char *md5, char *sha1);
+const char *engine_profile_name(int profile);
+
+#endif
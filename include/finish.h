@@ -0,0 +1,67 @@
+/**
+ * CleanRip - finish.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef FINISH_H
+#define FINISH_H
+
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+
+#define FINISH_MAX		4		// dumps waiting to be finished before queueing blocks
+#define FINISH_EXT		".finish"
+
+// Everything needed to finish a dump after its disc is gone
+typedef struct {
+	char journal[512 + 64 + sizeof(FINISH_EXT)];	// mount, game and FINISH_EXT, removed once the task has run
+	char mount[512];
+	char game[64];
+	char internal[512];
+	char ext[8];
+	char md5[36];
+	char sha1[48];
+	int disc_type;
+	int parts;				// number of .partN files, 0 for a single image
+	int checksums;
+	int audio;				// needs a CUE sheet
+	int readonly;			// nothing was written, only verify
+	u32 crc32;
+	u32 crc100000;
+	u32 version;
+	u32 seconds;
+	u64 dumped_at;			// time_t of the end of the dump
+	char result[128];		// filled in by the task
+	vu32 queued;
+} finish_task;
+
+typedef void (*finish_fn)(finish_task *task);
+
+void finish_init(finish_fn run);
+finish_task *finish_new();
+void finish_queue(finish_task *task);
+void finish_wait();
+int finish_pending();
+int finish_pending_game(const char *game);
+int finish_resume(const char *mount);
+const char *finish_last_result();
+
+#endif
@@ -0,0 +1,40 @@
+/**
+ * CleanRip - flac.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef FLAC_H
+#define FLAC_H
+
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+
+// FLAC frames of 16-bit stereo at 44.1kHz, with no stream header in front
+#define FLAC_MAX_BLOCK			4608
+#define FLAC_MAX_PARTITION_ORDER	4
+
+typedef struct {
+	s32 chan[4][FLAC_MAX_BLOCK];	// left, right, mid and side of the block
+} flac_enc;
+
+u32 flac_encode(flac_enc *e, const u8 *pcm, u32 samples, u32 block_size, u8 *out, u32 cap);
+
+#endif
@@ -0,0 +1,40 @@
+/**
+ * CleanRip - gcz.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef GCZ_H
+#define GCZ_H
+
+#include "sink.h"
+#include "archive.h"
+
+// Dolphin's compressed image: a header, a u64 offset and a u32 Adler-32
+// per block, then the blocks, all little endian
+#define GCZ_MAGIC			0xB10BC001
+#define GCZ_HEADER_SIZE		32
+#define GCZ_BLOCK_SIZE		0x8000
+#define GCZ_STORED			0x8000000000000000ULL	// offset flag, the block didn't compress
+
+int sink_gcz(sink *s, sink *next, u64 data_size);
+
+#if defined(__CYGWIN__) || defined(__linux__)
+int gcz_archive(archive *a, const char *path);
+#endif
+
+#endif
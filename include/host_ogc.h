@@ -0,0 +1,70 @@
+/**
+ * CleanRip - host_ogc.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * libogc types and thread primitives as emulated by the host build
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef HOST_OGC_H
+#define HOST_OGC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef __uint128_t u128;
+typedef __int128_t s128;
+typedef float f32;
+typedef volatile u32 vu32;
+
+typedef void* mqbox_t;
+typedef pthread_t lwp_t;
+typedef void* mqmsg_t;
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#define MQ_MSG_BLOCK 0
+
+void LWP_SetThreadPriority(lwp_t thread, u32 prio);
+void LWP_CreateThread(lwp_t* thread, void* (*func)(void*), void* arg, void* stack, u32 stack_size, u32 prio);
+void LWP_JoinThread(lwp_t thread, void** value_ptr);
+void LWP_YieldThread();
+void MQ_Init(mqbox_t* mq, u32 count);
+bool MQ_Receive(mqbox_t mq, mqmsg_t* msg, u32 flags);
+bool MQ_Send(mqbox_t mq, mqmsg_t msg, u32 flags);
+void MQ_Jam(mqbox_t mq, mqmsg_t msg, u32 flags);
+void MQ_Close(mqbox_t mq);
+
+u128 gettime();
+u32 diff_msec(u128 start, u128 end);
+u32 diff_sec(u128 start, u128 end);
+
+#endif
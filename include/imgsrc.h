@@ -0,0 +1,74 @@
+/**
+ * CleanRip - imgsrc.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef IMGSRC_H
+#define IMGSRC_H
+
+#include <stdio.h>
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+#include "archive.h"
+#include "sink.h"
+
+#define IMGSRC_MAX_PARTS 64
+#define IMGSRC_PATH_MAX 1024
+#define IMGSRC_READ_AHEAD (4*1024*1024)		// bytes decoded ahead of a sequential read
+#define IMGSRC_AHEAD_THREADS 4
+#define IMGSRC_HASH_BLOCK (1024*1024)		// what an uncompressed image is hashed in
+#define IMGSRC_MAX_WORKERS 16
+
+typedef struct imgsrc_cache imgsrc_cache;
+
+typedef struct {
+	char path[IMGSRC_PATH_MAX];		// as given, .part0 for a split image
+	FILE *fp[IMGSRC_MAX_PARTS];
+	u64 start[IMGSRC_MAX_PARTS];	// where each part begins in the whole image
+	int parts;
+	u64 size;						// bytes in all parts together
+	u32 file_sector;				// 2048 (cooked ISO) or 2352 (raw BIN)
+	u32 data_offset;				// user data in a raw data sector, 0 for audio or cooked
+#if defined(__CYGWIN__) || defined(__linux__)
+	archive arc;					// CISO, GCZ, RVZ, WBFS, seekable zstd or a store recipe, arc.block is NULL otherwise
+	imgsrc_cache *cache;			// its decoded blocks
+#endif
+} imgsrc;
+
+int imgsrc_open(imgsrc *img, const char *path);
+void imgsrc_close(imgsrc *img);
+int imgsrc_read(imgsrc *img, void *dst, u32 len, u64 offset, u32 sector_size);
+u32 imgsrc_sectors(imgsrc *img, u32 sector_size);
+int imgsrc_read_lba(imgsrc *img, u32 lba, u32 count, void *buf);
+int imgsrc_read_bca(imgsrc *img, void *buf, int size);
+
+#if defined(__CYGWIN__) || defined(__linux__)
+typedef struct {
+	u32 crc32;
+	char md5[33];
+	char sha1[41];
+} imgsrc_digest;
+
+int imgsrc_hash(imgsrc *img, imgsrc_digest *d);
+int imgsrc_copy(imgsrc *img, sink *out, imgsrc_digest *d);
+#endif
+
+#endif
@@ -0,0 +1,47 @@
+/**
+ * CleanRip - lfg.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef LFG_H
+#define LFG_H
+
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+
+// The lagged Fibonacci generator Nintendo's mastering filled unused disc space with
+#define LFG_K			521
+#define LFG_J			32
+#define LFG_SEED_SIZE	17
+#define LFG_BYTES		(LFG_K * 4)		// output between two steps
+
+typedef struct {
+	u32 buf[LFG_K];		// the words as they come out, big endian
+	u32 pos;			// bytes of buf already out
+} lfg;
+
+void lfg_set_seed(lfg *g, const u32 seed[LFG_SEED_SIZE]);
+void lfg_forward(lfg *g, u32 bytes);
+void lfg_get_bytes(lfg *g, u8 *out, u32 len);
+int lfg_get_seed(const u8 *data, u32 len, u32 offset, u32 seed[LFG_SEED_SIZE]);
+int lfg_maybe_junk(u32 word);
+
+#endif
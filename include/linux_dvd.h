@@ -0,0 +1,42 @@
+/**
+ * CleanRip - linux_dvd.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef LINUX_DVD_H
+#define LINUX_DVD_H
+
+#ifdef __linux__
+#include "host_ogc.h"
+
+#define LINUX_DVD_WORKERS	4			// commands kept in flight
+#define LINUX_DVD_PIECE		(64*1024)	// bytes per command, safe for any HBA
+
+typedef struct {
+	u8 first_track;
+	u8 last_track;
+	u32 leadout;		// first sector after the last track, pregap not counted
+	u32 start[100];		// start sector of each track
+	u8 control[100];	// 4 = data track
+} linux_dvd_toc;
+
+void linux_dvd_set_device(const char *path);
+int linux_dvd_read_toc(linux_dvd_toc *toc);
+#endif
+
+#endif
@@ -46,7 +46,7 @@
 #define HW_ARMIRQMASK 	(HW_REG_BASE + 0x03c)
 #define HW_ARMIRQFLAG 	(HW_REG_BASE + 0x038)
 
-#define MAX_WII_OPTIONS 3
+#define MAX_WII_OPTIONS 5
 #define MAX_NGC_OPTIONS 3
 
 // Version info
@@ -85,7 +85,11 @@ enum options
 	WII_DUAL_LAYER,
 	WII_CHUNK_SIZE,
 	WII_NEWFILE,
-	AUDIO_OUTPUT
+	WII_SPILL_SIZE,
+	AUDIO_OUTPUT,
+	NGC_OUTPUT,
+	WII_OUTPUT,
+	DVD_OUTPUT
 };
 
 enum dualOptions
@@ -113,14 +117,51 @@ enum newFileOptions
   NEWFILE_DELIM
 };
 
+enum spillOptions
+{
+  SPILL_MAX=0,
+  SPILL_16MB,
+  SPILL_32MB,
+  SPILL_OFF,
+  SPILL_DELIM
+};
+
 enum audioOutputOptions
 {
   AUDIO_OUT_BIN=0,
   AUDIO_OUT_WAV,
   AUDIO_OUT_WAV_FAST,
   AUDIO_OUT_WAV_BEST,
+  AUDIO_OUT_CHD,
   AUDIO_OUT_DELIM
 };
+
+enum ngcOutputOptions
+{
+  NGC_OUT_ISO=0,
+  NGC_OUT_CISO,
+  NGC_OUT_GCZ,
+  NGC_OUT_RVZ,
+  NGC_OUT_STORE,
+  NGC_OUT_DELIM
+};
+
+enum wiiOutputOptions
+{
+  WII_OUT_ISO=0,
+  WII_OUT_WBFS,
+  WII_OUT_STORE,
+  WII_OUT_DELIM
+};
+
+enum dvdOutputOptions
+{
+  DVD_OUT_ISO=0,
+  DVD_OUT_CHD,
+  DVD_OUT_ZST,
+  DVD_OUT_STORE,
+  DVD_OUT_DELIM
+};
 
 enum settingsAskStatus
 {
@@ -0,0 +1,54 @@
+/**
+ * CleanRip - netdump.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef NETDUMP_H
+#define NETDUMP_H
+
+#include <stdio.h>
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+#include "netproto.h"
+
+// Paths under this go to the receiver instead of a device
+#define NET_MOUNT		"net:/"
+
+int netdump_connect(const char *host, u16 port);
+int netdump_connected();
+void netdump_disconnect();
+const char *netdump_name(const char *path);
+
+// A file on the receiver, by the id netdump_open returned
+int netdump_open(const char *name);
+int netdump_reserve(int file, u64 size);
+int netdump_write(int file, const void *data, u32 len, u64 offset);
+int netdump_sync(int file);
+int netdump_close(int file);
+
+// stdio for the files next to an image, which may be on the receiver
+FILE *dump_fopen(const char *path, const char *mode);
+void dump_reserve(FILE *fp, u64 size);
+int dump_remove(const char *path);
+int dump_rename(const char *from, const char *to);
+int dump_exists(const char *path);
+
+#endif
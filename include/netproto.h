@@ -0,0 +1,72 @@
+/**
+ * CleanRip - netproto.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef NETPROTO_H
+#define NETPROTO_H
+
+// What goes between CleanRip and cleanrip-recv over TCP. Every frame is
+// a header followed by len bytes of payload, big endian. The receiver
+// answers every frame with an ACK, in the order they came in.
+
+#define NET_PORT		7320
+#define NET_MAGIC		0x43524E44		// "CRND"
+#define NET_VERSION		1
+#define NET_HEADER_SIZE	24
+#define NET_FRAME_MAX	(32*1024*1024)	// largest payload the receiver takes
+#define NET_NAME_MAX	256
+#define NET_FILES		16				// files open at once
+#define NET_NO_FILE		0xFFFF			// the file field of a frame that isn't for an open file
+
+// The sender waits for ACKs once this much is in flight
+#define NET_WINDOW		(8*1024*1024)
+#define NET_MAX_UNACKED	64
+
+// header fields, by offset
+#define NET_OFS_MAGIC	0		// u32
+#define NET_OFS_TYPE	4		// u16
+#define NET_OFS_FILE	6		// u16 which open file the frame is for
+#define NET_OFS_LEN		8		// u32 payload size, for an ACK the size acknowledged
+#define NET_OFS_CRC		12		// u32 CRC32 of the payload, for an ACK its status
+#define NET_OFS_OFFSET	16		// u64
+
+enum {
+	NET_HELLO = 1,		// offset is NET_VERSION
+	NET_OPEN,			// payload is the name, the file is created empty
+	NET_RESERVE,		// offset is the size the file will end up, to preallocate
+	NET_DATA,			// payload belongs at offset in the file
+	NET_CLOSE,			// the file is complete, what was reserved past its end is dropped
+	NET_REMOVE,			// payload is the name
+	NET_RENAME,			// payload is the old name, a NUL and the new one, which is replaced
+	NET_EXISTS,			// payload is the name, NET_ERR_NAME if there's no such file
+	NET_BYE,			// the end of the session
+	NET_ACK,
+};
+
+// ACK status
+enum {
+	NET_OK = 0,
+	NET_ERR_CRC,		// the payload didn't match its CRC
+	NET_ERR_IO,			// the receiver couldn't write it
+	NET_ERR_NAME,		// not a plain file name, or no such file
+	NET_ERR_FILE,		// the file isn't open
+	NET_ERR_PROTO,		// not a frame the receiver understands
+};
+
+#endif
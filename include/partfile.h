@@ -0,0 +1,63 @@
+/**
+ * CleanRip - partfile.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef PARTFILE_H
+#define PARTFILE_H
+
+#include <stdio.h>
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+
+#define PARTFILE_PATH_MAX 1024
+
+typedef struct {
+	int command;
+	int part;
+	FILE *fp;
+	u64 length;
+} part_job;
+
+typedef struct {
+	char prefix[PARTFILE_PATH_MAX];	// mount path + game name
+	char ext[8];
+	u64 part_size;					// exact size of every part but the last
+	u64 total_size;					// expected size of the whole image
+	u64 part_written;				// bytes written to the current part
+	int part;						// index of the current part
+	FILE *fp;
+	int open_pending;				// open_job is queued on the opener
+	vu32 failed;					// set by the opener if a background close failed
+	part_job open_job;
+	part_job close_job;
+	mqbox_t jobq;
+	mqbox_t doneq;
+	lwp_t opener;
+} partfile;
+
+int partfile_open(partfile *pf, const char *prefix, const char *ext, u64 part_size, u64 total_size);
+int partfile_write(partfile *pf, const void *data, u32 length);
+int partfile_close(partfile *pf);
+int partfile_count(partfile *pf);
+void partfile_path(partfile *pf, int part, char *path);
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ * CleanRip - pool.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "sink.h"
+
+#define POOL_MAX_WORKERS	16
+#define POOL_MAX_SLOTS		(POOL_MAX_WORKERS * 2)
+
+// run does a job with a worker's state, emit writes a done one out in order
+typedef void (*pool_run)(void *state, void *job);
+typedef int (*pool_emit)(sink *s, void *job);
+
+typedef struct _job_pool job_pool;
+
+typedef struct {
+	job_pool *p;
+	void *state;
+	lwp_t thread;
+} pool_worker;
+
+// The jobs are the format's, an array of slots of job_size each
+struct _job_pool {
+	sink *s;
+	pool_run run;
+	pool_emit emit;
+	u8 *jobs;
+	u32 job_size;
+	int slots;
+	void *self;			// the state jobs run with when there are no workers
+	int workers;
+	pool_worker worker[POOL_MAX_WORKERS];
+	int queues;			// jobq and the doneqs are set up
+	mqbox_t jobq;
+	mqbox_t doneq[POOL_MAX_SLOTS];
+	int first;			// oldest job still out
+	int pending;
+};
+
+int pool_cores();
+int pool_slots(int workers);
+void pool_init(job_pool *p, sink *s, void *jobs, u32 job_size, int slots, pool_run run, pool_emit emit, void *self);
+int pool_start(job_pool *p, void *state);
+void *pool_next(job_pool *p, int *ret);
+int pool_submit(job_pool *p);
+int pool_drain(job_pool *p);
+void pool_close(job_pool *p);
+
+#endif
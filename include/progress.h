@@ -0,0 +1,45 @@
+/**
+ * CleanRip - progress.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+
+#define PROGRESS_LINE_MAX 2048
+
+// One event is one JSON object on its own line:
+//   progress_begin("progress");
+//   progress_num("lba", lba);
+//   progress_end();
+int progress_open(int fd);
+int progress_enabled();
+void progress_begin(const char *event);
+void progress_str(const char *key, const char *value);
+void progress_num(const char *key, u64 value);
+void progress_real(const char *key, double value);
+void progress_end();
+void progress_close();
+
+#endif
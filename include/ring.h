@@ -0,0 +1,47 @@
+/**
+ * CleanRip - ring.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef RING_H
+#define RING_H
+
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+
+#define RING_MAX_BLOCKS 32
+
+typedef struct {
+	u8 *memory;
+	u32 header_size;	// writer message in front of every block
+	u32 block_size;
+	int count;
+	int parked_count;	// held back to keep fewer blocks in flight
+	void *parked[RING_MAX_BLOCKS];
+	mqbox_t freeq;
+} block_ring;
+
+int ring_alloc(block_ring *r, mqbox_t freeq, u32 header_size, u32 block_size, int count);
+void *ring_take(block_ring *r, int depth);
+int ring_drain(block_ring *r);
+void ring_free(block_ring *r);
+
+#endif
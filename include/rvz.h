@@ -0,0 +1,52 @@
+/**
+ * CleanRip - rvz.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef RVZ_H
+#define RVZ_H
+
+#include "sink.h"
+#include "archive.h"
+
+// Dolphin's RVZ, all big endian: two headers, the groups, then the
+// raw data and group tables
+#define RVZ_MAGIC				0x52565A01		// "RVZ\1"
+#define RVZ_VERSION				0x01000000
+#define RVZ_VERSION_COMPATIBLE	0x00030000
+#define RVZ_HEADER1_SIZE		0x48
+#define RVZ_HEADER2_SIZE		0xDC
+#define RVZ_DISC_HEADER_SIZE	0x80
+#define RVZ_CHUNK_SIZE			0x20000			// bytes of the image per group
+#define RVZ_JUNK_BLOCK			0x8000			// the junk generator starts over every this many bytes
+#define RVZ_JUNK				0x80000000		// a packed run that is junk, its seed follows
+#define RVZ_COMPRESSED			0x80000000		// a group's data_size flag
+
+// compression in the disc header
+enum {
+	RVZ_NONE = 0,
+	RVZ_ZSTD = 5,
+};
+
+int sink_rvz(sink *s, sink *next, u64 data_size);
+
+#if defined(__CYGWIN__) || defined(__linux__)
+int rvz_archive(archive *a, const char *path);
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * CleanRip - simdrive.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef SIMDRIVE_H
+#define SIMDRIVE_H
+
+#include "imgsrc.h"
+
+#define SIMDRIVE_MAX_BAD 64
+
+enum simBadTypes
+{
+	SIM_BAD_PERMANENT=0,
+	SIM_BAD_TRANSIENT
+};
+
+typedef struct {
+	u32 start;			// first bad sector
+	u32 count;
+	int type;
+	u32 failures;		// transient: reads that fail before it comes good
+} sim_bad_range;
+
+typedef struct {
+	// model, as loaded from the script
+	u32 sectors;		// disc size, reads past it fail
+	u32 layer_break;	// first sector of layer 1 (opposite track path), 0 for single layer
+	u32 inner_rate;		// bytes/s at the hub, CAV so it grows with the radius
+	u32 outer_rate;		// bytes/s at the rim
+	u32 cache_rate;		// bytes/s for data still in the drive cache
+	u32 cache_sectors;	// read-ahead kept after every read
+	u32 seek_ms;		// short seek
+	u32 full_seek_ms;	// added for a seek across the whole disc
+	u32 layer_jump_ms;
+	u32 retry_ms;		// drive's own retries before it reports an error
+	u32 flaky_ppm;		// chance in a million that any read fails once
+	u32 seed;
+	float time_scale;	// 1 = real time, 0 = only keep the virtual clock
+	sim_bad_range bad[SIMDRIVE_MAX_BAD];
+	int num_bad;
+	// state, kept when the same image is opened again
+	imgsrc image;		// data to serve, a counting pattern without one
+	int has_image;
+	int loaded;			// opened before, the state below is of image_path
+	char image_path[IMGSRC_PATH_MAX];
+	u32 head;			// sector after the last read
+	u32 cache_start;
+	u32 cache_end;
+	u32 rng;
+	u64 clock_us;		// virtual time spent in the drive
+	u32 reads;
+	u32 failed_reads;
+	u32 seeks;
+	u32 cache_hits;
+} simdrive;
+
+int simdrive_open(simdrive *sd, const char *script);
+void simdrive_close(simdrive *sd);
+int simdrive_read(simdrive *sd, void *dst, u32 len, u64 offset, u32 sector_size);
+u32 simdrive_sectors(simdrive *sd);
+void simdrive_stats(simdrive *sd);
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * CleanRip - sink.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef SINK_H
+#define SINK_H
+
+#include <stdio.h>
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+#include "partfile.h"
+
+#define WAV_HEADER_SIZE	44
+
+typedef struct _sink sink;
+
+// A tee's destination, written on its own thread
+typedef struct {
+	sink *s;
+	int command;
+	const void *data;
+	u32 len;
+	u64 offset;
+	int ret;
+	mqbox_t jobq;
+	mqbox_t doneq;
+	lwp_t thread;
+} sink_branch;
+
+typedef struct {
+	// len bytes that belong at offset in the image, 0 on success
+	int (*write)(sink *s, const void *data, u32 len, u64 offset);
+	int (*flush)(sink *s);
+	// closes everything downstream too, 0 if it all made it out
+	int (*close)(sink *s);
+} sink_ops;
+
+struct _sink {
+	const sink_ops *ops;
+	sink *next[2];			// where a tee or a stage passes the blocks on
+	sink_branch branch[2];	// tee
+	u64 pos;				// offset the next sequential write is at
+	// file
+	FILE *fp;
+	u64 origin;				// image offset the file starts at
+	// split
+	partfile *parts;
+	// net
+	int remote;				// the receiver's file
+	// stage
+	void *ctx;
+	int channels;
+	int sample_rate;
+};
+
+int sink_write(sink *s, const void *data, u32 len, u64 offset);
+int sink_flush(sink *s);
+int sink_close(sink *s);
+int sink_discards(sink *s);
+
+void sink_null(sink *s);
+int sink_file_open(sink *s, const char *path, u64 origin);
+int sink_file_reserve(sink *s, u64 size);
+void sink_split(sink *s, partfile *pf);
+void sink_tee(sink *s, sink *a, sink *b);
+void sink_stage(sink *s, const sink_ops *ops, void *ctx, sink *next);
+int sink_wav(sink *s, sink *next, int channels, int sample_rate);
+
+#endif
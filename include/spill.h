@@ -0,0 +1,45 @@
+/**
+ * CleanRip - spill.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef SPILL_H
+#define SPILL_H
+
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+
+typedef struct {
+	u8 *base;
+	u32 size;
+	u32 head;		// next byte to hand back
+	u32 used;		// bytes held
+	int arena;		// carved from the top of MEM2 rather than the heap
+} spill_buf;
+
+u32 spill_init(spill_buf *sb, u32 size);
+void spill_free(spill_buf *sb);
+int spill_push(spill_buf *sb, const void *data, u32 length);
+u32 spill_pop(spill_buf *sb, void *dst, u32 length);
+u32 spill_room(spill_buf *sb);
+u32 spill_used(spill_buf *sb);
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * CleanRip - store.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef STORE_H
+#define STORE_H
+
+#include "sink.h"
+#include "archive.h"
+
+// A store is a directory of pack files that chunks are appended to, and an
+// index of where each chunk is by its SHA-1. An image in it is a recipe: the
+// SHA-1 and length of each of its chunks in order, and the image's MD5. All
+// little endian.
+#define STORE_DIR			"cleanrip-store"
+#define STORE_INDEX			"index.bin"
+#define STORE_PACK_SIZE		0x40000000		// a new pack is started past 1GB, well short of FAT's 4GB
+#define STORE_INDEX_MAGIC	"CRSI"
+#define STORE_RECIPE_MAGIC	"CRSR"
+#define STORE_VERSION		1
+#define STORE_RECORD_SIZE	32				// sha1, pack, offset, length
+#define STORE_ENTRY_SIZE	24				// sha1, length
+#define STORE_HEADER_SIZE	64
+#define STORE_READ_BLOCK	0x40000			// what a recipe is read back in
+
+// FastCDC's normalised chunking: no cut before MIN, a harder mask up to AVG,
+// an easier one after it, and a cut at MAX whatever the data
+#define STORE_CDC_MIN		0x4000
+#define STORE_CDC_AVG		0x10000
+#define STORE_CDC_MAX		0x40000
+#define STORE_FIXED_SIZE	0x10000			// Wii partitions start on a multiple of it
+
+enum {
+	STORE_CHUNK_FIXED = 0,
+	STORE_CHUNK_CDC
+};
+
+int sink_store(sink *s, sink *next, const char *dir, int chunking);
+
+#if defined(__CYGWIN__) || defined(__linux__)
+int store_archive(archive *a, const char *path);
+int store_recipe_md5(const char *path, char *md5);
+#endif
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * CleanRip - stripe.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef STRIPE_H
+#define STRIPE_H
+
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+
+#define STRIPE_SIZE			(1024*1024)
+#define STRIPE_MAX_READERS	8
+#define STRIPE_SLOTS		4		// stripes each reader may have waiting
+
+// Reads len bytes at offset from the given reader's drive, 0 on success
+typedef int (*stripe_read_fn)(int reader, void *dst, u32 len, u64 offset);
+
+typedef struct {
+	u8 *data;
+	u64 offset;			// tag: where on the disc this stripe starts
+	u32 length;
+	int failed;
+} stripe_slot;
+
+typedef struct _stripe_reader stripe_reader;
+
+typedef struct {
+	stripe_reader *owner;
+	int index;
+	u64 next;			// start of the next stripe this reader owns
+	stripe_slot slots[STRIPE_SLOTS];
+	mqbox_t freeq;
+	mqbox_t readyq;		// filled stripes, in disc order
+	lwp_t thread;
+} stripe_worker;
+
+struct _stripe_reader {
+	stripe_read_fn read;
+	int readers;
+	u64 position;		// next byte handed to the caller
+	stripe_slot *current;
+	int current_reader;
+	vu32 stop;
+	u8 *memory;
+	stripe_worker workers[STRIPE_MAX_READERS];
+};
+
+int stripe_start(stripe_reader *sr, int readers, stripe_read_fn read, u64 start);
+int stripe_read(stripe_reader *sr, void *dst, u32 len, u64 offset);
+void stripe_stop(stripe_reader *sr);
+
+#endif
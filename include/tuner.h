@@ -0,0 +1,73 @@
+/**
+ * CleanRip - tuner.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef TUNER_H
+#define TUNER_H
+
+#ifdef __CYGWIN__
+#include "host_ogc.h"
+#else
+#include <gccore.h>
+#endif
+
+#define TUNER_MAX_SIZES 4
+#define TUNER_MAX_DEPTHS 3
+
+enum tunerStates
+{
+	TUNER_FIXED=0,
+	TUNER_WARMUP,
+	TUNER_SIZES,
+	TUNER_DEPTHS,
+	TUNER_STEADY
+};
+
+typedef struct {
+	u32 sizes[TUNER_MAX_SIZES];		// candidate read sizes, ascending
+	int num_sizes;
+	int depths[TUNER_MAX_DEPTHS];	// candidate pipeline depths, ascending
+	int num_depths;
+	int base_size;					// index of the built-in default
+	int base_depth;
+	int state;
+	int trial;						// candidate being measured
+	int size;						// size and depth in use
+	int depth;
+	int best;
+	u32 best_score;
+	u64 window_start;
+	u64 window_bytes;
+	u32 window_errors;
+	u32 steady_rate;				// bytes/s once settled, follows the drive upwards
+	int slow_windows;
+	int retunes;
+} tuner;
+
+void tuner_init(tuner *t, u32 sector_size, u32 base_size, int base_depth, int enabled);
+void tuner_update(tuner *t, u32 bytes, int error);
+u32 tuner_read_size(tuner *t);
+int tuner_depth(tuner *t);
+int tuner_probing(tuner *t);
+u32 tuner_base_size(tuner *t);
+u32 tuner_max_size(tuner *t);
+int tuner_max_depth(tuner *t);
+void tuner_ring_shape(tuner *t, u32 *block_size, int *count);
+
+#endif
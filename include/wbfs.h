@@ -0,0 +1,45 @@
+/**
+ * CleanRip - wbfs.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef WBFS_H
+#define WBFS_H
+
+#include "sink.h"
+#include "archive.h"
+
+// A WBFS file as USB loaders keep them: a one disc WBFS partition,
+// its first block holds the head, the disc's block map and the free map
+#define WBFS_MAGIC			0x57424653		// "WBFS"
+#define WBFS_HD_SECTOR		512
+#define WBFS_BLOCK_SHIFT	21
+#define WBFS_BLOCK_SIZE		(1 << WBFS_BLOCK_SHIFT)
+#define WBFS_WII_SECTORS	(143432 * 2)	// 32KB sectors on a dual layer disc
+#define WBFS_SPLIT_SIZE		0xFFFF8000ULL	// 4GB less 32KB, where the loaders split for FAT
+#define WBFS_MAX_PARTS		4
+#define WBFS_MAX_PARTITIONS	16
+
+int sink_wbfs(sink *s, sink *next, const char *prefix, u64 split);
+void wbfs_part_ext(int part, char *ext);
+
+#if defined(__CYGWIN__) || defined(__linux__)
+int wbfs_archive(archive *a, const char *path);
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ * CleanRip - zst.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef ZST_H
+#define ZST_H
+
+#include "sink.h"
+#include "archive.h"
+
+// zstd's seekable format, all little endian: independent zstd frames of
+// ZST_FRAME_SIZE bytes of the image each, then a skippable frame holding
+// the compressed and decompressed size of every frame and a footer
+#define ZST_FRAME_SIZE		0x20000
+#define ZST_FRAME_MAGIC		0xFD2FB528
+#define ZST_SKIPPABLE_MAGIC	0x184D2A5E
+#define ZST_SEEKABLE_MAGIC	0x8F92EAB1
+#define ZST_FOOTER_SIZE		9
+#define ZST_CHECKSUMS		0x80			// the footer's flag for a checksum in every entry
+
+int sink_zst(sink *s, sink *next, u64 data_size);
+
+#if defined(__CYGWIN__) || defined(__linux__)
+int zst_archive(archive *a, const char *path);
+#endif
+
+#endif
@@ -0,0 +1,544 @@
+/**
+ * CleanRip - batch.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * Unattended dumping from several drives at once (host only). Every
+ * drive gets a job thread that waits for a disc, dumps it into its
+ * own image named from the disc ID, ejects it and waits for the next
+ * one. The jobs share a fixed pool of hashing threads and take turns
+ * writing through one arbiter, so extra drives don't mean extra
+ * threads fighting over the CPU or the output disk. Each job reads
+ * and checksums through its own dump engine, so a disc gets the same
+ * retries and recovery as in an interactive dump, and the platform
+ * writes its BCA and dumpinfo the same way too.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifdef __CYGWIN__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <malloc.h>
+#include "batch.h"
+#include "bytes.h"
+
+#define JOB_PRIO		128
+#define POLL_MS			500
+#define SPINUP_SECS		30		// a disc can show up before it is readable
+
+// in sectors, as in main.h
+#define NGC_MAGIC		0xC2339F3D
+#define WII_MAGIC		0x5D1C9EA3
+#define NGC_DISC_SIZE	0x0AE0B0
+#define WII_D1_SIZE		NGC_DISC_SIZE
+#define WII_D5_SIZE		0x230480
+#define WII_D9_SIZE		0x3F69C0
+
+static void set_state(batch_job *job, int state, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+static void set_state(batch_job *job, int state, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(job->message, sizeof(job->message), fmt, args);
+	va_end(args);
+	job->state = state;
+}
+
+const char *batch_state_str(int state) {
+	switch (state) {
+		case BATCH_WAITING:		return "Waiting";
+		case BATCH_READING:		return "Reading";
+		case BATCH_FINISHING:	return "Finishing";
+		case BATCH_DONE:		return "Done";
+		case BATCH_FAILED:		return "Failed";
+		default:				return "Stopped";
+	}
+}
+
+/* the engine's source */
+
+// The engine's read has no context, so every job thread says which job it reads for
+static __thread batch_job *reading;
+
+static int engine_source(void *dst, u32 len, u64 offset, int isKnownDatel) {
+	return reading->owner->ops->read(reading->drive, dst, len, offset);
+}
+
+static u32 engine_error(void) {
+	return 0;
+}
+
+// GameCube and Wii only, so there is never a Datel check
+static const engine_ops batch_engine_ops = { engine_source, engine_error, NULL };
+
+/* shared hashing pool */
+
+static void release_block(batch_block *blk) {
+	if (__sync_sub_and_fetch(&blk->refs, 1) == 0) {
+		MQ_Send(blk->job->freeq, (mqmsg_t)blk, MQ_MSG_BLOCK);
+	}
+}
+
+static void queue_job(batch *b, batch_job *job) {
+	job->run_next = NULL;
+	if (b->run_tail) {
+		b->run_tail->run_next = job;
+	} else {
+		b->run_head = job;
+	}
+	b->run_tail = job;
+}
+
+// A job is queued at most once, so only one hasher ever works on it and its
+// blocks are hashed in the order they were read
+static void hash_submit(batch *b, batch_block *blk) {
+	batch_job *job = blk->job;
+	blk->next = NULL;
+	pthread_mutex_lock(&b->lock);
+	if (job->hash_tail) {
+		job->hash_tail->next = blk;
+	} else {
+		job->hash_head = blk;
+	}
+	job->hash_tail = blk;
+	job->hash_pending++;
+	if (!job->hash_queued) {
+		job->hash_queued = 1;
+		queue_job(b, job);
+		pthread_cond_signal(&b->work);
+	}
+	pthread_mutex_unlock(&b->lock);
+}
+
+static void hash_wait(batch *b, batch_job *job) {
+	pthread_mutex_lock(&b->lock);
+	while (job->hash_pending) {
+		pthread_cond_wait(&b->idle, &b->lock);
+	}
+	pthread_mutex_unlock(&b->lock);
+}
+
+static void* hasher_thread(void *_b) {
+	batch *b = (batch*)_b;
+
+	pthread_mutex_lock(&b->lock);
+	while (1) {
+		while (!b->run_head && !b->hash_stop) {
+			pthread_cond_wait(&b->work, &b->lock);
+		}
+		if (!b->run_head) {
+			break;
+		}
+		batch_job *job = b->run_head;
+		b->run_head = job->run_next;
+		if (!b->run_head) {
+			b->run_tail = NULL;
+		}
+		batch_block *blk = job->hash_head;
+		job->hash_head = blk->next;
+		if (!job->hash_head) {
+			job->hash_tail = NULL;
+		}
+		pthread_mutex_unlock(&b->lock);
+
+		engine_account(&job->engine, blk->data, blk->lba, blk->length / job->engine.sector_size);
+		release_block(blk);
+
+		pthread_mutex_lock(&b->lock);
+		job->hash_pending--;
+		if (job->hash_head) {
+			// back of the line so every drive gets its turn
+			queue_job(b, job);
+		} else {
+			job->hash_queued = 0;
+			pthread_cond_broadcast(&b->idle);
+		}
+	}
+	pthread_mutex_unlock(&b->lock);
+	return NULL;
+}
+
+/* global write arbiter */
+
+static void throttle(batch *b, u32 bytes) {
+	u128 now = gettime();
+	u32 elapsed = diff_msec(b->window_start, now);
+	u64 due = b->window_bytes * 1000 / b->write_limit;
+	if (elapsed > due + 1000) {
+		// been idle, don't let it make up for more than a second
+		b->window_start = now;
+		b->window_bytes = 0;
+	} else if (due > elapsed) {
+		usleep((due - elapsed) * 1000);
+	}
+	b->window_bytes += bytes;
+}
+
+static int arbiter_write(batch *b, FILE *fp, const u8 *data, u32 length) {
+	while (length) {
+		u32 slice = (length < BATCH_WRITE_SLICE) ? length : BATCH_WRITE_SLICE;
+
+		pthread_mutex_lock(&b->write_lock);
+		u32 ticket = b->next_ticket++;
+		while (ticket != b->serving) {
+			pthread_cond_wait(&b->write_turn, &b->write_lock);
+		}
+		pthread_mutex_unlock(&b->write_lock);
+
+		if (b->write_limit) {
+			throttle(b, slice);
+		}
+		int ok = fwrite(data, slice, 1, fp) == 1;
+
+		pthread_mutex_lock(&b->write_lock);
+		b->serving++;
+		pthread_cond_broadcast(&b->write_turn);
+		pthread_mutex_unlock(&b->write_lock);
+
+		if (!ok) {
+			return -1;
+		}
+		data += slice;
+		length -= slice;
+	}
+	return 0;
+}
+
+static void* writer_thread(void *_job) {
+	batch_job *job = (batch_job*)_job;
+	batch_block *blk;
+
+	while (MQ_Receive(job->writeq, (mqmsg_t*)&blk, MQ_MSG_BLOCK)==TRUE && blk) {
+		// keep taking blocks after a failure so the reader never waits on us
+		if (!job->write_failed && arbiter_write(job->owner, job->fp, blk->data, blk->length)) {
+			job->write_failed = 1;
+		}
+		release_block(blk);
+	}
+	return NULL;
+}
+
+/* jobs */
+
+static int name_taken(batch *b, batch_job *self, const char *name) {
+	char path[640];
+	for (int i = 0; i < b->job_count; i++) {
+		batch_job *job = &b->jobs[i];
+		if (job != self && job->state >= BATCH_READING && job->state <= BATCH_FINISHING && !strcmp(job->name, name)) {
+			return 1;
+		}
+	}
+	snprintf(path, sizeof(path), "%s%s.iso", b->out_path, name);
+	return access(path, F_OK) == 0;
+}
+
+// GAMEID or GAMEID-discN as in identify_disc, with -2, -3... for repeats
+static void pick_name(batch *b, batch_job *job, const u8 *header) {
+	char base[32];
+	char id[7];
+
+	memcpy(id, header, 6);
+	id[6] = 0;
+	for (int i = 0; i < 6; i++) {
+		if (!((id[i] >= 'A' && id[i] <= 'Z') || (id[i] >= '0' && id[i] <= '9'))) {
+			id[i] = '_';
+		}
+	}
+	if (header[6]) {
+		snprintf(base, sizeof(base), "%s-disc%i", id, header[6] + 1);
+	} else {
+		snprintf(base, sizeof(base), "%s", id);
+	}
+
+	pthread_mutex_lock(&b->lock);
+	snprintf(job->name, sizeof(job->name), "%s", base);
+	for (int n = 2; name_taken(b, job, job->name); n++) {
+		snprintf(job->name, sizeof(job->name), "%s-%i", base, n);
+	}
+	job->state = BATCH_READING;
+	pthread_mutex_unlock(&b->lock);
+}
+
+static u32 disc_sectors(batch_job *job, int disc_type) {
+	u8 probe[2048] __attribute__((aligned(32)));
+
+	if (disc_type == BATCH_NGC) {
+		return NGC_DISC_SIZE;
+	}
+	// same probes as detect_duallayer_disc
+	u32 sectors = WII_D1_SIZE;
+	if (job->owner->ops->read(job->drive, probe, sizeof(probe), (u64)WII_D1_SIZE << 11) == 0) {
+		sectors = WII_D5_SIZE;
+	}
+	if (job->owner->ops->read(job->drive, probe, sizeof(probe), (u64)WII_D5_SIZE << 11) == 0) {
+		sectors = WII_D9_SIZE;
+	}
+	return sectors;
+}
+
+static void finish_disc(batch_job *job) {
+	batch *b = job->owner;
+	char md5sum[64];
+	char sha1sum[64];
+	char verified_name[64];
+	int verified = 0;
+
+	engine_finish(&job->engine, md5sum, sha1sum);
+
+	verified_name[0] = 0;
+	if (b->ops->verify) {
+		// the dat lookup isn't shared safely between threads
+		pthread_mutex_lock(&b->lock);
+		verified = b->ops->verify(md5sum, job->disc_type, verified_name, sizeof(verified_name));
+		pthread_mutex_unlock(&b->lock);
+	}
+	if (verified && verified_name[0]) {
+		char before[640], after[640];
+		snprintf(before, sizeof(before), "%s%s.iso", b->out_path, job->name);
+		snprintf(after, sizeof(after), "%s%s.iso", b->out_path, verified_name);
+		if (access(after, F_OK) != 0 && rename(before, after) == 0) {
+			snprintf(job->name, sizeof(job->name), "%s", verified_name);
+		}
+	}
+	// the disc is still in, the BCA is read under the name the image ended up with
+	b->ops->bca(job->drive, b->out_path, job->name);
+	b->ops->info(b->out_path, job->name, job->header, md5sum, sha1sum, job->engine.crc32, verified,
+				 diff_sec(job->start_time, gettime()));
+	job->discs++;
+	set_state(job, BATCH_DONE, "%s.iso MD5: %s%s", job->name, md5sum, verified ? " (Verified OK)" : "");
+}
+
+static void dump_disc(batch_job *job) {
+	batch *b = job->owner;
+	u8 header[2048] __attribute__((aligned(32)));
+	char path[640];
+	batch_block *blk;
+	int ok;
+
+	set_state(job, BATCH_WAITING, "Spinning up");
+	u128 start = gettime();
+	while (!(ok = (b->ops->read(job->drive, header, sizeof(header), 0) == 0))
+			&& diff_sec(start, gettime()) < SPINUP_SECS && !b->stop) {
+		usleep(POLL_MS * 1000);
+	}
+	if (!ok) {
+		set_state(job, BATCH_FAILED, "Couldn't read the disc");
+		return;
+	}
+	if (get_be32(header + 0x1C) == NGC_MAGIC) {
+		job->disc_type = BATCH_NGC;
+	} else if (get_be32(header + 0x18) == WII_MAGIC) {
+		job->disc_type = BATCH_WII;
+	} else {
+		set_state(job, BATCH_FAILED, "Not a GameCube or Wii disc");
+		return;
+	}
+	job->total = (u64)disc_sectors(job, job->disc_type) * 2048;
+	job->done = 0;
+	memcpy(job->header, header, sizeof(job->header));
+	pick_name(b, job, header);
+
+	snprintf(path, sizeof(path), "%s%s.iso", b->out_path, job->name);
+	job->fp = fopen(path, "wb");
+	if (!job->fp) {
+		set_state(job, BATCH_FAILED, "Failed to create %s", path);
+		return;
+	}
+	set_state(job, BATCH_READING, "%s", job->name);
+	engine_init(&job->engine, &batch_engine_ops, job->disc_type == BATCH_NGC ? PROFILE_GAMECUBE : PROFILE_WII, 2048, 1);
+	// every job reads whole blocks, there is no ring for the tuner to reshape
+	tuner_init(&job->tune, 2048, BATCH_BLOCK_SIZE, BATCH_BLOCKS, 0);
+	job->write_failed = 0;
+	job->start_time = gettime();
+	LWP_CreateThread(&job->writer, writer_thread, (void*)job, NULL, 0, JOB_PRIO);
+
+	int read_failed = 0;
+	for (u64 offset = 0; offset < job->total && !job->write_failed; ) {
+		u64 left = job->total - offset;
+		u32 len = (left < BATCH_BLOCK_SIZE) ? (u32)left : BATCH_BLOCK_SIZE;
+
+		MQ_Receive(job->freeq, (mqmsg_t*)&blk, MQ_MSG_BLOCK);
+		if (engine_read(&job->engine, &job->tune, blk->data, (u32)(offset >> 11), len >> 11)) {
+			MQ_Send(job->freeq, (mqmsg_t)blk, MQ_MSG_BLOCK);
+			read_failed = 1;
+			break;
+		}
+		blk->lba = (u32)(offset >> 11);
+		blk->length = len;
+		blk->refs = 2;
+		hash_submit(b, blk);
+		MQ_Send(job->writeq, (mqmsg_t)blk, MQ_MSG_BLOCK);
+		offset += len;
+		job->done = offset;
+	}
+
+	job->state = BATCH_FINISHING;
+	MQ_Send(job->writeq, (mqmsg_t)NULL, MQ_MSG_BLOCK);
+	LWP_JoinThread(job->writer, NULL);
+	hash_wait(b, job);
+	if (fclose(job->fp) != 0) {
+		job->write_failed = 1;
+	}
+	job->fp = NULL;
+
+	if (read_failed || job->write_failed) {
+		remove(path);
+		set_state(job, BATCH_FAILED, "%s: %s error at %lluMB", job->name,
+				  read_failed ? "Read" : "Write", (unsigned long long)(job->done >> 20));
+		return;
+	}
+	finish_disc(job);
+}
+
+static int wait_for_disc(batch_job *job, int present) {
+	batch *b = job->owner;
+	while (!b->stop) {
+		if ((b->ops->present(job->drive) != 0) == present) {
+			return 1;
+		}
+		usleep(POLL_MS * 1000);
+	}
+	return 0;
+}
+
+static void* job_thread(void *_job) {
+	batch_job *job = (batch_job*)_job;
+	batch *b = job->owner;
+
+	reading = job;
+	while (!b->stop) {
+		if (job->state != BATCH_DONE && job->state != BATCH_FAILED) {
+			set_state(job, BATCH_WAITING, "Insert a disc");
+		}
+		if (!wait_for_disc(job, 1)) {
+			break;
+		}
+		dump_disc(job);
+		if (b->auto_eject) {
+			b->ops->eject(job->drive);
+		}
+		// the next disc starts the next dump, not this one again
+		if (!wait_for_disc(job, 0)) {
+			break;
+		}
+	}
+	if (job->state != BATCH_DONE && job->state != BATCH_FAILED) {
+		set_state(job, BATCH_STOPPED, "Stopped");
+	}
+	return NULL;
+}
+
+int batch_start(batch *b, const batch_drive_ops *ops, const char *out_path, const char *drive_names,
+				int drives, int hashers, u64 write_limit, int auto_eject) {
+	memset(b, 0, sizeof(batch));
+	if (drives > BATCH_MAX_JOBS) {
+		drives = BATCH_MAX_JOBS;
+	}
+	if (hashers < 1) {
+		hashers = 1;
+	}
+	if (hashers > BATCH_MAX_HASHERS) {
+		hashers = BATCH_MAX_HASHERS;
+	}
+	b->ops = ops;
+	snprintf(b->out_path, sizeof(b->out_path), "%s", out_path);
+	b->auto_eject = auto_eject;
+	b->write_limit = write_limit;
+	b->window_start = gettime();
+	pthread_mutex_init(&b->lock, NULL);
+	pthread_cond_init(&b->work, NULL);
+	pthread_cond_init(&b->idle, NULL);
+	pthread_mutex_init(&b->write_lock, NULL);
+	pthread_cond_init(&b->write_turn, NULL);
+
+	for (int i = 0; i < drives; i++) {
+		batch_job *job = &b->jobs[i];
+		job->memory = memalign(32, BATCH_BLOCKS * BATCH_BLOCK_SIZE);
+		if (!job->memory) {
+			break;
+		}
+		job->owner = b;
+		job->drive = i;
+		snprintf(job->drive_name, sizeof(job->drive_name), "%c:", drive_names[i]);
+		MQ_Init(&job->freeq, BATCH_BLOCKS);
+		MQ_Init(&job->writeq, BATCH_BLOCKS + 1);
+		for (int k = 0; k < BATCH_BLOCKS; k++) {
+			job->blocks[k].job = job;
+			job->blocks[k].data = job->memory + k * BATCH_BLOCK_SIZE;
+			MQ_Send(job->freeq, (mqmsg_t)&job->blocks[k], MQ_MSG_BLOCK);
+		}
+		b->job_count++;
+	}
+	if (!b->job_count) {
+		return -1;
+	}
+
+	b->hasher_count = hashers;
+	for (int i = 0; i < hashers; i++) {
+		LWP_CreateThread(&b->hashers[i], hasher_thread, (void*)b, NULL, 0, JOB_PRIO);
+	}
+	for (int i = 0; i < b->job_count; i++) {
+		LWP_CreateThread(&b->jobs[i].thread, job_thread, (void*)&b->jobs[i], NULL, 0, JOB_PRIO);
+	}
+	return 0;
+}
+
+int batch_busy(batch *b) {
+	for (int i = 0; i < b->job_count; i++) {
+		if (b->jobs[i].state == BATCH_READING || b->jobs[i].state == BATCH_FINISHING) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// No new discs are started; a dump already under way runs to the end
+void batch_stop(batch *b) {
+	b->stop = 1;
+}
+
+// Waits for the jobs to stop and frees everything
+void batch_end(batch *b) {
+	b->stop = 1;
+	for (int i = 0; i < b->job_count; i++) {
+		LWP_JoinThread(b->jobs[i].thread, NULL);
+	}
+
+	pthread_mutex_lock(&b->lock);
+	b->hash_stop = 1;
+	pthread_cond_broadcast(&b->work);
+	pthread_mutex_unlock(&b->lock);
+	for (int i = 0; i < b->hasher_count; i++) {
+		LWP_JoinThread(b->hashers[i], NULL);
+	}
+
+	for (int i = 0; i < b->job_count; i++) {
+		MQ_Close(b->jobs[i].freeq);
+		MQ_Close(b->jobs[i].writeq);
+		free(b->jobs[i].memory);
+	}
+	pthread_mutex_destroy(&b->lock);
+	pthread_cond_destroy(&b->work);
+	pthread_cond_destroy(&b->idle);
+	pthread_mutex_destroy(&b->write_lock);
+	pthread_cond_destroy(&b->write_turn);
+}
+
+#endif
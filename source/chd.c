@@ -0,0 +1,773 @@
+/**
+ * CleanRip - chd.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * A sink stage that writes the image as a version 5 CHD while it is
+ * dumped, the way MAME's chdman would make it. A CD goes in as frames
+ * of a raw sector and 96 bytes of (empty) subcode, eight to a hunk,
+ * with each track padded out to a multiple of four frames; a DVD goes
+ * in as it is, sixteen sectors to a hunk. Every hunk is tried with each
+ * of the image's codecs by a pool of worker threads, one per core on a
+ * PC, and stored with whichever comes out smallest, or as it is if none
+ * of them helps. CD audio is tried as FLAC and deflate, a DVD as LZMA
+ * and zstd (just deflate on the console). The hunks are appended in
+ * order as they finish, the track list and the compressed hunk map go
+ * after them and the header is filled in at close.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "chd.h"
+#include "bytes.h"
+#include "pool.h"
+#include "flac.h"
+#include "sha1.h"
+
+#if defined(__CYGWIN__) || defined(__linux__)
+#include <lzma.h>
+#include <zstd.h>
+#define CHD_LZMA_PRESET 6
+#define CHD_ZSTD_LEVEL 9
+#define CHD_ZLIB_LEVEL Z_BEST_COMPRESSION
+#else
+#define CHD_ZLIB_LEVEL Z_BEST_SPEED
+#endif
+
+#define CHD_OUT_SIZE (1024*1024)	// hunks are passed on in writes of up to this
+#define CHD_CODECS 4
+#define CHD_NONE 4					// the map type of a hunk stored as it is
+#define CHD_RLE_SMALL 7				// map types repeated 3 to 18 times
+#define CHD_RLE_LARGE 8				// and 19 to 274 times
+#define CHD_MAP_HEADER_SIZE 16
+#define CHD_META_HEADER_SIZE 16
+#define CHD_META_CHECKSUM 0x01		// the entry is part of the overall SHA-1
+#define CHD_SUBCODE_SIZE (CHD_CD_FRAME_SIZE - CHD_CD_SECTOR_SIZE)
+
+#define CHD_CODEC_ZLIB 0x7A6C6962	// "zlib"
+#define CHD_CODEC_ZSTD 0x7A737464	// "zstd"
+#define CHD_CODEC_LZMA 0x6C7A6D61	// "lzma"
+#define CHD_CODEC_CDZL 0x63647A6C	// "cdzl", sectors and subcode deflated apart
+#define CHD_CODEC_CDFL 0x6364666C	// "cdfl", sectors as FLAC, subcode deflated
+#define CHD_TAG_TRACK 0x43485432	// "CHT2"
+#define CHD_TAG_DVD 0x44564420		// "DVD "
+
+typedef struct _chd_ctx chd_ctx;
+
+typedef struct {
+	chd_ctx *c;
+	z_stream strm;
+	flac_enc *flac;
+	u8 *split;			// a CD hunk's sectors, then its subcode
+#ifdef CHD_LZMA_PRESET
+	lzma_stream lzma;
+#endif
+#ifdef CHD_ZSTD_LEVEL
+	ZSTD_CCtx *cctx;
+#endif
+} chd_worker;
+
+typedef struct {
+	u8 *raw;			// the hunk as it reads back
+	u8 *out[2];			// the smallest so far and the next try
+	const u8 *data;		// what goes in the file
+	u32 len;
+	u8 type;			// which of the codecs, or CHD_NONE
+	u16 crc;
+} chd_job;
+
+struct _chd_ctx {
+	u32 codec[CHD_CODECS];
+	u32 hunk_bytes;
+	u32 unit_bytes;
+	u64 logical;		// the image as it reads back, padding and all
+	u32 num_hunks;
+	u32 queued;			// hunks handed out so far
+	u32 hunk;			// the next one to go out
+	u32 fill;			// of the hunk being put together
+	u64 out;			// where the next one goes in the file
+	u8 hdr[CHD_HEADER_SIZE];
+	u8 *map;			// type, length and CRC of each hunk, 8 bytes apiece
+	u32 max_len;		// of a compressed hunk
+	SHA1Context sha;	// of the image as it reads back
+	int cd;
+	chd_track track[CHD_MAX_TRACKS];
+	u32 frames[CHD_MAX_TRACKS];	// in each track, without the padding
+	int tracks;
+	int cur;			// the track coming in
+	u32 track_frames;	// of it so far, padding and all
+	u32 sector;			// the next one coming in
+	u32 sector_fill;
+	u8 *obuf;			// hunks not passed on yet
+	u32 ofill;
+	chd_worker self;	// when there are no workers
+	chd_worker worker[POOL_MAX_WORKERS];
+	int workers;		// set up
+	int slots;
+	chd_job *jobs;
+	job_pool pool;
+};
+
+typedef struct {
+	u8 *p;
+	u32 acc;
+	int bits;			// in acc, not written yet
+} bit_writer;
+
+static void put_be48(u8 *p, u64 value) {
+	put_be16(p, (value >> 32) & 0xFFFF);
+	put_be32(p + 2, value & 0xFFFFFFFF);
+}
+
+static void sha1_out(SHA1Context *sha, u8 *p) {
+	SHA1Result(sha);
+	for (int i = 0; i < 5; i++) {
+		put_be32(p + i * 4, sha->Message_Digest[i]);
+	}
+}
+
+static void put_sha1(u8 *p, const u8 *data, u32 len) {
+	SHA1Context sha;
+
+	SHA1Reset(&sha);
+	SHA1Input(&sha, data, len);
+	sha1_out(&sha, p);
+}
+
+// Up to 24 bits, first bit first
+static void put_bits(bit_writer *b, u32 value, int n) {
+	b->acc = (b->acc << n) | (value & ((1U << n) - 1));
+	b->bits += n;
+	while (b->bits >= 8) {
+		b->bits -= 8;
+		*b->p++ = (u8)(b->acc >> b->bits);
+	}
+}
+
+// CRC-16/CCITT, what the map keeps for each hunk and for itself
+static u16 crc16(u16 crc, const u8 *p, u32 len) {
+	while (len--) {
+		crc ^= *p++ << 8;
+		for (int i = 0; i < 8; i++) {
+			crc = (crc & 0x8000) ? (u16)((crc << 1) ^ 0x1021) : (u16)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+// Raw deflate, no zlib header
+static u32 chd_deflate(z_stream *strm, const u8 *in, u32 len, u8 *out, u32 cap) {
+	deflateReset(strm);
+	strm->next_in = (Bytef*)in;
+	strm->avail_in = len;
+	strm->next_out = out;
+	strm->avail_out = cap;
+	return deflate(strm, Z_FINISH) == Z_STREAM_END ? (u32)strm->total_out : 0;
+}
+
+#ifdef CHD_LZMA_PRESET
+// Raw LZMA, the reader works out the dictionary and properties from the hunk size
+static u32 chd_lzma(chd_worker *w, const u8 *in, u32 len, u8 *out, u32 cap) {
+	lzma_options_lzma opt;
+	lzma_filter filters[2];
+
+	lzma_lzma_preset(&opt, CHD_LZMA_PRESET);
+	opt.dict_size = len < LZMA_DICT_SIZE_MIN ? LZMA_DICT_SIZE_MIN : len;
+	filters[0].id = LZMA_FILTER_LZMA1;
+	filters[0].options = &opt;
+	filters[1].id = LZMA_VLI_UNKNOWN;
+	if (lzma_raw_encoder(&w->lzma, filters) != LZMA_OK) {
+		return 0;
+	}
+	w->lzma.next_in = in;
+	w->lzma.avail_in = len;
+	w->lzma.next_out = out;
+	w->lzma.avail_out = cap;
+	return lzma_code(&w->lzma, LZMA_FINISH) == LZMA_STREAM_END ? cap - (u32)w->lzma.avail_out : 0;
+}
+#endif
+
+// The reader makes up the FLAC stream header from the hunk size, the frames have to match it
+static u32 chd_flac_block(u32 bytes) {
+	u32 block = bytes / 4;
+	while (block > CHD_CD_SECTOR_SIZE) {
+		block /= 2;
+	}
+	return block;
+}
+
+// The CD codecs take a hunk's sectors first, then its subcode
+static void chd_split(chd_worker *w, const u8 *raw, u32 frames) {
+	for (u32 i = 0; i < frames; i++) {
+		memcpy(w->split + i * CHD_CD_SECTOR_SIZE, raw + i * CHD_CD_FRAME_SIZE, CHD_CD_SECTOR_SIZE);
+		memcpy(w->split + frames * CHD_CD_SECTOR_SIZE + i * CHD_SUBCODE_SIZE,
+			raw + i * CHD_CD_FRAME_SIZE + CHD_CD_SECTOR_SIZE, CHD_SUBCODE_SIZE);
+	}
+}
+
+// Returns the compressed size, or 0 if it didn't fit in cap
+static u32 chd_codec(chd_worker *w, u32 codec, const u8 *raw, u8 *out, u32 cap) {
+	chd_ctx *c = w->c;
+	u32 frames = c->hunk_bytes / CHD_CD_FRAME_SIZE;
+	u32 sectors = frames * CHD_CD_SECTOR_SIZE;
+	u32 len = 0;
+
+	switch (codec) {
+	case CHD_CODEC_ZLIB:
+		return chd_deflate(&w->strm, raw, c->hunk_bytes, out, cap);
+#ifdef CHD_LZMA_PRESET
+	case CHD_CODEC_LZMA:
+		return chd_lzma(w, raw, c->hunk_bytes, out, cap);
+#endif
+#ifdef CHD_ZSTD_LEVEL
+	case CHD_CODEC_ZSTD: {
+		size_t size = ZSTD_compressCCtx(w->cctx, out, cap, raw, c->hunk_bytes, CHD_ZSTD_LEVEL);
+		return ZSTD_isError(size) ? 0 : (u32)size;
+	}
+#endif
+	case CHD_CODEC_CDZL: {
+		// no sector has its ECC taken out, so the flags in front are all clear
+		u32 ecc = (frames + 7) / 8;
+		u32 head = ecc + (c->hunk_bytes < 65536 ? 2 : 3);
+		if (cap <= head) {
+			return 0;
+		}
+		memset(out, 0, head);
+		len = chd_deflate(&w->strm, w->split, sectors, out + head, cap - head);
+		if (!len) {
+			return 0;
+		}
+		if (c->hunk_bytes >= 65536) {
+			put_be24(out + ecc, len);
+		}
+		else {
+			put_be16(out + ecc, len);
+		}
+		len += head;
+		break;
+	}
+	case CHD_CODEC_CDFL:
+		len = flac_encode(w->flac, w->split, sectors / 4, chd_flac_block(sectors), out, cap);
+		break;
+	}
+	if (!len) {
+		return 0;
+	}
+	u32 sub = chd_deflate(&w->strm, w->split + sectors, frames * CHD_SUBCODE_SIZE, out + len, cap - len);
+	return sub ? len + sub : 0;
+}
+
+// Tries every codec, keeps the smallest
+static void chd_compress(void *_worker, void *_job) {
+	chd_worker *w = (chd_worker*)_worker;
+	chd_job *job = (chd_job*)_job;
+	chd_ctx *c = w->c;
+
+	job->crc = crc16(0xFFFF, job->raw, c->hunk_bytes);
+	job->type = CHD_NONE;
+	job->data = job->raw;
+	job->len = c->hunk_bytes;
+	if (c->cd) {
+		chd_split(w, job->raw, c->hunk_bytes / CHD_CD_FRAME_SIZE);
+	}
+	for (int i = 0; i < CHD_CODECS && c->codec[i]; i++) {
+		// the try goes in whichever buffer isn't holding the smallest so far
+		u8 *out = job->out[job->data == job->out[0]];
+		u32 len = chd_codec(w, c->codec[i], job->raw, out, job->len - 1);
+		if (len) {
+			job->type = i;
+			job->len = len;
+			job->data = out;
+		}
+	}
+}
+
+static int chd_pass_on(sink *s) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+	int ret = 0;
+
+	if (c->ofill) {
+		ret = sink_write(s->next[0], c->obuf, c->ofill, c->out - c->ofill);
+		c->ofill = 0;
+	}
+	return ret;
+}
+
+static int chd_append(sink *s, const u8 *data, u32 len) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+	int ret = 0;
+
+	if (c->ofill + len > CHD_OUT_SIZE) {
+		ret = chd_pass_on(s);
+	}
+	memcpy(c->obuf + c->ofill, data, len);
+	c->ofill += len;
+	c->out += len;
+	return ret;
+}
+
+// Appends a hunk and notes it for the map
+static int chd_emit(sink *s, void *_job) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+	chd_job *job = (chd_job*)_job;
+	u8 *entry = c->map + (u64)c->hunk * 8;
+
+	if (c->hunk >= c->num_hunks) {
+		return 1;
+	}
+	entry[0] = job->type;
+	put_be24(entry + 1, job->len);
+	put_be16(entry + 4, job->crc);
+	if (job->type != CHD_NONE && job->len > c->max_len) {
+		c->max_len = job->len;
+	}
+	c->hunk++;
+	return chd_append(s, job->data, job->len);
+}
+
+// The job the hunk is put together in, once it's free
+static u8 *chd_next(sink *s, int *ret) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+
+	return ((chd_job*)pool_next(&c->pool, ret))->raw;
+}
+
+// The hunk is complete, hands it out
+static int chd_hunk(sink *s) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+	int ret = 0;
+	chd_job *job = (chd_job*)pool_next(&c->pool, &ret);
+	u64 left = c->logical - (u64)c->queued * c->hunk_bytes;
+
+	c->fill = 0;
+	if (c->queued >= c->num_hunks) {
+		return 1;
+	}
+	// the zeroes past the end of the image aren't part of it
+	SHA1Input(&c->sha, job->raw, left < c->hunk_bytes ? (u32)left : c->hunk_bytes);
+	c->queued++;
+	return pool_submit(&c->pool) | ret;
+}
+
+static u32 chd_put(sink *s, const u8 *p, u32 len, int *ret) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+	u8 *raw = chd_next(s, ret);
+	u32 n = c->hunk_bytes - c->fill;
+
+	if (n > len) {
+		n = len;
+	}
+	memcpy(raw + c->fill, p, n);
+	c->fill += n;
+	if (c->fill == c->hunk_bytes) {
+		*ret |= chd_hunk(s);
+	}
+	return n;
+}
+
+static void chd_frame(sink *s, int *ret) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+
+	c->fill += CHD_CD_FRAME_SIZE;
+	c->track_frames++;
+	if (c->fill == c->hunk_bytes) {
+		*ret |= chd_hunk(s);
+	}
+}
+
+// Pads out the tracks that end before the sector coming in
+static void chd_track_end(sink *s, int *ret) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+
+	while (c->cur + 1 < c->tracks && c->sector >= c->track[c->cur + 1].start) {
+		while (c->track_frames % CHD_CD_TRACK_PAD) {
+			memset(chd_next(s, ret) + c->fill, 0, CHD_CD_FRAME_SIZE);
+			chd_frame(s, ret);
+		}
+		c->cur++;
+		c->track_frames = 0;
+	}
+}
+
+static u32 chd_put_cd(sink *s, const u8 *p, u32 len, int *ret) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+
+	if (!c->sector_fill) {
+		chd_track_end(s, ret);
+	}
+	u8 *frame = chd_next(s, ret) + c->fill;
+	u32 n = CHD_CD_SECTOR_SIZE - c->sector_fill;
+	if (n > len) {
+		n = len;
+	}
+	memcpy(frame + c->sector_fill, p, n);
+	c->sector_fill += n;
+	if (c->sector_fill == CHD_CD_SECTOR_SIZE) {
+		// audio is kept big endian
+		if (!c->track[c->cur].data) {
+			for (u32 i = 0; i < CHD_CD_SECTOR_SIZE; i += 2) {
+				u8 t = frame[i];
+				frame[i] = frame[i + 1];
+				frame[i + 1] = t;
+			}
+		}
+		memset(frame + CHD_CD_SECTOR_SIZE, 0, CHD_SUBCODE_SIZE);
+		c->sector_fill = 0;
+		c->sector++;
+		chd_frame(s, ret);
+	}
+	return n;
+}
+
+static int chd_write(sink *s, const void *data, u32 len, u64 offset) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+	const u8 *p = (const u8*)data;
+	int ret = 0;
+
+	// the hunks only work if every block comes in order
+	if (offset != s->pos) {
+		return 1;
+	}
+	s->pos += len;
+	while (len && !ret) {
+		u32 n = c->cd ? chd_put_cd(s, p, len, &ret) : chd_put(s, p, len, &ret);
+		p += n;
+		len -= n;
+	}
+	return ret;
+}
+
+static int chd_flush(sink *s) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+
+	return pool_drain(&c->pool) | chd_pass_on(s) | sink_flush(s->next[0]);
+}
+
+// One entry per CD track, or the DVD marker, chained one after the other.
+// The overall SHA-1 covers the image and the entries' SHA-1s, sorted.
+static int chd_meta(sink *s) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+	int entries = c->cd ? c->tracks : 1;
+	u8 hash[CHD_MAX_TRACKS][24];
+	char text[128];
+	u64 base = c->out;
+	u32 len = 0;
+	SHA1Context sha;
+
+	u8 *buf = (u8*)malloc(entries * (CHD_META_HEADER_SIZE + sizeof(text)));
+	if (!buf) {
+		return 1;
+	}
+	for (int i = 0; i < entries; i++) {
+		u8 *entry = buf + len;
+		u32 tag = c->cd ? CHD_TAG_TRACK : CHD_TAG_DVD;
+		u32 size = 1;
+		text[0] = 0;
+		if (c->cd) {
+			// the terminator is part of the entry
+			size = sprintf(text, "TRACK:%d TYPE:%s SUBTYPE:NONE FRAMES:%u PREGAP:0 PGTYPE:MODE1 PGSUB:NONE POSTGAP:0",
+				i + 1, c->track[i].data ? "MODE1_RAW" : "AUDIO", c->frames[i]) + 1;
+		}
+		len += CHD_META_HEADER_SIZE + size;
+		put_be32(entry, tag);
+		put_be32(entry + 4, (CHD_META_CHECKSUM << 24) | size);
+		put_be64(entry + 8, i + 1 < entries ? base + len : 0);
+		memcpy(entry + CHD_META_HEADER_SIZE, text, size);
+		put_be32(hash[i], tag);
+		put_sha1(hash[i] + 4, (u8*)text, size);
+	}
+	// insertion sort, there are at most 99 of them
+	for (int i = 1; i < entries; i++) {
+		for (int j = i; j > 0 && memcmp(hash[j - 1], hash[j], 24) > 0; j--) {
+			u8 t[24];
+			memcpy(t, hash[j], 24);
+			memcpy(hash[j], hash[j - 1], 24);
+			memcpy(hash[j - 1], t, 24);
+		}
+	}
+	sha1_out(&c->sha, c->hdr + 64);
+	SHA1Reset(&sha);
+	SHA1Input(&sha, c->hdr + 64, 20);
+	SHA1Input(&sha, hash[0], entries * 24);
+	sha1_out(&sha, c->hdr + 84);
+	put_be64(c->hdr + 48, base);
+	int ret = chd_append(s, buf, len) | chd_pass_on(s);
+	free(buf);
+	return ret;
+}
+
+// The map is Huffman coded, with a fixed tree: every type is its own 4-bit code
+static int chd_map(sink *s) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+	u8 head[CHD_MAP_HEADER_SIZE] = { 0 };
+	u8 raw[12];
+	u64 offset = CHD_HEADER_SIZE;
+	u16 crc = 0xFFFF;
+	int lengthbits = 0;
+	u8 last = 0;
+
+	// types, lengths and CRCs, plus the tree and a little to spare
+	u8 *bits = (u8*)malloc((u64)c->num_hunks * 6 + 64);
+	if (!bits) {
+		return 1;
+	}
+	bit_writer b = { bits, 0, 0 };
+	while (c->max_len >> lengthbits) {
+		lengthbits++;
+	}
+	for (int i = 0; i < 16; i++) {
+		put_bits(&b, 4, 4);
+	}
+	for (u32 i = 0; i < c->num_hunks;) {
+		u8 type = c->map[(u64)i * 8];
+		u32 run = 1;
+		while (i + run < c->num_hunks && c->map[(u64)(i + run) * 8] == type) {
+			run++;
+		}
+		i += run;
+		while (run) {
+			if (type != last || run < 3) {
+				put_bits(&b, type, 4);
+				last = type;
+				run--;
+			}
+			else if (run < 19) {
+				put_bits(&b, CHD_RLE_SMALL, 4);
+				put_bits(&b, run - 3, 4);
+				run = 0;
+			}
+			else {
+				u32 n = run - 19 > 255 ? 255 : run - 19;
+				put_bits(&b, CHD_RLE_LARGE, 4);
+				put_bits(&b, n, 8);
+				run -= n + 19;
+			}
+		}
+	}
+	for (u32 i = 0; i < c->num_hunks; i++) {
+		u8 *entry = c->map + (u64)i * 8;
+		u32 len = get_be24(entry + 1);
+		if (entry[0] != CHD_NONE) {
+			put_bits(&b, len, lengthbits);
+		}
+		put_bits(&b, (entry[4] << 8) | entry[5], 16);
+		// the CRC is of the map as the reader unpacks it
+		raw[0] = entry[0];
+		put_be24(raw + 1, len);
+		put_be48(raw + 4, offset);
+		memcpy(raw + 10, entry + 4, 2);
+		crc = crc16(crc, raw, sizeof(raw));
+		offset += len;
+	}
+	if (b.bits) {
+		put_bits(&b, 0, 8 - b.bits);
+	}
+	u32 size = b.p - bits;
+	put_be32(head, size);
+	put_be48(head + 4, CHD_HEADER_SIZE);
+	put_be16(head + 10, crc);
+	head[12] = lengthbits;
+	put_be64(c->hdr + 40, c->out);
+	int ret = chd_append(s, head, sizeof(head)) | chd_pass_on(s);
+	// it can be bigger than obuf
+	ret |= sink_write(s->next[0], bits, size, c->out);
+	c->out += size;
+	free(bits);
+	return ret;
+}
+
+static int chd_header(sink *s) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+	u8 *h = c->hdr;
+
+	memcpy(h, "MComprHD", 8);
+	put_be32(h + 8, CHD_HEADER_SIZE);
+	put_be32(h + 12, CHD_VERSION);
+	for (int i = 0; i < CHD_CODECS; i++) {
+		put_be32(h + 16 + i * 4, c->codec[i]);
+	}
+	put_be64(h + 32, c->logical);
+	put_be32(h + 56, c->hunk_bytes);
+	put_be32(h + 60, c->unit_bytes);
+	return sink_write(s->next[0], h, CHD_HEADER_SIZE, 0);
+}
+
+static void chd_worker_free(chd_worker *w) {
+	deflateEnd(&w->strm);
+	free(w->flac);
+	free(w->split);
+#ifdef CHD_LZMA_PRESET
+	lzma_end(&w->lzma);
+#endif
+#ifdef CHD_ZSTD_LEVEL
+	ZSTD_freeCCtx(w->cctx);
+#endif
+}
+
+static int chd_worker_init(chd_worker *w, chd_ctx *c) {
+	w->c = c;
+	if (deflateInit2(&w->strm, CHD_ZLIB_LEVEL, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		return 1;
+	}
+	if (c->cd) {
+		w->flac = (flac_enc*)malloc(sizeof(flac_enc));
+		w->split = (u8*)malloc(c->hunk_bytes);
+		if (!w->flac || !w->split) {
+			return 1;
+		}
+	}
+#ifdef CHD_ZSTD_LEVEL
+	w->cctx = ZSTD_createCCtx();
+	if (!w->cctx) {
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+static void chd_free(chd_ctx *c) {
+	pool_close(&c->pool);
+	for (int i = 0; i < c->workers; i++) {
+		chd_worker_free(&c->worker[i]);
+	}
+	for (int i = 0; c->jobs && i < c->slots; i++) {
+		free(c->jobs[i].raw);
+		free(c->jobs[i].out[0]);
+		free(c->jobs[i].out[1]);
+	}
+	chd_worker_free(&c->self);
+	free(c->jobs);
+	free(c->obuf);
+	free(c->map);
+	free(c);
+}
+
+static int chd_close(sink *s) {
+	chd_ctx *c = (chd_ctx*)s->ctx;
+	int ret = 0;
+
+	if (c) {
+		// the last track's padding and the end of the last hunk read back as zeroes
+		while (!ret && c->queued < c->num_hunks) {
+			u8 *raw = chd_next(s, &ret);
+			memset(raw + c->fill, 0, c->hunk_bytes - c->fill);
+			ret |= chd_hunk(s);
+		}
+		ret |= pool_drain(&c->pool) | chd_pass_on(s);
+		ret |= chd_meta(s);
+		ret |= chd_map(s);
+		ret |= chd_header(s);
+		chd_free(c);
+		s->ctx = NULL;
+	}
+	return sink_close(s->next[0]) | ret;
+}
+
+static const sink_ops chd_ops = { chd_write, chd_flush, chd_close };
+
+// c is freed if it fails
+static int chd_open(sink *s, chd_ctx *c, sink *next, u32 hunk_bytes, u32 unit_bytes, u64 logical) {
+	c->hunk_bytes = hunk_bytes;
+	c->unit_bytes = unit_bytes;
+	c->logical = logical;
+	c->num_hunks = (logical + hunk_bytes - 1) / hunk_bytes;
+	c->out = CHD_HEADER_SIZE;
+	SHA1Reset(&c->sha);
+	c->map = (u8*)calloc(c->num_hunks + 1, 8);
+	c->obuf = (u8*)malloc(CHD_OUT_SIZE);
+	int workers = pool_cores();
+	c->slots = pool_slots(workers);
+	c->jobs = (chd_job*)calloc(c->slots, sizeof(chd_job));
+	int failed = !c->map || !c->obuf || !c->jobs || chd_worker_init(&c->self, c);
+	for (int i = 0; !failed && i < c->slots; i++) {
+		chd_job *job = &c->jobs[i];
+		job->raw = (u8*)malloc(hunk_bytes);
+		job->out[0] = (u8*)malloc(hunk_bytes);
+		job->out[1] = (u8*)malloc(hunk_bytes);
+		failed = !job->raw || !job->out[0] || !job->out[1];
+	}
+	if (failed) {
+		chd_free(c);
+		return 1;
+	}
+	pool_init(&c->pool, s, c->jobs, sizeof(chd_job), c->slots, chd_compress, chd_emit, &c->self);
+	// fewer workers is fine, with none the writer thread compresses
+	for (; c->workers < workers; c->workers++) {
+		chd_worker *w = &c->worker[c->workers];
+		if (chd_worker_init(w, c)) {
+			chd_worker_free(w);
+			break;
+		}
+		pool_start(&c->pool, w);
+	}
+	sink_stage(s, &chd_ops, c, next);
+	// an empty header until the dump is done
+	if (chd_header(s)) {
+		chd_free(c);
+		s->ctx = NULL;
+		return 1;
+	}
+	return 0;
+}
+
+// data_size is what the drive reads, 2352 byte sectors. Tracks past the
+// end of it are left out, with none the whole disc is one audio track.
+int sink_chd_cd(sink *s, sink *next, const chd_track *tracks, int count, u64 data_size) {
+	chd_ctx *c = (chd_ctx*)calloc(1, sizeof(chd_ctx));
+	u32 sectors = data_size / CHD_CD_SECTOR_SIZE;
+	u64 frames = 0;
+
+	if (!c) {
+		return 1;
+	}
+	c->cd = 1;
+	for (int i = 0; i < count && c->tracks < CHD_MAX_TRACKS; i++) {
+		if (tracks[i].start >= sectors || (c->tracks && tracks[i].start <= c->track[c->tracks - 1].start)) {
+			continue;
+		}
+		c->track[c->tracks++] = tracks[i];
+	}
+	if (!c->tracks) {
+		c->tracks = 1;
+	}
+	// anything before the first track goes in it
+	c->track[0].start = 0;
+	for (int i = 0; i < c->tracks; i++) {
+		c->frames[i] = (i + 1 < c->tracks ? c->track[i + 1].start : sectors) - c->track[i].start;
+		frames += (c->frames[i] + CHD_CD_TRACK_PAD - 1) / CHD_CD_TRACK_PAD * CHD_CD_TRACK_PAD;
+	}
+	c->codec[0] = CHD_CODEC_CDFL;
+	c->codec[1] = CHD_CODEC_CDZL;
+	return chd_open(s, c, next, CHD_CD_HUNK_FRAMES * CHD_CD_FRAME_SIZE, CHD_CD_FRAME_SIZE,
+		frames * CHD_CD_FRAME_SIZE);
+}
+
+int sink_chd_dvd(sink *s, sink *next, u64 data_size) {
+	chd_ctx *c = (chd_ctx*)calloc(1, sizeof(chd_ctx));
+	if (!c) {
+		return 1;
+	}
+#ifdef CHD_LZMA_PRESET
+	c->codec[0] = CHD_CODEC_LZMA;
+	c->codec[1] = CHD_CODEC_ZSTD;
+#else
+	c->codec[0] = CHD_CODEC_ZLIB;
+#endif
+	return chd_open(s, c, next, CHD_DVD_HUNK_SIZE, CHD_DVD_SECTOR_SIZE, data_size);
+}
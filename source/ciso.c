@@ -0,0 +1,226 @@
+/**
+ * CleanRip - ciso.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * A sink stage that writes the image as a CISO while it is dumped.
+ * The image is cut into blocks; a block that is nothing but zeroes
+ * is only marked absent in the map, every other one is appended to
+ * the file in order. Whether a block is all zeroes is only known
+ * once it has come in, so its leading zeroes are held back until
+ * something else turns up in it. The map goes into the header at
+ * close, the same way the WAV header gets its sizes. On a PC a CISO
+ * can also be read back, an absent block reading as zeroes.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "ciso.h"
+
+typedef struct {
+	u32 block_size;
+	u32 block;			// the block coming in
+	u32 filled;			// how much of it has
+	int used;			// something in it isn't zero, so it's in the file
+	u64 out;			// where it starts in the file
+	u8 hdr[CISO_HEADER_SIZE];
+} ciso_ctx;
+
+static const u8 zeroes[0x8000];
+
+static int all_zero(const u8 *p, u32 len) {
+	// the ring's blocks are aligned, so this mostly goes a word at a time
+	while (len && ((u32)(uintptr_t)p & 3)) {
+		if (*p++) {
+			return 0;
+		}
+		len--;
+	}
+	for (; len >= 4; p += 4, len -= 4) {
+		if (*(const u32*)p) {
+			return 0;
+		}
+	}
+	while (len--) {
+		if (*p++) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int ciso_header(sink *s) {
+	ciso_ctx *c = (ciso_ctx*)s->ctx;
+	u32 size = c->block_size;
+
+	memcpy(c->hdr, "CISO", 4);
+	c->hdr[4] = size & 0xFF;
+	c->hdr[5] = (size >> 8) & 0xFF;
+	c->hdr[6] = (size >> 16) & 0xFF;
+	c->hdr[7] = size >> 24;
+	return sink_write(s->next[0], c->hdr, CISO_HEADER_SIZE, 0);
+}
+
+static int write_zeroes(sink *s, u32 len, u64 offset) {
+	while (len) {
+		u32 n = len < sizeof(zeroes) ? len : sizeof(zeroes);
+		if (sink_write(s->next[0], zeroes, n, offset)) {
+			return 1;
+		}
+		offset += n;
+		len -= n;
+	}
+	return 0;
+}
+
+static int ciso_write(sink *s, const void *data, u32 len, u64 offset) {
+	ciso_ctx *c = (ciso_ctx*)s->ctx;
+	const u8 *p = (const u8*)data;
+
+	// the map only works if every block comes in order
+	if (offset != s->pos) {
+		return 1;
+	}
+	s->pos += len;
+	while (len) {
+		u32 n = c->block_size - c->filled;
+		if (n > len) {
+			n = len;
+		}
+		if (!c->used && !all_zero(p, n)) {
+			if (c->block >= CISO_MAP_SIZE) {
+				return 1;
+			}
+			c->used = 1;
+			c->hdr[8 + c->block] = 1;
+			if (write_zeroes(s, c->filled, c->out)) {
+				return 1;
+			}
+		}
+		if (c->used && sink_write(s->next[0], p, n, c->out + c->filled)) {
+			return 1;
+		}
+		p += n;
+		len -= n;
+		c->filled += n;
+		if (c->filled == c->block_size) {
+			if (c->used) {
+				c->out += c->block_size;
+			}
+			c->block++;
+			c->filled = 0;
+			c->used = 0;
+		}
+	}
+	return 0;
+}
+
+static int ciso_flush(sink *s) {
+	return sink_flush(s->next[0]);
+}
+
+static int ciso_close(sink *s) {
+	ciso_ctx *c = (ciso_ctx*)s->ctx;
+	int ret = 0;
+
+	if (c) {
+		// a short last block is padded out, readers take whole blocks
+		if (c->used) {
+			ret = write_zeroes(s, c->block_size - c->filled, c->out + c->filled);
+		}
+		ret |= ciso_header(s);
+		free(c);
+		s->ctx = NULL;
+	}
+	return sink_close(s->next[0]) | ret;
+}
+
+static const sink_ops ciso_ops = { ciso_write, ciso_flush, ciso_close };
+
+int sink_ciso(sink *s, sink *next, u32 block_size) {
+	ciso_ctx *c = (ciso_ctx*)calloc(1, sizeof(ciso_ctx));
+	if (!c) {
+		return 1;
+	}
+	c->block_size = block_size;
+	c->out = CISO_HEADER_SIZE;
+	sink_stage(s, &ciso_ops, c, next);
+	// an empty map until the dump is done, so a cancelled dump still opens
+	if (ciso_header(s)) {
+		free(c);
+		s->ctx = NULL;
+		return 1;
+	}
+	return 0;
+}
+
+#if defined(__CYGWIN__) || defined(__linux__)
+typedef struct {
+	FILE *fp;
+	u64 *where;			// each block in the file, 0 if absent
+} ciso_reader;
+
+static int ciso_block(archive *a, u32 block, u8 *dst, u8 *scratch) {
+	ciso_reader *r = (ciso_reader*)a->ctx;
+
+	if (!r->where[block]) {
+		memset(dst, 0, a->block_size);
+		return 0;
+	}
+	return archive_pread(r->fp, dst, a->block_size, r->where[block]);
+}
+
+static void ciso_reader_close(archive *a) {
+	ciso_reader *r = (ciso_reader*)a->ctx;
+
+	fclose(r->fp);
+	free(r->where);
+	free(r);
+}
+
+int ciso_archive(archive *a, const char *path) {
+	u8 hdr[CISO_HEADER_SIZE];
+	ciso_reader *r = (ciso_reader*)calloc(1, sizeof(ciso_reader));
+
+	memset(a, 0, sizeof(archive));
+	if (!r || !(r->fp = fopen(path, "rb"))) {
+		free(r);
+		return -1;
+	}
+	a->ctx = r;
+	a->close = ciso_reader_close;
+	a->block = ciso_block;
+	if (archive_pread(r->fp, hdr, CISO_HEADER_SIZE, 0) || memcmp(hdr, "CISO", 4)
+		|| !(a->block_size = hdr[4] | (hdr[5] << 8) | (hdr[6] << 16) | ((u32)hdr[7] << 24))
+		|| !(r->where = (u64*)calloc(CISO_MAP_SIZE, sizeof(u64)))) {
+		ciso_reader_close(a);
+		return -1;
+	}
+	// blocks are in the file in map order, the image ends with the last one there
+	u64 out = CISO_HEADER_SIZE;
+	for (u32 i = 0; i < CISO_MAP_SIZE; i++) {
+		if (hdr[8 + i]) {
+			r->where[i] = out;
+			out += a->block_size;
+			a->blocks = i + 1;
+		}
+	}
+	a->size = (u64)a->blocks * a->block_size;
+	return 0;
+}
+#endif
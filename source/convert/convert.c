@@ -0,0 +1,436 @@
+/**
+ * CleanRip - convert.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * cleanrip-convert, which turns an image in any format CleanRip reads
+ * into any format it writes, without unpacking it to an ISO first.
+ * The image is read through imgsrc, a thread per core decoding, and
+ * every block goes through the digests while the output's own stage
+ * encodes it, so reading, hashing and writing all run at once in a
+ * few MB of blocks. The checksums are held against the dumpinfo that
+ * came with the image, which is copied next to the output with the BCA.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include "imgsrc.h"
+#include "bytes.h"
+#include "sink.h"
+#include "partfile.h"
+#include "netdump.h"
+#include "ciso.h"
+#include "gcz.h"
+#include "rvz.h"
+#include "wbfs.h"
+#include "chd.h"
+#include "zst.h"
+#include "store.h"
+#include "delta.h"
+
+#define NGC_MAGIC		0xC2339F3D
+#define WII_MAGIC		0x5D1C9EA3
+
+// exit codes, as the headless Windows build has them
+#define EXIT_DONE		0
+#define EXIT_FAILED		1
+#define EXIT_USAGE		2
+#define EXIT_MISMATCH	3
+
+typedef struct {
+	u64 total;
+	u64 shown;			// where the last line was printed
+} progress_ctx;
+
+// netdump.c logs through this on the console
+void print_gecko(const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+}
+
+// path without its extension, or without .part0 and the extension for a split image
+static void path_stem(char *stem, const char *path) {
+	char *ext, *slash;
+
+	snprintf(stem, IMGSRC_PATH_MAX, "%s", path);
+	slash = strrchr(stem, '/');
+	if ((ext = strstr(slash ? slash : stem, ".part0")) || (ext = strrchr(slash ? slash : stem, '.'))) {
+		*ext = 0;
+	}
+}
+
+static const char *path_ext(const char *path) {
+	const char *slash = strrchr(path, '/');
+	const char *ext = strrchr(slash ? slash : path, '.');
+	return ext ? ext : "";
+}
+
+// A progress line every 1% on stderr, the blocks pass through untouched
+static int progress_write(sink *s, const void *data, u32 len, u64 offset) {
+	progress_ctx *p = (progress_ctx*)s->ctx;
+
+	if (offset + len - p->shown >= p->total / 100 || offset + len == p->total) {
+		p->shown = offset + len;
+		fprintf(stderr, "\r%3u%% %llu/%llu MB", (u32)(p->shown * 100 / p->total),
+				(unsigned long long)(p->shown >> 20), (unsigned long long)(p->total >> 20));
+	}
+	return sink_write(s->next[0], data, len, offset);
+}
+
+static int progress_flush(sink *s) {
+	return sink_flush(s->next[0]);
+}
+
+static int progress_close(sink *s) {
+	fprintf(stderr, "\n");
+	return sink_close(s->next[0]);
+}
+
+static const sink_ops progress_ops = { progress_write, progress_flush, progress_close };
+
+// A BIN is an audio CD, a data track first if imgsrc found sync patterns in it
+static int open_chd(sink *stage, sink *next, imgsrc *img) {
+	chd_track track = { 0, img->data_offset != 0 };
+
+	if (img->file_sector == CHD_CD_SECTOR_SIZE) {
+		return sink_chd_cd(stage, next, &track, 1, img->size);
+	}
+	return sink_chd_dvd(stage, next, img->size);
+}
+
+// The output's stage in front of the file, as main.c's open_format has it; a store
+// is the cleanrip-store directory next to the recipe
+static int open_format(sink *stage, sink **root, const char *ext, imgsrc *img, const char *stem, int chunking,
+					   const char *reference) {
+	int open_failed = 0;
+	if (!strcmp(ext, ".ciso")) {
+		open_failed = sink_ciso(stage, *root, CISO_BLOCK_SIZE);
+	}
+	else if (!strcmp(ext, ".gcz")) {
+		open_failed = sink_gcz(stage, *root, img->size);
+	}
+	else if (!strcmp(ext, ".rvz")) {
+		open_failed = sink_rvz(stage, *root, img->size);
+	}
+	else if (!strcmp(ext, ".chd")) {
+		open_failed = open_chd(stage, *root, img);
+	}
+	else if (!strcmp(ext, ".zst")) {
+		open_failed = sink_zst(stage, *root, img->size);
+	}
+	else if (!strcmp(ext, ".rcp")) {
+		char dir[IMGSRC_PATH_MAX + 16];
+		const char *slash = strrchr(stem, '/');
+		snprintf(dir, sizeof(dir), "%.*s%s", slash ? (int)(slash + 1 - stem) : 0, stem, STORE_DIR);
+		open_failed = sink_store(stage, *root, dir, chunking);
+	}
+	else if (!strcmp(ext, ".dlt")) {
+		open_failed = sink_delta(stage, *root, reference);
+	}
+	if (!open_failed) {
+		*root = stage;
+	}
+	return open_failed;
+}
+
+// Whether the output format can hold this image, with what's wrong in why
+static const char *check_format(const char *ext, imgsrc *img, int *wii) {
+	u8 hdr[0x20];
+	int gc;
+
+	if (imgsrc_read(img, hdr, sizeof(hdr), 0, img->file_sector)) {
+		return "can't read the disc header";
+	}
+	gc = img->file_sector == 2048 && get_be32(&hdr[0x1C]) == NGC_MAGIC;
+	*wii = img->file_sector == 2048 && get_be32(&hdr[0x18]) == WII_MAGIC;
+	if (!strcmp(ext, ".iso") || !strcmp(ext, ".bin") || !strcmp(ext, ".gcz")
+		|| !strcmp(ext, ".zst") || !strcmp(ext, ".chd") || !strcmp(ext, ".rcp") || !strcmp(ext, ".dlt")) {
+		return NULL;
+	}
+	if (!strcmp(ext, ".ciso")) {
+		return img->size > (u64)CISO_MAP_SIZE * CISO_BLOCK_SIZE ? "the image is too big for a CISO" : NULL;
+	}
+	if (!strcmp(ext, ".rvz")) {
+		return gc ? NULL : "only GameCube images are written as RVZ";
+	}
+	if (!strcmp(ext, ".wbfs")) {
+		return *wii ? NULL : "only Wii images are written as WBFS";
+	}
+	return "unknown output format";
+}
+
+// The checksums the image was dumped with, 0 for the ones its dumpinfo doesn't have
+static int read_dumpinfo(const char *path, imgsrc_digest *d, int *has_crc) {
+	char line[256];
+	FILE *fp = fopen(path, "r");
+
+	memset(d, 0, sizeof(imgsrc_digest));
+	*has_crc = 0;
+	if (!fp) {
+		return 1;
+	}
+	while (fgets(line, sizeof(line), fp)) {
+		line[strcspn(line, "\r\n")] = 0;
+		if (!strncmp(line, "MD5: ", 5)) {
+			snprintf(d->md5, sizeof(d->md5), "%.32s", &line[5]);
+		}
+		else if (!strncmp(line, "SHA-1: ", 7)) {
+			snprintf(d->sha1, sizeof(d->sha1), "%.40s", &line[7]);
+		}
+		else if (!strncmp(line, "CRC32: ", 7)) {
+			d->crc32 = strtoul(&line[7], NULL, 16);
+			*has_crc = 1;
+		}
+	}
+	fclose(fp);
+	return 0;
+}
+
+static int copy_file(const char *from, const char *to) {
+	char buf[4096];
+	size_t n;
+	int ret = 0;
+	FILE *in = fopen(from, "rb"), *out;
+
+	if (!in) {
+		return 1;
+	}
+	if (!(out = fopen(to, "wb"))) {
+		fclose(in);
+		return 1;
+	}
+	while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+		ret |= fwrite(buf, 1, n, out) != n;
+	}
+	fclose(in);
+	return fclose(out) | ret;
+}
+
+static void rename_bad(const char *path) {
+	char bad[IMGSRC_PATH_MAX + 32];
+
+	snprintf(bad, sizeof(bad), "%s.bad", path);
+	dump_remove(bad);
+	if (!dump_rename(path, bad)) {
+		printf("Renamed to %s\n", bad);
+	}
+}
+
+// An output that doesn't match what it was made from is renamed to *.bad, split parts and all,
+// so nothing is left under the real name for a dumpinfo to vouch for
+static int mismatch(const char *out_path, const char *out_stem, const char *ext) {
+	char part[IMGSRC_PATH_MAX + 16];
+
+	if (dump_exists(out_path)) {
+		rename_bad(out_path);
+	}
+	for (int i = 0; ; i++) {
+		snprintf(part, sizeof(part), "%s.part%i%s", out_stem, i, ext);
+		if (!dump_exists(part)) {
+			break;
+		}
+		rename_bad(part);
+	}
+	for (int i = 1; ; i++) {
+		snprintf(part, sizeof(part), "%s.wbf%i", out_stem, i);
+		if (!dump_exists(part)) {
+			break;
+		}
+		rename_bad(part);
+	}
+	return EXIT_MISMATCH;
+}
+
+static int usage(const char *name) {
+	fprintf(stderr, "Usage: %s [-s MB] [--chunks=fixed|cdc] [--ref=image] [--no-verify] input output\n"
+			"  input   .iso/.bin (or .part0), .ciso, .gcz, .rvz, .wbfs, .zst, .rcp or .dlt\n"
+			"  output  .iso/.bin, .ciso, .gcz, .rvz, .wbfs, .chd, .zst, .rcp or .dlt\n"
+			"  -s MB   split an .iso/.bin into parts, or a .wbfs into .wbf1..., of this size\n"
+			"  --chunks=fixed|cdc  how a recipe's image is cut up (fixed for Wii, cdc otherwise)\n"
+			"  --ref=image  the image of another release a .dlt is written against\n", name);
+	return EXIT_USAGE;
+}
+
+int main(int argc, char **argv) {
+	const char *in_path = NULL, *out_path = NULL, *ref_path = NULL;
+	char in_stem[IMGSRC_PATH_MAX], out_stem[IMGSRC_PATH_MAX];
+	char from[IMGSRC_PATH_MAX + 16], to[IMGSRC_PATH_MAX + 16];
+	sink file, stage, wbfs, progress;
+	sink *root = &file;
+	partfile parts;
+	progress_ctx prog;
+	imgsrc img;
+	imgsrc_digest d, want;
+	u64 split = 0;
+	int verify = 1, has_crc, ret, wii, chunking = -1;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+			split = strtoull(argv[++i], NULL, 10) << 20;
+		}
+		else if (!strcmp(argv[i], "--chunks=fixed")) {
+			chunking = STORE_CHUNK_FIXED;
+		}
+		else if (!strcmp(argv[i], "--chunks=cdc")) {
+			chunking = STORE_CHUNK_CDC;
+		}
+		else if (!strncmp(argv[i], "--ref=", 6)) {
+			ref_path = argv[i] + 6;
+		}
+		else if (!strcmp(argv[i], "--no-verify")) {
+			verify = 0;
+		}
+		else if (argv[i][0] == '-') {
+			return usage(argv[0]);
+		}
+		else if (!in_path) {
+			in_path = argv[i];
+		}
+		else if (!out_path) {
+			out_path = argv[i];
+		}
+		else {
+			return usage(argv[0]);
+		}
+	}
+	if (!in_path || !out_path) {
+		return usage(argv[0]);
+	}
+
+	const char *ext = path_ext(out_path);
+	if (!strcmp(ext, ".dlt") && !ref_path) {
+		return usage(argv[0]);
+	}
+	if (imgsrc_open(&img, in_path)) {
+		fprintf(stderr, "Can't open %s\n", in_path);
+		return EXIT_FAILED;
+	}
+	const char *why = check_format(ext, &img, &wii);
+	if (why) {
+		fprintf(stderr, "Can't write %s: %s\n", out_path, why);
+		imgsrc_close(&img);
+		return EXIT_USAGE;
+	}
+	path_stem(in_stem, in_path);
+	path_stem(out_stem, out_path);
+
+	// a split ISO is cut into sector aligned parts, a WBFS splits itself
+	int raw = !strcmp(ext, ".iso") || !strcmp(ext, ".bin");
+	int open_failed;
+	if (raw && split && split < img.size) {
+		split = (split / img.file_sector) * img.file_sector;
+		open_failed = partfile_open(&parts, out_stem, ext, split, img.size);
+		sink_split(&file, &parts);
+	}
+	else {
+		dump_remove(out_path);
+		open_failed = sink_file_open(&file, out_path, 0);
+		if (!open_failed && raw) {
+			sink_file_reserve(&file, img.size);
+		}
+	}
+	if (!open_failed && !strcmp(ext, ".wbfs")) {
+		open_failed = sink_wbfs(&wbfs, &file, out_stem, split);
+		root = &wbfs;
+	}
+	else if (!open_failed && !raw) {
+		// as a dump does it: Wii partitions are encrypted, only the same data at the same place dedups
+		if (chunking < 0) {
+			chunking = wii ? STORE_CHUNK_FIXED : STORE_CHUNK_CDC;
+		}
+		open_failed = open_format(&stage, &root, ext, &img, out_stem, chunking, ref_path);
+	}
+	if (open_failed) {
+		fprintf(stderr, "Can't create %s\n", out_path);
+		sink_close(root);
+		imgsrc_close(&img);
+		return EXIT_FAILED;
+	}
+	prog.total = img.size;
+	prog.shown = 0;
+	sink_stage(&progress, &progress_ops, &prog, root);
+
+	u128 start = gettime();
+	ret = imgsrc_copy(&img, &progress, &d);
+	ret |= sink_close(&progress);
+	u32 msec = diff_msec(start, gettime());
+	u64 size = img.size;
+	imgsrc_close(&img);
+	if (ret) {
+		fprintf(stderr, "Converting %s failed\n", in_path);
+		return EXIT_FAILED;
+	}
+	printf("%s: %llu bytes in %u.%03u sec, %u MB/s\n", out_path, (unsigned long long)size,
+		   msec / 1000, msec % 1000, msec ? (u32)(((size >> 20) * 1000) / msec) : 0);
+	printf("MD5: %s\nSHA-1: %s\nCRC32: %08X\n", d.md5, d.sha1, d.crc32);
+
+	// a recipe keeps the MD5 of the image it was cut from
+	if (verify && !strcmp(path_ext(in_path), ".rcp")) {
+		char md5[33];
+		if (store_recipe_md5(in_path, md5) || strcmp(md5, d.md5)) {
+			printf("Doesn't match the recipe's MD5\n");
+			return mismatch(out_path, out_stem, ext);
+		}
+		printf("Matches the recipe's MD5\n");
+	}
+	// and a delta the MD5 and SHA-1 of the image it was written from
+	if (verify && !strcmp(path_ext(in_path), ".dlt")) {
+		char md5[33], sha1[41];
+		if (delta_digest(in_path, md5, sha1) || strcmp(md5, d.md5) || strcmp(sha1, d.sha1)) {
+			printf("Doesn't match the delta's MD5 and SHA-1\n");
+			return mismatch(out_path, out_stem, ext);
+		}
+		printf("Matches the delta's MD5 and SHA-1\n");
+	}
+
+	// the dumpinfo is only copied once the output is known to be the disc it describes
+	snprintf(from, sizeof(from), "%s-dumpinfo.txt", in_stem);
+	int has_info = !read_dumpinfo(from, &want, &has_crc);
+	if (!has_info) {
+		printf("No dumpinfo, not verified\n");
+	}
+	// a WBFS left blocks out, what it reads back isn't the disc the dumpinfo has
+	else if (!verify || !strcasecmp(path_ext(in_path), ".wbfs")) {
+		printf("Not verified\n");
+	}
+	else if ((want.md5[0] && strcasecmp(want.md5, d.md5)) || (want.sha1[0] && strcasecmp(want.sha1, d.sha1))
+			 || (has_crc && want.crc32 != d.crc32)) {
+		printf("Doesn't match the dumpinfo (MD5: %s)\n", want.md5[0] ? want.md5 : "none");
+		return mismatch(out_path, out_stem, ext);
+	}
+	else {
+		printf("Verified OK against the dumpinfo\n");
+	}
+
+	// the BCA and the dumpinfo go with the image, the dumpinfo is of the disc whatever the format
+	snprintf(to, sizeof(to), "%s-dumpinfo.txt", out_stem);
+	if (has_info && strcmp(from, to)) {
+		copy_file(from, to);
+	}
+	snprintf(from, sizeof(from), "%s.bca", in_stem);
+	snprintf(to, sizeof(to), "%s.bca", out_stem);
+	if (strcmp(from, to)) {
+		copy_file(from, to);
+	}
+	return EXIT_DONE;
+}
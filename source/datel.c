@@ -34,6 +34,7 @@
 #include "http.h"
 #include "main.h"
 #include "verify.h"
+#include "netdump.h"
 
 // Pointers to the file
 static char *datelDAT = NULL;
@@ -277,7 +278,7 @@ void datel_addSkip(uint64_t start, u32 length) {
 
 void dump_skips(char *mountPath, u32 crc100000) {
 	sprintf(txtbuffer, "%s%s.skp", mountPath, get_game_name());
-	FILE *fp = fopen(txtbuffer, "wb");
+	FILE *fp = dump_fopen(txtbuffer, "wb");
 	if (fp) {
 		int sk=0;
 		char SkipsInfo[100];
@@ -0,0 +1,657 @@
+/**
+ * CleanRip - delta.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * A sink stage that writes the image as its differences from a
+ * reference image, another release of the same disc. Every block of
+ * the reference gets a rolling hash when the stage opens. The image
+ * is then looked up a block at a time: where a block turns up in the
+ * reference, the match is compared back over what the window rolled
+ * past and forward byte for byte, and becomes one copy op however far
+ * it goes on. Where it stops, the same place a little further on in
+ * both is tried first, so a few changed bytes only cost themselves;
+ * otherwise the window rolls a byte at a time until a block turns up
+ * again, and what it rolled past is stored as data. A bitmap of the
+ * hashes keeps most of the rolling out of the table. The header gets
+ * the image's MD5 and SHA-1 at close so a rebuilt image can be
+ * checked. On a PC a delta can be read back as the image while its
+ * reference is next to it.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include "delta.h"
+#include "bytes.h"
+#include "imgsrc.h"
+#include "sha1.h"
+#include "md5.h"
+
+void print_gecko(const char* fmt, ...);
+
+#define DELTA_PRIME		0x100000001B3ULL	// odd, so every byte shifts the whole hash
+#define DELTA_MIX		0x9E3779B97F4A7C15ULL
+#define DELTA_FILTER_BITS	23					// a 1MB bitmap, small enough to stay in the cache
+#define DELTA_BUF_SIZE	(4*1024*1024)		// image data held to look matches up in
+#define DELTA_CMP_SIZE	0x10000				// how much of a match is compared at once
+#define DELTA_RESUME_GAP	0x1000				// how far past a mismatch the match is looked for again
+#define DELTA_RESUME_RUN	32					// bytes that have to agree for it to be found
+#define DELTA_OUT_SIZE	0x10000				// ops passed on in writes of up to this
+#define DELTA_COPY_SIZE	13
+#define DELTA_DATA_SIZE	5
+
+// A reference block by its hash; block is 0 for an empty slot, so it's one past
+typedef struct {
+	u64 hash;
+	u32 block;
+} delta_slot;
+
+typedef struct {
+	imgsrc ref;
+	const char *ref_path;
+	delta_slot *slot;
+	u32 mask;
+	u8 *filter;
+	u64 pow;			// DELTA_PRIME to the block size less one, what the byte leaving the window weighed
+	u8 *buf;			// image data not looked up yet, and the byte before it
+	u32 filled;
+	u32 scan;			// where the window starts
+	u32 lit;			// data before scan that isn't out yet starts here
+	u64 hash;
+	u32 hash_at;		// the window hash is of, or ~0
+	int copying;		// a match that may go on into the next write
+	u64 copy_ref;
+	u64 copy_len;
+	u64 copied;			// how much of the image came from the reference
+	u8 *cmp;			// reference data to compare with
+	u8 *obuf;
+	u32 ofill;
+	u64 out;			// where obuf goes in the file
+	md5_state_t md5;
+	SHA1Context sha;
+	u8 hdr[DELTA_HEADER_SIZE];
+} delta_ctx;
+
+static u64 block_hash(const u8 *p) {
+	u64 h = 0;
+
+	for (u32 i = 0; i < DELTA_BLOCK_SIZE; i++) {
+		h = h * DELTA_PRIME + p[i];
+	}
+	return h;
+}
+
+static u32 filter_bit(u64 hash) {
+	return (u32)((hash * DELTA_MIX) >> (64 - DELTA_FILTER_BITS));
+}
+
+static delta_slot *find_slot(delta_ctx *c, u64 hash) {
+	u32 i = (u32)((hash * DELTA_MIX) >> 32) & c->mask;
+
+	while (c->slot[i].block && c->slot[i].hash != hash) {
+		i = (i + 1) & c->mask;
+	}
+	return &c->slot[i];
+}
+
+// Hashes every whole block of the reference; blocks that hash alike are the same data, the first one is kept
+static int hash_reference(delta_ctx *c) {
+	u32 blocks = (u32)(c->ref.size / DELTA_BLOCK_SIZE);
+	u32 slots = 1;
+
+	while (slots < blocks * 2) {
+		slots <<= 1;
+	}
+	c->mask = slots - 1;
+	c->slot = (delta_slot*)calloc(slots, sizeof(delta_slot));
+	c->filter = (u8*)calloc(1, 1 << (DELTA_FILTER_BITS - 3));
+	if (!c->slot || !c->filter) {
+		return 1;
+	}
+	for (u32 b = 0; b < blocks; ) {
+		u32 n = blocks - b < DELTA_BUF_SIZE / DELTA_BLOCK_SIZE ? blocks - b : DELTA_BUF_SIZE / DELTA_BLOCK_SIZE;
+		if (imgsrc_read(&c->ref, c->buf, n * DELTA_BLOCK_SIZE, (u64)b * DELTA_BLOCK_SIZE, c->ref.file_sector)) {
+			return 1;
+		}
+		for (u32 i = 0; i < n; i++, b++) {
+			u64 hash = block_hash(&c->buf[i * DELTA_BLOCK_SIZE]);
+			delta_slot *slot = find_slot(c, hash);
+			if (!slot->block) {
+				slot->hash = hash;
+				slot->block = b + 1;
+				c->filter[filter_bit(hash) >> 3] |= 1 << (filter_bit(hash) & 7);
+			}
+		}
+	}
+	return 0;
+}
+
+static int pass_on(sink *s) {
+	delta_ctx *c = (delta_ctx*)s->ctx;
+
+	if (!c->ofill) {
+		return 0;
+	}
+	if (sink_write(s->next[0], c->obuf, c->ofill, c->out)) {
+		return 1;
+	}
+	c->out += c->ofill;
+	c->ofill = 0;
+	return 0;
+}
+
+static int emit(sink *s, const void *data, u32 len) {
+	delta_ctx *c = (delta_ctx*)s->ctx;
+
+	if (c->ofill + len > DELTA_OUT_SIZE && pass_on(s)) {
+		return 1;
+	}
+	if (len > DELTA_OUT_SIZE) {
+		if (sink_write(s->next[0], data, len, c->out)) {
+			return 1;
+		}
+		c->out += len;
+		return 0;
+	}
+	memcpy(&c->obuf[c->ofill], data, len);
+	c->ofill += len;
+	return 0;
+}
+
+// The data from lit up to scan
+static int emit_data(sink *s) {
+	delta_ctx *c = (delta_ctx*)s->ctx;
+	u8 op[DELTA_DATA_SIZE];
+	u32 len = c->scan - c->lit;
+
+	if (!len) {
+		return 0;
+	}
+	op[0] = DELTA_OP_DATA;
+	put_le32(&op[1], len);
+	if (emit(s, op, DELTA_DATA_SIZE) || emit(s, &c->buf[c->lit], len)) {
+		return 1;
+	}
+	c->lit = c->scan;
+	return 0;
+}
+
+static int emit_copy(sink *s) {
+	delta_ctx *c = (delta_ctx*)s->ctx;
+	u8 op[DELTA_COPY_SIZE];
+
+	c->copying = 0;
+	c->copied += c->copy_len;
+	c->lit = c->scan;
+	c->hash_at = ~0;
+	// a copy op only takes a u32, a longer match is cut up
+	while (c->copy_len) {
+		u32 n = c->copy_len > 0x80000000ULL ? 0x80000000 : (u32)c->copy_len;
+		op[0] = DELTA_OP_COPY;
+		put_le64(&op[1], c->copy_ref);
+		put_le32(&op[9], n);
+		if (emit(s, op, DELTA_COPY_SIZE)) {
+			return 1;
+		}
+		c->copy_ref += n;
+		c->copy_len -= n;
+	}
+	return 0;
+}
+
+// The window's block in the reference, if it is there; -1 if the reference can't be read
+static int lookup(delta_ctx *c, u64 *ref) {
+	u32 bit = filter_bit(c->hash);
+	delta_slot *slot;
+
+	if (!(c->filter[bit >> 3] & (1 << (bit & 7))) || !(slot = find_slot(c, c->hash))->block) {
+		return 0;
+	}
+	*ref = (u64)(slot->block - 1) * DELTA_BLOCK_SIZE;
+	if (imgsrc_read(&c->ref, c->cmp, DELTA_BLOCK_SIZE, *ref, c->ref.file_sector)) {
+		return -1;
+	}
+	return !memcmp(c->cmp, &c->buf[c->scan], DELTA_BLOCK_SIZE);
+}
+
+// A match found by its block may start before it, in what the window rolled past
+static int extend_back(delta_ctx *c, u64 *ref) {
+	while (c->scan > c->lit && *ref) {
+		u32 n = c->scan - c->lit;
+		if (n > DELTA_CMP_SIZE) {
+			n = DELTA_CMP_SIZE;
+		}
+		if (n > *ref) {
+			n = (u32)*ref;
+		}
+		if (imgsrc_read(&c->ref, c->cmp, n, *ref - n, c->ref.file_sector)) {
+			return 1;
+		}
+		u32 same = 0;
+		while (same < n && c->cmp[n - 1 - same] == c->buf[c->scan - 1 - same]) {
+			same++;
+		}
+		c->scan -= same;
+		*ref -= same;
+		if (same < n) {
+			break;
+		}
+	}
+	return 0;
+}
+
+// Where the match picks up again past the mismatch at cmp[at], 0 if not within the gap
+static u32 resume_at(delta_ctx *c, u32 at, u32 n) {
+	for (u32 k = 1; k <= DELTA_RESUME_GAP && at + k + DELTA_RESUME_RUN <= n; k++) {
+		if (c->cmp[at + k] == c->buf[c->scan + k]
+			&& !memcmp(&c->cmp[at + k], &c->buf[c->scan + k], DELTA_RESUME_RUN)) {
+			return k;
+		}
+	}
+	return 0;
+}
+
+// Goes as far through the data held as it can; with last set there is no more coming
+static int delta_scan(sink *s, int last) {
+	delta_ctx *c = (delta_ctx*)s->ctx;
+	u64 ref;
+
+	while (1) {
+		if (c->copying) {
+			// carry the match on for as long as the reference agrees
+			u64 ref_pos = c->copy_ref + c->copy_len;
+			u32 n = c->filled - c->scan;
+			if (n > DELTA_CMP_SIZE) {
+				n = DELTA_CMP_SIZE;
+			}
+			if (n > c->ref.size - ref_pos) {
+				n = (u32)(c->ref.size - ref_pos);
+			}
+			if (!n) {
+				if (c->filled == c->scan && !last) {
+					return 0;
+				}
+				if (emit_copy(s)) {
+					return 1;
+				}
+				continue;
+			}
+			if (imgsrc_read(&c->ref, c->cmp, n, ref_pos, c->ref.file_sector)) {
+				return 1;
+			}
+			u32 same = memcmp(c->cmp, &c->buf[c->scan], n) ? 0 : n;
+			while (same < n && c->cmp[same] == c->buf[c->scan + same]) {
+				same++;
+			}
+			c->copy_len += same;
+			c->scan += same;
+			if (same == n) {
+				continue;
+			}
+			// a few bytes that differ, a flipped bit or a patched word, and the match goes on past them
+			u32 k = resume_at(c, same, n);
+			u32 past = n - same;
+			if (!k && past < DELTA_RESUME_GAP + DELTA_RESUME_RUN) {
+				u32 held = c->filled - c->scan;
+				if (past < held && past < c->ref.size - ref_pos - same) {
+					// only cmp's size cut the look short, compare again from the mismatch
+					continue;
+				}
+				if (past == held && !last) {
+					return 0;
+				}
+			}
+			u64 at = c->copy_ref + c->copy_len;
+			if (emit_copy(s)) {
+				return 1;
+			}
+			if (k) {
+				c->scan += k;
+				if (emit_data(s)) {
+					return 1;
+				}
+				c->copying = 1;
+				c->copy_ref = at + k;
+				c->copy_len = 0;
+			}
+			continue;
+		}
+		if (c->filled - c->scan < DELTA_BLOCK_SIZE) {
+			// a tail shorter than a block can only be data
+			if (last) {
+				c->scan = c->filled;
+				return emit_data(s);
+			}
+			return 0;
+		}
+		if (c->scan && c->hash_at == c->scan - 1) {
+			c->hash = (c->hash - c->buf[c->scan - 1] * c->pow) * DELTA_PRIME + c->buf[c->scan + DELTA_BLOCK_SIZE - 1];
+		}
+		else if (c->hash_at != c->scan) {
+			c->hash = block_hash(&c->buf[c->scan]);
+		}
+		c->hash_at = c->scan;
+		int found = lookup(c, &ref);
+		if (found < 0) {
+			return 1;
+		}
+		if (found) {
+			u32 end = c->scan + DELTA_BLOCK_SIZE;
+			if (extend_back(c, &ref) || emit_data(s)) {
+				return 1;
+			}
+			c->copying = 1;
+			c->copy_ref = ref;
+			c->copy_len = end - c->scan;
+			c->scan = end;
+			continue;
+		}
+		c->scan++;
+	}
+}
+
+static int delta_write(sink *s, const void *data, u32 len, u64 offset) {
+	delta_ctx *c = (delta_ctx*)s->ctx;
+	const u8 *p = (const u8*)data;
+
+	// ops follow the image in order
+	if (offset != s->pos) {
+		return 1;
+	}
+	s->pos += len;
+	md5_append(&c->md5, (const md5_byte_t *)data, len);
+	SHA1Input(&c->sha, (const unsigned char *)data, len);
+	while (len) {
+		if (c->filled == DELTA_BUF_SIZE) {
+			// what the window has passed goes out as data, the byte before it stays for the rolling hash
+			if (!c->copying && emit_data(s)) {
+				return 1;
+			}
+			u32 keep = c->scan ? c->scan - 1 : 0;
+			memmove(c->buf, &c->buf[keep], c->filled - keep);
+			c->filled -= keep;
+			c->scan -= keep;
+			c->lit = c->scan;
+			c->hash_at -= c->hash_at == ~0U ? 0 : keep;
+		}
+		u32 n = DELTA_BUF_SIZE - c->filled;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(&c->buf[c->filled], p, n);
+		c->filled += n;
+		p += n;
+		len -= n;
+		if (delta_scan(s, 0)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int delta_flush(sink *s) {
+	return sink_flush(s->next[0]);
+}
+
+static int delta_header(sink *s, int done) {
+	delta_ctx *c = (delta_ctx*)s->ctx;
+	md5_byte_t md5[16];
+	const char *name = strrchr(c->ref_path, '/');
+
+	memset(c->hdr, 0, DELTA_HEADER_SIZE);
+	memcpy(c->hdr, DELTA_MAGIC, 4);
+	put_le32(&c->hdr[4], DELTA_VERSION);
+	put_le32(&c->hdr[8], DELTA_BLOCK_SIZE);
+	put_le64(&c->hdr[24], c->ref.size);
+	// the reader looks for the reference next to the delta under this name
+	snprintf((char*)&c->hdr[DELTA_NAME_OFFSET], DELTA_NAME_MAX, "%s", name ? name + 1 : c->ref_path);
+	if (done) {
+		put_le64(&c->hdr[16], s->pos);
+		md5_finish(&c->md5, md5);
+		memcpy(&c->hdr[32], md5, 16);
+		if (SHA1Result(&c->sha)) {
+			for (int i = 0; i < 5; i++) {
+				c->hdr[48 + i * 4] = c->sha.Message_Digest[i] >> 24;
+				c->hdr[48 + i * 4 + 1] = (c->sha.Message_Digest[i] >> 16) & 0xFF;
+				c->hdr[48 + i * 4 + 2] = (c->sha.Message_Digest[i] >> 8) & 0xFF;
+				c->hdr[48 + i * 4 + 3] = c->sha.Message_Digest[i] & 0xFF;
+			}
+		}
+	}
+	return sink_write(s->next[0], c->hdr, DELTA_HEADER_SIZE, 0);
+}
+
+static void free_ctx(delta_ctx *c) {
+	imgsrc_close(&c->ref);
+	free(c->slot);
+	free(c->filter);
+	free(c->buf);
+	free(c->cmp);
+	free(c->obuf);
+	free(c);
+}
+
+static int delta_close(sink *s) {
+	delta_ctx *c = (delta_ctx*)s->ctx;
+	u8 end = DELTA_OP_END;
+	int ret = 0;
+
+	if (c) {
+		ret = delta_scan(s, 1) || emit(s, &end, 1) || pass_on(s) || delta_header(s, 1);
+		print_gecko("Delta: %llu of %llu bytes from the reference\r\n",
+					(unsigned long long)c->copied, (unsigned long long)s->pos);
+		free_ctx(c);
+		s->ctx = NULL;
+	}
+	return sink_close(s->next[0]) | ret;
+}
+
+static const sink_ops delta_ops = { delta_write, delta_flush, delta_close };
+
+// next is the delta file; the reference is hashed through before this returns
+int sink_delta(sink *s, sink *next, const char *reference) {
+	delta_ctx *c = (delta_ctx*)calloc(1, sizeof(delta_ctx));
+
+	if (!c) {
+		return 1;
+	}
+	c->ref_path = reference;
+	c->hash_at = ~0;
+	c->pow = 1;
+	for (int i = 1; i < DELTA_BLOCK_SIZE; i++) {
+		c->pow *= DELTA_PRIME;
+	}
+	md5_init(&c->md5);
+	SHA1Reset(&c->sha);
+	c->buf = (u8*)malloc(DELTA_BUF_SIZE);
+	c->cmp = (u8*)malloc(DELTA_CMP_SIZE);
+	c->obuf = (u8*)malloc(DELTA_OUT_SIZE);
+	if (!c->buf || !c->cmp || !c->obuf || imgsrc_open(&c->ref, reference) || hash_reference(c)) {
+		free_ctx(c);
+		return 1;
+	}
+	sink_stage(s, &delta_ops, c, next);
+	// sizes and checksums go in once the dump is done
+	c->out = DELTA_HEADER_SIZE;
+	if (delta_header(s, 0)) {
+		free_ctx(c);
+		s->ctx = NULL;
+		return 1;
+	}
+	return 0;
+}
+
+#if defined(__CYGWIN__) || defined(__linux__)
+typedef struct {
+	u64 start;			// in the image
+	u64 from;			// in the reference, or in the delta for data
+	u32 len;
+	int copy;
+} delta_op;
+
+typedef struct {
+	FILE *fp;
+	imgsrc ref;
+	u32 count;
+	delta_op *op;
+} delta_reader;
+
+static int delta_block(archive *a, u32 block, u8 *dst, u8 *scratch) {
+	delta_reader *r = (delta_reader*)a->ctx;
+	u64 pos = (u64)block * a->block_size;
+	u64 end = pos + a->block_size > a->size ? a->size : pos + a->block_size;
+	u32 lo = 0, hi = r->count;
+
+	// the last op that starts at or before pos
+	while (hi - lo > 1) {
+		u32 mid = (lo + hi) / 2;
+		if (r->op[mid].start <= pos) {
+			lo = mid;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	memset(dst + (end - pos), 0, a->block_size - (u32)(end - pos));
+	for (u32 i = lo; pos < end; i++) {
+		delta_op *op = &r->op[i];
+		u32 skip = (u32)(pos - op->start);
+		u32 n = op->len - skip < end - pos ? op->len - skip : (u32)(end - pos);
+		if (op->copy ? imgsrc_read(&r->ref, dst, n, op->from + skip, r->ref.file_sector)
+					 : archive_pread(r->fp, dst, n, op->from + skip)) {
+			return 1;
+		}
+		dst += n;
+		pos += n;
+	}
+	return 0;
+}
+
+static void delta_reader_close(archive *a) {
+	delta_reader *r = (delta_reader*)a->ctx;
+
+	imgsrc_close(&r->ref);
+	fclose(r->fp);
+	free(r->op);
+	free(r);
+}
+
+static int read_delta_header(FILE *fp, u8 *hdr) {
+	return archive_pread(fp, hdr, DELTA_HEADER_SIZE, 0) || memcmp(hdr, DELTA_MAGIC, 4)
+		|| get_le32(&hdr[4]) != DELTA_VERSION;
+}
+
+// The ops are read through once to find where each one's part of the image is
+static int read_ops(delta_reader *r, u64 size) {
+	u8 op[DELTA_COPY_SIZE];
+	u64 at = DELTA_HEADER_SIZE, pos = 0;
+	u32 room = 0;
+
+	while (1) {
+		if (archive_pread(r->fp, op, 1, at)) {
+			return 1;
+		}
+		if (op[0] == DELTA_OP_END) {
+			return pos != size;
+		}
+		if (r->count == room) {
+			room = room ? room * 2 : 4096;
+			delta_op *more = (delta_op*)realloc(r->op, room * sizeof(delta_op));
+			if (!more) {
+				return 1;
+			}
+			r->op = more;
+		}
+		delta_op *d = &r->op[r->count++];
+		d->start = pos;
+		if (op[0] == DELTA_OP_COPY) {
+			if (archive_pread(r->fp, op, DELTA_COPY_SIZE, at)) {
+				return 1;
+			}
+			d->copy = 1;
+			d->from = get_le64(&op[1]);
+			d->len = get_le32(&op[9]);
+			at += DELTA_COPY_SIZE;
+		}
+		else if (op[0] == DELTA_OP_DATA) {
+			if (archive_pread(r->fp, op, DELTA_DATA_SIZE, at)) {
+				return 1;
+			}
+			d->copy = 0;
+			d->len = get_le32(&op[1]);
+			d->from = at + DELTA_DATA_SIZE;
+			at = d->from + d->len;
+		}
+		else {
+			return 1;
+		}
+		pos += d->len;
+	}
+}
+
+// The reference is looked for next to the delta under the name it was written with
+int delta_archive(archive *a, const char *path) {
+	u8 hdr[DELTA_HEADER_SIZE];
+	char ref_path[IMGSRC_PATH_MAX];
+	delta_reader *r = (delta_reader*)calloc(1, sizeof(delta_reader));
+
+	memset(a, 0, sizeof(archive));
+	if (!r || !(r->fp = fopen(path, "rb"))) {
+		free(r);
+		return -1;
+	}
+	a->ctx = r;
+	a->close = delta_reader_close;
+	a->block = delta_block;
+	if (read_delta_header(r->fp, hdr)) {
+		delta_reader_close(a);
+		return -1;
+	}
+	hdr[DELTA_NAME_OFFSET + DELTA_NAME_MAX - 1] = 0;
+	const char *slash = strrchr(path, '/');
+	snprintf(ref_path, sizeof(ref_path), "%.*s%s", slash ? (int)(slash + 1 - path) : 0, path,
+			 (char*)&hdr[DELTA_NAME_OFFSET]);
+	a->size = get_le64(&hdr[16]);
+	if (imgsrc_open(&r->ref, ref_path) || r->ref.size != get_le64(&hdr[24]) || read_ops(r, a->size)) {
+		delta_reader_close(a);
+		return -1;
+	}
+	a->size_known = 1;
+	a->block_size = DELTA_READ_BLOCK;
+	a->blocks = (u32)((a->size + DELTA_READ_BLOCK - 1) / DELTA_READ_BLOCK);
+	return 0;
+}
+
+// The MD5 and SHA-1 of the image the delta was written from, as the dumpinfo has them
+int delta_digest(const char *path, char *md5, char *sha1) {
+	u8 hdr[DELTA_HEADER_SIZE];
+	FILE *fp = fopen(path, "rb");
+
+	if (!fp) {
+		return 1;
+	}
+	int ret = read_delta_header(fp, hdr);
+	fclose(fp);
+	for (int i = 0; !ret && i < 16; i++) {
+		sprintf(&md5[i * 2], "%02x", hdr[32 + i]);
+	}
+	for (int i = 0; !ret && i < 20; i++) {
+		sprintf(&sha1[i * 2], "%02x", hdr[48 + i]);
+	}
+	return ret;
+}
+#endif
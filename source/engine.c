@@ -0,0 +1,242 @@
+/**
+ * CleanRip - engine.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * The per block part of a dump, shared by the console and host
+ * builds: reading with the retries and recovery the disc profile
+ * calls for, and the checksums. The profile and options pick the
+ * functions once when the dump starts, so the block loop doesn't
+ * test them again for every block.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#ifndef __CYGWIN__
+#include <ogc/lwp_watchdog.h>
+#endif
+#include "engine.h"
+#include "crc32.h"
+
+void print_gecko(const char* fmt, ...);
+
+typedef struct {
+	const char *name;
+	int (*read)(dump_engine *e, u8 *dst, u32 len, u64 offset);
+	int (*recover)(dump_engine *e, u8 *dst, u32 lba, u32 sectors, int ret);
+	void (*check)(dump_engine *e, u32 lba, u32 len);
+} dump_profile;
+
+/* reads */
+static int read_once(dump_engine *e, u8 *dst, u32 len, u64 offset) {
+	return e->ops->read(dst, len, offset, e->known_datel);
+}
+
+// Audio CDs: a scratch is often read fine on the next go
+static int read_retry(dump_engine *e, u8 *dst, u32 len, u64 offset) {
+	int ret = 1;
+	for (int attempt = 0; attempt < e->attempts; attempt++) {
+		e->retries += (attempt > 0);
+		ret = e->ops->read(dst, len, offset, e->known_datel);
+		if (ret == 0) {
+			break;
+		}
+		usleep(1000 + (attempt * 500));
+	}
+	return ret;
+}
+
+// Same read split into smaller requests, for drives that refuse a larger transfer
+static int read_pieces(dump_engine *e, u8 *dst, u32 len, u64 offset, u32 piece) {
+	for (u32 done = 0; done < len; done += piece) {
+		u32 n = (len - done < piece) ? (len - done) : piece;
+		int ret = e->read(e, dst + done, n, offset + done);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+	return 0;
+}
+
+/* what happens to a block that couldn't be read */
+static int recover_fail(dump_engine *e, u8 *dst, u32 lba, u32 sectors, int ret) {
+	return ret;
+}
+
+static void log_audio_errors(dump_engine *e, u32 lba) {
+	// Keep dumping despite sporadic read errors; report every 64 failed sectors.
+	if ((e->sectors_failed & 63) == 1) {
+		print_gecko("Audio CD read errors=%u sectors (last LBA %u, err=%08X)\r\n",
+			e->sectors_failed, lba, e->ops->error());
+	}
+}
+
+// zero-fill the whole block
+static int recover_zero(dump_engine *e, u8 *dst, u32 lba, u32 sectors, int ret) {
+	e->sectors_failed += sectors;
+	memset(dst, 0, sectors * e->sector_size);
+	if (e->badfp) {
+		fprintf(e->badfp, "%u,%u\n", lba, sectors);
+	}
+	log_audio_errors(e, lba);
+	return 0;
+}
+
+// read the block again a sector at a time, only what still fails is zero-filled
+static int recover_sectors(dump_engine *e, u8 *dst, u32 lba, u32 sectors, int ret) {
+	u32 bad_run_start = 0;
+	u32 bad_run_len = 0;
+
+	if (sectors == 1) {
+		return recover_zero(e, dst, lba, sectors, ret);
+	}
+	for (u32 s = 0; s < sectors; s++) {
+		u8 *sector = dst + (s * e->sector_size);
+		e->retries++;
+		if (read_retry(e, sector, e->sector_size, ((u64)lba + s) * e->sector_size) != 0) {
+			e->sectors_failed++;
+			memset(sector, 0, e->sector_size);
+			if (bad_run_len == 0) {
+				bad_run_start = lba + s;
+			}
+			bad_run_len++;
+		}
+		else if (bad_run_len > 0) {
+			if (e->badfp) {
+				fprintf(e->badfp, "%u,%u\n", bad_run_start, bad_run_len);
+			}
+			bad_run_len = 0;
+		}
+	}
+	if (bad_run_len > 0 && e->badfp) {
+		fprintf(e->badfp, "%u,%u\n", bad_run_start, bad_run_len);
+	}
+	log_audio_errors(e, lba);
+	return 0;
+}
+
+/* checksums */
+static void hash_crc(dump_engine *e, const u8 *data, u32 len) {
+	e->crc32 = Crc32_ComputeBuf(e->crc32, data, len);
+}
+
+static void hash_all(dump_engine *e, const u8 *data, u32 len) {
+	md5_append(&e->md5, (const md5_byte_t *)data, len);
+	SHA1Input(&e->sha, (const unsigned char *)data, len);
+	e->crc32 = Crc32_ComputeBuf(e->crc32, data, len);
+}
+
+/* after a block is accounted for */
+static void check_none(dump_engine *e, u32 lba, u32 len) {
+}
+
+// the CRC of the first MB tells which Datel disc it is, and whether its skips are known
+static void check_datel(dump_engine *e, u32 lba, u32 len) {
+	if (((u64)lba * e->sector_size) + len == DATEL_CHECK_OFFSET) {
+		e->crc100000 = e->crc32;
+		u64 wait_start = gettime();
+		e->known_datel = e->ops->datel_check(e->crc100000);
+		e->paused += (gettime() - wait_start);
+	}
+}
+
+static const dump_profile profiles[PROFILE_COUNT] = {
+	{ "GameCube",	read_once,	recover_fail,	check_none },
+	{ "Wii",		read_once,	recover_fail,	check_none },
+	{ "Datel",		read_once,	recover_fail,	check_datel },
+	{ "DVD-Video",	read_once,	recover_fail,	check_none },
+	{ "Audio CD",	read_retry,	recover_zero,	check_none },
+};
+
+const char *engine_profile_name(int profile) {
+	return profiles[profile].name;
+}
+
+void engine_init(dump_engine *e, const engine_ops *ops, int profile, u32 sector_size, int checksums) {
+	memset(e, 0, sizeof(dump_engine));
+	e->ops = ops;
+	e->profile = profile;
+	e->sector_size = sector_size;
+	e->checksums = checksums;
+	e->attempts = 1;
+	e->read = profiles[profile].read;
+	e->recover = profiles[profile].recover;
+	e->check = profiles[profile].check;
+	e->hash = checksums ? hash_all : hash_crc;
+	md5_init(&e->md5);
+	SHA1Reset(&e->sha);
+}
+
+void engine_set_audio(dump_engine *e, int attempts, int sector_recovery, FILE *badfp) {
+	e->attempts = attempts;
+	e->badfp = badfp;
+	if (sector_recovery) {
+		e->recover = recover_sectors;
+	}
+}
+
+// Reads a block, 0 on success or the drive's error if it can't be dumped
+int engine_read(dump_engine *e, tuner *t, u8 *dst, u32 lba, u32 sectors) {
+	u32 len = sectors * e->sector_size;
+	u64 offset = (u64)lba * e->sector_size;
+
+	e->sectors += sectors;
+	int ret = e->read(e, dst, len, offset);
+	int read_error = (ret != 0);
+	if (ret != 0 && tuner_probing(t) && len > tuner_base_size(t)) {
+		// the candidate may simply be too big for this drive, don't fail the dump over it
+		e->retries++;
+		ret = read_pieces(e, dst, len, offset, tuner_base_size(t));
+	}
+	tuner_update(t, len, read_error);
+	if (ret != 0) {
+		ret = e->recover(e, dst, lba, sectors, ret);
+	}
+	return ret;
+}
+
+// Adds a block that was read to the checksums, in disc order
+void engine_account(dump_engine *e, const u8 *data, u32 lba, u32 sectors) {
+	u32 len = sectors * e->sector_size;
+	e->hash(e, data, len);
+	e->check(e, lba, len);
+}
+
+// Nothing at all could be read (only audio dumps carry on past errors)
+int engine_all_failed(dump_engine *e) {
+	return e->sectors && e->sectors_failed == e->sectors;
+}
+
+// MD5 and SHA-1 as hex, empty without checksums
+void engine_finish(dump_engine *e, char *md5, char *sha1) {
+	md5_byte_t digest[16];
+
+	md5[0] = 0;
+	sha1[0] = 0;
+	if (!e->checksums) {
+		return;
+	}
+	md5_finish(&e->md5, digest);
+	int i; for (i=0; i<16; i++) sprintf(&md5[i*2],"%02x",digest[i]);
+	if(SHA1Result(&e->sha)) {
+		for (i=0; i<5; i++) sprintf(&sha1[i*8],"%08x",e->sha.Message_Digest[i]);
+	}
+	else {
+		sprintf(sha1, "Error computing SHA-1");
+	}
+}
@@ -0,0 +1,215 @@
+/**
+ * CleanRip - finish.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * Finishes dumps in the background. This covers verifying against
+ * the DATs, renaming the parts, and writing the dumpinfo and CUE.
+ * Meanwhile the next disc can be put in and identified. Every queued
+ * dump is first written to a small journal next to the image. A
+ * journal still there on the next start means the app quit before that
+ * dump was finished, so it is queued again. The steps only rename files
+ * that are there and rewrite their own output, so running one twice is
+ * harmless.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include "finish.h"
+#include "netdump.h"
+
+// above the UI loops, which spin on the pads instead of sleeping
+#define FINISH_PRIO 129
+#define FINISH_STACK (32*1024)	// file and DAT work goes deeper than the default
+
+static finish_task tasks[FINISH_MAX];
+static mqbox_t freeq, taskq;
+static lwp_t worker;
+static finish_fn run_task = NULL;
+static vu32 pending = 0;
+static char last_result[128];
+
+static void* finish_thread(void *arg) {
+	finish_task *task;
+
+	while (MQ_Receive(taskq, (mqmsg_t*)&task, MQ_MSG_BLOCK)==TRUE && task) {
+		run_task(task);
+		if (task->journal[0]) {
+			remove(task->journal);
+		}
+		snprintf(last_result, sizeof(last_result), "%s", task->result);
+		task->queued = 0;
+		MQ_Send(freeq, (mqmsg_t)task, MQ_MSG_BLOCK);
+		__sync_sub_and_fetch(&pending, 1);
+	}
+	return NULL;
+}
+
+void finish_init(finish_fn run) {
+	run_task = run;
+	MQ_Init(&freeq, FINISH_MAX);
+	MQ_Init(&taskq, FINISH_MAX);
+	for (int i = 0; i < FINISH_MAX; i++) {
+		MQ_Send(freeq, (mqmsg_t)&tasks[i], MQ_MSG_BLOCK);
+	}
+	LWP_CreateThread(&worker, finish_thread, NULL, NULL, FINISH_STACK, FINISH_PRIO);
+}
+
+// Waits for a free task if FINISH_MAX dumps are still being finished
+finish_task *finish_new() {
+	finish_task *task;
+	MQ_Receive(freeq, (mqmsg_t*)&task, MQ_MSG_BLOCK);
+	memset(task, 0, sizeof(finish_task));
+	return task;
+}
+
+static int write_journal(finish_task *task) {
+	char temp[sizeof(task->journal) + 8];
+
+	sprintf(temp, "%s.tmp", task->journal);
+	FILE *fp = fopen(temp, "wb");
+	if (!fp) {
+		return -1;
+	}
+	fprintf(fp, "mount %s\ngame %s\ninternal %s\next %s\nmd5 %s\nsha1 %s\n", task->mount, task->game,
+			task->internal, task->ext, task->md5, task->sha1);
+	fprintf(fp, "disc_type %i\nparts %i\nchecksums %i\naudio %i\n", task->disc_type, task->parts,
+			task->checksums, task->audio);
+	fprintf(fp, "crc32 %08X\ncrc100000 %08X\nversion %u\nseconds %u\ndumped_at %llu\n", task->crc32,
+			task->crc100000, task->version, task->seconds, (unsigned long long)task->dumped_at);
+	if (fclose(fp) != 0) {
+		remove(temp);
+		return -1;
+	}
+	// a half written journal is never mistaken for a whole one
+	remove(task->journal);
+	return rename(temp, task->journal);
+}
+
+static int read_journal(finish_task *task, const char *path) {
+	char line[640];
+	char key[32];
+	char text[576];
+	u32 value;
+
+	FILE *fp = fopen(path, "rb");
+	if (!fp) {
+		return -1;
+	}
+	snprintf(task->journal, sizeof(task->journal), "%s", path);
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "%31s", key) != 1) {
+			continue;
+		}
+		text[0] = 0;
+		sscanf(line, "%*s %575[^\r\n]", text);
+		if (!strcmp(key, "mount")) snprintf(task->mount, sizeof(task->mount), "%s", text);
+		else if (!strcmp(key, "game")) snprintf(task->game, sizeof(task->game), "%s", text);
+		else if (!strcmp(key, "internal")) snprintf(task->internal, sizeof(task->internal), "%s", text);
+		else if (!strcmp(key, "ext")) snprintf(task->ext, sizeof(task->ext), "%s", text);
+		else if (!strcmp(key, "md5")) snprintf(task->md5, sizeof(task->md5), "%s", text);
+		else if (!strcmp(key, "sha1")) snprintf(task->sha1, sizeof(task->sha1), "%s", text);
+		else if (!strcmp(key, "crc32") && sscanf(text, "%x", &value) == 1) task->crc32 = value;
+		else if (!strcmp(key, "crc100000") && sscanf(text, "%x", &value) == 1) task->crc100000 = value;
+		else if (!strcmp(key, "dumped_at")) task->dumped_at = strtoull(text, NULL, 10);
+		else if (sscanf(text, "%u", &value) == 1) {
+			if (!strcmp(key, "disc_type")) task->disc_type = value;
+			else if (!strcmp(key, "parts")) task->parts = value;
+			else if (!strcmp(key, "checksums")) task->checksums = value;
+			else if (!strcmp(key, "audio")) task->audio = value;
+			else if (!strcmp(key, "version")) task->version = value;
+			else if (!strcmp(key, "seconds")) task->seconds = value;
+		}
+	}
+	fclose(fp);
+	return task->mount[0] && task->game[0] ? 0 : -1;
+}
+
+void finish_queue(finish_task *task) {
+	// a dump on the receiver can't be looked for again after a restart
+	if (!task->readonly && !netdump_name(task->mount)) {
+		snprintf(task->journal, sizeof(task->journal), "%s%s%s", task->mount, task->game, FINISH_EXT);
+		if (write_journal(task)) {
+			// still finish it, it just won't survive a crash
+			task->journal[0] = 0;
+		}
+	}
+	task->queued = 1;
+	__sync_add_and_fetch(&pending, 1);
+	MQ_Send(taskq, (mqmsg_t)task, MQ_MSG_BLOCK);
+}
+
+int finish_pending() {
+	return pending;
+}
+
+// A new dump of the same disc must not be renamed out from under itself
+int finish_pending_game(const char *game) {
+	for (int i = 0; i < FINISH_MAX; i++) {
+		if (tasks[i].queued && !strcmp(tasks[i].game, game)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void finish_wait() {
+	while (pending) {
+		usleep(10000);
+	}
+}
+
+// Queues the dumps an earlier run didn't get to finish, nothing may be queued yet
+int finish_resume(const char *mount) {
+	char path[576];
+	int count = 0;
+	int ext_len = strlen(FINISH_EXT);
+
+	DIR *dir = opendir(mount);
+	if (!dir) {
+		return 0;
+	}
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		int len = strlen(entry->d_name);
+		if (len <= ext_len || strcmp(entry->d_name + len - ext_len, FINISH_EXT)) {
+			continue;
+		}
+		finish_task *task = finish_new();
+		snprintf(path, sizeof(path), "%s%s", mount, entry->d_name);
+		if (read_journal(task, path)) {
+			remove(path);
+			MQ_Send(freeq, (mqmsg_t)task, MQ_MSG_BLOCK);
+			continue;
+		}
+		// the device may be mounted somewhere else this time
+		snprintf(task->mount, sizeof(task->mount), "%s", mount);
+		task->queued = 1;
+		__sync_add_and_fetch(&pending, 1);
+		MQ_Send(taskq, (mqmsg_t)task, MQ_MSG_BLOCK);
+		count++;
+	}
+	closedir(dir);
+	return count;
+}
+
+const char *finish_last_result() {
+	return last_result;
+}
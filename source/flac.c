@@ -0,0 +1,293 @@
+/**
+ * CleanRip - flac.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * Just enough of a FLAC encoder for CD audio in a CHD: 16-bit stereo
+ * at 44.1kHz cut into fixed size blocks, each one a frame with no
+ * stream header in front. Every channel is tried as it is, as a
+ * constant and with each of the fixed predictors, the residual is
+ * Rice coded in as many partitions as pay off, and the frame keeps
+ * whichever pair of left, right, mid and side comes out smallest. No
+ * LPC, so it is a little bigger than the reference encoder's output
+ * but cheap enough for the console.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <string.h>
+#include "flac.h"
+
+#define FLAC_CONSTANT		0
+#define FLAC_VERBATIM		1
+#define FLAC_FIXED			8		// plus the order
+#define FLAC_MAX_ORDER		4
+#define FLAC_MAX_RICE		14		// 15 is the escape code
+
+typedef struct {
+	u8 *p;
+	u8 *end;
+	u64 acc;
+	int bits;			// in acc, not written yet
+	int over;			// ran out of room
+} bit_writer;
+
+typedef struct {
+	int type;
+	int order;
+	int porder;			// the residual is in 1 << porder partitions
+	u8 k[1 << FLAC_MAX_PARTITION_ORDER];
+	u64 bits;
+} subframe;
+
+// Up to 32 bits, first bit first
+static void put_bits(bit_writer *b, u32 value, int n) {
+	b->acc = (b->acc << n) | (n < 32 ? value & ((1U << n) - 1) : value);
+	b->bits += n;
+	while (b->bits >= 8) {
+		b->bits -= 8;
+		if (b->p == b->end) {
+			b->over = 1;
+		}
+		else {
+			*b->p++ = (u8)(b->acc >> b->bits);
+		}
+	}
+}
+
+static void put_zeros(bit_writer *b, u32 n) {
+	for (; n > 24; n -= 24) {
+		put_bits(b, 0, 24);
+	}
+	put_bits(b, 0, n);
+}
+
+static void put_utf8(bit_writer *b, u32 value) {
+	if (value < 0x80) {
+		put_bits(b, value, 8);
+		return;
+	}
+	int extra = value < 0x800 ? 1 : (value < 0x10000 ? 2 : (value < 0x200000 ? 3 : (value < 0x4000000 ? 4 : 5)));
+	put_bits(b, ((0xFF80 >> extra) & 0xFF) | (value >> (6 * extra)), 8);
+	for (int i = extra - 1; i >= 0; i--) {
+		put_bits(b, 0x80 | ((value >> (6 * i)) & 0x3F), 8);
+	}
+}
+
+static void put_rice(bit_writer *b, u32 value, int k) {
+	put_zeros(b, value >> k);
+	put_bits(b, (1U << k) | (value & ((1U << k) - 1)), k + 1);
+}
+
+static u8 crc8(const u8 *p, u32 len) {
+	u8 crc = 0;
+	while (len--) {
+		crc ^= *p++;
+		for (int i = 0; i < 8; i++) {
+			crc = (crc & 0x80) ? (u8)((crc << 1) ^ 0x07) : (u8)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+static u16 crc16(const u8 *p, u32 len) {
+	u16 crc = 0;
+	while (len--) {
+		crc ^= *p++ << 8;
+		for (int i = 0; i < 8; i++) {
+			crc = (crc & 0x8000) ? (u16)((crc << 1) ^ 0x8005) : (u16)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+static s32 residual(const s32 *x, u32 i, int order) {
+	switch (order) {
+	case 0:
+		return x[i];
+	case 1:
+		return x[i] - x[i - 1];
+	case 2:
+		return x[i] - 2 * x[i - 1] + x[i - 2];
+	case 3:
+		return x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3];
+	default:
+		return x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4];
+	}
+}
+
+// Rice codes take the sign in the lowest bit
+static u32 fold(s32 value) {
+	return ((u32)value << 1) ^ (u32)(value >> 31);
+}
+
+// The best parameter for a partition, from the sum of its folded residuals
+static u64 rice_bits(u64 sum, u32 n, u8 *k) {
+	u64 best = ~0ULL;
+	for (int j = 0; j <= FLAC_MAX_RICE; j++) {
+		u64 bits = (u64)n * (j + 1) + (sum >> j);
+		if (bits < best) {
+			best = bits;
+			*k = j;
+		}
+	}
+	return best;
+}
+
+// Sizes up a fixed predictor, with the partitioning that suits it
+static void size_fixed(const s32 *x, u32 n, int bps, int order, subframe *sf) {
+	u64 sum[1 << FLAC_MAX_PARTITION_ORDER];
+	u8 k[1 << FLAC_MAX_PARTITION_ORDER];
+	int max_porder = 0;
+
+	while (max_porder < FLAC_MAX_PARTITION_ORDER && !(n & ((2U << max_porder) - 1))
+		&& (n >> (max_porder + 1)) > (u32)order) {
+		max_porder++;
+	}
+	u32 psize = n >> max_porder;
+	for (int p = 0; p < (1 << max_porder); p++) {
+		sum[p] = 0;
+		for (u32 i = p ? p * psize : (u32)order; i < (p + 1) * psize; i++) {
+			sum[p] += fold(residual(x, i, order));
+		}
+	}
+	sf->bits = ~0ULL;
+	for (int porder = max_porder; porder >= 0; porder--) {
+		int parts = 1 << porder;
+		u64 bits = 0;
+		for (int p = 0; p < parts; p++) {
+			u32 count = (n >> porder) - (p ? 0 : order);
+			bits += 4 + rice_bits(sum[p], count, &k[p]);
+		}
+		if (bits < sf->bits) {
+			sf->bits = bits;
+			sf->porder = porder;
+			memcpy(sf->k, k, parts);
+		}
+		// the sums for the next order down
+		for (int p = 0; p < parts / 2; p++) {
+			sum[p] = sum[p * 2] + sum[p * 2 + 1];
+		}
+	}
+	sf->type = FLAC_FIXED;
+	sf->order = order;
+	sf->bits += 8 + order * bps + 6;
+}
+
+static void choose_subframe(const s32 *x, u32 n, int bps, subframe *sf) {
+	u32 i = 1;
+	while (i < n && x[i] == x[0]) {
+		i++;
+	}
+	if (i == n) {
+		sf->type = FLAC_CONSTANT;
+		sf->bits = 8 + bps;
+		return;
+	}
+	sf->type = FLAC_VERBATIM;
+	sf->bits = 8 + (u64)n * bps;
+	for (int order = 0; order <= FLAC_MAX_ORDER && (u32)order < n; order++) {
+		subframe fixed;
+		size_fixed(x, n, bps, order, &fixed);
+		if (fixed.bits < sf->bits) {
+			*sf = fixed;
+		}
+	}
+}
+
+static void put_subframe(bit_writer *b, const s32 *x, u32 n, int bps, const subframe *sf) {
+	if (sf->type == FLAC_CONSTANT) {
+		put_bits(b, FLAC_CONSTANT << 1, 8);
+		put_bits(b, x[0], bps);
+		return;
+	}
+	if (sf->type == FLAC_VERBATIM) {
+		put_bits(b, FLAC_VERBATIM << 1, 8);
+		for (u32 i = 0; i < n; i++) {
+			put_bits(b, x[i], bps);
+		}
+		return;
+	}
+	put_bits(b, (FLAC_FIXED + sf->order) << 1, 8);
+	for (int i = 0; i < sf->order; i++) {
+		put_bits(b, x[i], bps);
+	}
+	put_bits(b, 0, 2);				// Rice with 4-bit parameters
+	put_bits(b, sf->porder, 4);
+	u32 psize = n >> sf->porder;
+	for (int p = 0; p < (1 << sf->porder); p++) {
+		put_bits(b, sf->k[p], 4);
+		for (u32 i = p ? p * psize : (u32)sf->order; i < (p + 1) * psize; i++) {
+			put_rice(b, fold(residual(x, i, sf->order)), sf->k[p]);
+		}
+	}
+}
+
+static void put_frame(flac_enc *e, bit_writer *b, const u8 *pcm, u32 n, u32 frame) {
+	// first, second and the channel assignment that says so
+	static const int pairs[4][3] = { { 0, 1, 1 }, { 0, 3, 8 }, { 3, 1, 9 }, { 2, 3, 10 } };
+	subframe sf[4];
+	u8 *start = b->p;
+	int best = 0;
+
+	for (u32 i = 0; i < n; i++) {
+		s32 left = (s16)((pcm[i * 4] << 8) | pcm[i * 4 + 1]);
+		s32 right = (s16)((pcm[i * 4 + 2] << 8) | pcm[i * 4 + 3]);
+		e->chan[0][i] = left;
+		e->chan[1][i] = right;
+		e->chan[2][i] = (left + right) >> 1;
+		e->chan[3][i] = left - right;
+	}
+	for (int c = 0; c < 4; c++) {
+		choose_subframe(e->chan[c], n, c == 3 ? 17 : 16, &sf[c]);
+	}
+	for (int i = 1; i < 4; i++) {
+		if (sf[pairs[i][0]].bits + sf[pairs[i][1]].bits < sf[pairs[best][0]].bits + sf[pairs[best][1]].bits) {
+			best = i;
+		}
+	}
+
+	put_bits(b, 0xFFF8, 16);		// sync code, fixed block size
+	put_bits(b, 7, 4);				// block size at the end of the header
+	put_bits(b, 9, 4);				// 44.1kHz
+	put_bits(b, pairs[best][2], 4);
+	put_bits(b, 4, 3);				// 16 bits per sample
+	put_bits(b, 0, 1);
+	put_utf8(b, frame);
+	put_bits(b, n - 1, 16);
+	put_bits(b, crc8(start, b->p - start), 8);
+	for (int i = 0; i < 2; i++) {
+		int c = pairs[best][i];
+		put_subframe(b, e->chan[c], n, c == 3 ? 17 : 16, &sf[c]);
+	}
+	if (b->bits) {
+		put_bits(b, 0, 8 - b->bits);
+	}
+	put_bits(b, crc16(start, b->p - start), 16);
+}
+
+// Big endian samples in, the frames out. Returns their size, or 0 if they didn't fit in cap.
+u32 flac_encode(flac_enc *e, const u8 *pcm, u32 samples, u32 block_size, u8 *out, u32 cap) {
+	bit_writer b = { out, out + cap, 0, 0, 0 };
+
+	if (!block_size || block_size > FLAC_MAX_BLOCK) {
+		return 0;
+	}
+	for (u32 i = 0, frame = 0; i < samples && !b.over; i += block_size, frame++) {
+		u32 n = samples - i < block_size ? samples - i : block_size;
+		put_frame(e, &b, pcm + i * 4, n, frame);
+	}
+	return b.over ? 0 : (u32)(b.p - out);
+}
@@ -0,0 +1,323 @@
+/**
+ * CleanRip - gcz.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * A sink stage that writes the image as a GCZ while it is dumped, so
+ * there is no ISO to convert afterwards. Every block that comes in is
+ * cut into GCZ blocks which are deflated by a pool of worker threads,
+ * one per core on a PC. They are appended to the file in order as
+ * they finish, and the offsets and hashes for the table in front of
+ * them are kept until close. The console compresses in the writer
+ * thread at the fastest level, the ring keeps the drive reading
+ * meanwhile. On a PC a GCZ can be read back a block at a time.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "gcz.h"
+#include "bytes.h"
+#include "pool.h"
+
+#define GCZ_OUT_SIZE (1024*1024)	// blocks are passed on in writes of up to this
+
+#if defined(__CYGWIN__) || defined(__linux__)
+#define GCZ_LEVEL Z_DEFAULT_COMPRESSION
+#else
+#define GCZ_LEVEL Z_BEST_SPEED
+#endif
+
+typedef struct {
+	u8 *in;				// the block, copied out of the write it came in
+	u8 *out;
+	u32 len;			// compressed size, or GCZ_BLOCK_SIZE if stored
+	int stored;
+	u32 hash;
+} gcz_job;
+
+typedef struct {
+	u64 data_size;
+	u32 num_blocks;
+	u32 block;			// the next block to go out
+	u64 out;			// where it goes, from the start of the data
+	u8 *table;			// header, offsets and hashes, as they go in the file
+	u32 table_size;
+	u32 fill;			// of the block being put together
+	u8 *obuf;			// compressed blocks not passed on yet
+	u32 ofill;
+	z_stream strm;		// when there are no workers
+	z_stream worker[POOL_MAX_WORKERS];
+	int workers;		// with a deflate stream set up
+	int slots;
+	gcz_job *jobs;
+	job_pool pool;
+} gcz_ctx;
+
+// One block, the way Dolphin stores it: deflated unless that doesn't make it smaller
+static void gcz_compress(void *_strm, void *_job) {
+	z_stream *strm = (z_stream*)_strm;
+	gcz_job *job = (gcz_job*)_job;
+
+	deflateReset(strm);
+	strm->next_in = (Bytef*)job->in;
+	strm->avail_in = GCZ_BLOCK_SIZE;
+	strm->next_out = job->out;
+	strm->avail_out = GCZ_BLOCK_SIZE;
+	if (deflate(strm, Z_FINISH) == Z_STREAM_END && strm->total_out < GCZ_BLOCK_SIZE) {
+		job->len = strm->total_out;
+		job->stored = 0;
+	}
+	else {
+		job->len = GCZ_BLOCK_SIZE;
+		job->stored = 1;
+	}
+	job->hash = adler32(1, job->stored ? job->in : job->out, job->len);
+}
+
+static int gcz_pass_on(sink *s) {
+	gcz_ctx *c = (gcz_ctx*)s->ctx;
+	int ret = 0;
+
+	if (c->ofill) {
+		ret = sink_write(s->next[0], c->obuf, c->ofill, c->table_size + c->out - c->ofill);
+		c->ofill = 0;
+	}
+	return ret;
+}
+
+// Appends a compressed block and notes it in the table
+static int gcz_emit(sink *s, void *_job) {
+	gcz_ctx *c = (gcz_ctx*)s->ctx;
+	gcz_job *job = (gcz_job*)_job;
+	int ret = 0;
+
+	if (c->block >= c->num_blocks) {
+		return 1;
+	}
+	put_le64(c->table + GCZ_HEADER_SIZE + (u64)c->block * 8, c->out | (job->stored ? GCZ_STORED : 0));
+	put_le32(c->table + GCZ_HEADER_SIZE + (u64)c->num_blocks * 8 + (u64)c->block * 4, job->hash);
+	if (c->ofill + job->len > GCZ_OUT_SIZE) {
+		ret = gcz_pass_on(s);
+	}
+	memcpy(c->obuf + c->ofill, job->stored ? job->in : job->out, job->len);
+	c->ofill += job->len;
+	c->block++;
+	c->out += job->len;
+	return ret;
+}
+
+static int gcz_write(sink *s, const void *data, u32 len, u64 offset) {
+	gcz_ctx *c = (gcz_ctx*)s->ctx;
+	const u8 *p = (const u8*)data;
+	int ret = 0;
+
+	// the table only works if every block comes in order
+	if (offset != s->pos) {
+		return 1;
+	}
+	s->pos += len;
+	while (len) {
+		gcz_job *job = (gcz_job*)pool_next(&c->pool, &ret);
+		u32 n = GCZ_BLOCK_SIZE - c->fill;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(job->in + c->fill, p, n);
+		c->fill += n;
+		p += n;
+		len -= n;
+		if (c->fill == GCZ_BLOCK_SIZE) {
+			ret |= pool_submit(&c->pool);
+			c->fill = 0;
+		}
+	}
+	return ret;
+}
+
+// Only here and at close are the jobs out waited for
+static int gcz_flush(sink *s) {
+	gcz_ctx *c = (gcz_ctx*)s->ctx;
+
+	return pool_drain(&c->pool) | gcz_pass_on(s) | sink_flush(s->next[0]);
+}
+
+static int gcz_header(sink *s) {
+	gcz_ctx *c = (gcz_ctx*)s->ctx;
+
+	put_le32(c->table, GCZ_MAGIC);
+	put_le32(c->table + 4, 0);						// GameCube
+	put_le64(c->table + 8, c->out);
+	put_le64(c->table + 16, c->data_size);
+	put_le32(c->table + 24, GCZ_BLOCK_SIZE);
+	put_le32(c->table + 28, c->num_blocks);
+	return sink_write(s->next[0], c->table, c->table_size, 0);
+}
+
+static void gcz_free(gcz_ctx *c) {
+	pool_close(&c->pool);
+	for (int i = 0; i < c->workers; i++) {
+		deflateEnd(&c->worker[i]);
+	}
+	for (int i = 0; c->jobs && i < c->slots; i++) {
+		free(c->jobs[i].in);
+		free(c->jobs[i].out);
+	}
+	deflateEnd(&c->strm);
+	free(c->jobs);
+	free(c->obuf);
+	free(c->table);
+	free(c);
+}
+
+static int gcz_close(sink *s) {
+	gcz_ctx *c = (gcz_ctx*)s->ctx;
+	int ret = 0;
+
+	if (c) {
+		// a short last block is padded out, readers take whole blocks
+		if (c->fill) {
+			gcz_job *job = (gcz_job*)pool_next(&c->pool, &ret);
+			memset(job->in + c->fill, 0, GCZ_BLOCK_SIZE - c->fill);
+			ret |= pool_submit(&c->pool);
+		}
+		ret |= pool_drain(&c->pool) | gcz_pass_on(s);
+		ret |= gcz_header(s);
+		gcz_free(c);
+		s->ctx = NULL;
+	}
+	return sink_close(s->next[0]) | ret;
+}
+
+static const sink_ops gcz_ops = { gcz_write, gcz_flush, gcz_close };
+
+int sink_gcz(sink *s, sink *next, u64 data_size) {
+	gcz_ctx *c = (gcz_ctx*)calloc(1, sizeof(gcz_ctx));
+	if (!c) {
+		return 1;
+	}
+	c->data_size = data_size;
+	c->num_blocks = (data_size + GCZ_BLOCK_SIZE - 1) / GCZ_BLOCK_SIZE;
+	c->table_size = GCZ_HEADER_SIZE + c->num_blocks * 12;
+	c->table = (u8*)calloc(1, c->table_size);
+	c->obuf = (u8*)malloc(GCZ_OUT_SIZE);
+	int workers = pool_cores();
+	c->slots = pool_slots(workers);
+	c->jobs = (gcz_job*)calloc(c->slots, sizeof(gcz_job));
+	int failed = !c->table || !c->obuf || !c->jobs || deflateInit(&c->strm, GCZ_LEVEL) != Z_OK;
+	for (int i = 0; !failed && i < c->slots; i++) {
+		c->jobs[i].in = (u8*)malloc(GCZ_BLOCK_SIZE);
+		c->jobs[i].out = (u8*)malloc(GCZ_BLOCK_SIZE);
+		failed = !c->jobs[i].in || !c->jobs[i].out;
+	}
+	if (failed) {
+		gcz_free(c);
+		return 1;
+	}
+	pool_init(&c->pool, s, c->jobs, sizeof(gcz_job), c->slots, gcz_compress, gcz_emit, &c->strm);
+	// fewer workers is fine, with none the writer thread compresses
+	for (; c->workers < workers && deflateInit(&c->worker[c->workers], GCZ_LEVEL) == Z_OK; c->workers++) {
+		pool_start(&c->pool, &c->worker[c->workers]);
+	}
+	sink_stage(s, &gcz_ops, c, next);
+	// an empty table until the dump is done
+	if (gcz_header(s)) {
+		gcz_free(c);
+		s->ctx = NULL;
+		return 1;
+	}
+	return 0;
+}
+
+#if defined(__CYGWIN__) || defined(__linux__)
+typedef struct {
+	FILE *fp;
+	u64 data_start;		// the blocks, after the table
+	u64 data_end;
+	u8 *table;			// offsets and hashes as they are in the file
+} gcz_reader;
+
+static int gcz_read_block(archive *a, u32 block, u8 *dst, u8 *scratch) {
+	gcz_reader *r = (gcz_reader*)a->ctx;
+	u64 start = get_le64(r->table + (u64)block * 8);
+	u64 end = (block + 1 < a->blocks) ? get_le64(r->table + (u64)(block + 1) * 8) & ~GCZ_STORED : r->data_end;
+	u32 hash = get_le32(r->table + (u64)a->blocks * 8 + (u64)block * 4);
+	int stored = (start & GCZ_STORED) != 0;
+
+	start &= ~GCZ_STORED;
+	if (end < start || end - start > a->scratch_size
+		|| archive_pread(r->fp, scratch, end - start, r->data_start + start)
+		|| adler32(1, scratch, end - start) != hash) {
+		return 1;
+	}
+	if (stored) {
+		if (end - start != a->block_size) {
+			return 1;
+		}
+		memcpy(dst, scratch, a->block_size);
+		return 0;
+	}
+	// the last block may come out short
+	uLongf len = a->block_size;
+	if (uncompress(dst, &len, scratch, end - start) != Z_OK) {
+		return 1;
+	}
+	memset(dst + len, 0, a->block_size - len);
+	return 0;
+}
+
+static void gcz_reader_close(archive *a) {
+	gcz_reader *r = (gcz_reader*)a->ctx;
+
+	fclose(r->fp);
+	free(r->table);
+	free(r);
+}
+
+int gcz_archive(archive *a, const char *path) {
+	u8 hdr[GCZ_HEADER_SIZE];
+	gcz_reader *r = (gcz_reader*)calloc(1, sizeof(gcz_reader));
+
+	memset(a, 0, sizeof(archive));
+	if (!r || !(r->fp = fopen(path, "rb"))) {
+		free(r);
+		return -1;
+	}
+	a->ctx = r;
+	a->close = gcz_reader_close;
+	a->block = gcz_read_block;
+	if (archive_pread(r->fp, hdr, GCZ_HEADER_SIZE, 0) || get_le32(hdr) != GCZ_MAGIC) {
+		gcz_reader_close(a);
+		return -1;
+	}
+	a->size = get_le64(hdr + 16);
+	a->size_known = 1;
+	a->block_size = get_le32(hdr + 24);
+	a->blocks = get_le32(hdr + 28);
+	a->scratch_size = a->block_size;
+	u64 table_size = (u64)a->blocks * 12;
+	r->data_start = GCZ_HEADER_SIZE + table_size;
+	r->data_end = get_le64(hdr + 8);
+	if (!a->block_size || (u64)a->blocks * a->block_size < a->size
+		|| !(r->table = (u8*)malloc(table_size + 1))
+		|| archive_pread(r->fp, r->table, table_size, GCZ_HEADER_SIZE)) {
+		gcz_reader_close(a);
+		return -1;
+	}
+	return 0;
+}
+#endif
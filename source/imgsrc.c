@@ -0,0 +1,696 @@
+/**
+ * CleanRip - imgsrc.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * Reads a disc image (ISO/BIN, optionally split into .partN files)
+ * as if it were the drive, so a dump can be reproduced at storage
+ * speed. Raw 2352 byte data sectors are cut down to their 2048
+ * bytes of user data when the dump asks for cooked sectors. On a PC
+ * it also reads every compressed format CleanRip writes: their
+ * blocks are kept in a small cache, and while reads come in order
+ * a few threads decode the blocks ahead of them. The whole image
+ * can be hashed, or hashed and written out to a sink, with a thread
+ * per core decoding.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include "imgsrc.h"
+#include "bytes.h"
+
+#if defined(__CYGWIN__) || defined(__linux__)
+#include <unistd.h>
+#include <pthread.h>
+#include "ciso.h"
+#include "gcz.h"
+#include "rvz.h"
+#include "wbfs.h"
+#include "zst.h"
+#include "store.h"
+#include "delta.h"
+#include "crc32.h"
+#include "md5.h"
+#include "sha1.h"
+
+#define WORKER_PRIO 128 // the decoders only run on a PC, where LWP_CreateThread ignores it
+
+// in sectors, as in main.h
+#define NGC_MAGIC		0xC2339F3D
+#define WII_MAGIC		0x5D1C9EA3
+#define NGC_DISC_SIZE	0x0AE0B0
+#define WII_D5_SIZE		0x230480
+#define WII_D9_SIZE		0x3F69C0
+
+enum {
+	SLOT_EMPTY = 0,
+	SLOT_LOADING,
+	SLOT_READY
+};
+
+typedef struct {
+	u32 block;
+	int state;
+	u32 used;			// when it was last read, the oldest goes first
+	u8 *data;
+} imgsrc_slot;
+
+typedef struct {
+	imgsrc *img;
+	u8 *scratch;
+	lwp_t thread;
+} imgsrc_ahead;
+
+struct imgsrc_cache {
+	pthread_mutex_t lock;
+	pthread_cond_t loaded;		// a slot is done loading
+	pthread_cond_t work;		// there is something to read ahead
+	int slots;
+	imgsrc_slot *slot;
+	u32 tick;
+	u8 *scratch;				// for the blocks the reader decodes itself
+	u32 next;					// the block after the last read
+	u32 ahead_blocks;
+	u32 ahead_next;				// read ahead up to, not including, ahead_end
+	u32 ahead_end;
+	int quit;
+	int threads;
+	imgsrc_ahead ahead[IMGSRC_AHEAD_THREADS];
+};
+
+typedef struct {
+	imgsrc *img;
+	u32 block;
+	u32 block_size;
+	u32 len;
+	u8 *data;
+	u8 *scratch;
+	int ret;
+	int hashing;		// out to the digest threads
+	mqbox_t doneq;
+	mqbox_t hashedq;
+} hash_job;
+
+enum {
+	DIGEST_CRC32 = 0,
+	DIGEST_MD5,
+	DIGEST_SHA1,
+	DIGESTS
+};
+
+// Each digest has a thread of its own, the slowest one sets the pace
+typedef struct {
+	int kind;
+	mqbox_t q;
+	lwp_t thread;
+	u32 crc32;
+	md5_state_t md5;
+	SHA1Context sha;
+} hash_digest;
+
+static const struct {
+	const char *ext;
+	int (*open)(archive *a, const char *path);
+} formats[] = {
+	{ ".ciso", ciso_archive },
+	{ ".gcz", gcz_archive },
+	{ ".rvz", rvz_archive },
+	{ ".wbfs", wbfs_archive },
+	{ ".zst", zst_archive },
+	{ ".rcp", store_archive },
+	{ ".dlt", delta_archive },
+};
+#endif
+
+static const u8 sync_pattern[12] = {
+	0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00
+};
+
+static int add_part(imgsrc *img, const char *path) {
+	FILE *fp = fopen(path, "rb");
+	if (!fp) {
+		return -1;
+	}
+	fseeko(fp, 0, SEEK_END);
+	u64 size = (u64)ftello(fp);
+	img->fp[img->parts] = fp;
+	img->start[img->parts] = img->size;
+	img->parts++;
+	img->size += size;
+	return 0;
+}
+
+static int read_bytes(imgsrc *img, u8 *dst, u32 len, u64 pos);
+
+// Raw images are recognised by the sync pattern, audio BINs by their size alone
+static void detect_geometry(imgsrc *img) {
+	u8 header[16];
+
+	img->file_sector = 2048;
+	img->data_offset = 0;
+	if (img->size < sizeof(header) || read_bytes(img, header, sizeof(header), 0)) {
+		return;
+	}
+	if (!(img->size % 2352) && !memcmp(header, sync_pattern, sizeof(sync_pattern))) {
+		img->file_sector = 2352;
+		// Mode 2 Form 1 has an 8 byte subheader in front of the data
+		img->data_offset = (header[15] == 2) ? 24 : 16;
+	}
+	else if (!(img->size % 2352) && (img->size % 2048)) {
+		img->file_sector = 2352;
+	}
+}
+
+#if defined(__CYGWIN__) || defined(__linux__)
+// A block past the last one in the file is zeroes
+static int archive_block(imgsrc *img, u32 block, u8 *dst, u8 *scratch) {
+	if (block >= img->arc.blocks) {
+		memset(dst, 0, img->arc.block_size);
+		return 0;
+	}
+	return img->arc.block(&img->arc, block, dst, scratch);
+}
+
+static imgsrc_slot *cache_find(imgsrc_cache *c, u32 block) {
+	for (int i = 0; i < c->slots; i++) {
+		if (c->slot[i].state != SLOT_EMPTY && c->slot[i].block == block) {
+			return &c->slot[i];
+		}
+	}
+	return NULL;
+}
+
+// An empty slot, or the one read longest ago; NULL if they are all loading
+static imgsrc_slot *cache_claim(imgsrc_cache *c, u32 block) {
+	imgsrc_slot *best = NULL;
+
+	for (int i = 0; i < c->slots; i++) {
+		imgsrc_slot *s = &c->slot[i];
+		if (s->state == SLOT_EMPTY) {
+			best = s;
+			break;
+		}
+		if (s->state == SLOT_READY && (!best || s->used < best->used)) {
+			best = s;
+		}
+	}
+	if (best) {
+		best->block = block;
+		best->state = SLOT_LOADING;
+	}
+	return best;
+}
+
+// Called with the lock held, which is let go while the block is decoded
+static int cache_load(imgsrc *img, imgsrc_slot *s, u8 *scratch) {
+	imgsrc_cache *c = img->cache;
+
+	pthread_mutex_unlock(&c->lock);
+	int ret = archive_block(img, s->block, s->data, scratch);
+	pthread_mutex_lock(&c->lock);
+	s->state = ret ? SLOT_EMPTY : SLOT_READY;
+	s->used = ++c->tick;
+	pthread_cond_broadcast(&c->loaded);
+	return ret;
+}
+
+static void* ahead_thread(void *arg) {
+	imgsrc_ahead *a = (imgsrc_ahead*)arg;
+	imgsrc *img = a->img;
+	imgsrc_cache *c = img->cache;
+
+	pthread_mutex_lock(&c->lock);
+	while (!c->quit) {
+		if (c->ahead_next >= c->ahead_end) {
+			pthread_cond_wait(&c->work, &c->lock);
+			continue;
+		}
+		u32 block = c->ahead_next++;
+		imgsrc_slot *s;
+		if (!cache_find(c, block) && (s = cache_claim(c, block))) {
+			cache_load(img, s, a->scratch);
+		}
+	}
+	pthread_mutex_unlock(&c->lock);
+	return NULL;
+}
+
+// Copies a range out of the blocks, decoding those that aren't cached
+static int cache_read(imgsrc *img, u8 *dst, u32 len, u64 pos) {
+	imgsrc_cache *c = img->cache;
+	u32 bs = img->arc.block_size;
+	u32 first = pos / bs, last = (pos + len - 1) / bs;
+	int ret = 0;
+
+	if (!len) {
+		return 0;
+	}
+	pthread_mutex_lock(&c->lock);
+	// in order, keep the read-ahead going past this read; otherwise drop what it had to do
+	if (first == c->next || first + 1 == c->next) {
+		if (c->ahead_next <= last) {
+			c->ahead_next = last + 1;
+		}
+		c->ahead_end = last + 1 + c->ahead_blocks;
+		if (c->ahead_end > img->arc.blocks) {
+			c->ahead_end = img->arc.blocks;
+		}
+		pthread_cond_broadcast(&c->work);
+	}
+	else {
+		c->ahead_next = c->ahead_end = last + 1;
+	}
+	c->next = last + 1;
+	for (u32 block = first; block <= last && !ret; ) {
+		imgsrc_slot *s = cache_find(c, block);
+		if (s && s->state == SLOT_LOADING) {
+			pthread_cond_wait(&c->loaded, &c->lock);
+			continue;
+		}
+		if (!s) {
+			if (!(s = cache_claim(c, block))) {
+				pthread_cond_wait(&c->loaded, &c->lock);
+				continue;
+			}
+			if (cache_load(img, s, c->scratch)) {
+				ret = 1;
+				break;
+			}
+			// it could have gone again while the lock was let go
+			continue;
+		}
+		u64 start = (u64)block * bs;
+		u32 from = pos > start ? (u32)(pos - start) : 0;
+		u32 n = bs - from < len ? bs - from : len;
+		memcpy(dst, s->data + from, n);
+		s->used = ++c->tick;
+		dst += n;
+		pos += n;
+		len -= n;
+		block++;
+	}
+	pthread_mutex_unlock(&c->lock);
+	return ret;
+}
+
+static void cache_close(imgsrc *img) {
+	imgsrc_cache *c = img->cache;
+
+	if (!c) {
+		return;
+	}
+	pthread_mutex_lock(&c->lock);
+	c->quit = 1;
+	pthread_cond_broadcast(&c->work);
+	pthread_mutex_unlock(&c->lock);
+	for (int i = 0; i < c->threads; i++) {
+		LWP_JoinThread(c->ahead[i].thread, NULL);
+		free(c->ahead[i].scratch);
+	}
+	for (int i = 0; c->slot && i < c->slots; i++) {
+		free(c->slot[i].data);
+	}
+	pthread_cond_destroy(&c->work);
+	pthread_cond_destroy(&c->loaded);
+	pthread_mutex_destroy(&c->lock);
+	free(c->slot);
+	free(c->scratch);
+	free(c);
+	img->cache = NULL;
+}
+
+static int cache_open(imgsrc *img) {
+	imgsrc_cache *c = (imgsrc_cache*)calloc(1, sizeof(imgsrc_cache));
+	u32 scratch = img->arc.scratch_size ? img->arc.scratch_size : 1;
+
+	if (!c) {
+		return 1;
+	}
+	img->cache = c;
+	pthread_mutex_init(&c->lock, NULL);
+	pthread_cond_init(&c->loaded, NULL);
+	pthread_cond_init(&c->work, NULL);
+	// a few MB ahead whatever the block size, with room for what is being read
+	c->ahead_blocks = IMGSRC_READ_AHEAD / img->arc.block_size;
+	c->ahead_blocks = c->ahead_blocks < 2 ? 2 : (c->ahead_blocks > 64 ? 64 : c->ahead_blocks);
+	c->slots = c->ahead_blocks * 2 + 4;
+	c->slot = (imgsrc_slot*)calloc(c->slots, sizeof(imgsrc_slot));
+	c->scratch = (u8*)malloc(scratch);
+	if (!c->slot || !c->scratch) {
+		return 1;
+	}
+	for (int i = 0; i < c->slots; i++) {
+		if (!(c->slot[i].data = (u8*)malloc(img->arc.block_size))) {
+			return 1;
+		}
+	}
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	int threads = cores < 1 ? 1 : (cores > IMGSRC_AHEAD_THREADS ? IMGSRC_AHEAD_THREADS : (int)cores);
+	// fewer threads is fine, the reader decodes what isn't there yet itself
+	for (; c->threads < threads; c->threads++) {
+		imgsrc_ahead *a = &c->ahead[c->threads];
+		a->img = img;
+		if (!(a->scratch = (u8*)malloc(scratch))) {
+			break;
+		}
+		LWP_CreateThread(&a->thread, ahead_thread, (void*)a, NULL, 0, WORKER_PRIO);
+	}
+	return 0;
+}
+
+// A format that doesn't keep the size: a disc is as big as its kind, anything else ends with its last block
+static void archive_size(imgsrc *img) {
+	u8 hdr[0x20];
+
+	img->size = img->arc.size;
+	if (img->arc.size_known || img->size < sizeof(hdr) || cache_read(img, hdr, sizeof(hdr), 0)) {
+		return;
+	}
+	// the last block can go on past the end of the disc, padded out
+	u64 least = img->size > img->arc.block_size ? img->size - img->arc.block_size : 0;
+	if (get_be32(hdr + 0x1C) == NGC_MAGIC && least < (u64)NGC_DISC_SIZE * 2048) {
+		img->size = (u64)NGC_DISC_SIZE * 2048;
+	}
+	else if (get_be32(hdr + 0x18) == WII_MAGIC) {
+		img->size = (least < (u64)WII_D5_SIZE * 2048 ? (u64)WII_D5_SIZE : (u64)WII_D9_SIZE) * 2048;
+	}
+}
+#endif
+
+int imgsrc_open(imgsrc *img, const char *path) {
+	memset(img, 0, sizeof(imgsrc));
+	snprintf(img->path, sizeof(img->path), "%s", path);
+#if defined(__CYGWIN__) || defined(__linux__)
+	const char *ext = strrchr(path, '.');
+	for (int i = 0; ext && i < (int)(sizeof(formats) / sizeof(formats[0])); i++) {
+		if (!strcmp(ext, formats[i].ext)) {
+			if (formats[i].open(&img->arc, path)) {
+				return -1;
+			}
+			if (cache_open(img)) {
+				imgsrc_close(img);
+				return -1;
+			}
+			archive_size(img);
+			detect_geometry(img);
+			return 0;
+		}
+	}
+#endif
+	if (add_part(img, path)) {
+		return -1;
+	}
+
+	// game.part0.iso pulls in game.part1.iso, game.part2.iso, ...
+	char *marker = strstr(img->path, ".part0");
+	if (marker) {
+		char part_path[IMGSRC_PATH_MAX + 16];
+		int prefix = marker - img->path;
+		while (img->parts < IMGSRC_MAX_PARTS) {
+			snprintf(part_path, sizeof(part_path), "%.*s.part%i%s", prefix, img->path, img->parts, marker + 6);
+			if (add_part(img, part_path)) {
+				break;
+			}
+		}
+	}
+	detect_geometry(img);
+	return 0;
+}
+
+void imgsrc_close(imgsrc *img) {
+#if defined(__CYGWIN__) || defined(__linux__)
+	cache_close(img);
+	if (img->arc.block) {
+		img->arc.close(&img->arc);
+		img->arc.block = NULL;
+	}
+#endif
+	for (int i = 0; i < img->parts; i++) {
+		fclose(img->fp[i]);
+	}
+	img->parts = 0;
+	img->size = 0;
+}
+
+// Straight copy of the image bytes, across part boundaries
+static int read_bytes(imgsrc *img, u8 *dst, u32 len, u64 pos) {
+	if (pos + len > img->size) {
+		return 1;
+	}
+#if defined(__CYGWIN__) || defined(__linux__)
+	if (img->arc.block) {
+		return cache_read(img, dst, len, pos);
+	}
+#endif
+	int part = img->parts - 1;
+	while (part > 0 && img->start[part] > pos) {
+		part--;
+	}
+	while (len) {
+		u64 part_end = (part + 1 < img->parts) ? img->start[part + 1] : img->size;
+		u32 n = (pos + len > part_end) ? (u32)(part_end - pos) : len;
+#if defined(__CYGWIN__) || defined(__linux__)
+		// hashing reads from several threads at once
+		if (archive_pread(img->fp[part], dst, n, pos - img->start[part])) {
+			return 1;
+		}
+#else
+		if (fseeko(img->fp[part], (off_t)(pos - img->start[part]), SEEK_SET)
+			|| fread(dst, n, 1, img->fp[part]) != 1) {
+			return 1;
+		}
+#endif
+		dst += n;
+		pos += n;
+		len -= n;
+		part++;
+	}
+	return 0;
+}
+
+// offset is a byte offset into the image; sector_size is how the disc is read, 2048 for cooked user data. Returns 0 on success
+int imgsrc_read(imgsrc *img, void *dst, u32 len, u64 offset, u32 sector_size) {
+	u8 *out = (u8*)dst;
+
+	if (!img->data_offset || sector_size != 2048) {
+		return read_bytes(img, out, len, offset);
+	}
+	// cooked read of a raw data image, one sector's user data at a time
+	while (len) {
+		u64 lba = offset / 2048;
+		u32 in_sector = (u32)(offset % 2048);
+		u32 n = (len < 2048 - in_sector) ? len : (2048 - in_sector);
+		if (read_bytes(img, out, n, lba * 2352 + img->data_offset + in_sector)) {
+			return 1;
+		}
+		out += n;
+		offset += n;
+		len -= n;
+	}
+	return 0;
+}
+
+u32 imgsrc_sectors(imgsrc *img, u32 sector_size) {
+	if (img->data_offset && sector_size == 2048) {
+		return (u32)(img->size / 2352);
+	}
+	return (u32)(img->size / sector_size);
+}
+
+// count 2048 byte sectors from lba, whatever the image is kept as
+int imgsrc_read_lba(imgsrc *img, u32 lba, u32 count, void *buf) {
+	return imgsrc_read(img, buf, count * 2048, (u64)lba * 2048, 2048);
+}
+
+// The BCA can't be in the image itself, take it from the .bca written next to it
+int imgsrc_read_bca(imgsrc *img, void *buf, int size) {
+	char bca_path[IMGSRC_PATH_MAX + 8];
+	char *ext;
+
+	snprintf(bca_path, sizeof(bca_path), "%s", img->path);
+	if ((ext = strstr(bca_path, ".part0")) || (ext = strrchr(bca_path, '.'))) {
+		*ext = 0;
+	}
+	strcat(bca_path, ".bca");
+	memset(buf, 0, size);
+	FILE *fp = fopen(bca_path, "rb");
+	if (!fp) {
+		return 0;
+	}
+	int ret = fread(buf, 1, size, fp);
+	fclose(fp);
+	return ret;
+}
+
+#if defined(__CYGWIN__) || defined(__linux__)
+static int hash_read(hash_job *job) {
+	imgsrc *img = job->img;
+	u64 start = (u64)job->block * job->block_size;
+
+	job->len = (img->size - start < job->block_size) ? (u32)(img->size - start) : job->block_size;
+	if (!img->arc.block) {
+		return read_bytes(img, job->data, job->len, start);
+	}
+	return archive_block(img, job->block, job->data, job->scratch);
+}
+
+static void* hash_thread(void *jobq) {
+	hash_job *job;
+
+	while (MQ_Receive((mqbox_t)jobq, (mqmsg_t*)&job, MQ_MSG_BLOCK)==TRUE && job) {
+		job->ret = hash_read(job);
+		MQ_Send(job->doneq, (mqmsg_t)job, MQ_MSG_BLOCK);
+	}
+	return NULL;
+}
+
+static void* digest_thread(void *_digest) {
+	hash_digest *g = (hash_digest*)_digest;
+	hash_job *job;
+
+	while (MQ_Receive(g->q, (mqmsg_t*)&job, MQ_MSG_BLOCK)==TRUE && job) {
+		if (g->kind == DIGEST_CRC32) {
+			g->crc32 = Crc32_ComputeBuf(g->crc32, job->data, job->len);
+		}
+		else if (g->kind == DIGEST_MD5) {
+			md5_append(&g->md5, (const md5_byte_t *)job->data, job->len);
+		}
+		else {
+			SHA1Input(&g->sha, (const unsigned char *)job->data, job->len);
+		}
+		MQ_Send(job->hashedq, (mqmsg_t)job, MQ_MSG_BLOCK);
+	}
+	return NULL;
+}
+
+// Waits until every digest is done with the job's block
+static void hash_wait(hash_job *job) {
+	hash_job *done;
+
+	for (; job->hashing; job->hashing--) {
+		MQ_Receive(job->hashedq, (mqmsg_t*)&done, MQ_MSG_BLOCK);
+	}
+}
+
+// CRC32, MD5 and SHA-1 of the whole image as the dumpinfo has them. A thread
+// per core reads and decodes the blocks, which go through the digests in order
+// and, unless out is NULL, to out while the digests have them.
+int imgsrc_copy(imgsrc *img, sink *out, imgsrc_digest *d) {
+	u32 block_size = img->arc.block ? img->arc.block_size : IMGSRC_HASH_BLOCK;
+	u32 blocks = (img->size + block_size - 1) / block_size;
+	u32 scratch = img->arc.block && img->arc.scratch_size ? img->arc.scratch_size : 1;
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	int workers = cores < 1 ? 1 : (cores > IMGSRC_MAX_WORKERS ? IMGSRC_MAX_WORKERS : (int)cores);
+	int slots = workers * 2 + 2, started = 0;
+	hash_job *jobs = (hash_job*)calloc(slots, sizeof(hash_job));
+	lwp_t threads[IMGSRC_MAX_WORKERS];
+	hash_digest digest[DIGESTS];
+	mqbox_t jobq;
+	md5_byte_t md5[16];
+	int ret = 0;
+
+	memset(d, 0, sizeof(imgsrc_digest));
+	if (!jobs) {
+		return 1;
+	}
+	MQ_Init(&jobq, slots);
+	for (int i = 0; i < slots; i++) {
+		jobs[i].img = img;
+		jobs[i].block_size = block_size;
+		jobs[i].data = (u8*)malloc(block_size);
+		jobs[i].scratch = (u8*)malloc(scratch);
+		MQ_Init(&jobs[i].doneq, 1);
+		MQ_Init(&jobs[i].hashedq, DIGESTS);
+		ret |= !jobs[i].data || !jobs[i].scratch;
+	}
+	for (int i = 0; i < workers; i++) {
+		LWP_CreateThread(&threads[i], hash_thread, (void*)jobq, NULL, 0, WORKER_PRIO);
+	}
+	memset(digest, 0, sizeof(digest));
+	md5_init(&digest[DIGEST_MD5].md5);
+	SHA1Reset(&digest[DIGEST_SHA1].sha);
+	for (int k = 0; k < DIGESTS; k++) {
+		digest[k].kind = k;
+		MQ_Init(&digest[k].q, slots);
+		LWP_CreateThread(&digest[k].thread, digest_thread, (void*)&digest[k], NULL, 0, WORKER_PRIO);
+	}
+	for (u32 next = 0; !ret && next < blocks && next < (u32)slots; next++, started++) {
+		jobs[next].block = next;
+		MQ_Send(jobq, (mqmsg_t)&jobs[next], MQ_MSG_BLOCK);
+	}
+	for (u32 block = 0; block < blocks && started; block++) {
+		hash_job *job = &jobs[block % slots], *done;
+		MQ_Receive(job->doneq, (mqmsg_t*)&done, MQ_MSG_BLOCK);
+		started--;
+		ret |= job->ret;
+		for (int k = 0; !ret && k < DIGESTS; k++, job->hashing++) {
+			MQ_Send(digest[k].q, (mqmsg_t)job, MQ_MSG_BLOCK);
+		}
+		if (!ret && out) {
+			ret = sink_write(out, job->data, job->len, (u64)block * block_size);
+		}
+		// the block before has been through the digests or nearly, its job takes the next one out
+		if (block) {
+			hash_job *prev = &jobs[(block - 1) % slots];
+			hash_wait(prev);
+			if (!ret && block - 1 + slots < blocks) {
+				prev->block = block - 1 + slots;
+				MQ_Send(jobq, (mqmsg_t)prev, MQ_MSG_BLOCK);
+				started++;
+			}
+		}
+	}
+	for (int i = 0; i < workers; i++) {
+		MQ_Send(jobq, (mqmsg_t)NULL, MQ_MSG_BLOCK);
+	}
+	for (int k = 0; k < DIGESTS; k++) {
+		MQ_Send(digest[k].q, (mqmsg_t)NULL, MQ_MSG_BLOCK);
+	}
+	for (int i = 0; i < workers; i++) {
+		LWP_JoinThread(threads[i], NULL);
+	}
+	for (int k = 0; k < DIGESTS; k++) {
+		LWP_JoinThread(digest[k].thread, NULL);
+		MQ_Close(digest[k].q);
+	}
+	for (int i = 0; i < slots; i++) {
+		hash_wait(&jobs[i]);
+		MQ_Close(jobs[i].doneq);
+		MQ_Close(jobs[i].hashedq);
+		free(jobs[i].data);
+		free(jobs[i].scratch);
+	}
+	MQ_Close(jobq);
+	free(jobs);
+	d->crc32 = digest[DIGEST_CRC32].crc32;
+	md5_finish(&digest[DIGEST_MD5].md5, md5);
+	for (int i = 0; i < 16; i++) {
+		sprintf(&d->md5[i * 2], "%02x", md5[i]);
+	}
+	if (SHA1Result(&digest[DIGEST_SHA1].sha)) {
+		for (int i = 0; i < 5; i++) {
+			sprintf(&d->sha1[i * 8], "%08x", digest[DIGEST_SHA1].sha.Message_Digest[i]);
+		}
+	}
+	return ret;
+}
+
+int imgsrc_hash(imgsrc *img, imgsrc_digest *d) {
+	return imgsrc_copy(img, NULL, d);
+}
+#endif
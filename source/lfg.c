@@ -0,0 +1,150 @@
+/**
+ * CleanRip - lfg.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * The junk generator from Nintendo's mastering tools. Space on a disc
+ * that no file uses is filled with its output, started over every
+ * 32KB. The seed can be worked back out of 521 words of the output,
+ * so a run of junk in a dump can be stored as 17 words instead, the
+ * same way Dolphin's RVZ does it. Each step is two passes of xors 32
+ * words apart, which the compiler turns into vector code where there
+ * is any.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <string.h>
+#include "lfg.h"
+#include "bytes.h"
+
+static void lfg_step(u32 *b) {
+	for (int i = 0; i < LFG_J; i++) {
+		b[i] ^= b[i + LFG_K - LFG_J];
+	}
+	for (int i = LFG_J; i < LFG_K; i++) {
+		b[i] ^= b[i - LFG_J];
+	}
+}
+
+// Undoes the steps for words start to end
+static void lfg_unstep(u32 *b, int start, int end) {
+	int loop_end = start > LFG_J ? start : LFG_J;
+	for (int i = end < LFG_K ? end : LFG_K; i > loop_end; i--) {
+		b[i - 1] ^= b[i - 1 - LFG_J];
+	}
+	for (int i = end < LFG_J ? end : LFG_J; i > start; i--) {
+		b[i - 1] ^= b[i - 1 + LFG_K - LFG_J];
+	}
+}
+
+// Fills out the buffer from the seed words. With check set the buffer
+// already holds output, and it has to be what the seed would give.
+static int lfg_init(u32 *b, int check) {
+	for (int i = LFG_SEED_SIZE; i < LFG_K; i++) {
+		u32 calc = (b[i - 17] << 23) ^ (b[i - 16] >> 9) ^ b[i - 1];
+		if (check) {
+			// the output lost two bits of every word
+			u32 actual = (b[i] & 0xFF00FFFF) | (b[i] << 2 & 0x00FC0000);
+			if ((calc & 0xFFFCFFFF) != actual) {
+				return 0;
+			}
+		}
+		b[i] = calc;
+	}
+	// the mastering tool shifts by 18 where it meant 16
+	for (int i = 0; i < LFG_K; i++) {
+		b[i] = (b[i] & 0xFF00FFFF) | ((b[i] >> 2) & 0x00FF0000);
+	}
+	for (int i = 0; i < 4; i++) {
+		lfg_step(b);
+	}
+	return 1;
+}
+
+void lfg_set_seed(lfg *g, const u32 seed[LFG_SEED_SIZE]) {
+	memcpy(g->buf, seed, LFG_SEED_SIZE * 4);
+	lfg_init(g->buf, 0);
+	g->pos = 0;
+}
+
+void lfg_forward(lfg *g, u32 bytes) {
+	for (g->pos += bytes; g->pos >= LFG_BYTES; g->pos -= LFG_BYTES) {
+		lfg_step(g->buf);
+	}
+}
+
+void lfg_get_bytes(lfg *g, u8 *out, u32 len) {
+	while (len) {
+		if (!(g->pos & 3) && len >= 4) {
+			// whole words
+			u32 i = g->pos / 4, n = LFG_K - i;
+			if (n > len / 4) {
+				n = len / 4;
+			}
+			for (u32 j = 0; j < n; j++) {
+				put_be32(out + j * 4, g->buf[i + j]);
+			}
+			out += n * 4;
+			len -= n * 4;
+			g->pos += n * 4;
+		}
+		else {
+			*out++ = (g->buf[g->pos / 4] >> (24 - (g->pos & 3) * 8)) & 0xFF;
+			len--;
+			g->pos++;
+		}
+		if (g->pos == LFG_BYTES) {
+			lfg_step(g->buf);
+			g->pos = 0;
+		}
+	}
+}
+
+// Every word of output passes this, most other data soon doesn't
+int lfg_maybe_junk(u32 word) {
+	return (word & 0x00C00000) == ((word >> 2) & 0x00C00000);
+}
+
+// Works the seed out of LFG_K words of output that start offset bytes
+// (a multiple of 4) into the 32KB it was generated for.
+int lfg_get_seed(const u8 *data, u32 len, u32 offset, u32 seed[LFG_SEED_SIZE]) {
+	u32 b[LFG_K];
+	u32 words = offset / 4, r = words % LFG_K, q = words / LFG_K;
+
+	if (len < LFG_BYTES || (offset & 3)) {
+		return 0;
+	}
+	for (int i = 0; i < LFG_K; i++) {
+		u32 x = get_be32(data + i * 4);
+		if (!lfg_maybe_junk(x)) {
+			return 0;
+		}
+		b[(r + i) % LFG_K] = x;
+	}
+	// back to the buffer right after the seed went in
+	lfg_unstep(b, 0, r);
+	for (u32 i = 0; i < q + 4; i++) {
+		lfg_unstep(b, 0, LFG_K);
+	}
+	// the two lost bits come back from the recurrence, except in the
+	// first word, where they never make it to the output anyway
+	for (int i = 0; i < LFG_SEED_SIZE; i++) {
+		b[i] = (b[i] & 0xFF00FFFF) | (b[i] << 2 & 0x00FC0000) |
+			((b[i + 16] ^ b[i + 15]) << 9 & 0x00030000);
+	}
+	memcpy(seed, b, LFG_SEED_SIZE * 4);
+	return lfg_init(b, 1);
+}
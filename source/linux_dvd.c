@@ -0,0 +1,492 @@
+/**
+ * CleanRip - linux_dvd.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * DVD/CD reading for Linux through SG_IO on /dev/sr*: READ(12) for
+ * data, READ CD for audio, READ TOC and READ DISC STRUCTURE (BCA).
+ * A read is split into pieces that a few worker threads issue at
+ * once, and the block after a sequential read is fetched while the
+ * caller hashes and writes, so the drive always has work queued.
+ * Pointing it at a regular file reads that instead, for testing
+ * without a drive.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifdef __linux__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <scsi/sg.h>
+#include "linux_dvd.h"
+#include "gc_dvd.h"
+#include "datel.h"
+
+#define DEFAULT_DEVICE	"/dev/sr0"
+#define SENSE_LEN		32
+#define CMD_TIMEOUT		30000	// ms, a drive retrying a bad sector can take a while
+
+// sense key/ASC/ASCQ packed like the DI error codes
+#define SENSE_NO_MEDIUM		0x023A00
+#define SENSE_READ_ERROR	0x031100
+#define SENSE_OUT_OF_RANGE	0x052100
+
+typedef struct {
+	u8 *dst;
+	u32 lba;
+	u32 count;
+	u32 sector_size;	// 2048 for READ(12), 2352 for READ CD
+} read_piece;
+
+typedef struct {
+	read_piece *pieces;
+	int num_pieces;
+	int max_pieces;
+	int next;			// first piece nobody picked up yet
+	int pending;		// pieces not finished
+	int failed_piece;	// lowest failed piece, -1 if none
+	u32 sense;
+} read_batch;
+
+static char device_path[256];
+static int fds[LINUX_DVD_WORKERS] = { -1, -1, -1, -1 };
+static int file_backed = 0;
+static int workers_running = 0;
+static int workers_stop = 0;
+static pthread_t workers[LINUX_DVD_WORKERS];
+static pthread_mutex_t batch_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t batch_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t batch_done = PTHREAD_COND_INITIALIZER;
+static read_batch batch;
+static u32 last_sense = 0;
+
+// the block after the last sequential read, fetched in the background
+static u8 *ahead_buf = NULL;
+static u32 ahead_size = 0;
+static u64 ahead_offset = 0;
+static u32 ahead_len = 0;
+static int ahead_active = 0;
+static u64 last_end = ~0ULL;
+
+void linux_dvd_set_device(const char *path) {
+	snprintf(device_path, sizeof(device_path), "%s", path);
+}
+
+static u32 parse_sense(const u8 *sb, int len) {
+	if (len < 3) {
+		return SENSE_READ_ERROR;
+	}
+	if ((sb[0] & 0x7F) >= 0x72) {
+		// descriptor format
+		return ((sb[1] & 0xF) << 16) | (sb[2] << 8) | sb[3];
+	}
+	if (len < 14) {
+		return (sb[2] & 0xF) << 16;
+	}
+	return ((sb[2] & 0xF) << 16) | (sb[12] << 8) | sb[13];
+}
+
+// Issues one command, returns 0 or the sense it failed with
+static u32 scsi_command(int fd, u8 *cdb, int cdb_len, void *buf, u32 len) {
+	u8 sense[SENSE_LEN];
+	sg_io_hdr_t io;
+
+	memset(&io, 0, sizeof(io));
+	memset(sense, 0, sizeof(sense));
+	io.interface_id = 'S';
+	io.cmdp = cdb;
+	io.cmd_len = cdb_len;
+	io.dxferp = buf;
+	io.dxfer_len = len;
+	io.dxfer_direction = len ? SG_DXFER_FROM_DEV : SG_DXFER_NONE;
+	io.sbp = sense;
+	io.mx_sb_len = sizeof(sense);
+	io.timeout = CMD_TIMEOUT;
+	if (ioctl(fd, SG_IO, &io) < 0) {
+		return SENSE_READ_ERROR;
+	}
+	if (io.status || io.host_status || (io.driver_status & ~SG_INFO_OK_MASK)) {
+		return io.sb_len_wr ? parse_sense(sense, io.sb_len_wr) : SENSE_READ_ERROR;
+	}
+	return 0;
+}
+
+static u32 read_sectors(int fd, read_piece *p) {
+	u8 cdb[12];
+
+	if (file_backed) {
+		u32 len = p->count * p->sector_size;
+		off_t pos = (off_t)p->lba * p->sector_size;
+		return (pread(fd, p->dst, len, pos) == (ssize_t)len) ? 0 : SENSE_OUT_OF_RANGE;
+	}
+	memset(cdb, 0, sizeof(cdb));
+	if (p->sector_size == 2352) {
+		// READ CD, CD-DA sectors, user data only
+		cdb[0] = 0xBE;
+		cdb[1] = 0x04;
+		cdb[6] = (p->count >> 16) & 0xFF;
+		cdb[7] = (p->count >> 8) & 0xFF;
+		cdb[8] = p->count & 0xFF;
+		cdb[9] = 0x10;
+	}
+	else {
+		// READ(12)
+		cdb[0] = 0xA8;
+		cdb[6] = (p->count >> 24) & 0xFF;
+		cdb[7] = (p->count >> 16) & 0xFF;
+		cdb[8] = (p->count >> 8) & 0xFF;
+		cdb[9] = p->count & 0xFF;
+	}
+	cdb[2] = (p->lba >> 24) & 0xFF;
+	cdb[3] = (p->lba >> 16) & 0xFF;
+	cdb[4] = (p->lba >> 8) & 0xFF;
+	cdb[5] = p->lba & 0xFF;
+	return scsi_command(fd, cdb, 12, p->dst, p->count * p->sector_size);
+}
+
+static void* worker_thread(void *arg) {
+	int fd = fds[(long)arg];
+
+	pthread_mutex_lock(&batch_lock);
+	while (1) {
+		while (!workers_stop && batch.next >= batch.num_pieces) {
+			pthread_cond_wait(&batch_work, &batch_lock);
+		}
+		if (workers_stop) {
+			break;
+		}
+		int n = batch.next++;
+		read_piece piece = batch.pieces[n];
+		pthread_mutex_unlock(&batch_lock);
+
+		u32 sense = read_sectors(fd, &piece);
+
+		pthread_mutex_lock(&batch_lock);
+		if (sense && (batch.failed_piece < 0 || n < batch.failed_piece)) {
+			batch.failed_piece = n;
+			batch.sense = sense;
+		}
+		if (--batch.pending == 0) {
+			pthread_cond_broadcast(&batch_done);
+		}
+	}
+	pthread_mutex_unlock(&batch_lock);
+	return NULL;
+}
+
+// Hands a contiguous read to the workers, one command per piece
+static void start_batch(u8 *dst, u64 offset, u32 len, u32 sector_size) {
+	u32 per_piece = LINUX_DVD_PIECE / sector_size;
+	u32 lba = (u32)(offset / sector_size);
+	u32 sectors = len / sector_size;
+	int needed = (sectors + per_piece - 1) / per_piece;
+
+	pthread_mutex_lock(&batch_lock);
+	if (needed > batch.max_pieces) {
+		batch.pieces = realloc(batch.pieces, needed * sizeof(read_piece));
+		batch.max_pieces = needed;
+	}
+	batch.num_pieces = 0;
+	for (u32 done = 0; done < sectors; done += per_piece) {
+		read_piece *p = &batch.pieces[batch.num_pieces++];
+		p->dst = dst + done * sector_size;
+		p->lba = lba + done;
+		p->count = (sectors - done < per_piece) ? (sectors - done) : per_piece;
+		p->sector_size = sector_size;
+	}
+	batch.next = 0;
+	batch.pending = batch.num_pieces;
+	batch.failed_piece = -1;
+	batch.sense = 0;
+	pthread_cond_broadcast(&batch_work);
+	pthread_mutex_unlock(&batch_lock);
+}
+
+static u32 wait_batch() {
+	pthread_mutex_lock(&batch_lock);
+	while (batch.pending) {
+		pthread_cond_wait(&batch_done, &batch_lock);
+	}
+	u32 sense = batch.sense;
+	pthread_mutex_unlock(&batch_lock);
+	return sense;
+}
+
+static void stop_workers() {
+	if (ahead_active) {
+		wait_batch();
+		ahead_active = 0;
+	}
+	if (workers_running) {
+		pthread_mutex_lock(&batch_lock);
+		workers_stop = 1;
+		pthread_cond_broadcast(&batch_work);
+		pthread_mutex_unlock(&batch_lock);
+		for (int i = 0; i < LINUX_DVD_WORKERS; i++) {
+			pthread_join(workers[i], NULL);
+		}
+		workers_running = 0;
+		workers_stop = 0;
+	}
+	for (int i = 0; i < LINUX_DVD_WORKERS; i++) {
+		if (fds[i] >= 0) {
+			close(fds[i]);
+			fds[i] = -1;
+		}
+	}
+	last_end = ~0ULL;
+}
+
+int init_dvd() {
+	struct stat st;
+	u8 cdb[6] = { 0 };
+
+	stop_workers();
+	if (!device_path[0]) {
+		const char *env = getenv("CLEANRIP_DRIVE");
+		linux_dvd_set_device(env ? env : DEFAULT_DEVICE);
+	}
+	if (stat(device_path, &st)) {
+		last_sense = SENSE_NO_MEDIUM;
+		return NO_HW_ACCESS;
+	}
+	file_backed = S_ISREG(st.st_mode);
+	// one descriptor per worker, the commands then don't queue up behind each other
+	for (int i = 0; i < LINUX_DVD_WORKERS; i++) {
+		fds[i] = open(device_path, O_RDONLY | (file_backed ? 0 : O_NONBLOCK));
+		if (fds[i] < 0) {
+			int err = errno;
+			stop_workers();
+			last_sense = SENSE_NO_MEDIUM;
+			return (err == ENOMEDIUM) ? NO_DISC : NO_HW_ACCESS;
+		}
+	}
+	if (!file_backed) {
+		// TEST UNIT READY
+		last_sense = scsi_command(fds[0], cdb, 6, NULL, 0);
+		if ((last_sense & 0xFFFF00) == SENSE_NO_MEDIUM) {
+			stop_workers();
+			return NO_DISC;
+		}
+	}
+	last_sense = 0;
+	for (long i = 0; i < LINUX_DVD_WORKERS; i++) {
+		pthread_create(&workers[i], NULL, worker_thread, (void*)i);
+	}
+	workers_running = 1;
+	return 0;
+}
+
+int DVD_LowRead64(void* dst, u32 len, u128 offset) {
+	if (!workers_running) {
+		last_sense = SENSE_NO_MEDIUM;
+		return -1;
+	}
+	u32 sector_size = (!(len % 2352) && !(offset % 2352)) ? 2352 : 2048;
+	if ((offset % sector_size) || (len % sector_size)) {
+		// small probes (e.g. the layer check) go through a whole sector
+		u32 skip = (u32)(offset % 2048);
+		u32 span = ((skip + len + 2047) / 2048) * 2048;
+		u8 *bounce = malloc(span);
+		if (!bounce) {
+			return -1;
+		}
+		int ret = DVD_LowRead64(bounce, span, offset - skip);
+		if (!ret) {
+			memcpy(dst, bounce + skip, len);
+		}
+		free(bounce);
+		return ret;
+	}
+
+	int hit = 0;
+	if (ahead_active) {
+		u32 sense = wait_batch();
+		ahead_active = 0;
+		if (!sense && ahead_offset == (u64)offset && ahead_len == len) {
+			memcpy(dst, ahead_buf, len);
+			hit = 1;
+		}
+	}
+	if (!hit) {
+		// a failed read ahead is read again here, so errors are reported for the caller's read
+		start_batch(dst, (u64)offset, len, sector_size);
+		last_sense = wait_batch();
+		if (last_sense) {
+			last_end = ~0ULL;
+			return 1;
+		}
+	}
+	last_sense = 0;
+
+	// keep the drive busy with the next block while this one is hashed and written
+	if ((u64)offset == last_end) {
+		if (ahead_size < len) {
+			free(ahead_buf);
+			ahead_buf = malloc(len);
+			ahead_size = ahead_buf ? len : 0;
+		}
+		if (ahead_buf) {
+			ahead_offset = (u64)offset + len;
+			ahead_len = len;
+			ahead_active = 1;
+			start_batch(ahead_buf, ahead_offset, len, sector_size);
+		}
+	}
+	last_end = (u64)offset + len;
+	return 0;
+}
+
+int DVD_LowRead64Datel(void* dst, u32 len, u128 offset, int isKnownDatel) {
+	uint64_t discoffset = (uint64_t)offset;
+	u32 disclen = len;
+	u32 fill = 0;
+	datel_adjustStartStop(&discoffset, &disclen, &fill);
+	if ((discoffset != offset) || (disclen != len))
+		memset(dst, fill, len);
+	if (disclen == 0) {
+		return 0;
+	}
+	for (int try = 0; try < 2; try++) {
+		if (DVD_LowRead64(((u8*)dst) + (discoffset - offset), disclen, discoffset) == 0) {
+			return 0;
+		}
+	}
+	if (isKnownDatel) {
+		return 1;
+	}
+	// Logic assumes READ_SIZE 0x10000
+	datel_addSkip(offset & 0xFFFF0000, 0x00100000 - (offset & 0x000F0000));
+	memset(dst, fill, len);
+	return 0;
+}
+
+int dvd_read_id() {
+	u8 readbuf[2048];
+	return DVD_LowRead64(readbuf, 2048, 0);
+}
+
+void dvd_read_bca(void* dst) {
+	u8 cdb[12];
+	u8 buf[4 + 188];
+
+	memset(dst, 0, 64);
+	if (!workers_running || file_backed) {
+		return;
+	}
+	// READ DISC STRUCTURE, BCA
+	memset(cdb, 0, sizeof(cdb));
+	cdb[0] = 0xAD;
+	cdb[7] = 0x03;
+	cdb[8] = (sizeof(buf) >> 8) & 0xFF;
+	cdb[9] = sizeof(buf) & 0xFF;
+	memset(buf, 0, sizeof(buf));
+	if (!scsi_command(fds[0], cdb, 12, buf, sizeof(buf))) {
+		memcpy(dst, buf + 4, 64);
+	}
+}
+
+int linux_dvd_read_toc(linux_dvd_toc *toc) {
+	u8 cdb[10];
+	u8 buf[4 + 8 * 100];
+
+	memset(toc, 0, sizeof(linux_dvd_toc));
+	if (!workers_running) {
+		return -1;
+	}
+	if (file_backed) {
+		struct stat st;
+		fstat(fds[0], &st);
+		toc->first_track = toc->last_track = 1;
+		toc->control[1] = 4;
+		toc->leadout = (u32)(st.st_size / 2048);
+		return 0;
+	}
+	// READ TOC, format 0 with LBA addresses
+	memset(cdb, 0, sizeof(cdb));
+	cdb[0] = 0x43;
+	cdb[6] = 1;
+	cdb[7] = (sizeof(buf) >> 8) & 0xFF;
+	cdb[8] = sizeof(buf) & 0xFF;
+	memset(buf, 0, sizeof(buf));
+	if ((last_sense = scsi_command(fds[0], cdb, 10, buf, sizeof(buf)))) {
+		return -1;
+	}
+	int entries = (((buf[0] << 8) | buf[1]) - 2) / 8;
+	toc->first_track = buf[2];
+	toc->last_track = buf[3];
+	for (int i = 0; i < entries && i < 100; i++) {
+		u8 *desc = &buf[4 + i * 8];
+		u32 lba = (desc[4] << 24) | (desc[5] << 16) | (desc[6] << 8) | desc[7];
+		if (desc[2] == 0xAA) {
+			toc->leadout = lba;
+		}
+		else if (desc[2] < 100) {
+			toc->start[desc[2]] = lba;
+			toc->control[desc[2]] = desc[1] & 0xF;
+		}
+	}
+	return toc->leadout ? 0 : -1;
+}
+
+void dvd_motor_off(int eject) {
+	u8 cdb[6] = { 0 };
+
+	if (ahead_active) {
+		wait_batch();
+		ahead_active = 0;
+	}
+	last_end = ~0ULL;
+	if (!workers_running || file_backed) {
+		return;
+	}
+	// START STOP UNIT, stop and optionally open the tray
+	cdb[0] = 0x1B;
+	cdb[4] = eject ? 0x02 : 0x00;
+	scsi_command(fds[0], cdb, 6, NULL, 0);
+}
+
+u32 dvd_get_error(void) {
+	return last_sense;
+}
+
+char *dvd_error_str() {
+	static char error_str[64];
+	switch (last_sense) {
+	case 0:
+		return "OK";
+	case SENSE_NO_MEDIUM:
+		return "Medium not present";
+	case SENSE_READ_ERROR:
+		return "Unrecovered read error";
+	case SENSE_OUT_OF_RANGE:
+		return "Logical block address out of range";
+	}
+	sprintf(error_str, "Sense %02X/%02X/%02X", (last_sense >> 16) & 0xFF, (last_sense >> 8) & 0xFF, last_sense & 0xFF);
+	return error_str;
+}
+
+void xeno_disable() {
+}
+
+#endif
@@ -41,6 +41,25 @@
 #include "crc32.h"
 #include "sha1.h"
 #include "md5.h"
+#include "partfile.h"
+#include "spill.h"
+#include "tuner.h"
+#include "ring.h"
+#include "imgsrc.h"
+#include "simdrive.h"
+#include "linux_dvd.h"
+#include "finish.h"
+#include "engine.h"
+#include "sink.h"
+#include "ciso.h"
+#include "gcz.h"
+#include "rvz.h"
+#include "wbfs.h"
+#include "chd.h"
+#include "zst.h"
+#include "store.h"
+#include "delta.h"
+#include "netdump.h"
 #include <fat.h>
 #include "m2loader/m2loader.h"
 
@@ -61,7 +80,8 @@ static DISC_INTERFACE* usb = &__io_usbstorage;
 enum {
 	TYPE_USB = 0,
 	TYPE_SD,
-	TYPE_READONLY
+	TYPE_READONLY,
+	TYPE_NET		// cleanrip-recv on another machine (--net=host)
 };
 enum {
 	SRC_INTERNAL_DISC = 0,
@@ -78,7 +98,8 @@ static DISC_INTERFACE* m2loader = &__io_m2ldr;
 enum {
 	TYPE_SD = 0,
 	TYPE_M2LOADER,
-	TYPE_READONLY
+	TYPE_READONLY,
+	TYPE_NET		// cleanrip-recv on another machine (--net=host)
 };
 #endif
 
@@ -86,11 +107,21 @@ static int selected_device = 0;
 #ifdef HW_RVL
 static int selected_source = SRC_INTERNAL_DISC;
 #endif
+static char *image_path = NULL;		// dump an image file instead of a disc (--image=path)
+static imgsrc image_source;
+static char *sim_path = NULL;		// dump from a simulated drive (--sim=script)
+static char *delta_path = NULL;		// write the image as its differences from this one (--delta=path)
+static simdrive sim_drive;
 static int calcChecksums = 0;
 static int dumpCounter = 0;
 static char gameName[32];
 static char internalName[512];
 static char mountPath[512];
+static int mirror_requested = 0;	// write a second copy to the other device (--mirror)
+static char mirrorPath[16];			// where that copy goes, empty if it isn't mounted
+static char *net_host = NULL;		// dump to cleanrip-recv instead of a device (--net=host[:port])
+static u16 net_port = NET_PORT;
+static char bca_data_for_display[64];
 static char wpadNeedScan = 0;
 static char padNeedScan = 0;
 int print_usb = 0;
@@ -101,7 +132,7 @@ u32 iosversion = -1;
 int verify_type_in_use = 0;
 GXRModeObj *vmode = NULL;
 u32 *xfb[2] = { NULL, NULL };
-int options_map[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+int options_map[11] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 int newProgressDisplay = 1;
 static int forced_disc_profile = 0;
 static u32 forced_audio_sector_size = 0;
@@ -139,8 +170,43 @@ static u32 get_forced_disc_end_sectors() {
 
 static const char *get_output_extension(int disc_type) {
 	if (disc_type == IS_OTHER_DISC && forced_disc_profile == FORCED_AUDIO_CD) {
+		if (options_map[AUDIO_OUTPUT] == AUDIO_OUT_CHD) {
+			return ".chd";
+		}
 		return (options_map[AUDIO_OUTPUT] == AUDIO_OUT_WAV || options_map[AUDIO_OUTPUT] == AUDIO_OUT_WAV_FAST) ? ".wav" : ".bin";
 	}
+	if (delta_path) {
+		return ".dlt";
+	}
+	if (disc_type == IS_OTHER_DISC && options_map[DVD_OUTPUT] == DVD_OUT_CHD) {
+		return ".chd";
+	}
+	if (disc_type == IS_OTHER_DISC && options_map[DVD_OUTPUT] == DVD_OUT_ZST) {
+		return ".zst";
+	}
+	if (disc_type == IS_OTHER_DISC && options_map[DVD_OUTPUT] == DVD_OUT_STORE) {
+		return ".rcp";
+	}
+	if (disc_type == IS_NGC_DISC || disc_type == IS_DATEL_DISC) {
+		if (options_map[NGC_OUTPUT] == NGC_OUT_CISO) {
+			return ".ciso";
+		}
+		if (options_map[NGC_OUTPUT] == NGC_OUT_GCZ) {
+			return ".gcz";
+		}
+		if (options_map[NGC_OUTPUT] == NGC_OUT_RVZ) {
+			return ".rvz";
+		}
+		if (options_map[NGC_OUTPUT] == NGC_OUT_STORE) {
+			return ".rcp";
+		}
+	}
+	if (disc_type == IS_WII_DISC && options_map[WII_OUTPUT] == WII_OUT_WBFS) {
+		return ".wbfs";
+	}
+	if (disc_type == IS_WII_DISC && options_map[WII_OUTPUT] == WII_OUT_STORE) {
+		return ".rcp";
+	}
 	return ".iso";
 }
 
@@ -164,12 +230,19 @@ static void sanitize_game_name() {
 
 static u32 detect_audio_cd_size_sectors(u32 sector_size) {
 	(void)sector_size;
+#ifdef __linux__
+	// a PC drive answers READ TOC without any fuss
+	linux_dvd_toc toc;
+	if (!image_path && !sim_path && linux_dvd_read_toc(&toc) == 0) {
+		return toc.leadout;
+	}
+#endif
 	// Keep Audio CD mode stable: avoid probe reads that can upset some drives.
 	return 360000;
 }
 
 enum {
-	MSG_SETFILE,
+	MSG_SETSINK,
 	MSG_WRITE,
 	MSG_FLUSH,
 };
@@ -180,33 +253,35 @@ typedef union _writer_msg {
 		void* data;
 		u32 length;
 		mqbox_t ret_box;
+		u64 offset;
 	};
 	uint8_t pad[32]; // pad to 32 bytes for alignment
 } writer_msg;
 
 static void* writer_thread(void* _msgq) {
-	FILE* fp = NULL;
+	sink* out = NULL;
 	mqbox_t msgq = (mqbox_t)_msgq;
 	writer_msg* msg;
 
 	// stupid libogc returns TRUE even if the message queue gets destroyed while waiting
 	while (MQ_Receive(msgq, (mqmsg_t*)&msg, MQ_MSG_BLOCK)==TRUE && msg) {
 		switch (msg->command) {
-			case MSG_SETFILE:
-				fp = (FILE*)msg->data;
+			case MSG_SETSINK:
+				out = (sink*)msg->data;
 				break;
 			case MSG_WRITE:
-				if(selected_device != TYPE_READONLY) {
-					if (fp && fwrite(msg->data, msg->length, 1, fp)!=1) {
-						// write error, signal it by pushing a NULL message to the front
-						MQ_Jam(msg->ret_box, (mqmsg_t)NULL, MQ_MSG_BLOCK);
-						return NULL;
-					}
+				if (sink_write(out, msg->data, msg->length, msg->offset)) {
+					// write error, signal it by pushing a NULL message to the front
+					MQ_Jam(msg->ret_box, (mqmsg_t)NULL, MQ_MSG_BLOCK);
+					return NULL;
 				}
 				// release the block so it can be reused
 				MQ_Send(msg->ret_box, (mqmsg_t)msg, MQ_MSG_BLOCK);
 				break;
 			case MSG_FLUSH:
+				if (out) {
+					sink_flush(out);
+				}
 				*(vu32*)msg->data = 1;
 				break;
 		}
@@ -364,6 +439,8 @@ void wait_press_A_exit_B(bool tryAgain) {
 		}
 		else if (get_buttons_pressed() & PAD_BUTTON_B) {
 			print_gecko("Exit\r\n");
+			finish_wait();
+			netdump_disconnect();
 			exit(0);
 		}
 	}
@@ -554,8 +631,112 @@ static int initialise_dvd() {
 	return ret;
 }
 
+/* Open the image file or simulated drive in place of the drive */
+static int initialise_file_source() {
+	if (sim_path) {
+		simdrive_close(&sim_drive);
+		if (simdrive_open(&sim_drive, sim_path)) {
+			print_gecko("Failed to load drive script %s\r\n", sim_path);
+			return NO_DISC;
+		}
+		print_gecko("Simulated drive: %s (%u sectors)\r\n", sim_path, simdrive_sectors(&sim_drive));
+		return 0;
+	}
+	imgsrc_close(&image_source);
+	if (imgsrc_open(&image_source, image_path)) {
+		print_gecko("Failed to open image %s\r\n", image_path);
+		return NO_DISC;
+	}
+	print_gecko("Image source: %s (%i part(s), %u byte sectors)\r\n",
+		image_path, image_source.parts, image_source.file_sector);
+	return 0;
+}
+
+/* DVD_LowRead64Datel's skip discovery, against the simulated drive */
+static int sim_read_datel(void* dst, u32 len, u64 offset, int isKnownDatel) {
+	uint64_t discoffset = offset;
+	u32 disclen = len;
+	u32 fill = 0;
+	datel_adjustStartStop(&discoffset, &disclen, &fill);
+	if ((discoffset != offset) || (disclen != len))
+		memset(dst, fill, len);
+	if (disclen == 0) {
+		return 0;
+	}
+	for (int try = 0; try < 2; try++) {
+		if (simdrive_read(&sim_drive, ((u8*)dst) + (discoffset - offset), disclen, discoffset, 2048) == 0) {
+			return 0;
+		}
+	}
+	if (isKnownDatel) {
+		return 1;
+	}
+	// Logic assumes READ_SIZE 0x10000
+	datel_addSkip(offset & 0xFFFF0000, 0x00100000 - (offset & 0x000F0000));
+	memset(dst, fill, len);
+	return 0;
+}
+
+static u32 file_sector_size = 2048;
+
+static int read_image(void* dst, u32 len, u64 offset, int isKnownDatel) {
+	return imgsrc_read(&image_source, dst, len, offset, file_sector_size);
+}
+
+static int read_sim(void* dst, u32 len, u64 offset, int isKnownDatel) {
+	return simdrive_read(&sim_drive, dst, len, offset, file_sector_size);
+}
+
+static int read_dvd(void* dst, u32 len, u64 offset, int isKnownDatel) {
+	return DVD_LowRead64(dst, len, offset);
+}
+
+static int read_dvd_datel(void* dst, u32 len, u64 offset, int isKnownDatel) {
+	return DVD_LowRead64Datel(dst, len, offset, isKnownDatel);
+}
+
+#ifdef HW_RVL
+static int read_usb(void* dst, u32 len, u64 offset, int isKnownDatel) {
+	if ((offset & 0x1FF) || (len & 0x1FF)) {
+		return 1;
+	}
+	return usb->readSectors(usb, (sec_t)(offset >> 9), (sec_t)(len >> 9), dst) ? 0 : 1;
+}
+#endif
+
+/* Picks the read for this disc from the selected source, the dump engine
+   then calls it for every block without looking at the disc type again */
+static engine_read_fn select_source_read(int disc_type) {
+	file_sector_size = (disc_type == IS_OTHER_DISC) ? get_forced_disc_sector_size() : 2048;
+	if (sim_path) {
+		return (disc_type == IS_DATEL_DISC) ? sim_read_datel : read_sim;
+	}
+	if (image_path) {
+		return read_image;
+	}
+#ifdef HW_RVL
+	if (selected_source == SRC_USB_DRIVE) {
+		return read_usb;
+	}
+#endif
+	return (disc_type == IS_DATEL_DISC) ? read_dvd_datel : read_dvd;
+}
+
+static int source_read(void* dst, u32 len, u64 offset, int disc_type, int isKnownDatel) {
+	return select_source_read(disc_type)(dst, len, offset, isKnownDatel);
+}
+
+static void source_motor_off(int eject) {
+	if (!image_path && !sim_path) {
+		dvd_motor_off(eject);
+	}
+}
+
 #ifdef HW_RVL
 static int initialise_source() {
+	if (image_path || sim_path) {
+		return initialise_file_source();
+	}
 	if (selected_source == SRC_USB_DRIVE) {
 		DrawFrameStart();
 		DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
@@ -571,29 +752,12 @@ static int initialise_source() {
 	}
 	return initialise_dvd();
 }
-
-static int source_read(void* dst, u32 len, u64 offset, int disc_type, int isKnownDatel) {
-	if (selected_source == SRC_USB_DRIVE) {
-		if ((offset & 0x1FF) || (len & 0x1FF)) {
-			return 1;
-		}
-		return usb->readSectors(usb, (sec_t)(offset >> 9), (sec_t)(len >> 9), dst) ? 0 : 1;
-	}
-	if (disc_type == IS_DATEL_DISC) {
-		return DVD_LowRead64Datel(dst, len, offset, isKnownDatel);
-	}
-	return DVD_LowRead64(dst, len, offset);
-}
 #else
 static int initialise_source() {
-	return initialise_dvd();
-}
-
-static int source_read(void* dst, u32 len, u64 offset, int disc_type, int isKnownDatel) {
-	if (disc_type == IS_DATEL_DISC) {
-		return DVD_LowRead64Datel(dst, len, offset, isKnownDatel);
+	if (image_path || sim_path) {
+		return initialise_file_source();
 	}
-	return DVD_LowRead64(dst, len, offset);
+	return initialise_dvd();
 }
 #endif
 
@@ -733,6 +897,87 @@ static int initialise_device(int fs) {
 	return ret;
 }
 
+// from network.h, whose socket names would clash with ours
+s32 if_config(char *local_ip, char *netmask, char *gateway, bool use_dhcp);
+
+/* Connect to the receiver, which stands in for the device */
+static int initialise_net() {
+	sprintf(&mountPath[0], NET_MOUNT);
+	if (netdump_connected()) {
+		return 1;
+	}
+	if (!net_initialized) {
+		char ip[16];
+		DrawFrameStart();
+		DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
+		WriteCentre(255, "Initializing Network...");
+		DrawFrameFinish();
+		if (if_config(ip, NULL, NULL, true) < 0) {
+			DrawFrameStart();
+			DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
+			WriteCentre(255, "Network failed to Initialize!");
+			wait_press_A_exit_B(true);
+			return 0;
+		}
+		net_initialized = 1;
+		print_gecko("Network Initialized! IP: %s\r\n", ip);
+	}
+	if (netdump_connect(net_host, net_port)) {
+		DrawFrameStart();
+		DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
+		sprintf(txtbuffer, "No receiver at %s:%u", net_host, net_port);
+		WriteCentre(230, txtbuffer);
+		WriteCentre(255, "Is cleanrip-recv running?");
+		wait_press_A_exit_B(true);
+		return 0;
+	}
+	return 1;
+}
+
+/* Mount the device that wasn't picked as the mirror, FAT only */
+static void mount_mirror() {
+	DISC_INTERFACE *other = NULL;
+
+	if (mirrorPath[0]) {
+		fatUnmount("mirror:/");
+		mirrorPath[0] = 0;
+	}
+	if (!mirror_requested || selected_device == TYPE_READONLY) {
+		return;
+	}
+#ifdef HW_RVL
+	if (selected_device == TYPE_SD && selected_source != SRC_USB_DRIVE) {
+		other = usb;
+	}
+	else if (selected_device == TYPE_USB || selected_device == TYPE_NET) {
+		other = sdcard;
+	}
+#else
+	if (selected_device == TYPE_SD) {
+		other = m2loader;
+	}
+	else if (selected_device == TYPE_M2LOADER || selected_device == TYPE_NET) {
+		other = get_sd_card_handler(sdcard_slot);
+	}
+#endif
+	if (other && fatMountSimple("mirror", other)) {
+		sprintf(mirrorPath, "mirror:/");
+		print_gecko("Mirroring dumps to %s\r\n", mirrorPath);
+		return;
+	}
+	DrawFrameStart();
+	DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
+	WriteCentre(230, "No FAT device to mirror to,");
+	WriteCentre(255, "dumping to one device only");
+	wait_press_A("to continue");
+}
+
+// disc headers are big endian, which only the console reads natively
+static u32 header_u32(const char *p) {
+	const u8 *b = (const u8*)p;
+	return ((u32)b[0] << 24) | ((u32)b[1] << 16) | ((u32)b[2] << 8) | b[3];
+}
+
 /* identify whether this disc is a Gamecube or Wii disc */
 static int identify_disc() {
 	char readbuf[2048] __attribute__((aligned(32)));
@@ -755,11 +1000,11 @@ static int identify_disc() {
 	} else {
 		sprintf(&gameName[0], "disc%i", dumpCounter);
 	}
-	if ((*(volatile u32*)(readbuf + 0x1C)) == NGC_MAGIC) {
+	if (header_u32(readbuf + 0x1C) == NGC_MAGIC) {
 		print_gecko("NGC disc\r\n");
 		return IS_NGC_DISC;
 	}
-	if ((*(volatile u32*)(readbuf + 0x18)) == WII_MAGIC) {
+	if (header_u32(readbuf + 0x18) == WII_MAGIC) {
 		print_gecko("Wii disc\r\n");
 		return IS_WII_DISC;
 	}
@@ -1004,6 +1249,19 @@ char *getChunkSizeOption() {
 	return 0;
 }
 
+char *getSpillSizeOption() {
+	int opt = options_map[WII_SPILL_SIZE];
+	if (opt == SPILL_MAX)
+		return "Max";
+	else if (opt == SPILL_16MB)
+		return "16MB";
+	else if (opt == SPILL_32MB)
+		return "32MB";
+	else if (opt == SPILL_OFF)
+		return "Off";
+	return 0;
+}
+
 char *getAudioOutputOption() {
 	int opt = options_map[AUDIO_OUTPUT];
 	if (opt == AUDIO_OUT_BIN)
@@ -1014,6 +1272,47 @@ char *getAudioOutputOption() {
 		return "WAV (fast)";
 	else if (opt == AUDIO_OUT_WAV_BEST)
 		return "WAV (best)";
+	else if (opt == AUDIO_OUT_CHD)
+		return "CHD";
+	return 0;
+}
+
+char *getNgcOutputOption() {
+	int opt = options_map[NGC_OUTPUT];
+	if (opt == NGC_OUT_ISO)
+		return "ISO";
+	else if (opt == NGC_OUT_CISO)
+		return "CISO";
+	else if (opt == NGC_OUT_GCZ)
+		return "GCZ";
+	else if (opt == NGC_OUT_RVZ)
+		return "RVZ";
+	else if (opt == NGC_OUT_STORE)
+		return "Store";
+	return 0;
+}
+
+char *getWiiOutputOption() {
+	int opt = options_map[WII_OUTPUT];
+	if (opt == WII_OUT_ISO)
+		return "ISO";
+	else if (opt == WII_OUT_WBFS)
+		return "WBFS";
+	else if (opt == WII_OUT_STORE)
+		return "Store";
+	return 0;
+}
+
+char *getDvdOutputOption() {
+	int opt = options_map[DVD_OUTPUT];
+	if (opt == DVD_OUT_ISO)
+		return "ISO";
+	else if (opt == DVD_OUT_CHD)
+		return "CHD";
+	else if (opt == DVD_OUT_ZST)
+		return "ZST";
+	else if (opt == DVD_OUT_STORE)
+		return "Store";
 	return 0;
 }
 
@@ -1025,21 +1324,40 @@ int getMaxPos(int option_pos) {
 		return CHUNK_DELIM;
 	case WII_NEWFILE:
 		return NEWFILE_DELIM;
+	case WII_SPILL_SIZE:
+		return SPILL_DELIM;
 	case AUDIO_OUTPUT:
 		return AUDIO_OUT_DELIM;
+	case NGC_OUTPUT:
+		return NGC_OUT_DELIM;
+	case WII_OUTPUT:
+		return WII_OUT_DELIM;
+	case DVD_OUTPUT:
+		return DVD_OUT_DELIM;
 	}
 	return 0;
 }
 
+// The receiver only takes files, there is no store on it to add chunks to
+static int option_hidden(int option_pos, int opt) {
+	if (selected_device != TYPE_NET) {
+		return 0;
+	}
+	return (option_pos == NGC_OUTPUT && opt == NGC_OUT_STORE) || (option_pos == WII_OUTPUT && opt == WII_OUT_STORE)
+		|| (option_pos == DVD_OUTPUT && opt == DVD_OUT_STORE);
+}
+
 void toggleOption(int option_pos, int dir) {
 	int max = getMaxPos(option_pos);
-	if (options_map[option_pos] + dir >= max) {
-		options_map[option_pos] = 0;
-	} else if (options_map[option_pos] + dir < 0) {
-		options_map[option_pos] = max - 1;
-	} else {
-		options_map[option_pos] += dir;
-	}
+	do {
+		if (options_map[option_pos] + dir >= max) {
+			options_map[option_pos] = 0;
+		} else if (options_map[option_pos] + dir < 0) {
+			options_map[option_pos] = max - 1;
+		} else {
+			options_map[option_pos] += dir;
+		}
+	} while (option_hidden(option_pos, options_map[option_pos]));
 }
 
 static void get_settings(int disc_type) {
@@ -1050,11 +1368,12 @@ static void get_settings(int disc_type) {
 		maxSettingPos = MAX_WII_OPTIONS - 1;
 	}
 	else if (disc_type == IS_OTHER_DISC) {
-		// For forced non-Nintendo profiles expose chunking + audio output mode.
-		maxSettingPos = (forced_disc_profile == FORCED_AUDIO_CD) ? 2 : 1;
+		// For forced non-Nintendo profiles expose chunking + audio output mode (or the swap buffer and output format).
+		maxSettingPos = (forced_disc_profile == FORCED_AUDIO_CD) ? 2 : 3;
 	}
 	else {
-		maxSettingPos = MAX_NGC_OPTIONS - 1;
+		// Gamecube only picks the output format
+		maxSettingPos = 0;
 	}
 
 	while ((get_buttons_pressed() & PAD_BUTTON_A));
@@ -1073,6 +1392,10 @@ static void get_settings(int disc_type) {
 			DrawSelectableButton(vmode->fbWidth - 220, 160 + (32 * 2), -1, 160 + (32 * 2) + 30, getChunkSizeOption(), (currentSettingPos == 1) ? B_SELECTED : B_NOSELECT, -1);
 			WriteFont(80, 160 + (32 * 3), "New device per chunk");
 			DrawSelectableButton(vmode->fbWidth - 220, 160 + (32 * 3), -1, 160 + (32 * 3) + 30, getNewFileOption(), (currentSettingPos == 2) ? B_SELECTED : B_NOSELECT, -1);
+			WriteFont(80, 160 + (32 * 4), "Swap buffer");
+			DrawSelectableButton(vmode->fbWidth - 220, 160 + (32 * 4), -1, 160 + (32 * 4) + 30, getSpillSizeOption(), (currentSettingPos == 3) ? B_SELECTED : B_NOSELECT, -1);
+			WriteFont(80, 160 + (32 * 5), "Output Format");
+			DrawSelectableButton(vmode->fbWidth - 220, 160 + (32 * 5), -1, 160 + (32 * 5) + 30, getWiiOutputOption(), (currentSettingPos == 4) ? B_SELECTED : B_NOSELECT, -1);
 		}
 		else if (disc_type == IS_OTHER_DISC) {
 			WriteFont(80, 160 + (32 * 1), "Chunk Size");
@@ -1083,6 +1406,16 @@ static void get_settings(int disc_type) {
 				WriteFont(80, 160 + (32 * 3), "Audio Output");
 				DrawSelectableButton(vmode->fbWidth - 220, 160 + (32 * 3), -1, 160 + (32 * 3) + 30, getAudioOutputOption(), (currentSettingPos == 2) ? B_SELECTED : B_NOSELECT, -1);
 			}
+			else {
+				WriteFont(80, 160 + (32 * 3), "Swap buffer");
+				DrawSelectableButton(vmode->fbWidth - 220, 160 + (32 * 3), -1, 160 + (32 * 3) + 30, getSpillSizeOption(), (currentSettingPos == 2) ? B_SELECTED : B_NOSELECT, -1);
+				WriteFont(80, 160 + (32 * 4), "Output Format");
+				DrawSelectableButton(vmode->fbWidth - 220, 160 + (32 * 4), -1, 160 + (32 * 4) + 30, getDvdOutputOption(), (currentSettingPos == 3) ? B_SELECTED : B_NOSELECT, -1);
+			}
+		}
+		else {
+			WriteFont(80, 160 + (32 * 1), "Output Format");
+			DrawSelectableButton(vmode->fbWidth - 220, 160 + (32 * 1), -1, 160 + (32 * 1) + 30, getNgcOutputOption(), B_SELECTED, -1);
 		}
 		WriteCentre(370,"Press  A  to continue");
 		DrawAButton(265,360);
@@ -1093,14 +1426,30 @@ static void get_settings(int disc_type) {
 		if(btns & PAD_BUTTON_RIGHT) {
 			int optionPos = optionBase + currentSettingPos;
 			if (disc_type == IS_OTHER_DISC) {
-				optionPos = (currentSettingPos == 0) ? WII_CHUNK_SIZE : (currentSettingPos == 1 ? WII_NEWFILE : AUDIO_OUTPUT);
+				optionPos = (currentSettingPos == 0) ? WII_CHUNK_SIZE : (currentSettingPos == 1 ? WII_NEWFILE
+					: (forced_disc_profile == FORCED_AUDIO_CD ? AUDIO_OUTPUT
+						: (currentSettingPos == 3 ? DVD_OUTPUT : WII_SPILL_SIZE)));
+			}
+			else if (disc_type != IS_WII_DISC) {
+				optionPos = NGC_OUTPUT;
+			}
+			else if (currentSettingPos == 4) {
+				optionPos = WII_OUTPUT;
 			}
 			toggleOption(optionPos, 1);
 		}
 		if(btns & PAD_BUTTON_LEFT) {
 			int optionPos = optionBase + currentSettingPos;
 			if (disc_type == IS_OTHER_DISC) {
-				optionPos = (currentSettingPos == 0) ? WII_CHUNK_SIZE : (currentSettingPos == 1 ? WII_NEWFILE : AUDIO_OUTPUT);
+				optionPos = (currentSettingPos == 0) ? WII_CHUNK_SIZE : (currentSettingPos == 1 ? WII_NEWFILE
+					: (forced_disc_profile == FORCED_AUDIO_CD ? AUDIO_OUTPUT
+						: (currentSettingPos == 3 ? DVD_OUTPUT : WII_SPILL_SIZE)));
+			}
+			else if (disc_type != IS_WII_DISC) {
+				optionPos = NGC_OUTPUT;
+			}
+			else if (currentSettingPos == 4) {
+				optionPos = WII_OUTPUT;
 			}
 			toggleOption(optionPos, -1);
 		}
@@ -1118,111 +1467,117 @@ static void get_settings(int disc_type) {
 	while(get_buttons_pressed() & PAD_BUTTON_B);
 }
 
-void prompt_new_file(FILE **fp, int chunk, int fs, int silent, int disc_type) {
-	// Close the file and unmount the fs
-	fclose(*fp);
-	if(silent == ASK_USER) {
-		if (fs == TYPE_FAT) {
-			fatUnmount("fat:/");
-			if (selected_device == TYPE_SD) {
-				sdcard->shutdown(sdcard);
-			}
+static void unmount_chunk_device(int fs) {
+	if (fs == TYPE_FAT) {
+		fatUnmount("fat:/");
+		if (selected_device == TYPE_SD) {
+			sdcard->shutdown(sdcard);
+		}
 #ifdef HW_DOL
-			else if (selected_device == TYPE_M2LOADER) {
-				m2loader->shutdown(m2loader);
-			}
+		else if (selected_device == TYPE_M2LOADER) {
+			m2loader->shutdown(m2loader);
+		}
 #else
-			else if (selected_device == TYPE_USB) {
-				usb->shutdown(usb);
-			}
+		else if (selected_device == TYPE_USB) {
+			usb->shutdown(usb);
+		}
 #endif
+	}
+	else if (fs == TYPE_NTFS) {
+		ntfsUnmount(mounts[0].name, true);
+		free(mounts);
+		if (selected_device == TYPE_SD) {
+			sdcard->shutdown(sdcard);
 		}
-		else if (fs == TYPE_NTFS) {
-			ntfsUnmount(mounts[0].name, true);
-			free(mounts);
-			if (selected_device == TYPE_SD) {
-				sdcard->shutdown(sdcard);
-			}
 #ifdef HW_DOL
-			else if (selected_device == TYPE_M2LOADER) {
-				m2loader->shutdown(m2loader);
-			}
+		else if (selected_device == TYPE_M2LOADER) {
+			m2loader->shutdown(m2loader);
+		}
 #else
-			else if (selected_device == TYPE_USB) {
-				usb->shutdown(usb);
-			}
-#endif
+		else if (selected_device == TYPE_USB) {
+			usb->shutdown(usb);
 		}
-		// Stop the disc if we're going to wait on the user
-		dvd_motor_off(0);
+#endif
 	}
+}
 
-	if(silent == ASK_USER) {
-		int ret = -1;
-		do {
-				DrawFrameStart();
-				DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
-				WriteCentre(255, "Insert a device for the next chunk");
-				wait_press_A_exit_B(false);
-
-			if (fs == TYPE_FAT) {
-				int i = 0;
-				for (i = 0; i < 10; i++) {
-					switch (selected_device) {
-						case TYPE_SD:
-							ret = fatMountSimple("fat", sdcard);
-							break;
+// Returns 1 once the device for the next chunk is mounted
+static int mount_chunk_device(int fs) {
+	int ret = -1;
+	if (fs == TYPE_FAT) {
+		int i = 0;
+		for (i = 0; i < 10; i++) {
+			switch (selected_device) {
+				case TYPE_SD:
+					ret = fatMountSimple("fat", sdcard);
+					break;
 #ifdef HW_DOL
-						case TYPE_M2LOADER:
-							ret = fatMountSimple("fat", m2loader);
-							break;
+				case TYPE_M2LOADER:
+					ret = fatMountSimple("fat", m2loader);
+					break;
 #else
-						case TYPE_USB:
-							ret = fatMountSimple("fat", usb);
-							break;
+				case TYPE_USB:
+					ret = fatMountSimple("fat", usb);
+					break;
 #endif
-					}
-					if (ret == 1) {
-						break;
-					}
-				}
 			}
-			else if (fs == TYPE_NTFS) {
-				int mountCount = 0;
-				if(selected_device == TYPE_SD) {
-					mountCount = ntfsMountDevice(sdcard, &mounts, NTFS_DEFAULT | NTFS_RECOVER);
-				}
+			if (ret == 1) {
+				break;
+			}
+		}
+	}
+	else if (fs == TYPE_NTFS) {
+		int mountCount = 0;
+		if(selected_device == TYPE_SD) {
+			mountCount = ntfsMountDevice(sdcard, &mounts, NTFS_DEFAULT | NTFS_RECOVER);
+		}
 #ifdef HW_DOL
-				if(selected_device == TYPE_M2LOADER) {
-					mountCount = ntfsMountDevice(m2loader, &mounts, NTFS_DEFAULT | NTFS_RECOVER);
-				}
+		if(selected_device == TYPE_M2LOADER) {
+			mountCount = ntfsMountDevice(m2loader, &mounts, NTFS_DEFAULT | NTFS_RECOVER);
+		}
 #else
-				if(selected_device ==  TYPE_USB) {
-					mountCount = ntfsMountDevice(usb, &mounts, NTFS_DEFAULT | NTFS_RECOVER);
-				}
+		if(selected_device ==  TYPE_USB) {
+			mountCount = ntfsMountDevice(usb, &mounts, NTFS_DEFAULT | NTFS_RECOVER);
+		}
 #endif
-				if (mountCount && mountCount != -1) {
-					sprintf(&mountPath[0], "%s:/", mounts[0].name);
-					ret = 1;
-				} else {
-					ret = -1;
-				}
-			}
-			if (ret != 1) {
-				DrawFrameStart();
-				DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
-				sprintf(txtbuffer, "Error Mounting Device [%08X]", ret);
-				WriteCentre(255, txtbuffer);
-				wait_press_A_exit_B(true);
-			}
-		} while (ret != 1);
+		if (mountCount && mountCount != -1) {
+			sprintf(&mountPath[0], "%s:/", mounts[0].name);
+			ret = 1;
+		} else {
+			ret = -1;
+		}
 	}
+	return ret;
+}
+
+static void show_mount_error(int ret) {
+	DrawFrameStart();
+	DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
+	sprintf(txtbuffer, "Error Mounting Device [%08X]", ret);
+	WriteCentre(255, txtbuffer);
+	wait_press_A_exit_B(true);
+}
+
+static void wait_chunk_device(int fs) {
+	int ret = -1;
+	do {
+			DrawFrameStart();
+			DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
+			WriteCentre(255, "Insert a device for the next chunk");
+			wait_press_A_exit_B(false);
 
-	*fp = NULL;
+		ret = mount_chunk_device(fs);
+		if (ret != 1) {
+			show_mount_error(ret);
+		}
+	} while (ret != 1);
+}
+
+// The chunk starts at origin in the image
+static void open_chunk_file(sink *out, int chunk, u64 origin, int disc_type) {
 	sprintf(txtbuffer, "%s%s.part%i%s", &mountPath[0], &gameName[0], chunk, get_output_extension(disc_type));
 	remove(&txtbuffer[0]);
-	*fp = fopen(&txtbuffer[0], "wb");
-	if (*fp == NULL) {
+	if (sink_file_open(out, &txtbuffer[0], origin)) {
 		DrawFrameStart();
 		DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
 		WriteCentre(230, "Failed to create file:");
@@ -1232,29 +1587,35 @@ void prompt_new_file(FILE **fp, int chunk, int fs, int silent, int disc_type) {
 		sleep(5);
 		exit(0);
 	}
+}
+
+void prompt_new_file(sink *out, int chunk, u64 origin, int fs, int silent, int disc_type) {
+	// Close the file and unmount the fs
+	sink_close(out);
+	if(silent == ASK_USER) {
+		unmount_chunk_device(fs);
+		// Stop the disc if we're going to wait on the user
+		source_motor_off(0);
+		wait_chunk_device(fs);
+	}
+
+	open_chunk_file(out, chunk, origin, disc_type);
 	if(silent == ASK_USER) {
 		initialise_source();
 	}
 }
 
-void dump_bca() {
-	print_gecko("dumping bca to %s%s.bca\n", &mountPath[0], &gameName[0]);
-	char bca_data[64] __attribute__((aligned(32)));
-	memset(bca_data, 0, 64);
-	DCZeroRange(bca_data, 64);
-	DCFlushRange(bca_data, 64);
-	dvd_read_bca(bca_data);
-	memcpy(bca_data_for_display, bca_data, sizeof(bca_data));
-
-	sprintf(txtbuffer, "%s%s.bca", &mountPath[0], &gameName[0]);
-	FILE *fp = fopen(txtbuffer, "wb");
+static void write_bca(const char *mount, const char *bca_data) {
+	print_gecko("dumping bca to %s%s.bca\n", mount, &gameName[0]);
+	sprintf(txtbuffer, "%s%s.bca", mount, &gameName[0]);
+	FILE *fp = dump_fopen(txtbuffer, "wb");
 	if (fp) {
 		fwrite(bca_data, 1, 0x40, fp);
 		fclose(fp);
 	}
 
-	sprintf(txtbuffer, "%s%s.bca.txt", &mountPath[0], &gameName[0]);
-	fp = fopen(txtbuffer, "w");
+	sprintf(txtbuffer, "%s%s.bca.txt", mount, &gameName[0]);
+	fp = dump_fopen(txtbuffer, "w");
 	if (fp) {
 		for (int i = 0; i < 64; i++) {
 			for (int b = 7; b >= 0; b--) {
@@ -1267,41 +1628,39 @@ void dump_bca() {
 	}
 }
 
-static void write_le32(FILE *fp, u32 value) {
-	fputc((int)(value & 0xFF), fp);
-	fputc((int)((value >> 8) & 0xFF), fp);
-	fputc((int)((value >> 16) & 0xFF), fp);
-	fputc((int)((value >> 24) & 0xFF), fp);
-}
+// The BCA is read once and written next to each copy of the image, mirror may be NULL
+void dump_bca(const char *mirror) {
+	char bca_data[64] __attribute__((aligned(32)));
+	memset(bca_data, 0, 64);
+	DCZeroRange(bca_data, 64);
+	DCFlushRange(bca_data, 64);
+	if (image_path || sim_path) {
+		imgsrc *img = !sim_path ? &image_source : (sim_drive.has_image ? &sim_drive.image : NULL);
+		if (img) {
+			imgsrc_read_bca(img, bca_data, 64);
+		}
+	}
+	else {
+		dvd_read_bca(bca_data);
+	}
+	memcpy(bca_data_for_display, bca_data, sizeof(bca_data));
 
-void write_wav_header(FILE *fp, u32 data_size) {
-	if (!fp) {
-		return;
+	write_bca(&mountPath[0], bca_data);
+	if (mirror) {
+		write_bca(mirror, bca_data);
 	}
-	// 44-byte PCM RIFF header, 16-bit stereo 44.1kHz
-	fwrite("RIFF", 1, 4, fp);
-	write_le32(fp, data_size + 36);
-	fwrite("WAVE", 1, 4, fp);
-	fwrite("fmt ", 1, 4, fp);
-	write_le32(fp, 16);          // PCM fmt chunk size
-	fputc(1, fp); fputc(0, fp);  // AudioFormat = PCM
-	fputc(2, fp); fputc(0, fp);  // NumChannels = 2
-	write_le32(fp, 44100);       // SampleRate
-	write_le32(fp, 176400);      // ByteRate = 44100*2*2
-	fputc(4, fp); fputc(0, fp);  // BlockAlign = 4
-	fputc(16, fp); fputc(0, fp); // BitsPerSample = 16
-	fwrite("data", 1, 4, fp);
-	write_le32(fp, data_size);
-}
-
-void dump_audio_cue(const char *audioFileName, int isWave) {
-	if (selected_device == TYPE_READONLY || !audioFileName) {
+}
+
+void dump_audio_cue(const char *mount, const char *base, const char *audioFileName, int isWave) {
+	char path[1024];
+
+	if (!audioFileName) {
 		return;
 	}
 
-	sprintf(txtbuffer, "%s%s.cue", &mountPath[0], &gameName[0]);
-	remove(&txtbuffer[0]);
-	FILE *fp = fopen(txtbuffer, "wb");
+	sprintf(path, "%s%s.cue", mount, base);
+	dump_remove(path);
+	FILE *fp = dump_fopen(path, "wb");
 	if (!fp) {
 		return;
 	}
@@ -1312,63 +1671,59 @@ void dump_audio_cue(const char *audioFileName, int isWave) {
 	fclose(fp);
 }
 
-void dump_info(char *md5, char *sha1, u32 crc32, int verified, u32 seconds, char* name) {
-	if(selected_device == TYPE_READONLY) {
-		return;
-	}
-	
+void dump_info(finish_task *task, int verified, const char* name) {
 	char infoLine[1024];
-	char timeLine[256];
-	memset(infoLine, 0, 1024);
-	memset(timeLine, 0, 256);
-	time_t curtime;
-	time(&curtime);
+	char timeLine[32];
+	char path[1024];
+	memset(infoLine, 0, sizeof(infoLine));
+	memset(timeLine, 0, sizeof(timeLine));
+	time_t curtime = (time_t)task->dumped_at;
 	strftime(timeLine, sizeof(timeLine), "%Y-%m-%d %H:%M:%S", localtime(&curtime));
 
-	if(md5 && sha1 && crc32) {
-		sprintf(infoLine, "--File Generated by CleanRip v%i.%i.%i--"
+	if(task->checksums && task->crc32) {
+		snprintf(infoLine, sizeof(infoLine), "--File Generated by CleanRip v%i.%i.%i--"
 						  "\r\n\r\nFilename: %s\r\nInternal Name: %s\r\nMD5: %s\r\n"
 						  "SHA-1: %s\r\nCRC32: %08X\r\nVersion: 1.0%i\r\nVerified: %s\r\nDuration: %u min. %u sec\r\nDumped at: %s.\r\n",
-				V_MAJOR,V_MID,V_MINOR,&gameName[0],&internalName[0], md5, sha1, crc32, *(u8*)0x80000007,
-				verified ? "Yes" : "No", seconds/60, seconds%60, timeLine);
+				V_MAJOR,V_MID,V_MINOR,task->game,task->internal, task->md5, task->sha1, task->crc32, task->version,
+				verified ? "Yes" : "No", task->seconds/60, task->seconds%60, timeLine);
 	}
 	else {
-		sprintf(infoLine, "--File Generated by CleanRip v%i.%i.%i--"
+		snprintf(infoLine, sizeof(infoLine), "--File Generated by CleanRip v%i.%i.%i--"
 						  "\r\n\r\nFilename: %s\r\nInternal Name: %s\r\n"
 						  "CRC32: %08X\r\nVersion: 1.0%i\r\nVerified: %s\r\nDuration: %u min. %u sec\r\nDumped at: %s.\r\n"
 						  "\r\n-- DO NOT USE THIS FOR REDUMP SUBMISSIONS, ENABLE CHECKSUM CALCULATIONS FOR THAT!",
-				V_MAJOR,V_MID,V_MINOR,&gameName[0],&internalName[0], crc32, *(u8*)0x80000007,
-				verified ? "Yes" : "No", seconds/60, seconds%60, timeLine);
+				V_MAJOR,V_MID,V_MINOR,task->game,task->internal, task->crc32, task->version,
+				verified ? "Yes" : "No", task->seconds/60, task->seconds%60, timeLine);
 	}
 
-	if (name != NULL) {
-		sprintf(txtbuffer, "%s%s-dumpinfo.txt", &mountPath[0], &name[0]);
-	}
-	else {
-		sprintf(txtbuffer, "%s%s-dumpinfo.txt", &mountPath[0], &gameName[0]);
-	}
-	
-	remove(&txtbuffer[0]);
-	FILE *fp = fopen(txtbuffer, "wb");
+	snprintf(path, sizeof(path), "%s%s-dumpinfo.txt", task->mount, name ? name : task->game);
+	dump_remove(path);
+	FILE *fp = dump_fopen(path, "wb");
 	if (fp) {
 		fwrite(infoLine, 1, strlen(&infoLine[0]), fp);
 		fclose(fp);
 	}
 }
 
-void renameFile(char* mountPath, char* befor, char* after, char* base) {
-	char tempstr[2048];
+void renameFile(const char* mountPath, const char* befor, const char* after, const char* base) {
+	char beforePath[1024];
+	char afterPath[1024];
 
 	if (mountPath == NULL || befor == NULL || after == NULL || base == NULL) return;
 
-	sprintf(txtbuffer, "%s%s%s", &mountPath[0], &befor[0], &base[0]);
-	sprintf(tempstr, "%s%s%s", &mountPath[0], &after[0], &base[0]);
-	remove(&tempstr[0]);
-	if (rename(txtbuffer, tempstr) == 0) {
-		print_gecko("Renamed: %s\r\n\t->%s\r\n", txtbuffer, tempstr);
+	sprintf(beforePath, "%s%s%s", &mountPath[0], &befor[0], &base[0]);
+	sprintf(afterPath, "%s%s%s", &mountPath[0], &after[0], &base[0]);
+	// a finish task run again after a crash must not remove what it renamed the first time
+	if (!dump_exists(beforePath)) {
+		print_gecko("Rename skipped, not found: %s\r\n", beforePath);
+		return;
+	}
+	dump_remove(&afterPath[0]);
+	if (dump_rename(beforePath, afterPath) == 0) {
+		print_gecko("Renamed: %s\r\n\t->%s\r\n", beforePath, afterPath);
 	}
 	else {
-		print_gecko("Rename failed: %s\r\n", txtbuffer);
+		print_gecko("Rename failed: %s\r\n", beforePath);
 	}
 }
 
@@ -1400,23 +1755,311 @@ char *getDiscTypeStr(int disc_type, bool isDualLayer) {
 #define MSG_COUNT 8
 #define THREAD_PRIO 128
 
+#ifdef HW_RVL
+#define SPILL_MAX_SIZE (48*1024*1024)	// clamped to what MEM2 can spare
+#else
+#define SPILL_MAX_SIZE (8*1024*1024)
+#endif
+
+static u32 get_spill_size() {
+	switch (options_map[WII_SPILL_SIZE]) {
+	case SPILL_16MB:
+		return 16*1024*1024;
+	case SPILL_32MB:
+		return 32*1024*1024;
+	case SPILL_OFF:
+		return 0;
+	default:
+		return SPILL_MAX_SIZE;
+	}
+}
+
+static int engine_profile(int disc_type) {
+	switch (disc_type) {
+	case IS_NGC_DISC:
+		return PROFILE_GAMECUBE;
+	case IS_WII_DISC:
+		return PROFILE_WII;
+	case IS_DATEL_DISC:
+		return PROFILE_DATEL;
+	default:
+		return (forced_disc_profile == FORCED_AUDIO_CD) ? PROFILE_AUDIO_CD : PROFILE_DVD_VIDEO;
+	}
+}
+
+// The first MB of a Datel disc was read, tell the user what it is
+static int datel_check(u32 crc100000) {
+	int isKnownDatel = datel_findCrcSum(crc100000);
+	DrawFrameStart();
+	DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
+	if(!isKnownDatel) {
+		WriteCentre(215, "(Warning: This disc will take a while to dump!)");
+	}
+	sprintf(txtbuffer, "%s CRC100000=%08X", (isKnownDatel ? "Known":"Unknown"), crc100000);
+	WriteCentre(255, txtbuffer);
+	wait_press_A_exit_B(false);
+	return isKnownDatel;
+}
+
+// Opens the part on the freshly mounted device and queues everything read while it was out
+static void resume_after_swap(sink *out, spill_buf *spill, writer_msg *msg, mqbox_t msgq, mqbox_t blockq,
+								u32 block_size, int chunk, u64 origin, int disc_type) {
+	writer_msg *smsg;
+	open_chunk_file(out, chunk, origin, disc_type);
+
+	msg->command = MSG_SETSINK;
+	msg->data = out;
+	MQ_Send(msgq, (mqmsg_t)msg, MQ_MSG_BLOCK);
+	while (spill_used(spill)) {
+		MQ_Receive(blockq, (mqmsg_t*)&smsg, MQ_MSG_BLOCK);
+		if (smsg == NULL) {
+			// write error, leave it for the dump loop to report
+			MQ_Jam(blockq, (mqmsg_t)NULL, MQ_MSG_BLOCK);
+			break;
+		}
+		smsg->command = MSG_WRITE;
+		smsg->data = smsg+1;
+		smsg->length = spill_pop(spill, smsg+1, block_size);
+		smsg->ret_box = blockq;
+		smsg->offset = origin;
+		origin += smsg->length;
+		MQ_Send(msgq, (mqmsg_t)smsg, MQ_MSG_BLOCK);
+	}
+}
+
+// verify_init() keeps reloading until every DAT is found
+static int dats_loaded() {
+	return verify_is_available(IS_NGC_DISC) != VERIFY_INTERNAL_CRC
+#ifdef HW_RVL
+		&& verify_is_available(IS_WII_DISC) != VERIFY_INTERNAL_CRC
+#endif
+		;
+}
+
+/* Verifies a dump against the DATs and names its files to match. Runs on the
+   finish thread while the next disc is being read, so only the task is used */
+static void finish_dump(finish_task *task) {
+	char tempstr[64];
+	char* name = NULL;
+	int verified = 0;
+	int disc_type = task->disc_type;
+	int canVerifyWithDat = (disc_type == IS_NGC_DISC || disc_type == IS_WII_DISC || disc_type == IS_DATEL_DISC);
+	int availableVerificationType = canVerifyWithDat ? verify_is_available(disc_type) : -1;
+
+	if (canVerifyWithDat) {
+		if(availableVerificationType != VERIFY_INTERNAL_CRC && task->checksums) {
+			verified = verify_findMD5Sum(task->md5, disc_type);
+		}
+		else {
+			verified = verify_findCrc32(task->crc32, disc_type);
+		}
+	}
+	if (verified && availableVerificationType != VERIFY_INTERNAL_CRC) {
+		name = verify_get_name(0);
+		if (!task->readonly) {
+			if (task->parts) {
+				for (int i = 0; i < task->parts; i++) {
+					sprintf(tempstr, ".part%i%s", i, task->ext);
+					renameFile(task->mount, task->game, name, &tempstr[0]);
+				}
+			}
+			else {
+				renameFile(task->mount, task->game, name, task->ext);
+			}
+			// a WBFS split for FAT goes on in .wbf1, .wbf2...
+			if (!strcmp(task->ext, ".wbfs")) {
+				for (int i = 1; i < WBFS_MAX_PARTS; i++) {
+					wbfs_part_ext(i, tempstr);
+					renameFile(task->mount, task->game, name, tempstr);
+				}
+			}
+#ifdef HW_RVL
+			renameFile(task->mount, task->game, name, ".bca");
+#endif
+		}
+	}
+	if ((disc_type == IS_DATEL_DISC)) {
+		verified = datel_findMD5Sum(task->md5);
+		if (verified) {
+			name = datel_get_name(0);
+			if (!task->readonly) {
+				renameFile(task->mount, task->game, name, task->ext);
+				renameFile(task->mount, task->game, name, ".skp");
+#ifdef HW_RVL
+				renameFile(task->mount, task->game, name, ".bca");
+#endif
+			}
+		}
+	}
+
+	if (!task->readonly) {
+		dump_info(task, verified, task->checksums ? name : NULL);
+		// a CHD has its own track list
+		if (task->audio && strcmp(task->ext, ".chd")) {
+			char cueFileName[80];
+			sprintf(cueFileName, "%s%s", task->game, task->ext);
+			dump_audio_cue(task->mount, task->game, &cueFileName[0], strcmp(task->ext, ".wav") == 0);
+		}
+		if ((disc_type == IS_DATEL_DISC) && !(verified)) {
+			sprintf(tempstr, "datel_%08x", task->crc100000);
+			renameFile(task->mount, task->game, &tempstr[0], task->ext);
+			renameFile(task->mount, task->game, &tempstr[0], "-dumpinfo.txt");
+			renameFile(task->mount, task->game, &tempstr[0], ".skp");
+#ifdef HW_RVL
+			renameFile(task->mount, task->game, &tempstr[0], ".bca");
+#endif
+		}
+	}
+
+	if (!canVerifyWithDat) {
+		snprintf(task->result, sizeof(task->result), "%s CRC32: %08X", task->game, task->crc32);
+	}
+	else if ((disc_type == IS_DATEL_DISC)) {
+		snprintf(task->result, sizeof(task->result), "%s: %s", task->game,
+				 verified ? datel_get_name(1) : "Not Verified with datel.dat");
+	}
+	else if (verified) {
+		snprintf(task->result, sizeof(task->result), "%s: %s", task->game,
+				 (availableVerificationType != VERIFY_INTERNAL_CRC) ? verify_get_name(1) : "Verified disc dump");
+	}
+	else {
+		snprintf(task->result, sizeof(task->result), "%s: Not verified with redump DAT", task->game);
+	}
+	if (task->checksums && canVerifyWithDat) {
+		print_gecko("MD5: %s\r\n", verified ? "Verified OK" : "Not Verified ");
+	}
+	print_gecko("Finished: %s\r\n", task->result);
+}
+
+// One place a copy of the dump is written to
+typedef struct {
+	sink file;
+	sink wav;
+	sink wbfs;
+	partfile parts;
+} output;
+
+static int is_compressed(const char *ext) {
+	return !strcmp(ext, ".ciso") || !strcmp(ext, ".gcz") || !strcmp(ext, ".rvz") || !strcmp(ext, ".chd")
+		|| !strcmp(ext, ".zst") || !strcmp(ext, ".rcp") || !strcmp(ext, ".dlt");
+}
+
+// An audio CD's CHD is cut into the tracks in the drive's TOC, with none it is one audio track
+static int open_chd(sink *stage, sink *next, u64 total_bytes) {
+	chd_track tracks[CHD_MAX_TRACKS];
+	int count = 0;
+
+	if (forced_disc_profile != FORCED_AUDIO_CD) {
+		return sink_chd_dvd(stage, next, total_bytes);
+	}
+#ifdef __linux__
+	linux_dvd_toc toc;
+	if (!image_path && !sim_path && linux_dvd_read_toc(&toc) == 0) {
+		for (int t = toc.first_track; t <= toc.last_track && t < 100 && count < CHD_MAX_TRACKS; t++) {
+			tracks[count].start = toc.start[t];
+			tracks[count].data = (toc.control[t] & 4) != 0;
+			count++;
+		}
+	}
+#endif
+	return sink_chd_cd(stage, next, tracks, count, total_bytes);
+}
+
+// The format's stage goes in front of every copy, so a block is only compressed once.
+// A store is on the device under mount, on failure its path or the reference's is in txtbuffer
+static int open_format(sink *stage, sink **root, const char *ext, u64 total_bytes, const char *mount, int disc_type) {
+	int open_failed = 0;
+	if (!strcmp(ext, ".ciso")) {
+		open_failed = sink_ciso(stage, *root, CISO_BLOCK_SIZE);
+	}
+	else if (!strcmp(ext, ".gcz")) {
+		open_failed = sink_gcz(stage, *root, total_bytes);
+	}
+	else if (!strcmp(ext, ".rvz")) {
+		open_failed = sink_rvz(stage, *root, total_bytes);
+	}
+	else if (!strcmp(ext, ".chd")) {
+		open_failed = open_chd(stage, *root, total_bytes);
+	}
+	else if (!strcmp(ext, ".zst")) {
+		open_failed = sink_zst(stage, *root, total_bytes);
+	}
+	else if (!strcmp(ext, ".rcp")) {
+		// Wii partitions are encrypted, so only the same data at the same place dedups anyway
+		sprintf(txtbuffer, "%s%s", mount, STORE_DIR);
+		open_failed = sink_store(stage, *root, txtbuffer, disc_type == IS_WII_DISC ? STORE_CHUNK_FIXED : STORE_CHUNK_CDC);
+	}
+	else if (!strcmp(ext, ".dlt")) {
+		// the reference is hashed through here, before the first block comes
+		sprintf(txtbuffer, "%s", delta_path);
+		open_failed = sink_delta(stage, *root, delta_path);
+	}
+	if (!open_failed) {
+		*root = stage;
+	}
+	return open_failed;
+}
+
+// Opens the image under mount, *root is what the blocks for it go to. On failure the path is in txtbuffer
+static int open_output(output *o, sink **root, const char *mount, const char *ext,
+					   int auto_split, int chunked, u64 part_size, u64 total_bytes, int wav, int compressed, u64 wbfs_split) {
+	int open_failed;
+
+	*root = &o->file;
+	if (auto_split) {
+		// parts are sector aligned so every one but the last is exactly the chunk size
+		sprintf(txtbuffer, "%s%s", mount, &gameName[0]);
+		open_failed = partfile_open(&o->parts, txtbuffer, ext, part_size, total_bytes);
+		partfile_path(&o->parts, 0, txtbuffer);
+		sink_split(&o->file, &o->parts);
+	}
+	else {
+		if (chunked) {
+			sprintf(txtbuffer, "%s%s.part0%s", mount, &gameName[0], ext);
+		} else {
+			sprintf(txtbuffer, "%s%s%s", mount, &gameName[0], ext);
+		}
+		dump_remove(&txtbuffer[0]);
+		open_failed = sink_file_open(&o->file, &txtbuffer[0], 0);
+		// how much a compressed image or a WBFS takes isn't known up front
+		if (!open_failed && !chunked && !compressed && strcmp(ext, ".wbfs")) {
+			sink_file_reserve(&o->file, total_bytes + (wav ? WAV_HEADER_SIZE : 0));
+		}
+	}
+	if (!open_failed && wav) {
+		// 16-bit stereo 44.1kHz, the header gets its size when the sink is closed
+		open_failed = sink_wav(&o->wav, &o->file, 2, 44100);
+		*root = &o->wav;
+	}
+	if (!open_failed && !strcmp(ext, ".wbfs")) {
+		// the stage opens the .wbf1... after the first file itself
+		sprintf(txtbuffer, "%s%s", mount, &gameName[0]);
+		open_failed = sink_wbfs(&o->wbfs, &o->file, txtbuffer, wbfs_split);
+		*root = &o->wbfs;
+	}
+	return open_failed;
+}
+
 int dump_game(int disc_type, int fs) {
 
 	isDumping = 1;
-	md5_state_t state;
-	md5_byte_t digest[16];
-	SHA1Context sha;
-	u32 crc32 = 0;
-	u32 crc100000 = 0;
-	char *buffer;
+	dump_engine engine;
+	engine_ops ops;
+	block_ring ring;
+	tuner tune;
 	mqbox_t msgq, blockq;
 	lwp_t writer;
 	writer_msg *wmsg;
 	writer_msg msg;
-	int i;
 
-	MQ_Init(&blockq, MSG_COUNT);
-	MQ_Init(&msgq, MSG_COUNT);
+	// same disc again, let the last dump of it be renamed first
+	while (finish_pending_game(&gameName[0])) {
+		usleep(10000);
+	}
+
+	// room for the deepest pipeline the tuner may try
+	MQ_Init(&blockq, RING_MAX_BLOCKS);
+	MQ_Init(&msgq, RING_MAX_BLOCKS);
 
 	// since libogc is too shitty to be able to get the current thread priority, just force it to a known value
 	LWP_SetThreadPriority(0, THREAD_PRIO);
@@ -1425,6 +2068,10 @@ int dump_game(int disc_type, int fs) {
 
 	// Check if we will ask the user to insert a new device per chunk
 	int silent = options_map[WII_NEWFILE];
+	if (selected_device == TYPE_NET) {
+		// there's no device to swap, the receiver takes the parts as they come
+		silent = AUTO_CHUNK;
+	}
 	int audio_mode = options_map[AUDIO_OUTPUT];
 
 	int is_audio_profile = (disc_type == IS_OTHER_DISC && forced_disc_profile == FORCED_AUDIO_CD);
@@ -1441,7 +2088,9 @@ int dump_game(int disc_type, int fs) {
 	if (read_sectors == 0) {
 		read_sectors = 1;
 	}
-	u32 max_read_size = read_sectors * sector_size;
+	// Datel reads are checked at fixed offsets, keep them as they are
+	tuner_init(&tune, sector_size, read_sectors * sector_size, MSG_COUNT, disc_type != IS_DATEL_DISC);
+	u32 max_read_size = tuner_max_size(&tune);
 	u64 one_gigabyte_bytes = (u64)ONE_GIGABYTE * 2048;
 
 	u32 startLBA = 0;
@@ -1454,6 +2103,13 @@ int dump_game(int disc_type, int fs) {
 	if (disc_type == IS_OTHER_DISC && forced_disc_profile == FORCED_AUDIO_CD) {
 		endLBA = detect_audio_cd_size_sectors(sector_size);
 	}
+	if (image_path && disc_type == IS_OTHER_DISC) {
+		// the forced profile picks the geometry, the image how much of it there is
+		endLBA = imgsrc_sectors(&image_source, sector_size);
+	}
+	if (sim_path && disc_type == IS_OTHER_DISC) {
+		endLBA = simdrive_sectors(&sim_drive);
+	}
 	u64 total_bytes = (u64)endLBA * sector_size;
 
 	// Work out the chunk size
@@ -1461,7 +2117,7 @@ int dump_game(int disc_type, int fs) {
 	u64 opt_chunk_size;
 	if (chunk_size_wii == CHUNK_MAX) {
 		// use 4GB chunks max for FAT drives
-		if (selected_device != TYPE_READONLY && fs == TYPE_FAT) {
+		if (selected_device != TYPE_READONLY && selected_device != TYPE_NET && fs == TYPE_FAT) {
 			long file_size_bits = pathconf("fat:/", _PC_FILESIZEBITS);
 			if (file_size_bits <= 33) {
 			opt_chunk_size = (4ULL * one_gigabyte_bytes) - max_read_size - 1;
@@ -1483,39 +2139,99 @@ int dump_game(int disc_type, int fs) {
 		// Keep audio dumps as a single BIN so a single CUE can reference it.
 		opt_chunk_size = total_bytes + max_read_size;
 	}
+	if (selected_device == TYPE_READONLY) {
+		// nothing is written, so there is never a next chunk to open
+		opt_chunk_size = total_bytes + max_read_size;
+	}
+	u64 wbfs_split = 0;
+	if (!strcmp(get_output_extension(disc_type), ".wbfs")) {
+		// a WBFS is only split where FAT has to, into files named the way the loaders look for them
+		if (selected_device != TYPE_READONLY && selected_device != TYPE_NET && fs == TYPE_FAT
+			&& pathconf("fat:/", _PC_FILESIZEBITS) <= 33) {
+			wbfs_split = WBFS_SPLIT_SIZE;
+		}
+		opt_chunk_size = total_bytes + max_read_size;
+	}
+	const char *single_ext = get_output_extension(disc_type);
+	if (!strcmp(single_ext, ".chd") || !strcmp(single_ext, ".zst") || !strcmp(single_ext, ".rcp")
+		|| !strcmp(single_ext, ".dlt")) {
+		// the map, seek table, recipe or delta header goes in at close, so there is only ever one file
+		opt_chunk_size = total_bytes + max_read_size;
+	}
+
+	// A second copy goes to the mirror, but not when the user swaps devices for each chunk
+	// or for a recipe, whose chunks are only in the store next to the first copy
+	int mirroring = (mirrorPath[0] && selected_device != TYPE_READONLY && (silent == AUTO_CHUNK || opt_chunk_size >= total_bytes)
+					 && strcmp(single_ext, ".rcp"));
+	if (mirrorPath[0] && !mirroring) {
+		print_gecko("Not mirroring this dump, %s\r\n", strcmp(single_ext, ".rcp") ? "chunks are swapped by hand" : "the store is on one device");
+	}
 
 	// Dump the BCA
 	if(selected_device != TYPE_READONLY) {
-		dump_bca();
+		dump_bca(mirroring ? mirrorPath : NULL);
 	}
 
-	// Create the read buffers
-	buffer = memalign(32, MSG_COUNT*(max_read_size+sizeof(writer_msg)));
-	for (i=0; i < MSG_COUNT; i++) {
-		MQ_Send(blockq, (mqmsg_t)(buffer+i*(max_read_size+sizeof(writer_msg))), MQ_MSG_BLOCK);
+	// Create the read buffers, big enough for every candidate until the tuner settles
+	u32 ring_size;
+	int ring_count;
+	tuner_ring_shape(&tune, &ring_size, &ring_count);
+	if (ring_alloc(&ring, blockq, sizeof(writer_msg), ring_size, ring_count)) {
+		tuner_init(&tune, sector_size, read_sectors * sector_size, MSG_COUNT, 0);
+		tuner_ring_shape(&tune, &ring_size, &ring_count);
+		ring_alloc(&ring, blockq, sizeof(writer_msg), ring_size, ring_count);
 	}
 
-	// Reset MD5/SHA-1/CRC
-	md5_init(&state);
-	SHA1Reset(&sha);
-	crc32 = 0;
-
 	// There will be chunks, name accordingly
-	FILE *fp = NULL;
+	output primary, mirror;
+	sink tee_out;
+	sink format_out;
+	sink *out = &primary.file;	// the root of where blocks go, all the loop below talks to
+	u64 chunk_origin = 0;
+	// Unless the user swaps devices per chunk, the writer rolls over to the next part by itself
+	int auto_split = (selected_device != TYPE_READONLY && silent == AUTO_CHUNK && opt_chunk_size < total_bytes);
+	// Otherwise keep reading into RAM while the user swaps devices
+	spill_buf spill;
+	int spilling = 0;
+	int swap_requested = 0;
+	int mount_ret = 0;
+	int mount_failed = 0;
+	memset(&spill, 0, sizeof(spill_buf));
+	if (selected_device != TYPE_READONLY && silent == ASK_USER && opt_chunk_size < total_bytes && get_spill_size()) {
+		spill_init(&spill, get_spill_size());
+		print_gecko("Swap buffer: %uKB\r\n", spill.size / 1024);
+	}
 	const char *output_ext = get_output_extension(disc_type);
 	int should_eject = (disc_type == IS_NGC_DISC || disc_type == IS_WII_DISC || disc_type == IS_DATEL_DISC);
 	FILE *badfp = NULL;
 	const int audio_max_attempts = (audio_mode == AUDIO_OUT_WAV_FAST) ? 3 : (audio_mode == AUDIO_OUT_WAV_BEST ? 10 : 6);
 	const int audio_sector_recovery = (audio_mode == AUDIO_OUT_WAV || audio_mode == AUDIO_OUT_WAV_BEST);
 	if(selected_device != TYPE_READONLY) {
-		if (opt_chunk_size < total_bytes) {
-			sprintf(txtbuffer, "%s%s.part0%s", &mountPath[0], &gameName[0], output_ext);
-		} else {
-			sprintf(txtbuffer, "%s%s%s", &mountPath[0], &gameName[0], output_ext);
+		u64 part_size = (opt_chunk_size / sector_size) * sector_size;
+		int wav = is_audio_profile && strcmp(output_ext, ".wav") == 0;
+		int compressed = is_compressed(output_ext);
+		int open_failed = open_output(&primary, &out, &mountPath[0], output_ext,
+									  auto_split, opt_chunk_size < total_bytes, part_size, total_bytes, wav, compressed, wbfs_split);
+		if (!open_failed && mirroring) {
+			sink *mirror_root;
+			open_failed = open_output(&mirror, &mirror_root, mirrorPath, output_ext,
+									  auto_split, opt_chunk_size < total_bytes, part_size, total_bytes, wav, compressed, wbfs_split);
+			if (open_failed) {
+				sink_close(out);
+			}
+			else {
+				// both get every block, the buffer is only reused once both have it
+				sink_tee(&tee_out, out, mirror_root);
+				out = &tee_out;
+			}
+		}
+		if (!open_failed && compressed) {
+			open_failed = open_format(&format_out, &out, output_ext, total_bytes, &mountPath[0], disc_type);
+			if (open_failed) {
+				sink_close(out);
+			}
 		}
-		remove(&txtbuffer[0]);
-		fp = fopen(&txtbuffer[0], "wb");
-		if (fp == NULL) {
+		if (open_failed) {
 			DrawFrameStart();
 			DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
 			WriteCentre(230, "Failed to create file:");
@@ -1525,186 +2241,166 @@ int dump_game(int disc_type, int fs) {
 			sleep(5);
 			exit(0);
 		}
-		if (is_audio_profile && strcmp(output_ext, ".wav") == 0) {
-			write_wav_header(fp, 0);
-		}
-		msg.command = MSG_SETFILE;
-		msg.data = fp;
-		MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
 
 		if (is_audio_profile) {
 			sprintf(txtbuffer, "%s%s.bad", &mountPath[0], &gameName[0]);
-			remove(&txtbuffer[0]);
-			badfp = fopen(&txtbuffer[0], "wb");
+			dump_remove(&txtbuffer[0]);
+			badfp = dump_fopen(&txtbuffer[0], "wb");
 			if (badfp) {
 				fprintf(badfp, "# zero-filled ranges (start_lba,sectors)\n");
 			}
 		}
 	}
+	else {
+		sink_null(&primary.file);
+	}
+	msg.command = MSG_SETSINK;
+	msg.data = out;
+	MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
+
+	// everything about this disc's reads is decided here, not per block
+	ops.read = select_source_read(disc_type);
+	ops.error = dvd_get_error;
+	ops.datel_check = datel_check;
+	engine_init(&engine, &ops, engine_profile(disc_type), sector_size, calcChecksums);
+	if (is_audio_profile) {
+		engine_set_audio(&engine, audio_max_attempts, audio_sector_recovery, badfp);
+	}
+	// when nothing is kept (a read-only scan) the blocks go straight back, not through the writer
+	mqbox_t deliverq = sink_discards(out) ? blockq : msgq;
 
 	int ret = 0;
-	u32 audio_read_errors = 0;
-	u32 audio_blocks_total = 0;
-	u32 audio_sectors_total = 0;
-	u32 audio_sectors_failed = 0;
 	u32 lastLBA = 0;
 	u64 lastCheckedTime = gettime();
 	u64 startTime = gettime();
 	int chunk = 1;
-	int isKnownDatel = 0;
 	char *discTypeStr = getDiscTypeStr(disc_type, endLBA == WII_D9_SIZE);
 
 	while (!ret && (startLBA < endLBA)) {
-		MQ_Receive(blockq, (mqmsg_t*)&wmsg, MQ_MSG_BLOCK);
-		if(selected_device != TYPE_READONLY) {
-			if (wmsg==NULL) { // asynchronous write error
-				LWP_JoinThread(writer, NULL);
-				fclose(fp);
-				DrawFrameStart();
-				DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
-				WriteCentre(255, "Write Error!");
-				WriteCentre(315, "Exiting in 10 seconds");
-				DrawFrameFinish();
-				sleep(10);
-				exit(1);
+		tuner_ring_shape(&tune, &ring_size, &ring_count);
+		if (ring_size != ring.block_size || ring_count != ring.count) {
+			// wait for writing to finish, then swap the buffers for ones that fit
+			vu32 sema = 0;
+			msg.command = MSG_FLUSH;
+			msg.data = (void*)&sema;
+			MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
+			while (!sema)
+				LWP_YieldThread();
+			if (ring_drain(&ring) == 0) {
+				ring_free(&ring);
+				if (ring_alloc(&ring, blockq, sizeof(writer_msg), ring_size, ring_count)) {
+					// not enough memory to measure again, stay with the defaults
+					tuner_init(&tune, sector_size, read_sectors * sector_size, MSG_COUNT, 0);
+					tuner_ring_shape(&tune, &ring_size, &ring_count);
+					ring_alloc(&ring, blockq, sizeof(writer_msg), ring_size, ring_count);
+				}
 			}
+		}
+		wmsg = ring_take(&ring, tuner_depth(&tune));
+		if (wmsg==NULL) { // asynchronous write error
+			LWP_JoinThread(writer, NULL);
+			sink_close(out);
+			DrawFrameStart();
+			DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
+			WriteCentre(255, "Write Error!");
+			WriteCentre(315, "Exiting in 10 seconds");
+			DrawFrameFinish();
+			sleep(10);
+			exit(1);
+		}
 
-			if (((u64)startLBA * sector_size) > (opt_chunk_size * chunk)) {
-				// wait for writing to finish
-				vu32 sema = 0;
-				msg.command = MSG_FLUSH;
-				msg.data = (void*)&sema;
-				MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
-				while (!sema)
-					LWP_YieldThread();
-
+		if (spilling) {
+			// mount the next device once the user asks for it, or when there's no room left
+			if (spill_room(&spill) < ring.block_size) {
+				u64 wait_begin = gettime();
+				// Stop the disc if we're going to wait on the user
+				source_motor_off(0);
+				wait_chunk_device(fs);
+				initialise_source();
+				mount_ret = 1;
+				// pretend the wait didn't happen
+				startTime -= (gettime() - wait_begin);
+			}
+			else if (swap_requested) {
+				mount_ret = mount_chunk_device(fs);
+				mount_failed = (mount_ret != 1);
+				swap_requested = 0;
+			}
+			if (mount_ret == 1) {
+				resume_after_swap(&primary.file, &spill, &msg, msgq, blockq, ring.block_size, chunk, chunk_origin, disc_type);
+				spilling = 0;
+				chunk++;
+			}
+		}
+		else if (!auto_split && ((u64)startLBA * sector_size) > (opt_chunk_size * chunk)) {
+			// wait for writing to finish
+			vu32 sema = 0;
+			msg.command = MSG_FLUSH;
+			msg.data = (void*)&sema;
+			MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
+			while (!sema)
+				LWP_YieldThread();
+
+			chunk_origin = (u64)startLBA * sector_size;
+			if (spill.size) {
+				// swap the device without stopping the drive, blocks go to RAM meanwhile
+				sink_close(&primary.file);
+				unmount_chunk_device(fs);
+				spilling = 1;
+				mount_ret = 0;
+				mount_failed = 0;
+				lastCheckedTime = 0;
+			}
+			else {
 				// open new file
 				u64 wait_begin = gettime();
 				if (badfp && silent == ASK_USER) {
 					fclose(badfp);
 					badfp = NULL;
 				}
-				prompt_new_file(&fp, chunk, fs, silent, disc_type);
+				prompt_new_file(&primary.file, chunk, chunk_origin, fs, silent, disc_type);
 				if (is_audio_profile && selected_device != TYPE_READONLY && silent == ASK_USER) {
 					sprintf(txtbuffer, "%s%s.bad", &mountPath[0], &gameName[0]);
 					badfp = fopen(&txtbuffer[0], "ab");
 				}
+				engine.badfp = badfp;
 				// pretend the wait didn't happen
 				startTime -= (gettime() - wait_begin);
 
 				// set writing file
-				msg.command = MSG_SETFILE;
-				msg.data = fp;
+				msg.command = MSG_SETSINK;
+				msg.data = out;
 				MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
 				chunk++;
-			}	
-		}
+			}
+		}	
 
-		u32 cur_read_sectors = ((startLBA + read_sectors) <= endLBA) ? read_sectors : (endLBA - startLBA);
+		u32 tuned_sectors = tuner_read_size(&tune) / sector_size;
+		u32 cur_read_sectors = ((startLBA + tuned_sectors) <= endLBA) ? tuned_sectors : (endLBA - startLBA);
 		u32 opt_read_size = cur_read_sectors * sector_size;
-		if (is_audio_profile) {
-			audio_blocks_total++;
-			audio_sectors_total += cur_read_sectors;
-		}
 
 		wmsg->command =  MSG_WRITE;
 		wmsg->data = wmsg+1;
 		wmsg->length = opt_read_size;
 		wmsg->ret_box = blockq;
+		wmsg->offset = (u64)startLBA * sector_size;
 
 		// Read from Disc
-		if (is_audio_profile) {
-			// Audio CD mode: retry several times before zero-filling.
-			ret = 1;
-			for (int attempt = 0; attempt < audio_max_attempts; attempt++) {
-				ret = source_read(wmsg->data, (u32)opt_read_size, (u64)startLBA * sector_size, disc_type, isKnownDatel);
-				if (ret == 0) {
-					break;
-				}
-				usleep(1000 + (attempt * 500));
-			}
-		}
-		else
-			ret = source_read(wmsg->data, (u32)opt_read_size, (u64)startLBA * sector_size, disc_type, isKnownDatel);
+		ret = engine_read(&engine, &tune, wmsg->data, startLBA, cur_read_sectors);
 		if (ret != 0) {
-			if (is_audio_profile) {
-				if (audio_sector_recovery && cur_read_sectors > 1) {
-					u32 bad_run_start = 0;
-					u32 bad_run_len = 0;
-					for (u32 s = 0; s < cur_read_sectors; s++) {
-						int sec_ret = 1;
-						for (int a = 0; a < audio_max_attempts; a++) {
-							sec_ret = source_read(((u8*)wmsg->data) + (s * sector_size), sector_size, ((u64)startLBA + s) * sector_size, disc_type, isKnownDatel);
-							if (sec_ret == 0) {
-								break;
-							}
-							usleep(1000 + (a * 500));
-						}
-						if (sec_ret != 0) {
-							audio_read_errors++;
-							audio_sectors_failed++;
-							memset(((u8*)wmsg->data) + (s * sector_size), 0, sector_size);
-							if (bad_run_len == 0) {
-								bad_run_start = startLBA + s;
-							}
-							bad_run_len++;
-						}
-						else if (bad_run_len > 0) {
-							if (badfp) {
-								fprintf(badfp, "%u,%u\n", bad_run_start, bad_run_len);
-							}
-							bad_run_len = 0;
-						}
-					}
-					if (bad_run_len > 0 && badfp) {
-						fprintf(badfp, "%u,%u\n", bad_run_start, bad_run_len);
-					}
-				}
-				else {
-					audio_read_errors += cur_read_sectors;
-					audio_sectors_failed += cur_read_sectors;
-					memset(wmsg->data, 0, opt_read_size);
-					if (badfp) {
-						fprintf(badfp, "%u,%u\n", startLBA, cur_read_sectors);
-					}
-				}
-				// Keep dumping despite sporadic read errors; report every 64 failed sectors.
-				if ((audio_read_errors & 63) == 1) {
-					print_gecko("Audio CD read errors=%u sectors (last LBA %u, err=%08X)\r\n",
-						audio_read_errors, startLBA, dvd_get_error());
-				}
-				ret = 0;
-			}
-			else {
-				MQ_Send(blockq, (mqmsg_t)wmsg, MQ_MSG_BLOCK);
-				break;
-			}
+			MQ_Send(blockq, (mqmsg_t)wmsg, MQ_MSG_BLOCK);
+			break;
 		}
 		usleep(50);
-		MQ_Send(msgq, (mqmsg_t)wmsg, MQ_MSG_BLOCK);
-		if(calcChecksums) {
-			// Calculate MD5
-			md5_append(&state, (const md5_byte_t *) (wmsg+1), (u32) opt_read_size);
-			// Calculate SHA-1
-			SHA1Input(&sha, (const unsigned char *) (wmsg+1), (u32) opt_read_size);
-		}
-		// Always calculate CRC32
-		crc32 = Crc32_ComputeBuf( crc32, wmsg+1, (u32) opt_read_size);
-
-		if(disc_type == IS_DATEL_DISC && (((u64)startLBA * sector_size) + opt_read_size == 0x100000)){
-			crc100000 = crc32;
-			isKnownDatel = datel_findCrcSum(crc100000);
-			DrawFrameStart();
-			DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
-			if(!isKnownDatel) {
-				WriteCentre(215, "(Warning: This disc will take a while to dump!)");
-			}
-			sprintf(txtbuffer, "%s CRC100000=%08X", (isKnownDatel ? "Known":"Unknown"), crc100000);
-			WriteCentre(255, txtbuffer);
-			u64 waitTimeStart = gettime();
-			wait_press_A_exit_B(false);
-			startTime += (gettime() - waitTimeStart);	// Don't throw time off because we'd paused here
+		if (spilling) {
+			// the device is out, hold on to the block until the next one is mounted
+			spill_push(&spill, wmsg+1, opt_read_size);
+			MQ_Send(blockq, (mqmsg_t)wmsg, MQ_MSG_BLOCK);
 		}
+		else {
+			MQ_Send(deliverq, (mqmsg_t)wmsg, MQ_MSG_BLOCK);
+		}
+		engine_account(&engine, (const u8*)(wmsg+1), startLBA, cur_read_sectors);
 
 		check_exit_status();
 	
@@ -1716,6 +2412,9 @@ int dump_game(int disc_type, int fs) {
 		if (pressedButtons & PAD_BUTTON_Y) {
 			newProgressDisplay ^= 1;
 		}
+		if (spilling && (pressedButtons & PAD_BUTTON_A)) {
+			swap_requested = 1;
+		}
 		// Update status every second
 		u64 curTime = gettime();
 		s32 timePassed = diff_msec(lastCheckedTime, curTime);
@@ -1726,7 +2425,20 @@ int dump_game(int disc_type, int fs) {
 			u64 remainder = (((u64)endLBA - startLBA) * sector_size) - opt_read_size;
 			u32 etaTime = bytes_since_last_read ? (remainder / bytes_since_last_read) : 0;
 			DrawFrameStart();
-			if(newProgressDisplay) {
+			if (spilling) {
+				DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
+				WriteCentre(215, "Insert a device for the next chunk");
+				sprintf(txtbuffer, "Buffered %uMB of %uMB", spill_used(&spill) >> 20, spill.size >> 20);
+				WriteCentre(255, txtbuffer);
+				if (mount_failed) {
+					sprintf(txtbuffer, "Error Mounting Device [%08X]", mount_ret);
+					WriteCentre(280, txtbuffer);
+				}
+				WriteFont(210, 315, "Press");
+				DrawAButton(285, 310);
+				WriteFont(330, 315, "when ready");
+			}
+			else if(newProgressDisplay) {
 				sprintf(txtbuffer, "Rate: %4.2fKB/s\nETA: %02d:%02d:%02d",
 					(float)bytes_since_last_read/1024.0f,
 					(int)((etaTime/3600)%60),(int)((etaTime/60)%60),(int)(etaTime%60));
@@ -1748,29 +2460,41 @@ int dump_game(int disc_type, int fs) {
 		}
 		startLBA += cur_read_sectors;
 	}
-	if(calcChecksums) {
-		md5_finish(&state, digest);
+	if (sim_path) {
+		simdrive_stats(&sim_drive);
 	}
-	if (is_audio_profile && audio_sectors_total && audio_sectors_failed == audio_sectors_total) {
+	if (engine_all_failed(&engine)) {
 		ret = -62; // all audio blocks failed
 	}
+	// leave the time spent waiting on the user out
+	startTime += engine.paused;
+
+	if (spilling) {
+		// reading ended during a swap, the rest of the image is still in RAM
+		wait_chunk_device(fs);
+		resume_after_swap(out, &spill, &msg, msgq, blockq, ring.block_size, chunk, chunk_origin, disc_type);
+		spilling = 0;
+		chunk++;
+	}
+	spill_free(&spill);
 
 	// signal writer to finish
 	MQ_Send(msgq, (mqmsg_t)NULL, MQ_MSG_BLOCK);
 	LWP_JoinThread(writer, NULL);
+	// the last part is flushed and closed here, anything left over is removed
+	if (sink_close(out) != 0 && !ret) {
+		ret = -63;
+	}
 	if(selected_device != TYPE_READONLY) {
-		if (fp && is_audio_profile && strcmp(output_ext, ".wav") == 0) {
-			u32 wav_data_size = (u32)((u64)startLBA * sector_size);
-			fseek(fp, 0, SEEK_SET);
-			write_wav_header(fp, wav_data_size);
+		if (auto_split) {
+			chunk = partfile_count(&primary.parts);
 		}
-		fclose(fp);
 		if (badfp) {
 			fclose(badfp);
 		}
 	}
 
-	free(buffer);
+	ring_free(&ring);
 	MQ_Close(blockq);
 	MQ_Close(msgq);
 
@@ -1780,12 +2504,15 @@ int dump_game(int disc_type, int fs) {
 		if (ret == -62) {
 			sprintf(txtbuffer, "Audio read failed (all blocks)");
 		}
+		else if (ret == -63) {
+			sprintf(txtbuffer, "Write Error!");
+		}
 		else {
 			sprintf(txtbuffer, "%s",dvd_error_str());
 		}
 		print_gecko("Error: %s\r\n",txtbuffer);
 		WriteCentre(255,txtbuffer);
-		dvd_motor_off(should_eject ? 1 : 0);
+		source_motor_off(should_eject ? 1 : 0);
 		wait_press_A("to continue");
 		return 0;
 	}
@@ -1795,11 +2522,45 @@ int dump_game(int disc_type, int fs) {
 		sprintf(txtbuffer, "Copy Cancelled");
 		print_gecko("%s\r\n",txtbuffer);
 		WriteCentre(255,txtbuffer);
-		dvd_motor_off(0);
+		source_motor_off(0);
 		wait_press_A("to continue");
 		return 0;
 	}
 	else {
+		// everything after this only needs the files, not the disc
+		finish_task *task = finish_new();
+		snprintf(task->mount, sizeof(task->mount), "%s", &mountPath[0]);
+		snprintf(task->game, sizeof(task->game), "%s", &gameName[0]);
+		snprintf(task->internal, sizeof(task->internal), "%s", &internalName[0]);
+		snprintf(task->ext, sizeof(task->ext), "%s", output_ext);
+		task->disc_type = disc_type;
+		task->parts = (opt_chunk_size < total_bytes) ? chunk : 0;
+		task->checksums = calcChecksums;
+		task->audio = is_audio_profile;
+		task->readonly = (selected_device == TYPE_READONLY);
+		task->crc32 = engine.crc32;
+		task->crc100000 = engine.crc100000;
+		task->version = *(u8*)0x80000007;
+		task->seconds = diff_sec(startTime, gettime());
+		task->dumped_at = (u64)time(NULL);
+		engine_finish(&engine, task->md5, task->sha1);
+		if ((disc_type == IS_DATEL_DISC) && !task->readonly) {
+			// the skip list is only kept until the next Datel disc is read
+			dump_skips(&mountPath[0], engine.crc100000);
+			if (mirroring) {
+				dump_skips(mirrorPath, engine.crc100000);
+			}
+		}
+		source_motor_off(should_eject ? 1 : 0);
+		if (mirroring) {
+			// the copy is proven by the same checksums, it's renamed and logged on its own device
+			finish_task *copy = finish_new();
+			memcpy(copy, task, sizeof(finish_task));
+			snprintf(copy->mount, sizeof(copy->mount), "%s", mirrorPath);
+			finish_queue(copy);
+		}
+		finish_queue(task);
+
 		DrawFrameStart();
 		DrawProgressDetailed((int)((float)((float)startLBA/(float)endLBA)*100), "Finished", 
 						(int) ((((u64)startLBA * sector_size) / (1024*1024))),
@@ -1807,124 +2568,22 @@ int dump_game(int disc_type, int fs) {
 		DrawEmptyBox (30,180, vmode->fbWidth-38, 350, COLOR_BLACK);
 		sprintf(txtbuffer,"Copy completed in %u mins. Press A",diff_sec(startTime, gettime())/60);
 		WriteCentre(190,txtbuffer);
-
-		int verified = 0;
-		char tempstr[64];
-
-		if ((disc_type == IS_DATEL_DISC)) {
-				dump_skips(&mountPath[0], crc100000);
-		}
-		char md5sum[64];
-		char sha1sum[64];
-		memset(&md5sum[0], 0, 64);
-		memset(&sha1sum[0], 0, 64);
-		if (calcChecksums) {
-			int i; for (i=0; i<16; i++) sprintf(&md5sum[i*2],"%02x",digest[i]);
-			if(SHA1Result(&sha)) {
-				for (i=0; i<5; i++) sprintf(&sha1sum[i*8],"%08x",sha.Message_Digest[i]);
-			}
-			else {
-				sprintf(sha1sum, "Error computing SHA-1");
-			}
-		}
-		char* name = NULL;
-		int canVerifyWithDat = (disc_type == IS_NGC_DISC || disc_type == IS_WII_DISC || disc_type == IS_DATEL_DISC);
-		int availableVerificationType = canVerifyWithDat ? verify_is_available(disc_type) : -1;
-		if (canVerifyWithDat) {
-			if(availableVerificationType != VERIFY_INTERNAL_CRC && calcChecksums) {
-				verified = verify_findMD5Sum(&md5sum[0], disc_type);
-			}
-			else {
-				verified = verify_findCrc32(crc32, disc_type);
-			}
-		}
-		if (verified && availableVerificationType != VERIFY_INTERNAL_CRC) {
-			if (opt_chunk_size < total_bytes) {
-				for (int i = 0; i < chunk; i++) {
-					sprintf(tempstr, ".part%i%s", i, output_ext);
-					renameFile(&mountPath[0], &gameName[0], verify_get_name(0), &tempstr[0]);
-				}
-			}
-			else {
-				renameFile(&mountPath[0], &gameName[0], verify_get_name(0), output_ext);
-			}
-#ifdef HW_RVL
-			renameFile(&mountPath[0], &gameName[0], verify_get_name(0), ".bca");
-#endif
-
-			name = verify_get_name(0);
-		}
-		if ((disc_type == IS_DATEL_DISC)) {
-			verified = datel_findMD5Sum(&md5sum[0]);
-			if (verified) {
-				renameFile(&mountPath[0], &gameName[0], datel_get_name(0), ".iso");
-				renameFile(&mountPath[0], &gameName[0], datel_get_name(0), ".skp");
-#ifdef HW_RVL
-				renameFile(&mountPath[0], &gameName[0], datel_get_name(0), ".bca");
-#endif
-				name = datel_get_name(0);
-			}
-		}
-		if(calcChecksums) {
-			dump_info(&md5sum[0], &sha1sum[0], crc32, verified, diff_sec(startTime, gettime()), name);
-			if (canVerifyWithDat) {
-				print_gecko("MD5: %s\r\n", verified ? "Verified OK" : "Not Verified ");
-			}
-			else {
-				print_gecko("Verification: Not available for this disc profile\r\n");
-			}
-
-		}
-		if (canVerifyWithDat) {
-			sprintf(txtbuffer, "%s: %s", (availableVerificationType != VERIFY_INTERNAL_CRC) ? "MD5" : "CRC32", verified ? "Verified OK" : "");
+		if (disc_type == IS_NGC_DISC || disc_type == IS_WII_DISC || disc_type == IS_DATEL_DISC) {
+			WriteCentre(230, "Verifying in the background,");
+			WriteCentre(255, "the next disc can go in now");
 		}
 		else {
-			sprintf(txtbuffer, "CRC32: %08X", crc32);
-		}
-		WriteCentre(230, txtbuffer);
-		if (!canVerifyWithDat) {
+			sprintf(txtbuffer, "CRC32: %08X", engine.crc32);
+			WriteCentre(230, txtbuffer);
 			WriteCentre(255, "Redump verification not available for this disc type");
 		}
-		else if ((disc_type == IS_DATEL_DISC)) {
-			WriteCentre(255, verified ? datel_get_name(1) : "Not Verified with datel.dat");
-		}
-		else {
-			if(verified) {
-				WriteCentre(255, (availableVerificationType != VERIFY_INTERNAL_CRC) ? verify_get_name(1) : "Verified disc dump");
-			}
-			else {
-				WriteCentre(255, "Not verified with redump DAT");
-			}
-		}
-		if (is_audio_profile && audio_read_errors) {
-			sprintf(txtbuffer, "Audio CD had %u read errors (zero-filled)", audio_read_errors);
+		if (engine.sectors_failed) {
+			sprintf(txtbuffer, "Audio CD had %u read errors (zero-filled)", engine.sectors_failed);
 			WriteCentre(305, txtbuffer);
 			sprintf(txtbuffer, "%s%s.bad", &mountPath[0], &gameName[0]);
 			WriteCentre(330, txtbuffer);
 		}
-		WriteCentre(280, &md5sum[0]);
-		if(!calcChecksums) {
-			dump_info(NULL, NULL, crc32, verified, diff_sec(startTime, gettime()), NULL);
-		}
-		if (is_audio_profile && selected_device != TYPE_READONLY) {
-			char cueFileName[64];
-			int cueIsWave = (strcmp(output_ext, ".wav") == 0);
-			sprintf(cueFileName, "%s%s", &gameName[0], output_ext);
-			dump_audio_cue(&cueFileName[0], cueIsWave);
-		}
-		if ((disc_type == IS_DATEL_DISC) && !(verified)) {
-			dump_skips(&mountPath[0], crc100000);
-			
-			char tempstr[64];
-			sprintf(tempstr, "datel_%08x", crc100000);
-			renameFile(&mountPath[0], &gameName[0], &tempstr[0], output_ext);
-			renameFile(&mountPath[0], &gameName[0], &tempstr[0], "-dumpinfo.txt");
-			renameFile(&mountPath[0], &gameName[0], &tempstr[0], ".skp");
-#ifdef HW_RVL
-			renameFile(&mountPath[0], &gameName[0], &tempstr[0], ".bca");
-#endif
-		}
-		dvd_motor_off(should_eject ? 1 : 0);
+		WriteCentre(280, task->md5);
 		wait_press_A_exit_B(false);
 	}
 	return 1;
@@ -1940,12 +2599,35 @@ int main(int argc, char **argv) {
 #ifdef HW_RVL
 	iosversion = IOS_GetVersion();
 #endif
+	for (int i = 1; i < argc; i++) {
+		if (!strncmp(argv[i], "--image=", 8)) {
+			image_path = argv[i] + 8;
+		}
+		else if (!strncmp(argv[i], "--sim=", 6)) {
+			sim_path = argv[i] + 6;
+		}
+		else if (!strncmp(argv[i], "--delta=", 8)) {
+			delta_path = argv[i] + 8;
+		}
+		else if (!strcmp(argv[i], "--mirror")) {
+			mirror_requested = 1;
+		}
+		else if (!strncmp(argv[i], "--net=", 6)) {
+			net_host = argv[i] + 6;
+			char *port = strchr(net_host, ':');
+			if (port) {
+				*port = 0;
+				net_port = atoi(port + 1);
+			}
+		}
+	}
 	if(usb_isgeckoalive(1)) {
 		usb_flush(1);
 		print_usb = 1;
 	}
 	print_gecko("CleanRip Version %i.%i.%i\r\n",V_MAJOR, V_MID, V_MINOR);
 	print_gecko("Arena Size: %iKb\r\n",(SYS_GetArena1Hi()-SYS_GetArena1Lo())/1024);
+	finish_init(finish_dump);
 
 #ifdef HW_RVL
 	print_gecko("Running on IOS ver: %i\r\n", iosversion);
@@ -1962,13 +2644,23 @@ int main(int argc, char **argv) {
 	int reuseSettings = NOT_ASKED;
 	while (1) {
 		int fs = 0, ret = 0;
+		int mounted = 0;
 		if(reuseSettings == NOT_ASKED || reuseSettings == ANSWER_NO) {
+			// the last dump's files may be on the device about to be changed
+			finish_wait();
 			int validSelection = 0;
 			while (!validSelection) {
 #ifdef HW_RVL
-				select_source_type();
+				if (!image_path && !sim_path) {
+					select_source_type();
+				}
 #endif
-				select_device_type();
+				if (net_host) {
+					selected_device = TYPE_NET;
+				}
+				else {
+					select_device_type();
+				}
 #ifdef HW_RVL
 				if (selected_source == SRC_USB_DRIVE && selected_device == TYPE_USB) {
 					DrawFrameStart();
@@ -1984,26 +2676,46 @@ int main(int argc, char **argv) {
 					validSelection = 1;
 				}
 			}
-			if (selected_device != TYPE_READONLY) {
+			if (selected_device == TYPE_NET) {
+				while (initialise_net() != 1);
+			}
+			else if (selected_device != TYPE_READONLY) {
 				fs = filesystem_type();
 				ret = -1;
 				do {
 					ret = initialise_device(fs);
 				} while (ret != 1);
-			}			
+				mounted = 1;
+			}
+			mount_mirror();
 		}
 
 		if(selected_device != TYPE_READONLY && calcChecksums) {
+			// not while the finish thread may be looking something up
+			if (!dats_loaded()) {
+				finish_wait();
+			}
 			// Try to load up redump.org dat files
 			verify_init(&mountPath[0]);
 #ifdef HW_RVL
-			// Ask the user if they want to download new ones
-			verify_download(&mountPath[0]);
+			// Ask the user if they want to download new ones, there's nowhere to keep them on the receiver
+			if (selected_device != TYPE_NET) {
+				verify_download(&mountPath[0]);
 
-			// User might've got some new files.
-			verify_init(&mountPath[0]);
+				// User might've got some new files.
+				verify_init(&mountPath[0]);
+			}
 #endif
 		}
+		if (mounted) {
+			int resumed = finish_resume(&mountPath[0]);
+			if (mirrorPath[0]) {
+				resumed += finish_resume(mirrorPath);
+			}
+			if (resumed) {
+				print_gecko("Finishing %i dump(s) from last time\r\n", resumed);
+			}
+		}
 
 		// Init the source and try to detect disc type
 		ret = NO_DISC;
@@ -2027,22 +2739,25 @@ int main(int argc, char **argv) {
 		}
 
 		if(reuseSettings == NOT_ASKED || reuseSettings == ANSWER_NO) {
-			if ((disc_type == IS_WII_DISC || disc_type == IS_OTHER_DISC) && selected_device != TYPE_READONLY) {
+			if (selected_device != TYPE_READONLY) {
 				get_settings(disc_type);
 			}
 		
 			// Ask the user if they want to force Datel check this time?
-			if(disc_type != IS_OTHER_DISC && selected_device != TYPE_READONLY
+			if(disc_type != IS_OTHER_DISC && selected_device != TYPE_READONLY && !image_path
 #ifdef HW_RVL
 				&& selected_source == SRC_INTERNAL_DISC
 #endif
 				&& DrawYesNoDialog("Is this a unlicensed datel disc?",
 								 "(Will attempt auto-detect if no)")) {
 				disc_type = IS_DATEL_DISC;
+				finish_wait();
 				datel_init(&mountPath[0]);
 #ifdef HW_RVL
-				datel_download(&mountPath[0]);
-				datel_init(&mountPath[0]);
+				if (selected_device != TYPE_NET) {
+					datel_download(&mountPath[0]);
+					datel_init(&mountPath[0]);
+				}
 #endif
 				calcChecksums = 1;
 			}
@@ -2065,6 +2780,12 @@ int main(int argc, char **argv) {
 		DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
 		sprintf(txtbuffer, "%i disc(s) dumped", dumpCounter);
 		WriteCentre(190, txtbuffer);
+		if (finish_pending()) {
+			WriteCentre(225, "Last dump is still being verified");
+		}
+		else if (finish_last_result()[0]) {
+			WriteCentre(225, (char*)finish_last_result());
+		}
 		WriteCentre(255, "Dump another disc?");
 		wait_press_A_exit_B(false);
 	}
@@ -0,0 +1,374 @@
+/**
+ * CleanRip - netdump.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * Dumping to cleanrip-recv on another machine, for when the SD card
+ * or USB device is what holds the dump back. One TCP connection is
+ * kept for the whole session and carries the image, its parts and
+ * the files next to it as frames with a CRC each. Every frame is
+ * acknowledged once the receiver has written it; the sender stops
+ * once NET_WINDOW bytes aren't acknowledged yet, so a slow receiver
+ * holds the ring up instead of the socket buffers.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#define _GNU_SOURCE		// fopencookie
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __CYGWIN__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#define net_socket			socket
+#define net_connect			connect
+#define net_send			send
+#define net_recv			recv
+#define net_close			close
+#define net_setsockopt		setsockopt
+#define net_gethostbyname	gethostbyname
+#else
+#include <network.h>
+#endif
+#include "netdump.h"
+#include "bytes.h"
+#include "crc32.h"
+
+void print_gecko(const char* fmt, ...);
+
+typedef struct {
+	int used;
+	int failed;			// a frame for it wasn't written
+	FILE *fp;			// opened with dump_fopen
+	u64 pos;
+} remote_file;
+
+static int sock = -1;
+static int broken;		// the connection is gone, nothing more can be sent
+static u32 unacked;		// frames the receiver hasn't answered yet
+static u32 unacked_bytes;
+static int last_status;
+static remote_file files[NET_FILES];
+// holds the one token that lets a thread use the connection, the writer
+// and the finish thread both do
+static mqbox_t lockq;
+static int lock_ready;
+
+static void lock() {
+	mqmsg_t token;
+	MQ_Receive(lockq, &token, MQ_MSG_BLOCK);
+}
+
+static void unlock() {
+	MQ_Send(lockq, (mqmsg_t)&lockq, MQ_MSG_BLOCK);
+}
+
+static int send_all(const void *data, u32 len) {
+	const u8 *p = (const u8*)data;
+	while (len) {
+		int sent = net_send(sock, p, len, 0);
+		if (sent <= 0) {
+			broken = 1;
+			return 1;
+		}
+		p += sent;
+		len -= sent;
+	}
+	return 0;
+}
+
+static int recv_all(void *data, u32 len) {
+	u8 *p = (u8*)data;
+	while (len) {
+		int got = net_recv(sock, p, len, 0);
+		if (got <= 0) {
+			broken = 1;
+			return 1;
+		}
+		p += got;
+		len -= got;
+	}
+	return 0;
+}
+
+static int send_frame(int type, int file, const void *data, u32 len, u64 offset) {
+	u8 hdr[NET_HEADER_SIZE];
+
+	if (broken) {
+		return 1;
+	}
+	put_be32(hdr + NET_OFS_MAGIC, NET_MAGIC);
+	put_be16(hdr + NET_OFS_TYPE, type);
+	put_be16(hdr + NET_OFS_FILE, file);
+	put_be32(hdr + NET_OFS_LEN, len);
+	put_be32(hdr + NET_OFS_CRC, len ? Crc32_ComputeBuf(0, data, len) : 0);
+	put_be32(hdr + NET_OFS_OFFSET, offset >> 32);
+	put_be32(hdr + NET_OFS_OFFSET + 4, offset & 0xFFFFFFFF);
+	if (send_all(hdr, NET_HEADER_SIZE) || (len && send_all(data, len))) {
+		return 1;
+	}
+	unacked++;
+	unacked_bytes += len;
+	return 0;
+}
+
+// Takes the next ACK, a failed write marks its file
+static int read_ack() {
+	u8 hdr[NET_HEADER_SIZE];
+
+	if (broken || recv_all(hdr, NET_HEADER_SIZE)) {
+		return 1;
+	}
+	u32 type = (hdr[NET_OFS_TYPE] << 8) | hdr[NET_OFS_TYPE + 1];
+	u32 file = (hdr[NET_OFS_FILE] << 8) | hdr[NET_OFS_FILE + 1];
+	u32 len = get_be32(hdr + NET_OFS_LEN);
+	if (get_be32(hdr + NET_OFS_MAGIC) != NET_MAGIC || type != NET_ACK || !unacked) {
+		broken = 1;
+		return 1;
+	}
+	last_status = get_be32(hdr + NET_OFS_CRC);
+	unacked--;
+	unacked_bytes -= (len < unacked_bytes) ? len : unacked_bytes;
+	if (last_status != NET_OK && file < NET_FILES) {
+		print_gecko("Receiver: status %i for file %u\r\n", last_status, file);
+		files[file].failed = 1;
+	}
+	return 0;
+}
+
+// Waits until the receiver has answered everything, the status is the last frame's
+static int drain() {
+	while (unacked) {
+		if (read_ack()) {
+			return 1;
+		}
+	}
+	return broken || last_status != NET_OK;
+}
+
+// A frame whose answer is needed before going on
+static int request(int type, int file, const void *data, u32 len, u64 offset) {
+	lock();
+	int ret = send_frame(type, file, data, len, offset) || drain();
+	unlock();
+	return ret;
+}
+
+int netdump_connect(const char *host, u16 port) {
+	struct sockaddr_in sa;
+	struct hostent *hp;
+	int one = 1;
+
+	if (!lock_ready) {
+		MQ_Init(&lockq, 1);
+		unlock();
+		lock_ready = 1;
+	}
+	netdump_disconnect();
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_port = htons(port);
+	hp = net_gethostbyname(host);
+	if (!hp || hp->h_addrtype != AF_INET) {
+		return 1;
+	}
+	memcpy(&sa.sin_addr, hp->h_addr_list[0], sizeof(sa.sin_addr));
+	sock = net_socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+	if (sock < 0) {
+		return 1;
+	}
+	if (net_connect(sock, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+		net_close(sock);
+		sock = -1;
+		return 1;
+	}
+	// the ACKs are small and the sender waits on them
+	net_setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	broken = 0;
+	unacked = 0;
+	unacked_bytes = 0;
+	memset(files, 0, sizeof(files));
+	if (request(NET_HELLO, NET_NO_FILE, NULL, 0, NET_VERSION)) {
+		print_gecko("Receiver at %s:%u didn't answer\r\n", host, port);
+		netdump_disconnect();
+		return 1;
+	}
+	print_gecko("Dumping to the receiver at %s:%u\r\n", host, port);
+	return 0;
+}
+
+int netdump_connected() {
+	return sock >= 0 && !broken;
+}
+
+void netdump_disconnect() {
+	if (sock < 0) {
+		return;
+	}
+	lock();
+	if (!broken) {
+		send_frame(NET_BYE, NET_NO_FILE, NULL, 0, 0);
+		drain();
+	}
+	net_close(sock);
+	sock = -1;
+	unlock();
+}
+
+// The name on the receiver, or NULL for a local path
+const char *netdump_name(const char *path) {
+	int len = strlen(NET_MOUNT);
+	return strncmp(path, NET_MOUNT, len) ? NULL : path + len;
+}
+
+int netdump_open(const char *name) {
+	int file;
+
+	if (sock < 0 || strlen(name) >= NET_NAME_MAX) {
+		return -1;
+	}
+	lock();
+	for (file = 0; file < NET_FILES && files[file].used; file++);
+	if (file == NET_FILES) {
+		unlock();
+		return -1;
+	}
+	memset(&files[file], 0, sizeof(remote_file));
+	files[file].used = 1;
+	unlock();
+	if (request(NET_OPEN, file, name, strlen(name), 0)) {
+		files[file].used = 0;
+		return -1;
+	}
+	return file;
+}
+
+int netdump_reserve(int file, u64 size) {
+	return request(NET_RESERVE, file, NULL, 0, size);
+}
+
+int netdump_write(int file, const void *data, u32 len, u64 offset) {
+	lock();
+	// past the window the receiver has to catch up first
+	while (unacked && (unacked >= NET_MAX_UNACKED || unacked_bytes + len > NET_WINDOW)) {
+		if (read_ack()) {
+			break;
+		}
+	}
+	int ret = send_frame(NET_DATA, file, data, len, offset) || files[file].failed;
+	unlock();
+	return ret;
+}
+
+// Everything sent for the file is written on the receiver
+int netdump_sync(int file) {
+	lock();
+	int ret = drain() || files[file].failed;
+	unlock();
+	return ret;
+}
+
+int netdump_close(int file) {
+	int ret = request(NET_CLOSE, file, NULL, 0, 0) || files[file].failed;
+	files[file].used = 0;
+	return ret;
+}
+
+/* stdio on the receiver's files, for everything that isn't the image */
+static ssize_t cookie_write(void *cookie, const char *buf, size_t size) {
+	remote_file *f = (remote_file*)cookie;
+	if (netdump_write(f - files, buf, size, f->pos)) {
+		return -1;
+	}
+	f->pos += size;
+	return size;
+}
+
+static int cookie_close(void *cookie) {
+	remote_file *f = (remote_file*)cookie;
+	f->fp = NULL;
+	return netdump_close(f - files) ? EOF : 0;
+}
+
+FILE *dump_fopen(const char *path, const char *mode) {
+	const char *name = netdump_name(path);
+	cookie_io_functions_t io = { NULL, cookie_write, NULL, cookie_close };
+
+	if (!name) {
+		return fopen(path, mode);
+	}
+	// only ever written from the start
+	if (mode[0] != 'w') {
+		return NULL;
+	}
+	int file = netdump_open(name);
+	if (file < 0) {
+		return NULL;
+	}
+	files[file].fp = fopencookie(&files[file], "w", io);
+	if (!files[file].fp) {
+		netdump_close(file);
+	}
+	return files[file].fp;
+}
+
+// Only the receiver preallocates, a local file is left as it is
+void dump_reserve(FILE *fp, u64 size) {
+	for (int file = 0; fp && file < NET_FILES; file++) {
+		if (files[file].used && files[file].fp == fp) {
+			netdump_reserve(file, size);
+			return;
+		}
+	}
+}
+
+int dump_remove(const char *path) {
+	const char *name = netdump_name(path);
+	if (!name) {
+		return remove(path);
+	}
+	return request(NET_REMOVE, NET_NO_FILE, name, strlen(name), 0) ? -1 : 0;
+}
+
+int dump_rename(const char *from, const char *to) {
+	char names[NET_NAME_MAX * 2];
+	const char *from_name = netdump_name(from);
+	const char *to_name = netdump_name(to);
+
+	if (!from_name && !to_name) {
+		return rename(from, to);
+	}
+	if (!from_name || !to_name || strlen(from_name) >= NET_NAME_MAX || strlen(to_name) >= NET_NAME_MAX) {
+		return -1;
+	}
+	int len = sprintf(names, "%s%c%s", from_name, 0, to_name);
+	return request(NET_RENAME, NET_NO_FILE, names, len, 0) ? -1 : 0;
+}
+
+int dump_exists(const char *path) {
+	const char *name = netdump_name(path);
+	if (!name) {
+		FILE *fp = fopen(path, "rb");
+		if (fp) {
+			fclose(fp);
+		}
+		return fp != NULL;
+	}
+	return !request(NET_EXISTS, NET_NO_FILE, name, strlen(name), 0);
+}
@@ -0,0 +1,226 @@
+/**
+ * CleanRip - partfile.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * Writes an image as a set of .partN files split at exact byte
+ * offsets. The next part is created ahead of time on a helper
+ * thread (and the finished one closed there) so the writer never
+ * waits on the filesystem at a chunk boundary.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "partfile.h"
+#include "netdump.h"
+
+#define OPENER_PRIO 128 // same as the reader/writer threads
+
+enum {
+	PART_OPEN,
+	PART_CLOSE,
+};
+
+void partfile_path(partfile *pf, int part, char *path) {
+	sprintf(path, "%s.part%i%s", pf->prefix, part, pf->ext);
+}
+
+static u64 part_length(partfile *pf, int part) {
+	u64 start = (u64)part * pf->part_size;
+	if (start >= pf->total_size) {
+		return 0;
+	}
+	u64 left = pf->total_size - start;
+	return left < pf->part_size ? left : pf->part_size;
+}
+
+static void part_preallocate(FILE *fp, u64 length) {
+#ifdef __CYGWIN__
+	// reserve the whole part up front so NTFS doesn't fragment it
+	posix_fallocate(fileno(fp), 0, (off_t)length);
+#else
+	// libfat/libntfs zero-fill a file when it is extended, which would
+	// double the amount written to the device. Creating it is enough,
+	// only a part on the receiver is reserved.
+	dump_reserve(fp, length);
+#endif
+}
+
+static int part_finish(FILE *fp, u64 written) {
+	int ret = 0;
+#ifdef __CYGWIN__
+	// a part that was preallocated but not filled (cancelled dump) must
+	// not keep its reserved tail
+	fflush(fp);
+	if (ftruncate(fileno(fp), (off_t)written) != 0) {
+		ret = -1;
+	}
+#else
+	(void)written;
+#endif
+	if (fclose(fp) != 0) {
+		ret = -1;
+	}
+	return ret;
+}
+
+static FILE *part_create(partfile *pf, int part) {
+	char path[PARTFILE_PATH_MAX + 16];
+	partfile_path(pf, part, path);
+	dump_remove(path);
+	FILE *fp = dump_fopen(path, "wb");
+	if (fp) {
+		part_preallocate(fp, part_length(pf, part));
+	}
+	return fp;
+}
+
+static void* opener_thread(void *_pf) {
+	partfile *pf = (partfile*)_pf;
+	part_job *job;
+
+	while (MQ_Receive(pf->jobq, (mqmsg_t*)&job, MQ_MSG_BLOCK)==TRUE && job) {
+		switch (job->command) {
+			case PART_OPEN:
+				job->fp = part_create(pf, job->part);
+				MQ_Send(pf->doneq, (mqmsg_t)job, MQ_MSG_BLOCK);
+				break;
+			case PART_CLOSE:
+				if (part_finish(job->fp, job->length)) {
+					pf->failed = 1;
+				}
+				job->fp = NULL;
+				break;
+		}
+	}
+	return NULL;
+}
+
+static void request_part(partfile *pf, int part) {
+	pf->open_job.command = PART_OPEN;
+	pf->open_job.part = part;
+	pf->open_job.fp = NULL;
+	pf->open_pending = 1;
+	MQ_Send(pf->jobq, (mqmsg_t)&pf->open_job, MQ_MSG_BLOCK);
+}
+
+static int next_part(partfile *pf) {
+	part_job *job;
+
+	// normally the opener finished with this long ago
+	if (!pf->open_pending) {
+		request_part(pf, pf->part + 1);
+	}
+	MQ_Receive(pf->doneq, (mqmsg_t*)&job, MQ_MSG_BLOCK);
+	pf->open_pending = 0;
+	if (!job->fp) {
+		return -1;
+	}
+
+	// the close job is free again: the opener handled it before the open we just received
+	pf->close_job.command = PART_CLOSE;
+	pf->close_job.fp = pf->fp;
+	pf->close_job.length = pf->part_written;
+	MQ_Send(pf->jobq, (mqmsg_t)&pf->close_job, MQ_MSG_BLOCK);
+
+	pf->fp = job->fp;
+	pf->part++;
+	pf->part_written = 0;
+	if (part_length(pf, pf->part + 1)) {
+		request_part(pf, pf->part + 1);
+	}
+	return 0;
+}
+
+int partfile_open(partfile *pf, const char *prefix, const char *ext, u64 part_size, u64 total_size) {
+	memset(pf, 0, sizeof(partfile));
+	snprintf(pf->prefix, sizeof(pf->prefix), "%s", prefix);
+	snprintf(pf->ext, sizeof(pf->ext), "%s", ext);
+	pf->part_size = part_size;
+	pf->total_size = total_size;
+
+	pf->fp = part_create(pf, 0);
+	if (!pf->fp) {
+		return -1;
+	}
+	MQ_Init(&pf->jobq, 4);
+	MQ_Init(&pf->doneq, 1);
+	LWP_CreateThread(&pf->opener, opener_thread, (void*)pf, NULL, 0, OPENER_PRIO);
+	if (part_length(pf, 1)) {
+		request_part(pf, 1);
+	}
+	return 0;
+}
+
+int partfile_write(partfile *pf, const void *data, u32 length) {
+	const u8 *src = (const u8*)data;
+
+	if (pf->failed) {
+		return -1;
+	}
+	while (length) {
+		if (pf->part_written >= pf->part_size) {
+			if (next_part(pf)) {
+				return -1;
+			}
+		}
+		// split a block that straddles the boundary across both parts
+		u64 room = pf->part_size - pf->part_written;
+		u32 len = ((u64)length < room) ? length : (u32)room;
+		if (fwrite(src, len, 1, pf->fp) != 1) {
+			return -1;
+		}
+		pf->part_written += len;
+		src += len;
+		length -= len;
+	}
+	return 0;
+}
+
+int partfile_close(partfile *pf) {
+	part_job *job;
+	int ret = 0;
+
+	if (pf->open_pending) {
+		// created for data that never came (cancelled or short read)
+		MQ_Receive(pf->doneq, (mqmsg_t*)&job, MQ_MSG_BLOCK);
+		pf->open_pending = 0;
+		if (job->fp) {
+			char path[PARTFILE_PATH_MAX + 16];
+			fclose(job->fp);
+			partfile_path(pf, job->part, path);
+			dump_remove(path);
+		}
+	}
+	MQ_Send(pf->jobq, (mqmsg_t)NULL, MQ_MSG_BLOCK);
+	LWP_JoinThread(pf->opener, NULL);
+	MQ_Close(pf->jobq);
+	MQ_Close(pf->doneq);
+
+	if (pf->fp && part_finish(pf->fp, pf->part_written)) {
+		ret = -1;
+	}
+	pf->fp = NULL;
+	return (ret || pf->failed) ? -1 : 0;
+}
+
+int partfile_count(partfile *pf) {
+	return pf->part + 1;
+}
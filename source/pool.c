@@ -0,0 +1,154 @@
+/**
+ * CleanRip - pool.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * The worker threads the compressing formats hand their blocks to.
+ * A job is filled in by the writer thread, done by whichever worker
+ * takes it, and written out by the format strictly in the order the
+ * jobs were handed out. Jobs own their data, so they stay out across
+ * writes and the ring block they came from goes straight back to the
+ * reader; only flush and close wait for all of them. The console has
+ * no workers, a job is done in the writer thread as it is handed out.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <string.h>
+#include <unistd.h>
+#include "pool.h"
+
+#define WORKER_PRIO 128 // workers only start on a PC, where LWP_CreateThread ignores it
+
+static int pool_slot(job_pool *p, void *job) {
+	return ((u8*)job - p->jobs) / p->job_size;
+}
+
+static void* worker_thread(void *_worker) {
+	pool_worker *w = (pool_worker*)_worker;
+	job_pool *p = w->p;
+	void *job;
+
+	while (MQ_Receive(p->jobq, (mqmsg_t*)&job, MQ_MSG_BLOCK)==TRUE && job) {
+		p->run(w->state, job);
+		MQ_Send(p->doneq[pool_slot(p, job)], (mqmsg_t)job, MQ_MSG_BLOCK);
+	}
+	return NULL;
+}
+
+// One worker per core on a PC, none on the console
+int pool_cores() {
+#if defined(__CYGWIN__) || defined(__linux__)
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	return cores < 1 ? 1 : (cores > POOL_MAX_WORKERS ? POOL_MAX_WORKERS : (int)cores);
+#else
+	return 0;
+#endif
+}
+
+// Enough jobs out that no worker waits on the next
+int pool_slots(int workers) {
+	return workers ? workers * 2 : 1;
+}
+
+void pool_init(job_pool *p, sink *s, void *jobs, u32 job_size, int slots, pool_run run, pool_emit emit, void *self) {
+	memset(p, 0, sizeof(job_pool));
+	p->s = s;
+	p->jobs = (u8*)jobs;
+	p->job_size = job_size;
+	p->slots = slots > POOL_MAX_SLOTS ? POOL_MAX_SLOTS : slots;
+	p->run = run;
+	p->emit = emit;
+	p->self = self;
+	if (p->slots > 1) {
+		MQ_Init(&p->jobq, p->slots);
+		for (int i = 0; i < p->slots; i++) {
+			MQ_Init(&p->doneq[i], 1);
+		}
+		p->queues = 1;
+	}
+}
+
+// Starts a worker with its own state; when none starts the jobs are done in the writer thread
+int pool_start(job_pool *p, void *state) {
+	if (!p->queues || p->workers == POOL_MAX_WORKERS) {
+		return 1;
+	}
+	pool_worker *w = &p->worker[p->workers++];
+	w->p = p;
+	w->state = state;
+	LWP_CreateThread(&w->thread, worker_thread, (void*)w, NULL, 0, WORKER_PRIO);
+	return 0;
+}
+
+// Waits for the oldest job and writes it out
+static int pool_retire(job_pool *p) {
+	void *job = p->jobs + p->first * p->job_size, *done;
+
+	MQ_Receive(p->doneq[p->first], (mqmsg_t*)&done, MQ_MSG_BLOCK);
+	p->first = (p->first + 1) % p->slots;
+	p->pending--;
+	return p->emit(p->s, job);
+}
+
+// The job to fill in next, once one is free; the same one until it is handed out
+void *pool_next(job_pool *p, int *ret) {
+	if (p->pending == p->slots) {
+		*ret |= pool_retire(p);
+	}
+	return p->jobs + ((p->first + p->pending) % p->slots) * p->job_size;
+}
+
+// Hands out the job pool_next gave
+int pool_submit(job_pool *p) {
+	int ret = 0;
+	void *job = pool_next(p, &ret);
+
+	if (!p->workers) {
+		p->run(p->self, job);
+		return p->emit(p->s, job) | ret;
+	}
+	p->pending++;
+	MQ_Send(p->jobq, (mqmsg_t)job, MQ_MSG_BLOCK);
+	return ret;
+}
+
+// Every job handed out is written
+int pool_drain(job_pool *p) {
+	int ret = 0;
+
+	while (p->pending) {
+		ret |= pool_retire(p);
+	}
+	return ret;
+}
+
+// Stops the workers, their states and the jobs are the format's to free
+void pool_close(job_pool *p) {
+	for (int i = 0; i < p->workers; i++) {
+		MQ_Send(p->jobq, (mqmsg_t)NULL, MQ_MSG_BLOCK);
+	}
+	for (int i = 0; i < p->workers; i++) {
+		LWP_JoinThread(p->worker[i].thread, NULL);
+	}
+	if (p->queues) {
+		MQ_Close(p->jobq);
+		for (int i = 0; i < p->slots; i++) {
+			MQ_Close(p->doneq[i]);
+		}
+	}
+	p->workers = 0;
+	p->queues = 0;
+}
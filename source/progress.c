@@ -0,0 +1,121 @@
+/**
+ * CleanRip - progress.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * Machine readable progress for unattended use. Every event is
+ * written as one line of JSON (newline delimited JSON) to a file
+ * descriptor handed over by whatever is driving the rip.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdio.h>
+#include <string.h>
+#include "progress.h"
+
+static FILE *progress_fp = NULL;
+static char line[PROGRESS_LINE_MAX];
+static int line_len = 0;
+
+int progress_open(int fd) {
+	progress_close();
+	progress_fp = fdopen(fd, "w");
+	return progress_fp ? 0 : -1;
+}
+
+int progress_enabled() {
+	return progress_fp != NULL;
+}
+
+static void append(const char *text, int len) {
+	// an event that doesn't fit is cut short rather than split over two lines,
+	// leave room for the closing "}\n"
+	if (line_len + len > PROGRESS_LINE_MAX - 3) {
+		len = PROGRESS_LINE_MAX - 3 - line_len;
+	}
+	if (len > 0) {
+		memcpy(line + line_len, text, len);
+		line_len += len;
+	}
+}
+
+static void append_string(const char *value) {
+	char esc[8];
+
+	append("\"", 1);
+	for (; *value; value++) {
+		unsigned char c = (unsigned char)*value;
+		if (c == '"' || c == '\\') {
+			esc[0] = '\\';
+			esc[1] = c;
+			append(esc, 2);
+		}
+		else if (c < 0x20) {
+			append(esc, sprintf(esc, "\\u%04x", c));
+		}
+		else {
+			append((const char*)&c, 1);
+		}
+	}
+	append("\"", 1);
+}
+
+static void append_key(const char *key) {
+	append(",", 1);
+	append_string(key);
+	append(":", 1);
+}
+
+void progress_begin(const char *event) {
+	line_len = 0;
+	append("{\"event\":", 9);
+	append_string(event);
+}
+
+void progress_str(const char *key, const char *value) {
+	append_key(key);
+	append_string(value ? value : "");
+}
+
+void progress_num(const char *key, u64 value) {
+	char num[24];
+	append_key(key);
+	append(num, sprintf(num, "%llu", (unsigned long long)value));
+}
+
+void progress_real(const char *key, double value) {
+	char num[32];
+	append_key(key);
+	append(num, sprintf(num, "%.2f", value));
+}
+
+void progress_end() {
+	if (!progress_fp) {
+		return;
+	}
+	append("}\n", 2);
+	fwrite(line, line_len, 1, progress_fp);
+	// whoever reads this wants it now, not when the buffer fills
+	fflush(progress_fp);
+	line_len = 0;
+}
+
+void progress_close() {
+	if (progress_fp) {
+		fclose(progress_fp);
+		progress_fp = NULL;
+	}
+}
@@ -0,0 +1,331 @@
+/**
+ * CleanRip - recv.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * cleanrip-recv, which takes the dumps CleanRip sends with --net=host
+ * and writes them to a directory on this machine. An image is
+ * preallocated once its size is known, every frame is checked against
+ * its CRC and only acknowledged once it has been written, which is
+ * what keeps the sender from running ahead of the disk here.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "netproto.h"
+#include "crc32.h"
+
+typedef struct {
+	int fd;					// -1 if not open
+	uint64_t end;			// the furthest anything was written to
+	uint64_t reserved;
+	time_t opened;
+	char name[NET_NAME_MAX];
+} recv_file;
+
+static const char *out_dir = ".";
+static recv_file files[NET_FILES];
+
+static void put_be16(uint8_t *p, uint16_t v) {
+	p[0] = v >> 8;
+	p[1] = v & 0xFF;
+}
+
+static void put_be32(uint8_t *p, uint32_t v) {
+	put_be16(p, v >> 16);
+	put_be16(p + 2, v & 0xFFFF);
+}
+
+static uint16_t get_be16(const uint8_t *p) {
+	return (p[0] << 8) | p[1];
+}
+
+static uint32_t get_be32(const uint8_t *p) {
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static int recv_all(int sock, void *data, uint32_t len) {
+	uint8_t *p = (uint8_t*)data;
+	while (len) {
+		ssize_t got = recv(sock, p, len, 0);
+		if (got <= 0) {
+			return 1;
+		}
+		p += got;
+		len -= got;
+	}
+	return 0;
+}
+
+static int send_all(int sock, const void *data, uint32_t len) {
+	const uint8_t *p = (const uint8_t*)data;
+	while (len) {
+		ssize_t sent = send(sock, p, len, 0);
+		if (sent <= 0) {
+			return 1;
+		}
+		p += sent;
+		len -= sent;
+	}
+	return 0;
+}
+
+// Only a plain file name in out_dir, nothing that leads out of it
+static int valid_name(const char *name) {
+	return name[0] && strcmp(name, ".") && strcmp(name, "..")
+		&& !strchr(name, '/') && !strchr(name, '\\') && !strchr(name, ':');
+}
+
+static void path_of(char *path, size_t size, const char *name) {
+	snprintf(path, size, "%s/%s", out_dir, name);
+}
+
+static void close_file(recv_file *f) {
+	if (f->fd >= 0) {
+		close(f->fd);
+		f->fd = -1;
+	}
+}
+
+static int file_open(recv_file *f, const char *name) {
+	char path[4096];
+
+	if (!valid_name(name)) {
+		return NET_ERR_NAME;
+	}
+	close_file(f);
+	path_of(path, sizeof(path), name);
+	f->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (f->fd < 0) {
+		fprintf(stderr, "Can't create %s: %s\n", path, strerror(errno));
+		return NET_ERR_IO;
+	}
+	snprintf(f->name, sizeof(f->name), "%s", name);
+	f->end = 0;
+	f->reserved = 0;
+	f->opened = time(NULL);
+	return NET_OK;
+}
+
+static int file_reserve(recv_file *f, uint64_t size) {
+	// a filesystem that can't preallocate still takes the file
+	int ret = posix_fallocate(f->fd, 0, (off_t)size);
+	if (ret && ret != EOPNOTSUPP && ret != EINVAL) {
+		fprintf(stderr, "Can't reserve %llu bytes for %s: %s\n", (unsigned long long)size, f->name, strerror(ret));
+		return NET_ERR_IO;
+	}
+	f->reserved = size;
+	return NET_OK;
+}
+
+static int file_write(recv_file *f, const uint8_t *data, uint32_t len, uint64_t offset) {
+	uint32_t done = 0;
+	while (done < len) {
+		ssize_t n = pwrite(f->fd, data + done, len - done, (off_t)(offset + done));
+		if (n <= 0) {
+			fprintf(stderr, "Write to %s failed: %s\n", f->name, strerror(errno));
+			return NET_ERR_IO;
+		}
+		done += n;
+	}
+	if (offset + len > f->end) {
+		f->end = offset + len;
+	}
+	return NET_OK;
+}
+
+static int file_close(recv_file *f) {
+	int ret = NET_OK;
+	// a cancelled dump doesn't keep the tail that was reserved for it
+	if (f->reserved > f->end && ftruncate(f->fd, (off_t)f->end)) {
+		ret = NET_ERR_IO;
+	}
+	if (fsync(f->fd) || close(f->fd)) {
+		ret = NET_ERR_IO;
+	}
+	f->fd = -1;
+	long seconds = (long)(time(NULL) - f->opened);
+	printf("%s: %llu bytes in %lds\n", f->name, (unsigned long long)f->end, seconds);
+	fflush(stdout);
+	return ret;
+}
+
+static int rename_file(const char *names, uint32_t len) {
+	char from[4096], to[4096];
+	const char *new_name = memchr(names, 0, len);
+
+	if (!new_name || !valid_name(names) || !valid_name(++new_name)) {
+		return NET_ERR_NAME;
+	}
+	path_of(from, sizeof(from), names);
+	path_of(to, sizeof(to), new_name);
+	if (rename(from, to)) {
+		return errno == ENOENT ? NET_ERR_NAME : NET_ERR_IO;
+	}
+	return NET_OK;
+}
+
+static int handle(int type, int file, uint8_t *payload, uint32_t len, uint64_t offset) {
+	char path[4096];
+	recv_file *f = (file < NET_FILES) ? &files[file] : NULL;
+
+	switch (type) {
+		case NET_HELLO:
+			return offset == NET_VERSION ? NET_OK : NET_ERR_PROTO;
+		case NET_OPEN:
+			return f ? file_open(f, (char*)payload) : NET_ERR_FILE;
+		case NET_RESERVE:
+			return (f && f->fd >= 0) ? file_reserve(f, offset) : NET_ERR_FILE;
+		case NET_DATA:
+			return (f && f->fd >= 0) ? file_write(f, payload, len, offset) : NET_ERR_FILE;
+		case NET_CLOSE:
+			return (f && f->fd >= 0) ? file_close(f) : NET_ERR_FILE;
+		case NET_REMOVE:
+			if (!valid_name((char*)payload)) {
+				return NET_ERR_NAME;
+			}
+			path_of(path, sizeof(path), (char*)payload);
+			return (unlink(path) && errno != ENOENT) ? NET_ERR_IO : NET_OK;
+		case NET_RENAME:
+			return rename_file((char*)payload, len);
+		case NET_EXISTS:
+			if (!valid_name((char*)payload)) {
+				return NET_ERR_NAME;
+			}
+			path_of(path, sizeof(path), (char*)payload);
+			return access(path, F_OK) ? NET_ERR_NAME : NET_OK;
+		case NET_BYE:
+			return NET_OK;
+	}
+	return NET_ERR_PROTO;
+}
+
+// One CleanRip session, until it says goodbye or the connection drops
+static void session(int sock) {
+	uint8_t hdr[NET_HEADER_SIZE];
+	uint8_t *payload = NULL;
+	uint32_t payload_size = 0;
+	int type = 0;
+
+	for (int i = 0; i < NET_FILES; i++) {
+		files[i].fd = -1;
+	}
+	while (type != NET_BYE && !recv_all(sock, hdr, NET_HEADER_SIZE)) {
+		type = get_be16(hdr + NET_OFS_TYPE);
+		int file = get_be16(hdr + NET_OFS_FILE);
+		uint32_t len = get_be32(hdr + NET_OFS_LEN);
+		uint64_t offset = ((uint64_t)get_be32(hdr + NET_OFS_OFFSET) << 32) | get_be32(hdr + NET_OFS_OFFSET + 4);
+		if (get_be32(hdr + NET_OFS_MAGIC) != NET_MAGIC || len > NET_FRAME_MAX) {
+			fprintf(stderr, "Not a CleanRip frame, dropping the connection\n");
+			break;
+		}
+		if (len + 1 > payload_size) {
+			// one more for the NUL that ends a name
+			free(payload);
+			payload_size = len + 1;
+			payload = malloc(payload_size);
+			if (!payload) {
+				break;
+			}
+		}
+		if (recv_all(sock, payload, len)) {
+			break;
+		}
+		payload[len] = 0;
+		int status = NET_ERR_CRC;
+		if (Crc32_ComputeBuf(0, payload, len) == get_be32(hdr + NET_OFS_CRC)) {
+			status = handle(type, file, payload, len, offset);
+		}
+		else {
+			fprintf(stderr, "CRC mismatch at %llu in file %d\n", (unsigned long long)offset, file);
+		}
+		put_be16(hdr + NET_OFS_TYPE, NET_ACK);
+		put_be32(hdr + NET_OFS_CRC, status);
+		if (send_all(sock, hdr, NET_HEADER_SIZE)) {
+			break;
+		}
+	}
+	// whatever was still open stays as far as it got
+	for (int i = 0; i < NET_FILES; i++) {
+		close_file(&files[i]);
+	}
+	free(payload);
+}
+
+int main(int argc, char **argv) {
+	struct sockaddr_in sa;
+	int port = NET_PORT;
+	int one = 1;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+			port = atoi(argv[++i]);
+		}
+		else if (argv[i][0] == '-') {
+			fprintf(stderr, "Usage: %s [-p port] [directory]\n", argv[0]);
+			return 2;
+		}
+		else {
+			out_dir = argv[i];
+		}
+	}
+
+	int listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listener < 0) {
+		perror("socket");
+		return 1;
+	}
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(INADDR_ANY);
+	sa.sin_port = htons(port);
+	if (bind(listener, (struct sockaddr *)&sa, sizeof(sa)) || listen(listener, 1)) {
+		perror("bind");
+		return 1;
+	}
+	printf("Waiting for CleanRip on port %d, writing to %s\n", port, out_dir);
+	fflush(stdout);
+
+	while (1) {
+		struct sockaddr_in peer;
+		socklen_t peer_len = sizeof(peer);
+		int sock = accept(listener, (struct sockaddr *)&peer, &peer_len);
+		if (sock < 0) {
+			continue;
+		}
+		setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		printf("Connected: %s\n", inet_ntoa(peer.sin_addr));
+		fflush(stdout);
+		session(sock);
+		close(sock);
+		printf("Disconnected\n");
+		fflush(stdout);
+	}
+	return 0;
+}
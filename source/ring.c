@@ -0,0 +1,86 @@
+/**
+ * CleanRip - ring.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * The read blocks passed between the dump loop and the writer
+ * thread. Blocks can be held back to run with a shallower
+ * pipeline, and the whole ring can be reallocated once every
+ * block is back home.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "ring.h"
+
+int ring_alloc(block_ring *r, mqbox_t freeq, u32 header_size, u32 block_size, int count) {
+	memset(r, 0, sizeof(block_ring));
+	if (count > RING_MAX_BLOCKS) {
+		count = RING_MAX_BLOCKS;
+	}
+	r->memory = memalign(32, count * (header_size + block_size));
+	if (!r->memory) {
+		return -1;
+	}
+	r->header_size = header_size;
+	r->block_size = block_size;
+	r->count = count;
+	r->freeq = freeq;
+	for (int i = 0; i < count; i++) {
+		MQ_Send(freeq, (mqmsg_t)(r->memory + i * (header_size + block_size)), MQ_MSG_BLOCK);
+	}
+	return 0;
+}
+
+// Next free block, keeping at most depth blocks in flight
+void *ring_take(block_ring *r, int depth) {
+	void *blk;
+
+	while (r->parked_count && r->count - r->parked_count < depth) {
+		MQ_Send(r->freeq, (mqmsg_t)r->parked[--r->parked_count], MQ_MSG_BLOCK);
+	}
+	MQ_Receive(r->freeq, (mqmsg_t*)&blk, MQ_MSG_BLOCK);
+	while (blk && r->count - r->parked_count > depth) {
+		r->parked[r->parked_count++] = blk;
+		MQ_Receive(r->freeq, (mqmsg_t*)&blk, MQ_MSG_BLOCK);
+	}
+	return blk;
+}
+
+// Collects every block in flight, the writer must have been flushed first
+int ring_drain(block_ring *r) {
+	void *blk;
+
+	for (int i = r->count - r->parked_count; i > 0; i--) {
+		MQ_Receive(r->freeq, (mqmsg_t*)&blk, MQ_MSG_BLOCK);
+		if (blk == NULL) {
+			// write error, leave it for the dump loop to report
+			MQ_Jam(r->freeq, (mqmsg_t)NULL, MQ_MSG_BLOCK);
+			return -1;
+		}
+	}
+	r->parked_count = 0;
+	return 0;
+}
+
+void ring_free(block_ring *r) {
+	free(r->memory);
+	r->memory = NULL;
+	r->count = 0;
+	r->parked_count = 0;
+}
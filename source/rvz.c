@@ -0,0 +1,601 @@
+/**
+ * CleanRip - rvz.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * A sink stage that writes the image as an RVZ while it is dumped.
+ * The image is cut into 128KB groups and each one is looked over for
+ * the mastering tool's junk: where a run of it turns up, the seed is
+ * worked out of the data and the run is stored as just that. What is
+ * left is compressed with zstd by a pool of worker threads, one per
+ * core on a PC, and the groups are appended in order as they finish.
+ * The tables and headers are written at close. There is no zstd for
+ * the console, so it packs the junk in the writer thread and stores
+ * the rest as it is. On a PC a GameCube RVZ can be read back a group
+ * at a time, the junk made again from its seeds.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include "rvz.h"
+#include "bytes.h"
+#include "pool.h"
+#include "lfg.h"
+#include "sha1.h"
+
+#if defined(__CYGWIN__) || defined(__linux__)
+#include <zstd.h>
+#define RVZ_LEVEL 5
+#endif
+
+#define RVZ_OUT_SIZE (1024*1024)	// groups are passed on in writes of up to this
+#define RVZ_DATA_START (RVZ_HEADER1_SIZE + RVZ_HEADER2_SIZE)
+#define RVZ_SEED_BYTES (LFG_SEED_SIZE * 4)
+#define RVZ_PACK_SIZE (RVZ_CHUNK_SIZE + 4096)	// room for the run sizes
+
+typedef struct {
+	lfg g;
+	u8 *junk;			// the junk for a 32KB block, to compare against
+#ifdef RVZ_LEVEL
+	ZSTD_CCtx *cctx;
+#endif
+} rvz_worker;
+
+typedef struct {
+	u8 *in;				// the group, copied out of the writes it came in
+	u32 len;
+	u8 *pack;			// junk runs and the data between them
+	u8 *out;			// compressed
+	const u8 *data;		// what goes in the file
+	u32 size;			// data_size as it goes in the table
+	u32 packed_size;
+} rvz_job;
+
+typedef struct {
+	u64 data_size;
+	u32 num_groups;
+	u32 group;			// the next group to go out
+	u64 out;			// where it goes in the file
+	u8 hdr[RVZ_DATA_START];
+	u8 *groups;			// the group table
+	u32 fill;			// of the group being put together
+	u8 *obuf;			// groups not passed on yet
+	u32 ofill;
+	rvz_worker self;	// when there are no workers, and for the tables
+	rvz_worker worker[POOL_MAX_WORKERS];
+	int workers;		// set up
+	int slots;
+	rvz_job *jobs;
+	job_pool pool;
+} rvz_ctx;
+
+static void put_sha1(u8 *p, const u8 *data, u32 len) {
+	SHA1Context sha;
+
+	SHA1Reset(&sha);
+	SHA1Input(&sha, data, len);
+	SHA1Result(&sha);
+	for (int i = 0; i < 5; i++) {
+		put_be32(p + i * 4, sha.Message_Digest[i]);
+	}
+}
+
+static u8 *rvz_raw(u8 *p, const u8 *data, u32 len) {
+	if (len) {
+		put_be32(p, len);
+		memcpy(p + 4, data, len);
+		p += 4 + len;
+	}
+	return p;
+}
+
+// Looks for junk in one 32KB block, which is where the generator starts over.
+// Returns what the group is packed into so far.
+static u8 *rvz_pack_block(rvz_worker *w, rvz_job *job, u8 *p, u32 *raw, u32 start, u32 end) {
+	u32 seed[LFG_SEED_SIZE];
+	u32 run = 0, word = start;
+
+	for (u32 i = start; i + 4 <= end; i += 4) {
+		if (!lfg_maybe_junk(get_be32(job->in + i))) {
+			run = 0;
+			continue;
+		}
+		if (!run++) {
+			word = i;
+		}
+		if (run < LFG_K) {
+			continue;
+		}
+		run = 0;
+		if (!lfg_get_seed(job->in + word, end - word, word - start, seed)) {
+			continue;
+		}
+		lfg_set_seed(&w->g, seed);
+		lfg_get_bytes(&w->g, w->junk, end - start);
+		const u8 *junk = w->junk - start;
+		u32 from = word, to = word, first = *raw > start ? *raw : start;
+		while (from > first && job->in[from - 1] == junk[from - 1]) {
+			from--;
+		}
+		while (to < end && job->in[to] == junk[to]) {
+			to++;
+		}
+		if (to - from <= RVZ_SEED_BYTES + 4) {
+			continue;
+		}
+		p = rvz_raw(p, job->in + *raw, from - *raw);
+		put_be32(p, (to - from) | RVZ_JUNK);
+		for (int j = 0; j < LFG_SEED_SIZE; j++) {
+			put_be32(p + 4 + j * 4, seed[j]);
+		}
+		p += 4 + RVZ_SEED_BYTES;
+		*raw = to;
+		i = ((to + 3) & ~3) - 4;
+	}
+	return p;
+}
+
+static void rvz_pack(void *_worker, void *_job) {
+	rvz_worker *w = (rvz_worker*)_worker;
+	rvz_job *job = (rvz_job*)_job;
+	u32 raw = 0, n = job->len;
+	u8 *p = job->pack;
+
+	job->packed_size = 0;
+	job->data = job->in;
+	job->size = 0;
+	// an all zero group isn't stored at all
+	while (n && !job->in[n - 1]) {
+		n--;
+	}
+	if (!n) {
+		return;
+	}
+	for (u32 i = 0; i < job->len; i += RVZ_JUNK_BLOCK) {
+		u32 end = job->len - i < RVZ_JUNK_BLOCK ? job->len : i + RVZ_JUNK_BLOCK;
+		p = rvz_pack_block(w, job, p, &raw, i, end);
+	}
+	job->size = job->len;
+	if (raw) {
+		p = rvz_raw(p, job->in + raw, job->len - raw);
+		job->data = job->pack;
+		job->size = job->packed_size = p - job->pack;
+	}
+#ifdef RVZ_LEVEL
+	size_t len = ZSTD_compressCCtx(w->cctx, job->out, ZSTD_compressBound(RVZ_PACK_SIZE),
+		job->data, job->size, RVZ_LEVEL);
+	if (!ZSTD_isError(len) && len < job->size) {
+		job->data = job->out;
+		job->size = len | RVZ_COMPRESSED;
+	}
+#endif
+}
+
+static int rvz_pass_on(sink *s) {
+	rvz_ctx *c = (rvz_ctx*)s->ctx;
+	int ret = 0;
+
+	if (c->ofill) {
+		ret = sink_write(s->next[0], c->obuf, c->ofill, c->out - c->ofill);
+		c->ofill = 0;
+	}
+	return ret;
+}
+
+static int rvz_append(sink *s, const u8 *data, u32 len) {
+	rvz_ctx *c = (rvz_ctx*)s->ctx;
+	int ret = 0;
+
+	// groups start on a word, their offsets are stored divided by 4
+	u32 padded = (len + 3) & ~3;
+	if (c->ofill + padded > RVZ_OUT_SIZE) {
+		ret = rvz_pass_on(s);
+	}
+	memcpy(c->obuf + c->ofill, data, len);
+	memset(c->obuf + c->ofill + len, 0, padded - len);
+	c->ofill += padded;
+	c->out += padded;
+	return ret;
+}
+
+// Appends a packed group and notes it in the table
+static int rvz_emit(sink *s, void *_job) {
+	rvz_ctx *c = (rvz_ctx*)s->ctx;
+	rvz_job *job = (rvz_job*)_job;
+	u8 *entry = c->groups + c->group * 12;
+
+	if (c->group >= c->num_groups) {
+		return 1;
+	}
+	put_be32(entry, c->out >> 2);
+	put_be32(entry + 4, job->size);
+	put_be32(entry + 8, job->packed_size);
+	c->group++;
+	return rvz_append(s, job->data, job->size & ~RVZ_COMPRESSED);
+}
+
+static int rvz_write(sink *s, const void *data, u32 len, u64 offset) {
+	rvz_ctx *c = (rvz_ctx*)s->ctx;
+	const u8 *p = (const u8*)data;
+	int ret = 0;
+
+	// the groups only work if every block comes in order
+	if (offset != s->pos) {
+		return 1;
+	}
+	// the disc header goes in the second header as well
+	if (offset < RVZ_DISC_HEADER_SIZE) {
+		u32 n = RVZ_DISC_HEADER_SIZE - offset;
+		memcpy(c->hdr + RVZ_HEADER1_SIZE + 0x10 + offset, p, n > len ? len : n);
+	}
+	s->pos += len;
+	while (len) {
+		rvz_job *job = (rvz_job*)pool_next(&c->pool, &ret);
+		u32 n = RVZ_CHUNK_SIZE - c->fill;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(job->in + c->fill, p, n);
+		c->fill += n;
+		p += n;
+		len -= n;
+		if (c->fill == RVZ_CHUNK_SIZE) {
+			job->len = RVZ_CHUNK_SIZE;
+			ret |= pool_submit(&c->pool);
+			c->fill = 0;
+		}
+	}
+	return ret;
+}
+
+static int rvz_flush(sink *s) {
+	rvz_ctx *c = (rvz_ctx*)s->ctx;
+
+	return pool_drain(&c->pool) | rvz_pass_on(s) | sink_flush(s->next[0]);
+}
+
+// A table goes after the groups, compressed the same way they are
+static int rvz_table(sink *s, const u8 *table, u32 len, u8 *entry) {
+	rvz_ctx *c = (rvz_ctx*)s->ctx;
+	const u8 *data = table;
+	int ret = 0;
+
+#ifdef RVZ_LEVEL
+	size_t bound = ZSTD_compressBound(len);
+	u8 *out = (u8*)malloc(bound);
+	if (!out) {
+		return 1;
+	}
+	size_t size = ZSTD_compressCCtx(c->self.cctx, out, bound, table, len, RVZ_LEVEL);
+	ret = ZSTD_isError(size);
+	data = out;
+	len = size;
+#endif
+	put_be64(entry, c->out);
+	put_be32(entry + 8, len);
+	if (!ret) {
+		ret = rvz_append(s, data, len) | rvz_pass_on(s);
+	}
+#ifdef RVZ_LEVEL
+	free(out);
+#endif
+	return ret;
+}
+
+static int rvz_header(sink *s) {
+	rvz_ctx *c = (rvz_ctx*)s->ctx;
+	u8 *h1 = c->hdr, *h2 = c->hdr + RVZ_HEADER1_SIZE;
+
+	put_be32(h2, 1);								// GameCube
+#ifdef RVZ_LEVEL
+	put_be32(h2 + 0x04, RVZ_ZSTD);
+	put_be32(h2 + 0x08, RVZ_LEVEL);
+#else
+	put_be32(h2 + 0x04, RVZ_NONE);
+#endif
+	put_be32(h2 + 0x0C, RVZ_CHUNK_SIZE);
+	// no partitions, the whole image is raw data
+	put_be32(h2 + 0x94, 0x30);
+	put_be64(h2 + 0x98, RVZ_DATA_START);
+	put_sha1(h2 + 0xA0, NULL, 0);
+	put_be32(h2 + 0xB4, 1);
+	put_be32(h2 + 0xC4, c->num_groups);
+	put_sha1(h1 + 0x10, h2, RVZ_HEADER2_SIZE);
+
+	put_be32(h1, RVZ_MAGIC);
+	put_be32(h1 + 0x04, RVZ_VERSION);
+	put_be32(h1 + 0x08, RVZ_VERSION_COMPATIBLE);
+	put_be32(h1 + 0x0C, RVZ_HEADER2_SIZE);
+	put_be64(h1 + 0x24, c->data_size);
+	put_be64(h1 + 0x2C, c->out);
+	put_sha1(h1 + 0x34, h1, 0x34);
+	return sink_write(s->next[0], c->hdr, RVZ_DATA_START, 0);
+}
+
+static void rvz_worker_free(rvz_worker *w) {
+	free(w->junk);
+#ifdef RVZ_LEVEL
+	ZSTD_freeCCtx(w->cctx);
+#endif
+}
+
+static int rvz_worker_init(rvz_worker *w) {
+	w->junk = (u8*)malloc(RVZ_JUNK_BLOCK);
+#ifdef RVZ_LEVEL
+	w->cctx = ZSTD_createCCtx();
+	if (!w->cctx) {
+		return 1;
+	}
+#endif
+	return !w->junk;
+}
+
+static void rvz_free(rvz_ctx *c) {
+	pool_close(&c->pool);
+	for (int i = 0; i < c->workers; i++) {
+		rvz_worker_free(&c->worker[i]);
+	}
+	for (int i = 0; c->jobs && i < c->slots; i++) {
+		free(c->jobs[i].in);
+		free(c->jobs[i].pack);
+		free(c->jobs[i].out);
+	}
+	rvz_worker_free(&c->self);
+	free(c->jobs);
+	free(c->obuf);
+	free(c->groups);
+	free(c);
+}
+
+static int rvz_close(sink *s) {
+	rvz_ctx *c = (rvz_ctx*)s->ctx;
+	u8 *h2 = c ? c->hdr + RVZ_HEADER1_SIZE : NULL;
+	u8 raw[24];
+	int ret = 0;
+
+	if (c) {
+		if (c->fill) {
+			rvz_job *job = (rvz_job*)pool_next(&c->pool, &ret);
+			job->len = c->fill;
+			ret |= pool_submit(&c->pool);
+		}
+		ret |= pool_drain(&c->pool) | rvz_pass_on(s);
+		// the raw data starts after the disc header, its groups from 0
+		put_be64(raw, RVZ_DISC_HEADER_SIZE);
+		put_be64(raw + 8, c->data_size - RVZ_DISC_HEADER_SIZE);
+		put_be32(raw + 16, 0);
+		put_be32(raw + 20, c->num_groups);
+		ret |= rvz_table(s, raw, sizeof(raw), h2 + 0xB8);
+		ret |= rvz_table(s, c->groups, c->num_groups * 12, h2 + 0xC8);
+		ret |= rvz_header(s);
+		rvz_free(c);
+		s->ctx = NULL;
+	}
+	return sink_close(s->next[0]) | ret;
+}
+
+static const sink_ops rvz_ops = { rvz_write, rvz_flush, rvz_close };
+
+int sink_rvz(sink *s, sink *next, u64 data_size) {
+	rvz_ctx *c = (rvz_ctx*)calloc(1, sizeof(rvz_ctx));
+	if (!c) {
+		return 1;
+	}
+	c->data_size = data_size;
+	c->num_groups = (data_size + RVZ_CHUNK_SIZE - 1) / RVZ_CHUNK_SIZE;
+	c->out = RVZ_DATA_START;
+	c->groups = (u8*)calloc(c->num_groups, 12);
+	c->obuf = (u8*)malloc(RVZ_OUT_SIZE);
+	int workers = pool_cores();
+	c->slots = pool_slots(workers);
+	c->jobs = (rvz_job*)calloc(c->slots, sizeof(rvz_job));
+	int failed = !c->groups || !c->obuf || !c->jobs || rvz_worker_init(&c->self);
+	for (int i = 0; !failed && i < c->slots; i++) {
+		rvz_job *job = &c->jobs[i];
+		job->in = (u8*)malloc(RVZ_CHUNK_SIZE);
+		job->pack = (u8*)malloc(RVZ_PACK_SIZE);
+		failed = !job->in || !job->pack;
+#ifdef RVZ_LEVEL
+		job->out = (u8*)malloc(ZSTD_compressBound(RVZ_PACK_SIZE));
+		failed |= !job->out;
+#endif
+	}
+	if (failed) {
+		rvz_free(c);
+		return 1;
+	}
+	pool_init(&c->pool, s, c->jobs, sizeof(rvz_job), c->slots, rvz_pack, rvz_emit, &c->self);
+	// fewer workers is fine, with none the writer thread packs
+	for (; c->workers < workers; c->workers++) {
+		rvz_worker *w = &c->worker[c->workers];
+		if (rvz_worker_init(w)) {
+			rvz_worker_free(w);
+			break;
+		}
+		pool_start(&c->pool, w);
+	}
+	sink_stage(s, &rvz_ops, c, next);
+	// empty headers until the dump is done
+	if (sink_write(next, c->hdr, RVZ_DATA_START, 0)) {
+		rvz_free(c);
+		s->ctx = NULL;
+		return 1;
+	}
+	return 0;
+}
+
+#if defined(__CYGWIN__) || defined(__linux__)
+typedef struct {
+	FILE *fp;
+	int compression;
+	u8 disc_header[RVZ_DISC_HEADER_SIZE];
+	u8 *groups;			// the group table, decompressed
+	u32 max_in;			// the biggest group in the file
+} rvz_reader;
+
+// A table after the groups, compressed the same way they are
+static u8 *rvz_read_table(rvz_reader *r, const u8 *entry, u32 len) {
+	u32 size = get_be32(entry + 8);
+	u8 *in = (u8*)malloc(size + 1);
+	u8 *table = (u8*)malloc(len + 1);
+
+	if (!in || !table || archive_pread(r->fp, in, size, get_be64(entry))) {
+		free(in);
+		free(table);
+		return NULL;
+	}
+	if (r->compression == RVZ_NONE && size == len) {
+		memcpy(table, in, len);
+	}
+	else if (r->compression != RVZ_ZSTD || ZSTD_decompress(table, len, in, size) != len) {
+		free(table);
+		table = NULL;
+	}
+	free(in);
+	return table;
+}
+
+// Junk runs come back from their seeds, the generator starting over every 32KB as on the disc
+static int rvz_unpack(const u8 *p, u32 len, u8 *dst, u32 size, u64 pos) {
+	const u8 *end = p + len;
+	lfg g;
+
+	while (p < end && size) {
+		if (end - p < 4) {
+			return 1;
+		}
+		u32 run = get_be32(p) & ~RVZ_JUNK;
+		int junk = (get_be32(p) & RVZ_JUNK) != 0;
+		p += 4;
+		if (run > size || (u32)(end - p) < (junk ? RVZ_SEED_BYTES : run)) {
+			return 1;
+		}
+		if (junk) {
+			u32 seed[LFG_SEED_SIZE];
+			for (int j = 0; j < LFG_SEED_SIZE; j++) {
+				seed[j] = get_be32(p + j * 4);
+			}
+			lfg_set_seed(&g, seed);
+			lfg_forward(&g, pos % RVZ_JUNK_BLOCK);
+			lfg_get_bytes(&g, dst, run);
+			p += RVZ_SEED_BYTES;
+		}
+		else {
+			memcpy(dst, p, run);
+			p += run;
+		}
+		dst += run;
+		pos += run;
+		size -= run;
+	}
+	return 0;
+}
+
+static int rvz_read_group(archive *a, u32 group, u8 *dst, u8 *scratch) {
+	rvz_reader *r = (rvz_reader*)a->ctx;
+	const u8 *entry = r->groups + (u64)group * 12;
+	u32 size = get_be32(entry + 4) & ~RVZ_COMPRESSED;
+	u32 packed = get_be32(entry + 8);
+	u64 pos = (u64)group * a->block_size;
+	u32 len = (a->size - pos < a->block_size) ? (u32)(a->size - pos) : a->block_size;
+	u8 *data = scratch;
+
+	memset(dst, 0, a->block_size);
+	if (size) {
+		if (archive_pread(r->fp, scratch, size, (u64)get_be32(entry) << 2)) {
+			return 1;
+		}
+		if (get_be32(entry + 4) & RVZ_COMPRESSED) {
+			// a plain group goes straight to dst, a packed one is unpacked from after the input
+			u8 *out = packed ? scratch + r->max_in : dst;
+			size_t n = ZSTD_decompress(out, packed ? packed : a->block_size, scratch, size);
+			if (ZSTD_isError(n)) {
+				return 1;
+			}
+			data = out;
+			size = n;
+		}
+		if (packed) {
+			if (rvz_unpack(data, size < packed ? size : packed, dst, len, pos)) {
+				return 1;
+			}
+		}
+		else if (data != dst) {
+			memcpy(dst, data, size < len ? size : len);
+		}
+	}
+	if (!group) {
+		memcpy(dst, r->disc_header, RVZ_DISC_HEADER_SIZE);
+	}
+	return 0;
+}
+
+static void rvz_reader_close(archive *a) {
+	rvz_reader *r = (rvz_reader*)a->ctx;
+
+	fclose(r->fp);
+	free(r->groups);
+	free(r);
+}
+
+// Only what a GameCube disc makes: no partitions, one run of raw data after the disc header
+int rvz_archive(archive *a, const char *path) {
+	u8 hdr[RVZ_DATA_START];
+	u8 *h2 = hdr + RVZ_HEADER1_SIZE;
+	u8 *raw = NULL;
+	rvz_reader *r = (rvz_reader*)calloc(1, sizeof(rvz_reader));
+
+	memset(a, 0, sizeof(archive));
+	if (!r || !(r->fp = fopen(path, "rb"))) {
+		free(r);
+		return -1;
+	}
+	a->ctx = r;
+	a->close = rvz_reader_close;
+	a->block = rvz_read_group;
+	if (archive_pread(r->fp, hdr, RVZ_DATA_START, 0) || get_be32(hdr) != RVZ_MAGIC
+		|| get_be32(hdr + 0x0C) != RVZ_HEADER2_SIZE || get_be32(h2 + 0x90) || get_be32(h2 + 0xB4) != 1) {
+		rvz_reader_close(a);
+		return -1;
+	}
+	r->compression = get_be32(h2 + 0x04);
+	memcpy(r->disc_header, h2 + 0x10, RVZ_DISC_HEADER_SIZE);
+	a->size = get_be64(hdr + 0x24);
+	a->size_known = 1;
+	a->block_size = get_be32(h2 + 0x0C);
+	a->blocks = get_be32(h2 + 0xC4);
+	if (!a->block_size || a->block_size % RVZ_JUNK_BLOCK || (u64)a->blocks * a->block_size < a->size
+		|| !(raw = rvz_read_table(r, h2 + 0xB8, 24))
+		|| !(r->groups = rvz_read_table(r, h2 + 0xC8, a->blocks * 12))
+		// the raw data's groups start at the 32KB block the data does
+		|| get_be64(raw) >= RVZ_JUNK_BLOCK || get_be32(raw + 16) || get_be32(raw + 20) != a->blocks) {
+		free(raw);
+		rvz_reader_close(a);
+		return -1;
+	}
+	free(raw);
+	u32 max_pack = a->block_size;
+	for (u32 i = 0; i < a->blocks; i++) {
+		u32 size = get_be32(r->groups + i * 12 + 4) & ~RVZ_COMPRESSED;
+		u32 packed = get_be32(r->groups + i * 12 + 8);
+		r->max_in = size > r->max_in ? size : r->max_in;
+		max_pack = packed > max_pack ? packed : max_pack;
+	}
+	a->scratch_size = r->max_in + max_pack;
+	return 0;
+}
+#endif
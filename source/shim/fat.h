@@ -0,0 +1,31 @@
+/**
+ * CleanRip - shim/fat.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * A FAT mount is a directory named after it, for the Linux build
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef SHIM_FAT_H
+#define SHIM_FAT_H
+
+#include <gccore.h>
+
+bool fatMountSimple(const char *name, const DISC_INTERFACE *interface);
+void fatUnmount(const char *name);
+
+#endif
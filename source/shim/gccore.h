@@ -0,0 +1,128 @@
+/**
+ * CleanRip - shim/gccore.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * The parts of libogc the console code uses, for the Linux build
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef SHIM_GCCORE_H
+#define SHIM_GCCORE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "host_ogc.h"
+
+typedef volatile u8 vu8;
+typedef volatile u16 vu16;
+
+#define ATTRIBUTE_ALIGN(v)	__attribute__((aligned(v)))
+#define MEM_K0_TO_K1(x)		(x)
+#define MQ_MSG_NOBLOCK		1
+
+#include <ogc/disc_io.h>
+
+/* video, only the calls Initialise() makes */
+typedef struct {
+	u32 viTVMode;
+	u16 fbWidth;
+	u16 efbHeight;
+	u16 xfbHeight;
+} GXRModeObj;
+
+typedef struct {
+	u8 r, g, b, a;
+} GXColor;
+
+#define VI_NON_INTERLACE	0
+#define GX_CULL_NONE		0
+#define GX_TRUE				1
+
+#define COLOR_BLACK		0x00800080
+#define COLOR_RED		0x4C544CFF
+#define COLOR_GREEN		0x4B554B4A
+#define COLOR_BLUE		0x1DFF1D6B
+#define COLOR_SILVER	0xB580B580
+#define COLOR_WHITE		0xFF80FF80
+
+void VIDEO_Init();
+GXRModeObj *VIDEO_GetPreferredMode(GXRModeObj *mode);
+void VIDEO_Configure(GXRModeObj *mode);
+void VIDEO_ClearFrameBuffer(GXRModeObj *mode, void *fb, u32 color);
+void VIDEO_SetNextFramebuffer(void *fb);
+void VIDEO_SetPostRetraceCallback(void (*callback)(u32));
+void VIDEO_SetBlack(bool black);
+void VIDEO_Flush();
+void VIDEO_WaitVSync();
+
+void GX_Init(void *fifo, u32 size);
+void GX_SetCopyClear(GXColor color, u32 z);
+void GX_SetViewport(f32 x, f32 y, f32 w, f32 h, f32 n, f32 f);
+void GX_SetDispCopyYScale(f32 scale);
+void GX_SetDispCopyDst(u16 width, u16 height);
+void GX_SetCullMode(u8 mode);
+void GX_CopyDisp(void *dest, u8 clear);
+
+/* system */
+#define SYS_POWEROFF	4
+
+void *SYS_AllocateFramebuffer(GXRModeObj *mode);
+void SYS_ResetSystem(s32 reset, u32 type, s32 force);
+void SYS_SetPowerCallback(void (*callback)());
+void *SYS_GetArena1Lo();
+void *SYS_GetArena1Hi();
+void *SYS_GetArena2Lo();
+void *SYS_GetArena2Hi();
+void SYS_SetArena2Hi(void *hi);
+
+void DCFlushRange(void *addr, u32 len);
+void DCInvalidateRange(void *addr, u32 len);
+void DCZeroRange(void *addr, u32 len);
+
+s32 IOS_ReloadIOS(int version);
+s32 IOS_GetVersion();
+s32 ES_GetNumTitles(u32 *count);
+s32 ES_GetTitles(u64 *titles, u32 count);
+s32 CONF_Init();
+
+/* usb gecko */
+int usb_isgeckoalive(s32 chn);
+void usb_flush(s32 chn);
+int usb_sendbuffer_safe(s32 chn, const void *buffer, int size);
+
+/* controller */
+#define PAD_BUTTON_LEFT		0x0001
+#define PAD_BUTTON_RIGHT	0x0002
+#define PAD_BUTTON_DOWN		0x0004
+#define PAD_BUTTON_UP		0x0008
+#define PAD_TRIGGER_Z		0x0010
+#define PAD_TRIGGER_R		0x0020
+#define PAD_TRIGGER_L		0x0040
+#define PAD_BUTTON_A		0x0100
+#define PAD_BUTTON_B		0x0200
+#define PAD_BUTTON_X		0x0400
+#define PAD_BUTTON_Y		0x0800
+#define PAD_BUTTON_START	0x1000
+
+u32 PAD_Init();
+u32 PAD_ScanPads();
+u16 PAD_ButtonsDown(int pad);
+
+/* tells the pad the screen now shows something to press */
+void shim_pad_prompt();
+
+#endif
@@ -0,0 +1,144 @@
+/**
+ * CleanRip - shim/lwp.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * LWP threads, message boxes and the timer on top of POSIX, behaving
+ * like the libogc ones. Kept apart from the rest of the shim so host
+ * tools that share the sinks and readers can link them on their own.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdlib.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <gccore.h>
+
+/* threads */
+void LWP_SetThreadPriority(lwp_t thread, u32 prio) {}
+
+void LWP_CreateThread(lwp_t* thread, void* (*func)(void*), void* arg, void* stack, u32 stack_size, u32 prio) {
+	pthread_create(thread, NULL, func, arg);
+}
+
+void LWP_JoinThread(lwp_t thread, void** value_ptr) {
+	pthread_join(thread, value_ptr);
+}
+
+void LWP_YieldThread() {
+	sched_yield();
+}
+
+/* message boxes */
+typedef struct {
+	mqmsg_t *msgs;
+	u32 size;
+	u32 head;
+	u32 count;
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty;
+	pthread_cond_t not_full;
+} mqbox;
+
+void MQ_Init(mqbox_t* mq, u32 count) {
+	mqbox *box = calloc(1, sizeof(mqbox));
+	box->msgs = calloc(count, sizeof(mqmsg_t));
+	box->size = count;
+	pthread_mutex_init(&box->lock, NULL);
+	pthread_cond_init(&box->not_empty, NULL);
+	pthread_cond_init(&box->not_full, NULL);
+	*mq = box;
+}
+
+static bool mq_wait_room(mqbox *box, u32 flags) {
+	while (box->count == box->size) {
+		if (flags == MQ_MSG_NOBLOCK) {
+			return false;
+		}
+		pthread_cond_wait(&box->not_full, &box->lock);
+	}
+	return true;
+}
+
+bool MQ_Send(mqbox_t mq, mqmsg_t msg, u32 flags) {
+	mqbox *box = (mqbox*)mq;
+	pthread_mutex_lock(&box->lock);
+	if (!mq_wait_room(box, flags)) {
+		pthread_mutex_unlock(&box->lock);
+		return false;
+	}
+	box->msgs[(box->head + box->count) % box->size] = msg;
+	box->count++;
+	pthread_cond_signal(&box->not_empty);
+	pthread_mutex_unlock(&box->lock);
+	return true;
+}
+
+void MQ_Jam(mqbox_t mq, mqmsg_t msg, u32 flags) {
+	mqbox *box = (mqbox*)mq;
+	pthread_mutex_lock(&box->lock);
+	if (mq_wait_room(box, flags)) {
+		// goes in front of everything already queued
+		box->head = (box->head + box->size - 1) % box->size;
+		box->msgs[box->head] = msg;
+		box->count++;
+		pthread_cond_signal(&box->not_empty);
+	}
+	pthread_mutex_unlock(&box->lock);
+}
+
+bool MQ_Receive(mqbox_t mq, mqmsg_t* msg, u32 flags) {
+	mqbox *box = (mqbox*)mq;
+	pthread_mutex_lock(&box->lock);
+	while (!box->count) {
+		if (flags == MQ_MSG_NOBLOCK) {
+			pthread_mutex_unlock(&box->lock);
+			return false;
+		}
+		pthread_cond_wait(&box->not_empty, &box->lock);
+	}
+	*msg = box->msgs[box->head];
+	box->head = (box->head + 1) % box->size;
+	box->count--;
+	pthread_cond_signal(&box->not_full);
+	pthread_mutex_unlock(&box->lock);
+	return true;
+}
+
+void MQ_Close(mqbox_t mq) {
+	mqbox *box = (mqbox*)mq;
+	pthread_mutex_destroy(&box->lock);
+	pthread_cond_destroy(&box->not_empty);
+	pthread_cond_destroy(&box->not_full);
+	free(box->msgs);
+	free(box);
+}
+
+/* time */
+u128 gettime() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u128)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+u32 diff_msec(u128 start, u128 end) {
+	return (u32)((end - start) / 1000000ULL);
+}
+
+u32 diff_sec(u128 start, u128 end) {
+	return (u32)((end - start) / 1000000000ULL);
+}
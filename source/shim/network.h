@@ -0,0 +1,45 @@
+/**
+ * CleanRip - shim/network.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * The Linux build has no network setup to do, DAT files are read from
+ * disk. Sockets are the host's, so --net= reaches a receiver on it.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef SHIM_NETWORK_H
+#define SHIM_NETWORK_H
+
+#include <gccore.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+
+s32 if_config(char *local_ip, char *netmask, char *gateway, bool use_dhcp);
+
+#define net_socket		socket
+#define net_connect		connect
+#define net_send		send
+#define net_recv		recv
+#define net_close		close
+#define net_setsockopt	setsockopt
+#define net_gethostbyname	gethostbyname
+
+#endif
@@ -0,0 +1,41 @@
+/**
+ * CleanRip - shim/ntfs.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * NTFS never mounts in the Linux build, use FAT
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef SHIM_NTFS_H
+#define SHIM_NTFS_H
+
+#include <gccore.h>
+
+#define NTFS_DEFAULT	0x00000000
+#define NTFS_RECOVER	0x00000002
+
+typedef struct _ntfs_md {
+	char name[32];
+	const DISC_INTERFACE *interface;
+	sec_t startSector;
+} ntfs_md;
+
+int ntfsMountDevice(const DISC_INTERFACE *interface, ntfs_md **mounts, u32 flags);
+void ntfsUnmount(const char *name, bool force);
+const char *ntfsGetVolumeName(const char *name);
+
+#endif
@@ -0,0 +1,315 @@
+/**
+ * CleanRip - shim/ogc.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * libogc on top of POSIX so the console code runs on Linux. Threads
+ * and message boxes are in lwp.c, the screen is a text log (screen.c)
+ * and the controller replays a list of button presses so a whole rip
+ * can run, and be profiled, without anybody there.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <gccore.h>
+#include <fat.h>
+#include <ntfs.h>
+#include <network.h>
+#include <ogc/usbstorage.h>
+#include <sdcard/wiisd_io.h>
+#include <wiiuse/wpad.h>
+#include "ios.h"
+#include "http.h"
+
+#define MEM1_BASE		0x80000000UL	// disc ID and OS globals
+#define MEM1_LOW_SIZE	0x4000
+#define HOLLYWOOD_BASE	0xcd800000UL	// AHBPROT and IRQ registers
+#define HOLLYWOOD_SIZE	0x1000
+#define RETRACE_USEC	16667			// 60Hz
+
+#define PAD_RELEASE_MS	50				// nothing held after a prompt shows up,
+#define PAD_HOLD_MS		100				// then the next button is held this long
+
+/* The console code reads a few fixed addresses (AHBPROT, the disc ID
+   in low MEM1). Map them where it expects them. */
+static void map_fixed(unsigned long addr, size_t size) {
+	void *p = mmap((void*)addr, size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+	if (p != (void*)addr) {
+		fprintf(stderr, "shim: can't map %08lx\n", addr);
+		exit(1);
+	}
+}
+
+__attribute__((constructor)) static void map_hardware() {
+	map_fixed(MEM1_BASE, MEM1_LOW_SIZE);
+	map_fixed(HOLLYWOOD_BASE, HOLLYWOOD_SIZE);
+	// HW_AHBPROT, all access already granted
+	*(vu32*)(HOLLYWOOD_BASE + 0x64) = 0xFFFFFFFF;
+}
+
+/* caches, coherent on a PC */
+void DCFlushRange(void *addr, u32 len) {}
+void DCInvalidateRange(void *addr, u32 len) {}
+
+void DCZeroRange(void *addr, u32 len) {
+	memset(addr, 0, len);
+}
+
+/* video */
+static GXRModeObj text_mode = { 0, 640, 480, 480 };
+static void (*retrace_callback)(u32) = NULL;
+static u32 retrace_count = 0;
+static lwp_t retrace_thread;
+
+static void* retrace_loop(void *arg) {
+	while (1) {
+		usleep(RETRACE_USEC);
+		if (retrace_callback) {
+			retrace_callback(++retrace_count);
+		}
+	}
+	return NULL;
+}
+
+void VIDEO_Init() {}
+GXRModeObj *VIDEO_GetPreferredMode(GXRModeObj *mode) { return &text_mode; }
+void VIDEO_Configure(GXRModeObj *mode) {}
+void VIDEO_ClearFrameBuffer(GXRModeObj *mode, void *fb, u32 color) {}
+void VIDEO_SetNextFramebuffer(void *fb) {}
+void VIDEO_SetBlack(bool black) {}
+void VIDEO_Flush() {}
+
+void VIDEO_SetPostRetraceCallback(void (*callback)(u32)) {
+	// the pads are only read after a retrace asked for it, so keep them coming
+	if (!retrace_callback) {
+		LWP_CreateThread(&retrace_thread, retrace_loop, NULL, NULL, 0, 0);
+	}
+	retrace_callback = callback;
+}
+
+void VIDEO_WaitVSync() {
+	usleep(RETRACE_USEC);
+}
+
+void GX_Init(void *fifo, u32 size) {}
+void GX_SetCopyClear(GXColor color, u32 z) {}
+void GX_SetViewport(f32 x, f32 y, f32 w, f32 h, f32 n, f32 f) {}
+void GX_SetDispCopyYScale(f32 scale) {}
+void GX_SetDispCopyDst(u16 width, u16 height) {}
+void GX_SetCullMode(u8 mode) {}
+void GX_CopyDisp(void *dest, u8 clear) {}
+
+/* system */
+void *SYS_AllocateFramebuffer(GXRModeObj *mode) {
+	return calloc(mode->fbWidth * mode->xfbHeight, 2);
+}
+
+void SYS_ResetSystem(s32 reset, u32 type, s32 force) {
+	exit(0);
+}
+
+void SYS_SetPowerCallback(void (*callback)()) {}
+
+// only ever printed
+void *SYS_GetArena1Lo() { return (void*)0x80400000UL; }
+void *SYS_GetArena1Hi() { return (void*)0x81700000UL; }
+
+// no MEM2 arena, the spill buffer then comes from the heap
+void *SYS_GetArena2Lo() { return NULL; }
+void *SYS_GetArena2Hi() { return NULL; }
+void SYS_SetArena2Hi(void *hi) {}
+
+s32 IOS_ReloadIOS(int version) { return 0; }
+s32 IOS_GetVersion() { return 58; }
+s32 CONF_Init() { return 0; }
+
+s32 ES_GetNumTitles(u32 *count) {
+	*count = 1;
+	return 0;
+}
+
+s32 ES_GetTitles(u64 *titles, u32 count) {
+	// IOS58, so the hardware checks pass
+	titles[0] = 0x000000010000003AULL;
+	return 0;
+}
+
+bool is_dolphin() { return false; }
+bool disable_ahbprot() { return true; }
+
+int usb_isgeckoalive(s32 chn) { return 0; }
+void usb_flush(s32 chn) {}
+int usb_sendbuffer_safe(s32 chn, const void *buffer, int size) { return size; }
+
+/* storage: a device is always there, a FAT mount is the directory "name:"
+   under the current one so "fat:/GAMEID.iso" works as it is */
+static bool device_ok(DISC_INTERFACE *disc) { return true; }
+static bool device_no_io(DISC_INTERFACE *disc, sec_t sector, sec_t count, void *buffer) { return false; }
+static bool device_no_write(DISC_INTERFACE *disc, sec_t sector, sec_t count, const void *buffer) { return false; }
+
+DISC_INTERFACE __io_wiisd = { 0, 0, device_ok, device_ok, device_no_io, device_no_write, device_ok, device_ok };
+DISC_INTERFACE __io_usbstorage = { 0, 0, device_ok, device_ok, device_no_io, device_no_write, device_ok, device_ok };
+
+bool fatMountSimple(const char *name, const DISC_INTERFACE *interface) {
+	char path[64];
+	struct stat st;
+	snprintf(path, sizeof(path), "%s:", name);
+	mkdir(path, 0777);
+	return !stat(path, &st) && S_ISDIR(st.st_mode);
+}
+
+void fatUnmount(const char *name) {}
+
+int ntfsMountDevice(const DISC_INTERFACE *interface, ntfs_md **mounts, u32 flags) { return 0; }
+void ntfsUnmount(const char *name, bool force) {}
+const char *ntfsGetVolumeName(const char *name) { return "NTFS"; }
+
+// the host's network is already up
+s32 if_config(char *local_ip, char *netmask, char *gateway, bool use_dhcp) {
+	strcpy(local_ip, "127.0.0.1");
+	return 0;
+}
+
+int http_request(char *http_host, char *http_path, u8 *buffer, u32 maxsize, bool silent, int retry) {
+	return -1;
+}
+
+/* Wii Remote, never connected */
+static WPADData no_remote;
+
+s32 WPAD_Init() { return 0; }
+s32 WPAD_ScanPads() { return 0; }
+WPADData *WPAD_Data(int chan) { return &no_remote; }
+void WPAD_SetIdleTimeout(u32 seconds) {}
+s32 WPAD_SetPowerButtonCallback(WPADShutdownCallback callback) { return 0; }
+s32 WPAD_Shutdown() { return 0; }
+
+/* GameCube controller. The presses come from CLEANRIP_PADS ("A RIGHT A B"),
+   then one per line from stdin. A press is only handed out once the screen
+   shows something to press (see shim_pad_prompt), so the dump loop polling
+   for B doesn't eat them. */
+static const struct {
+	const char *name;
+	u16 button;
+} pad_names[] = {
+	{ "A", PAD_BUTTON_A }, { "B", PAD_BUTTON_B }, { "X", PAD_BUTTON_X }, { "Y", PAD_BUTTON_Y },
+	{ "Z", PAD_TRIGGER_Z }, { "START", PAD_BUTTON_START }, { "UP", PAD_BUTTON_UP },
+	{ "DOWN", PAD_BUTTON_DOWN }, { "LEFT", PAD_BUTTON_LEFT }, { "RIGHT", PAD_BUTTON_RIGHT },
+};
+
+static const char *pad_script = NULL;
+static u16 pad_buttons = 0;
+static u16 pad_pressed = 0;
+static int pad_prompted = 0;
+static int pad_prompt_queued = 0;
+static u128 pad_prompt_time = 0;
+
+static u16 pad_button(const char *name) {
+	for (int i = 0; i < sizeof(pad_names) / sizeof(pad_names[0]); i++) {
+		if (!strcasecmp(name, pad_names[i].name)) {
+			return pad_names[i].button;
+		}
+	}
+	fprintf(stderr, "shim: unknown button %s\n", name);
+	return 0;
+}
+
+static u16 next_press() {
+	char name[32];
+	int len;
+
+	while (pad_script && *pad_script) {
+		if (sscanf(pad_script, " %31[^ ,\t\n]%n", name, &len) != 1) {
+			break;
+		}
+		pad_script += len;
+		while (*pad_script == ',' || *pad_script == ' ') {
+			pad_script++;
+		}
+		u16 button = pad_button(name);
+		if (button) {
+			printf("[pad] %s\n", name);
+			return button;
+		}
+	}
+	pad_script = NULL;
+	while (fgets(name, sizeof(name), stdin)) {
+		name[strcspn(name, "\r\n")] = 0;
+		if (name[0]) {
+			u16 button = pad_button(name);
+			if (button) {
+				return button;
+			}
+		}
+	}
+	// whatever was asked can't be answered
+	fprintf(stderr, "shim: no more button presses, exiting\n");
+	exit(1);
+}
+
+void shim_pad_prompt() {
+	// a redraw of the same prompt doesn't start another press, but a
+	// screen that comes up while the last press is still held does
+	if (pad_prompted) {
+		if (pad_pressed) {
+			pad_prompt_queued = 1;
+		}
+		return;
+	}
+	pad_prompted = 1;
+	pad_prompt_time = gettime();
+	pad_pressed = 0;
+}
+
+u32 PAD_Init() {
+	pad_script = getenv("CLEANRIP_PADS");
+	return 1;
+}
+
+u32 PAD_ScanPads() {
+	pad_buttons = 0;
+	if (pad_prompted) {
+		u32 ms = diff_msec(pad_prompt_time, gettime());
+		if (ms >= PAD_RELEASE_MS + PAD_HOLD_MS) {
+			pad_prompted = 0;
+			if (pad_prompt_queued) {
+				pad_prompt_queued = 0;
+				shim_pad_prompt();
+			}
+		}
+		else if (ms >= PAD_RELEASE_MS) {
+			if (!pad_pressed) {
+				pad_pressed = next_press();
+			}
+			pad_buttons = pad_pressed;
+		}
+	}
+	return 1;
+}
+
+u16 PAD_ButtonsDown(int pad) {
+	return pad_buttons;
+}
@@ -0,0 +1,43 @@
+/**
+ * CleanRip - shim/ogc/disc_io.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * Block device interface of libogc, for the Linux build
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef SHIM_DISC_IO_H
+#define SHIM_DISC_IO_H
+
+#include "host_ogc.h"
+
+typedef u32 sec_t;
+
+typedef struct DISC_INTERFACE_STRUCT DISC_INTERFACE;
+
+struct DISC_INTERFACE_STRUCT {
+	u32 ioType;
+	u32 features;
+	bool (*startup)(DISC_INTERFACE *disc);
+	bool (*isInserted)(DISC_INTERFACE *disc);
+	bool (*readSectors)(DISC_INTERFACE *disc, sec_t sector, sec_t count, void *buffer);
+	bool (*writeSectors)(DISC_INTERFACE *disc, sec_t sector, sec_t count, const void *buffer);
+	bool (*clearStatus)(DISC_INTERFACE *disc);
+	bool (*shutdown)(DISC_INTERFACE *disc);
+};
+
+#endif
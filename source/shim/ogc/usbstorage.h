@@ -0,0 +1,30 @@
+/**
+ * CleanRip - shim/ogc/usbstorage.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * USB mass storage, for the Linux build
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef SHIM_USBSTORAGE_H
+#define SHIM_USBSTORAGE_H
+
+#include <gccore.h>
+
+extern DISC_INTERFACE __io_usbstorage;
+
+#endif
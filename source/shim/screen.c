@@ -0,0 +1,204 @@
+/**
+ * CleanRip - shim/screen.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * FrameBufferMagic and IPLFontWrite for the Linux build. Whatever a
+ * frame writes is collected as text and printed once the frame is
+ * finished, unless it is the same as the frame before it. A frame
+ * that shows a button tells the pad a press is wanted.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdio.h>
+#include <string.h>
+#include <gccore.h>
+#include "FrameBufferMagic.h"
+#include "IPLFontWrite.h"
+#include "main.h"
+#include "verify.h"
+
+#define FRAME_TEXT_MAX	8192
+#define CHAR_WIDTH		12		// close enough to the IPL font for centring
+
+char txtbuffer[2048];
+GXColor defaultColor = (GXColor) {255,255,255,255};
+GXColor disabledColor = (GXColor) {175,175,182,255};
+GXColor fontColor = (GXColor) {255,255,255,255};
+
+static char frame[FRAME_TEXT_MAX];
+static char last_frame[FRAME_TEXT_MAX];
+static int frame_len = 0;
+static int frame_wants_press = 0;
+
+static void frame_text(const char *fmt, const char *text) {
+	int room = FRAME_TEXT_MAX - frame_len;
+	if (room > 1) {
+		int len = snprintf(frame + frame_len, room, fmt, text);
+		frame_len += (len < room) ? len : room - 1;
+	}
+}
+
+static void frame_line(const char *text) {
+	frame_text("  %s\n", text);
+}
+
+void init_font(void) {}
+void init_textures() {}
+
+void DrawFrameStart() {
+	whichfb ^= 1;
+	frame_len = 0;
+	frame[0] = 0;
+	frame_wants_press = 0;
+}
+
+void DrawFrameFinish() {
+	if (strcmp(frame, last_frame)) {
+		printf("----\n%s", frame);
+		fflush(stdout);
+		strcpy(last_frame, frame);
+	}
+	if (frame_wants_press) {
+		shim_pad_prompt();
+	}
+	VIDEO_WaitVSync();
+}
+
+void WriteFont(int x, int y, char *string) {
+	frame_line(string);
+}
+
+void WriteFontStyled(int x, int y, char *string, float size, bool centered, GXColor color) {
+	frame_line(string);
+}
+
+int GetTextSizeInPixels(char *string) {
+	return strlen(string) * CHAR_WIDTH;
+}
+
+float GetTextScaleToFitInWidth(char *string, int width) {
+	int strWidth = GetTextSizeInPixels(string);
+	return width>strWidth ? 1.0f : (float)((float)width/(float)strWidth);
+}
+
+void WriteCentre(int y, char *string) {
+	frame_line(string);
+}
+
+void DrawRawFont(int x, int y, char *message) {
+	WriteFont(x, y, message);
+}
+
+static void DrawDatInfo(int disc_type) {
+	if (disc_type == IS_OTHER_DISC || verify_type_in_use < 0) {
+		frame_line("Redump verification unavailable for this disc type");
+	}
+	else if (verify_type_in_use == VERIFY_REDUMP_DAT_GC) {
+		frame_line("Gamecube Redump.org DAT in use");
+	}
+	else if (verify_type_in_use == VERIFY_REDUMP_DAT_WII) {
+		frame_line("Wii Redump.org DAT in use");
+	}
+	else {
+		frame_line("Internal CRC list in use");
+	}
+}
+
+// The message can be a literal, so it is split up in a copy
+static void frame_lines(const char *message) {
+	char copy[1024];
+
+	snprintf(copy, sizeof(copy), "%s", message);
+	char *tok = strtok(copy, "\n");
+	while (tok != NULL) {
+		frame_line(tok);
+		tok = strtok(NULL, "\n");
+	}
+}
+
+void DrawProgressBar(int percent, char *message, int discType) {
+	char line[64];
+	frame_line(message);
+	sprintf(line, "%d %% complete", percent);
+	frame_line(line);
+	DrawDatInfo(discType);
+}
+
+void DrawProgressDetailed(int percent, char *message, int startMb, int endMb, char *discTypeStr, int calculateCheckSums, int discType) {
+	char line[128];
+	sprintf(line, "%s disc %04d / %d MB %d %%", discTypeStr, startMb, endMb, percent);
+	frame_line(line);
+	frame_lines(message);
+	frame_line(calculateCheckSums ? "Calcs: CRC32/MD5/SHA-1" : "Calcs: CRC32");
+	DrawDatInfo(discType);
+}
+
+void DrawMessageBox(int type, char *message) {
+	static const char *types[] = { "(Warning)", "(Info)", "(Error!)", "(Success)" };
+
+	DrawFrameStart();
+	if (type >= D_WARN && type <= D_PASS) {
+		frame_line(types[type]);
+	}
+	frame_lines(message);
+	DrawFrameFinish();
+}
+
+void DrawSelectableButton(int x1, int y1, int x2, int y2, char *message, int mode, u32 color) {
+	frame_text((mode==B_SELECTED) ? "> [%s]\n" : "  [%s]\n", message);
+	frame_wants_press = 1;
+}
+
+void DrawEmptyBox(int x1, int y1, int x2, int y2, int color) {}
+
+void DrawAButton(int x, int y) {
+	frame_text("  %s\n", "(A)");
+	frame_wants_press = 1;
+}
+
+void DrawBButton(int x, int y) {
+	frame_text("  %s\n", "(B)");
+	frame_wants_press = 1;
+}
+
+int DrawYesNoDialog(char *line1, char *line2) {
+	int selection = 0;
+	while ((get_buttons_pressed() & PAD_BUTTON_A));
+	while (1) {
+		DrawFrameStart();
+		int xlen = (vmode->fbWidth - 38) - 30;
+		DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
+		WriteCentre(230, line1);
+		WriteCentre(255, line2);
+		DrawSelectableButton((xlen/3), 310, -1, 340, "Yes", (selection) ? B_SELECTED : B_NOSELECT, -1);
+		DrawSelectableButton((vmode->fbWidth - 38) - (xlen/3), 310, -1, 340, "No", (!selection) ? B_SELECTED : B_NOSELECT, -1);
+		DrawFrameFinish();
+		while (!(get_buttons_pressed() & (PAD_BUTTON_RIGHT | PAD_BUTTON_LEFT
+				| PAD_BUTTON_B | PAD_BUTTON_A)));
+		u32 btns = get_buttons_pressed();
+		if (btns & PAD_BUTTON_RIGHT)
+			selection ^= 1;
+		if (btns & PAD_BUTTON_LEFT)
+			selection ^= 1;
+		if (btns & PAD_BUTTON_A)
+			break;
+		while ((get_buttons_pressed() & (PAD_BUTTON_RIGHT | PAD_BUTTON_LEFT
+				| PAD_BUTTON_B | PAD_BUTTON_A)));
+	}
+	while ((get_buttons_pressed() & PAD_BUTTON_A));
+	return selection;
+}
@@ -0,0 +1,57 @@
+/**
+ * CleanRip - shim/wiiuse/wpad.h
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * Wii Remote, for the Linux build. No remote is ever connected.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip/
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#ifndef SHIM_WPAD_H
+#define SHIM_WPAD_H
+
+#include <gccore.h>
+
+#define WPAD_BUTTON_2		0x0001
+#define WPAD_BUTTON_1		0x0002
+#define WPAD_BUTTON_B		0x0004
+#define WPAD_BUTTON_A		0x0008
+#define WPAD_BUTTON_MINUS	0x0010
+#define WPAD_BUTTON_HOME	0x0080
+#define WPAD_BUTTON_LEFT	0x0100
+#define WPAD_BUTTON_RIGHT	0x0200
+#define WPAD_BUTTON_DOWN	0x0400
+#define WPAD_BUTTON_UP		0x0800
+#define WPAD_BUTTON_PLUS	0x1000
+
+typedef struct {
+	s32 err;
+	u32 btns_h;
+	u32 btns_l;
+	u32 btns_d;
+	u32 btns_u;
+} WPADData;
+
+typedef void (*WPADShutdownCallback)(s32 chan);
+
+s32 WPAD_Init();
+s32 WPAD_ScanPads();
+WPADData *WPAD_Data(int chan);
+void WPAD_SetIdleTimeout(u32 seconds);
+s32 WPAD_SetPowerButtonCallback(WPADShutdownCallback callback);
+s32 WPAD_Shutdown();
+
+#endif
@@ -0,0 +1,314 @@
+/**
+ * CleanRip - simdrive.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * A simulated optical drive for exercising the dump loop without
+ * discs: CAV transfer rate by radius, seeks, the layer jump, a small
+ * cache of recently read sectors, and bad ranges that fail either
+ * for good or for the first few attempts. Everything is driven by a
+ * script and a seeded generator, so a run repeats exactly.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include "simdrive.h"
+
+#define DEFAULT_SECTORS 2294912	// single layer Wii disc
+
+void print_gecko(const char* fmt, ...);
+
+/*
+ Script format, one setting per line, # starts a comment:
+	image sd:/game.iso			data to serve (otherwise a counting pattern)
+	sectors 2294912
+	layer_break 2084960
+	inner_rate 3000000			bytes/s
+	outer_rate 7500000
+	cache_rate 40000000
+	cache_sectors 1024
+	seek_ms 70
+	full_seek_ms 100
+	layer_jump_ms 150
+	retry_ms 1500
+	flaky_ppm 0
+	seed 1
+	time_scale 1.0
+	bad 120000 64				unreadable for good
+	bad 500000 16 transient 3	fails three times, then reads
+*/
+static void parse_line(simdrive *sd, char *line) {
+	char key[32], arg[IMGSRC_PATH_MAX];
+	u32 value, count, failures;
+	float scale;
+
+	char *comment = strchr(line, '#');
+	if (comment) {
+		*comment = 0;
+	}
+	if (sscanf(line, "%31s", key) != 1) {
+		return;
+	}
+	if (!strcmp(key, "image") && sscanf(line, "%*s %1023[^\r\n]", arg) == 1) {
+		snprintf(sd->image_path, sizeof(sd->image_path), "%s", arg);
+		if (!imgsrc_open(&sd->image, arg)) {
+			sd->has_image = 1;
+		}
+		else {
+			print_gecko("Simulated drive: can't open %s\r\n", arg);
+		}
+	}
+	else if (!strcmp(key, "time_scale") && sscanf(line, "%*s %f", &scale) == 1) {
+		sd->time_scale = scale;
+	}
+	else if (!strcmp(key, "bad") && sscanf(line, "%*s %u %u", &value, &count) == 2) {
+		if (sd->num_bad < SIMDRIVE_MAX_BAD) {
+			sim_bad_range *bad = &sd->bad[sd->num_bad++];
+			bad->start = value;
+			bad->count = count;
+			bad->type = SIM_BAD_PERMANENT;
+			if (sscanf(line, "%*s %*u %*u %31s %u", arg, &failures) == 2 && !strcmp(arg, "transient")) {
+				bad->type = SIM_BAD_TRANSIENT;
+				bad->failures = failures;
+			}
+		}
+	}
+	else if (sscanf(line, "%*s %u", &value) == 1) {
+		if (!strcmp(key, "sectors")) sd->sectors = value;
+		else if (!strcmp(key, "layer_break")) sd->layer_break = value;
+		else if (!strcmp(key, "inner_rate")) sd->inner_rate = value;
+		else if (!strcmp(key, "outer_rate")) sd->outer_rate = value;
+		else if (!strcmp(key, "cache_rate")) sd->cache_rate = value;
+		else if (!strcmp(key, "cache_sectors")) sd->cache_sectors = value;
+		else if (!strcmp(key, "seek_ms")) sd->seek_ms = value;
+		else if (!strcmp(key, "full_seek_ms")) sd->full_seek_ms = value;
+		else if (!strcmp(key, "layer_jump_ms")) sd->layer_jump_ms = value;
+		else if (!strcmp(key, "retry_ms")) sd->retry_ms = value;
+		else if (!strcmp(key, "flaky_ppm")) sd->flaky_ppm = value;
+		else if (!strcmp(key, "seed")) sd->seed = value;
+		else print_gecko("Simulated drive: unknown setting %s\r\n", key);
+	}
+}
+
+// What a re-initialise or a chunk swap must not undo: the transient ranges
+// that have already failed stay as far along as they got
+static void keep_state(simdrive *sd, const simdrive *prev) {
+	for (int i = 0; i < sd->num_bad && i < prev->num_bad; i++) {
+		if (sd->bad[i].start == prev->bad[i].start && sd->bad[i].count == prev->bad[i].count
+			&& sd->bad[i].type == prev->bad[i].type) {
+			sd->bad[i].failures = prev->bad[i].failures;
+		}
+	}
+	sd->head = prev->head;
+	sd->cache_start = prev->cache_start;
+	sd->cache_end = prev->cache_end;
+	sd->rng = prev->rng;
+	sd->clock_us = prev->clock_us;
+	sd->reads = prev->reads;
+	sd->failed_reads = prev->failed_reads;
+	sd->seeks = prev->seeks;
+	sd->cache_hits = prev->cache_hits;
+}
+
+// Opening the same image again carries the drive's state on, a new one starts afresh
+int simdrive_open(simdrive *sd, const char *script) {
+	char line[IMGSRC_PATH_MAX + 64];
+	simdrive *prev = sd->loaded ? (simdrive*)malloc(sizeof(simdrive)) : NULL;
+
+	if (prev) {
+		memcpy(prev, sd, sizeof(simdrive));
+	}
+	memset(sd, 0, sizeof(simdrive));
+	sd->inner_rate = 3000000;
+	sd->outer_rate = 7500000;
+	sd->cache_rate = 40000000;
+	sd->cache_sectors = 1024;
+	sd->seek_ms = 70;
+	sd->full_seek_ms = 100;
+	sd->layer_jump_ms = 150;
+	sd->retry_ms = 1500;
+	sd->seed = 1;
+	sd->time_scale = 1.0f;
+
+	FILE *fp = fopen(script, "r");
+	if (!fp) {
+		free(prev);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), fp)) {
+		parse_line(sd, line);
+	}
+	fclose(fp);
+
+	if (!sd->sectors) {
+		sd->sectors = sd->has_image ? (u32)(sd->image.size / sd->image.file_sector) : DEFAULT_SECTORS;
+	}
+	if (sd->layer_break >= sd->sectors) {
+		sd->layer_break = 0;
+	}
+	sd->rng = sd->seed ? sd->seed : 1;
+	if (prev && !strcmp(prev->image_path, sd->image_path)) {
+		keep_state(sd, prev);
+	}
+	free(prev);
+	sd->loaded = 1;
+	return 0;
+}
+
+void simdrive_close(simdrive *sd) {
+	if (sd->has_image) {
+		imgsrc_close(&sd->image);
+		sd->has_image = 0;
+	}
+}
+
+static u32 next_random(simdrive *sd) {
+	// xorshift32, the same sequence for the same seed and reads
+	sd->rng ^= sd->rng << 13;
+	sd->rng ^= sd->rng >> 17;
+	sd->rng ^= sd->rng << 5;
+	return sd->rng;
+}
+
+static int layer_of(simdrive *sd, u32 lba) {
+	return (sd->layer_break && lba >= sd->layer_break) ? 1 : 0;
+}
+
+// CAV: the data rate follows the radius, and the area swept grows with its square
+static double media_rate(simdrive *sd, u32 lba) {
+	double pos;
+	if (!sd->layer_break) {
+		pos = (double)lba / sd->sectors;
+	}
+	else if (lba < sd->layer_break) {
+		pos = (double)lba / sd->layer_break;
+	}
+	else {
+		// layer 1 runs from the rim back to the hub
+		pos = 1.0 - (double)(lba - sd->layer_break) / (sd->sectors - sd->layer_break);
+	}
+	double in = sd->inner_rate, out = sd->outer_rate;
+	return sqrt(in * in + (out * out - in * in) * pos);
+}
+
+// Fails the read if it touches a bad range that hasn't come good yet
+static int hits_bad_range(simdrive *sd, u32 lba, u32 count) {
+	int failed = 0;
+	for (int i = 0; i < sd->num_bad; i++) {
+		sim_bad_range *bad = &sd->bad[i];
+		if (lba >= bad->start + bad->count || lba + count <= bad->start) {
+			continue;
+		}
+		if (bad->type == SIM_BAD_PERMANENT) {
+			failed = 1;
+		}
+		else if (bad->failures) {
+			bad->failures--;
+			failed = 1;
+		}
+	}
+	return failed;
+}
+
+static int serve(simdrive *sd, u8 *dst, u32 len, u64 offset, u32 sector_size) {
+	if (sd->has_image) {
+		return imgsrc_read(&sd->image, dst, len, offset, sector_size);
+	}
+	for (u32 i = 0; i < len; i++) {
+		u64 pos = offset + i;
+		dst[i] = (u8)((pos / sector_size) * 31 + (pos % sector_size));
+	}
+	return 0;
+}
+
+static void spend(simdrive *sd, u64 us) {
+	sd->clock_us += us;
+	if (sd->time_scale > 0.0f) {
+		usleep((useconds_t)(us * sd->time_scale));
+	}
+}
+
+// offset is a byte offset on the disc, sector_size what it is read in; returns 0 on success
+int simdrive_read(simdrive *sd, void *dst, u32 len, u64 offset, u32 sector_size) {
+	u32 lba = (u32)(offset / sector_size);
+	u32 count = (u32)((offset + len + sector_size - 1) / sector_size) - lba;
+	u64 us = 0;
+
+	sd->reads++;
+	if ((u64)lba + count > sd->sectors) {
+		sd->failed_reads++;
+		spend(sd, (u64)sd->retry_ms * 1000);
+		return 1;
+	}
+
+	if (lba >= sd->cache_start && lba + count <= sd->cache_end && lba != sd->head) {
+		// read again shortly after, e.g. a retry in smaller pieces
+		sd->cache_hits++;
+		spend(sd, (u64)len * 1000000 / sd->cache_rate);
+		return serve(sd, dst, len, offset, sector_size);
+	}
+	if (lba != sd->head) {
+		u32 distance = (lba > sd->head) ? (lba - sd->head) : (sd->head - lba);
+		sd->seeks++;
+		us += (u64)sd->seek_ms * 1000 + (u64)sd->full_seek_ms * 1000 * distance / sd->sectors;
+		if (layer_of(sd, lba) != layer_of(sd, sd->head)) {
+			us += (u64)sd->layer_jump_ms * 1000;
+		}
+	}
+	else if (layer_of(sd, lba) != layer_of(sd, lba + count - 1)) {
+		// reading straight through the layer break
+		us += (u64)sd->layer_jump_ms * 1000;
+	}
+
+	int failed = hits_bad_range(sd, lba, count);
+	if (!failed && sd->flaky_ppm && (next_random(sd) % 1000000) < sd->flaky_ppm) {
+		failed = 1;
+	}
+	if (failed) {
+		// the drive gives up where it started and keeps nothing
+		sd->failed_reads++;
+		sd->head = lba;
+		sd->cache_start = sd->cache_end = 0;
+		spend(sd, us + (u64)sd->retry_ms * 1000);
+		return 1;
+	}
+
+	us += (u64)((double)len * 1000000.0 / media_rate(sd, lba));
+	if (lba != sd->head || sd->cache_end != sd->head) {
+		sd->cache_start = lba;
+	}
+	sd->head = lba + count;
+	sd->cache_end = sd->head;
+	if (sd->cache_end - sd->cache_start > sd->cache_sectors) {
+		sd->cache_start = sd->cache_end - sd->cache_sectors;
+	}
+	spend(sd, us);
+	return serve(sd, dst, len, offset, sector_size);
+}
+
+// Sectors are whatever size the dump reads in, 2352 for an audio CD
+u32 simdrive_sectors(simdrive *sd) {
+	return sd->sectors;
+}
+
+void simdrive_stats(simdrive *sd) {
+	print_gecko("Simulated drive: %u reads, %u failed, %u seeks, %u cache hits, %u.%03us in the drive\r\n",
+		sd->reads, sd->failed_reads, sd->seeks, sd->cache_hits,
+		(u32)(sd->clock_us / 1000000), (u32)((sd->clock_us / 1000) % 1000));
+}
@@ -0,0 +1,307 @@
+/**
+ * CleanRip - sink.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * Where the dumped blocks go. A sink takes blocks with their offset
+ * in the image; files, split parts, the receiver or nothing at all are
+ * the ends, a tee or a stage (a WAV header, a compressor) passes them
+ * on to the sinks behind it. The dump loop and the writer only ever
+ * see the root, the graph is built once before the dump starts.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "sink.h"
+#include "bytes.h"
+#include "netdump.h"
+
+#define BRANCH_PRIO 128 // same as the reader/writer threads
+
+/* null: a read-only scan, nothing is kept */
+static int null_write(sink *s, const void *data, u32 len, u64 offset) {
+	return 0;
+}
+
+static int null_flush(sink *s) {
+	return 0;
+}
+
+static const sink_ops null_ops = { null_write, null_flush, null_flush };
+
+/* file: offsets are relative to where the file starts in the image,
+   anything out of order (a header written last) is seeked to */
+static int file_write(sink *s, const void *data, u32 len, u64 offset) {
+	if (!s->fp || offset < s->origin) {
+		return 1;
+	}
+	if (offset != s->pos && fseeko(s->fp, (off_t)(offset - s->origin), SEEK_SET)) {
+		return 1;
+	}
+	s->pos = offset + len;
+	return fwrite(data, len, 1, s->fp) != 1;
+}
+
+static int file_flush(sink *s) {
+	return s->fp ? fflush(s->fp) != 0 : 0;
+}
+
+static int file_close(sink *s) {
+	int ret = 0;
+	if (s->fp) {
+		ret = fclose(s->fp) != 0;
+		s->fp = NULL;
+	}
+	return ret;
+}
+
+static const sink_ops file_ops = { file_write, file_flush, file_close };
+
+/* split: .partN files, the partfile rolls over by itself so it can only append */
+static int split_write(sink *s, const void *data, u32 len, u64 offset) {
+	if (offset != s->pos) {
+		return 1;
+	}
+	s->pos += len;
+	return partfile_write(s->parts, data, len);
+}
+
+static int split_close(sink *s) {
+	int ret = 0;
+	if (s->parts) {
+		ret = partfile_close(s->parts) != 0;
+		s->parts = NULL;
+	}
+	return ret;
+}
+
+static const sink_ops split_ops = { split_write, null_flush, split_close };
+
+/* tee: the same block to both at once, each on its own thread. It only
+   returns once both are done with it, so the block can be reused then */
+enum {
+	BRANCH_WRITE,
+	BRANCH_FLUSH,
+	BRANCH_CLOSE,
+};
+
+static void* branch_thread(void* _branch) {
+	sink_branch *b = (sink_branch*)_branch;
+	sink_branch *job;
+
+	while (MQ_Receive(b->jobq, (mqmsg_t*)&job, MQ_MSG_BLOCK)==TRUE && job) {
+		switch (job->command) {
+			case BRANCH_WRITE:
+				job->ret = sink_write(job->s, job->data, job->len, job->offset);
+				break;
+			case BRANCH_FLUSH:
+				job->ret = sink_flush(job->s);
+				break;
+			case BRANCH_CLOSE:
+				job->ret = sink_close(job->s);
+				break;
+		}
+		MQ_Send(b->doneq, (mqmsg_t)job, MQ_MSG_BLOCK);
+	}
+	return NULL;
+}
+
+static int tee_run(sink *s, int command, const void *data, u32 len, u64 offset) {
+	sink_branch *done;
+	int ret = 0;
+
+	for (int i = 0; i < 2; i++) {
+		s->branch[i].command = command;
+		s->branch[i].data = data;
+		s->branch[i].len = len;
+		s->branch[i].offset = offset;
+		MQ_Send(s->branch[i].jobq, (mqmsg_t)&s->branch[i], MQ_MSG_BLOCK);
+	}
+	for (int i = 0; i < 2; i++) {
+		MQ_Receive(s->branch[i].doneq, (mqmsg_t*)&done, MQ_MSG_BLOCK);
+		ret |= done->ret;
+	}
+	return ret;
+}
+
+static int tee_write(sink *s, const void *data, u32 len, u64 offset) {
+	return tee_run(s, BRANCH_WRITE, data, len, offset);
+}
+
+static int tee_flush(sink *s) {
+	return tee_run(s, BRANCH_FLUSH, NULL, 0, 0);
+}
+
+static int tee_close(sink *s) {
+	if (!s->branch[0].s) {
+		return 0;
+	}
+	int ret = tee_run(s, BRANCH_CLOSE, NULL, 0, 0);
+	for (int i = 0; i < 2; i++) {
+		MQ_Send(s->branch[i].jobq, (mqmsg_t)NULL, MQ_MSG_BLOCK);
+		LWP_JoinThread(s->branch[i].thread, NULL);
+		MQ_Close(s->branch[i].jobq);
+		MQ_Close(s->branch[i].doneq);
+		s->branch[i].s = NULL;
+	}
+	return ret;
+}
+
+static const sink_ops tee_ops = { tee_write, tee_flush, tee_close };
+
+/* wav: the data goes after a PCM header, which gets its sizes at close */
+static int wav_header(sink *s, u32 data_size) {
+	u8 hdr[WAV_HEADER_SIZE];
+
+	memcpy(hdr, "RIFF", 4);
+	put_le32(hdr + 4, data_size + 36);
+	memcpy(hdr + 8, "WAVEfmt ", 8);
+	put_le32(hdr + 16, 16);							// PCM fmt chunk size
+	put_le16(hdr + 20, 1);							// AudioFormat = PCM
+	put_le16(hdr + 22, s->channels);
+	put_le32(hdr + 24, s->sample_rate);
+	put_le32(hdr + 28, s->sample_rate * s->channels * 2);	// ByteRate
+	put_le16(hdr + 32, s->channels * 2);			// BlockAlign
+	put_le16(hdr + 34, 16);							// BitsPerSample
+	memcpy(hdr + 36, "data", 4);
+	put_le32(hdr + 40, data_size);
+	return sink_write(s->next[0], hdr, WAV_HEADER_SIZE, 0);
+}
+
+static int wav_write(sink *s, const void *data, u32 len, u64 offset) {
+	if (offset + len > s->pos) {
+		s->pos = offset + len;
+	}
+	return sink_write(s->next[0], data, len, offset + WAV_HEADER_SIZE);
+}
+
+static int wav_flush(sink *s) {
+	return sink_flush(s->next[0]);
+}
+
+static int wav_close(sink *s) {
+	int ret = wav_header(s, (u32)s->pos);
+	return sink_close(s->next[0]) | ret;
+}
+
+static const sink_ops wav_ops = { wav_write, wav_flush, wav_close };
+
+/* net: a file on the receiver, each block goes as one frame to its offset */
+static int net_write(sink *s, const void *data, u32 len, u64 offset) {
+	if (s->remote < 0 || offset < s->origin) {
+		return 1;
+	}
+	return netdump_write(s->remote, data, len, offset - s->origin);
+}
+
+static int net_flush(sink *s) {
+	return s->remote >= 0 ? netdump_sync(s->remote) : 0;
+}
+
+static int net_close(sink *s) {
+	int ret = 0;
+	if (s->remote >= 0) {
+		ret = netdump_close(s->remote);
+		s->remote = -1;
+	}
+	return ret;
+}
+
+static const sink_ops net_ops = { net_write, net_flush, net_close };
+
+int sink_write(sink *s, const void *data, u32 len, u64 offset) {
+	return s->ops->write(s, data, len, offset);
+}
+
+int sink_flush(sink *s) {
+	return s->ops->flush(s);
+}
+
+int sink_close(sink *s) {
+	return s->ops->close(s);
+}
+
+// Nothing would be kept, so the blocks needn't go through the writer at all
+int sink_discards(sink *s) {
+	return s->ops == &null_ops;
+}
+
+static void sink_init(sink *s, const sink_ops *ops) {
+	memset(s, 0, sizeof(sink));
+	s->ops = ops;
+	s->remote = -1;
+}
+
+void sink_null(sink *s) {
+	sink_init(s, &null_ops);
+}
+
+// A path under NET_MOUNT is opened on the receiver
+int sink_file_open(sink *s, const char *path, u64 origin) {
+	const char *name = netdump_name(path);
+	if (name) {
+		sink_init(s, &net_ops);
+		s->origin = origin;
+		s->remote = netdump_open(name);
+		return s->remote < 0;
+	}
+	sink_init(s, &file_ops);
+	s->origin = origin;
+	s->pos = origin;
+	s->fp = fopen(path, "wb");
+	return s->fp == NULL;
+}
+
+// The size the file will end up, only the receiver preallocates it
+int sink_file_reserve(sink *s, u64 size) {
+	return s->remote >= 0 ? netdump_reserve(s->remote, size) : 0;
+}
+
+// pf is already open, closing the sink closes it
+void sink_split(sink *s, partfile *pf) {
+	sink_init(s, &split_ops);
+	s->parts = pf;
+}
+
+void sink_tee(sink *s, sink *a, sink *b) {
+	sink_init(s, &tee_ops);
+	s->next[0] = a;
+	s->next[1] = b;
+	for (int i = 0; i < 2; i++) {
+		sink_branch *branch = &s->branch[i];
+		branch->s = s->next[i];
+		MQ_Init(&branch->jobq, 1);
+		MQ_Init(&branch->doneq, 1);
+		LWP_CreateThread(&branch->thread, branch_thread, (void*)branch, NULL, 0, BRANCH_PRIO);
+	}
+}
+
+// A stage with its own ops in front of next, ctx is left for it to use
+void sink_stage(sink *s, const sink_ops *ops, void *ctx, sink *next) {
+	sink_init(s, ops);
+	s->ctx = ctx;
+	s->next[0] = next;
+}
+
+int sink_wav(sink *s, sink *next, int channels, int sample_rate) {
+	sink_stage(s, &wav_ops, NULL, next);
+	s->channels = channels;
+	s->sample_rate = sample_rate;
+	// a placeholder until the size is known, so a cancelled dump is still a WAV
+	return wav_header(s, 0);
+}
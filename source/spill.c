@@ -0,0 +1,108 @@
+/**
+ * CleanRip - spill.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * RAM overflow buffer that keeps dumped blocks while the output
+ * device is being swapped. On the Wii it is taken from the top of
+ * the MEM2 arena, elsewhere from the heap.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "spill.h"
+
+#ifdef HW_RVL
+// left between the heap and the spill so newlib can still grow into MEM2
+#define MEM2_HEAP_RESERVE	(8*1024*1024)
+#endif
+#define SPILL_MIN_SIZE		(1024*1024)
+
+u32 spill_init(spill_buf *sb, u32 size) {
+	memset(sb, 0, sizeof(spill_buf));
+	size &= ~31;
+#ifdef HW_RVL
+	// the heap grows up from Arena2Lo, so reserving from Arena2Hi down never collides with it
+	uintptr_t lo = (uintptr_t)SYS_GetArena2Lo();
+	uintptr_t hi = (uintptr_t)SYS_GetArena2Hi();
+	u32 avail = (hi - lo > MEM2_HEAP_RESERVE) ? ((hi - lo - MEM2_HEAP_RESERVE) & ~31) : 0;
+	if (size > avail) {
+		size = avail;
+	}
+	if (size >= SPILL_MIN_SIZE) {
+		sb->base = (u8*)(hi - size);
+		SYS_SetArena2Hi(sb->base);
+		sb->arena = 1;
+		sb->size = size;
+		return size;
+	}
+#endif
+	// take what the heap can spare
+	while (size >= SPILL_MIN_SIZE && !(sb->base = memalign(32, size))) {
+		size >>= 1;
+	}
+	sb->size = sb->base ? size : 0;
+	return sb->size;
+}
+
+void spill_free(spill_buf *sb) {
+#ifdef HW_RVL
+	if (sb->arena) {
+		// only give it back if nothing was carved below us since
+		if ((u8*)SYS_GetArena2Hi() == sb->base) {
+			SYS_SetArena2Hi(sb->base + sb->size);
+		}
+	}
+	else
+#endif
+	if (sb->base) {
+		free(sb->base);
+	}
+	memset(sb, 0, sizeof(spill_buf));
+}
+
+int spill_push(spill_buf *sb, const void *data, u32 length) {
+	if (spill_room(sb) < length) {
+		return -1;
+	}
+	memcpy(sb->base + sb->head + sb->used, data, length);
+	sb->used += length;
+	return 0;
+}
+
+u32 spill_pop(spill_buf *sb, void *dst, u32 length) {
+	if (length > sb->used) {
+		length = sb->used;
+	}
+	memcpy(dst, sb->base + sb->head, length);
+	sb->head += length;
+	sb->used -= length;
+	if (!sb->used) {
+		sb->head = 0;
+	}
+	return length;
+}
+
+u32 spill_room(spill_buf *sb) {
+	return sb->size - (sb->head + sb->used);
+}
+
+u32 spill_used(spill_buf *sb) {
+	return sb->used;
+}
@@ -0,0 +1,606 @@
+/**
+ * CleanRip - store.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * A sink stage that puts the image into a store shared by every dump
+ * instead of writing it out whole. The image is cut into chunks, of a
+ * fixed size or where FastCDC's rolling gear hash says, so a chunk
+ * that moved along the disc still comes out the same. Each chunk is
+ * known by its SHA-1: one the store's index already has is only named
+ * in the recipe, any other is appended to the current pack and added
+ * to the index. The recipe is the file the dump writes, its header
+ * gets the chunk count and the image's MD5 at close. On a PC a recipe
+ * can be read back as the image.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "store.h"
+#include "bytes.h"
+#include "sha1.h"
+#include "md5.h"
+
+#if defined(__CYGWIN__) || defined(__linux__)
+#include <pthread.h>
+#endif
+
+void print_gecko(const char* fmt, ...);
+
+#define STORE_PATH_MAX	1024
+#define STORE_FILE_MAX	(STORE_PATH_MAX + 32)		// a file in the store
+#define STORE_BUF_SIZE	(2 * STORE_CDC_MAX)
+#define STORE_ENTRIES	4096				// recipe entries passed on at once
+#define CDC_MASK_S		(~0ULL << (64 - 18))	// two bits harder than the average
+#define CDC_MASK_L		(~0ULL << (64 - 14))	// and two easier
+
+// The whole index is held in memory, 32 bytes a slot and at most half full.
+// Growing it needs the old table and the new one at once, and the console
+// has far less memory to spare than a PC
+#if defined(__CYGWIN__) || defined(__linux__)
+#define STORE_TABLE_MAX	0x1000000			// slots, 512MB for 8M chunks
+#else
+#define STORE_TABLE_MAX	0x80000				// slots, 16MB for 256K chunks
+#endif
+
+// The index keeps where a chunk starts in its pack as a u32
+#if STORE_PACK_SIZE > 0xFFFFFFFF - STORE_CDC_MAX
+#error "STORE_PACK_SIZE is too big for the index's pack offsets"
+#endif
+
+// Where a chunk is, as the index has it; len is 0 for an empty slot
+typedef struct {
+	u8 sha1[20];
+	u32 pack;
+	u32 offset;
+	u32 len;
+} store_rec;
+
+// Every chunk in the store by its SHA-1, open addressed and at most half full
+typedef struct {
+	store_rec *slot;
+	u32 mask;
+	u32 used;
+} store_table;
+
+typedef struct {
+	char dir[STORE_PATH_MAX];
+	int chunking;
+	store_table table;
+	FILE *index;
+	FILE *pack;
+	u32 pack_num;
+	u32 pack_size;
+	u8 *buf;			// image data not cut into chunks yet
+	u32 start;
+	u32 filled;
+	u8 *entries;		// recipe entries not passed on yet
+	u32 queued;
+	u32 chunks;
+	u64 out;			// where the next entries go in the recipe
+	md5_state_t md5;
+	u8 hdr[STORE_HEADER_SIZE];
+} store_ctx;
+
+static u64 gear[256];
+
+// The gear table only has to be the same every time, splitmix64 from a fixed seed
+static void gear_init(void) {
+	u64 x = 0x436C65616E526970ULL;
+
+	if (gear[0]) {
+		return;
+	}
+	for (int i = 0; i < 256; i++) {
+		u64 z = (x += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		gear[i] = z ^ (z >> 31);
+	}
+}
+
+static u32 cdc_cut(const u8 *p, u32 n) {
+	u64 fp = 0;
+	u32 i = STORE_CDC_MIN, normal = STORE_CDC_AVG;
+
+	if (n <= STORE_CDC_MIN) {
+		return n;
+	}
+	if (n > STORE_CDC_MAX) {
+		n = STORE_CDC_MAX;
+	}
+	if (normal > n) {
+		normal = n;
+	}
+	for (; i < normal; i++) {
+		fp = (fp << 1) + gear[p[i]];
+		if (!(fp & CDC_MASK_S)) {
+			return i + 1;
+		}
+	}
+	for (; i < n; i++) {
+		fp = (fp << 1) + gear[p[i]];
+		if (!(fp & CDC_MASK_L)) {
+			return i + 1;
+		}
+	}
+	return n;
+}
+
+static void chunk_sha1(const u8 *p, u32 len, u8 *sha1) {
+	SHA1Context sha;
+
+	SHA1Reset(&sha);
+	SHA1Input(&sha, (const unsigned char *)p, len);
+	SHA1Result(&sha);
+	for (int i = 0; i < 5; i++) {
+		sha1[i * 4] = sha.Message_Digest[i] >> 24;
+		sha1[i * 4 + 1] = (sha.Message_Digest[i] >> 16) & 0xFF;
+		sha1[i * 4 + 2] = (sha.Message_Digest[i] >> 8) & 0xFF;
+		sha1[i * 4 + 3] = sha.Message_Digest[i] & 0xFF;
+	}
+}
+
+// The chunk's slot, or the empty one it would go in
+static store_rec *table_find(store_table *t, const u8 *sha1) {
+	u32 i = get_le32(sha1) & t->mask;
+
+	while (t->slot[i].len && memcmp(t->slot[i].sha1, sha1, 20)) {
+		i = (i + 1) & t->mask;
+	}
+	return &t->slot[i];
+}
+
+static int table_grow(store_table *t) {
+	store_table bigger;
+
+	bigger.mask = t->slot ? t->mask * 2 + 1 : 0xFFFF;
+	bigger.used = t->used;
+	if (bigger.mask >= STORE_TABLE_MAX) {
+		print_gecko("The store's index is full at %u chunks, move %s aside to start a new store\r\n", t->used, STORE_DIR);
+		return 1;
+	}
+	bigger.slot = (store_rec*)calloc(bigger.mask + 1, sizeof(store_rec));
+	if (!bigger.slot) {
+		print_gecko("Not enough memory for the store's index of %u chunks\r\n", t->used);
+		return 1;
+	}
+	for (u32 i = 0; t->slot && i <= t->mask; i++) {
+		if (t->slot[i].len) {
+			*table_find(&bigger, t->slot[i].sha1) = t->slot[i];
+		}
+	}
+	free(t->slot);
+	*t = bigger;
+	return 0;
+}
+
+static int table_add(store_table *t, const store_rec *r) {
+	if ((t->used + 1) * 2 > t->mask + 1 && table_grow(t)) {
+		return 1;
+	}
+	store_rec *slot = table_find(t, r->sha1);
+	if (!slot->len) {
+		*slot = *r;
+		t->used++;
+	}
+	return 0;
+}
+
+static void store_path(char *path, const char *dir, const char *name) {
+	snprintf(path, STORE_FILE_MAX, "%s/%s", dir, name);
+}
+
+static void pack_path(char *path, const char *dir, u32 pack) {
+	char name[16];
+	sprintf(name, "pack%04u.pak", pack);
+	store_path(path, dir, name);
+}
+
+// Every chunk the store has, from its index; a store that isn't there yet is empty
+static int load_index(const char *dir, store_table *t, u32 *packs) {
+	char path[STORE_FILE_MAX];
+	u8 rec[STORE_RECORD_SIZE];
+	store_rec r;
+
+	memset(t, 0, sizeof(store_table));
+	*packs = 0;
+	if (table_grow(t)) {
+		return 1;
+	}
+	store_path(path, dir, STORE_INDEX);
+	FILE *fp = fopen(path, "rb");
+	if (!fp) {
+		return 0;
+	}
+	if (fread(rec, 1, 8, fp) != 8 || memcmp(rec, STORE_INDEX_MAGIC, 4) || get_le32(&rec[4]) != STORE_VERSION) {
+		fclose(fp);
+		return 1;
+	}
+	while (fread(rec, 1, STORE_RECORD_SIZE, fp) == STORE_RECORD_SIZE) {
+		memcpy(r.sha1, rec, 20);
+		r.pack = get_le32(&rec[20]);
+		r.offset = get_le32(&rec[24]);
+		r.len = get_le32(&rec[28]);
+		if (r.pack >= *packs) {
+			*packs = r.pack + 1;
+		}
+		if (r.len && table_add(t, &r)) {
+			fclose(fp);
+			return 1;
+		}
+	}
+	fclose(fp);
+	return 0;
+}
+
+// Appends to the last pack until it is full
+static int open_pack(store_ctx *c, u32 pack) {
+	char path[STORE_FILE_MAX];
+
+	if (c->pack && fclose(c->pack)) {
+		c->pack = NULL;
+		return 1;
+	}
+	pack_path(path, c->dir, pack);
+	c->pack_num = pack;
+	c->pack = fopen(path, "ab");
+	if (!c->pack || fseek(c->pack, 0, SEEK_END)) {
+		return 1;
+	}
+	// a pack past STORE_PACK_SIZE wasn't written by a store, its offsets may not fit
+	long size = ftell(c->pack);
+	if (size < 0 || (u64)size > STORE_PACK_SIZE) {
+		print_gecko("%s is bigger than a store's pack can be\r\n", path);
+		return 1;
+	}
+	c->pack_size = (u32)size;
+	return 0;
+}
+
+static int pass_entries(sink *s) {
+	store_ctx *c = (store_ctx*)s->ctx;
+	u32 len = c->queued * STORE_ENTRY_SIZE;
+
+	c->queued = 0;
+	if (sink_write(s->next[0], c->entries, len, c->out)) {
+		return 1;
+	}
+	c->out += len;
+	return 0;
+}
+
+static int store_chunk(sink *s, const u8 *p, u32 len) {
+	store_ctx *c = (store_ctx*)s->ctx;
+	u8 *entry = &c->entries[c->queued * STORE_ENTRY_SIZE];
+	u8 rec[STORE_RECORD_SIZE];
+	store_rec r;
+
+	chunk_sha1(p, len, r.sha1);
+	if (!table_find(&c->table, r.sha1)->len) {
+		if (c->pack_size && c->pack_size + len > STORE_PACK_SIZE && open_pack(c, c->pack_num + 1)) {
+			return 1;
+		}
+		r.pack = c->pack_num;
+		r.offset = c->pack_size;
+		r.len = len;
+		memcpy(rec, r.sha1, 20);
+		put_le32(&rec[20], r.pack);
+		put_le32(&rec[24], r.offset);
+		put_le32(&rec[28], r.len);
+		if (fwrite(p, 1, len, c->pack) != len || fwrite(rec, 1, STORE_RECORD_SIZE, c->index) != STORE_RECORD_SIZE
+			|| table_add(&c->table, &r)) {
+			return 1;
+		}
+		c->pack_size += len;
+	}
+	memcpy(entry, r.sha1, 20);
+	put_le32(&entry[20], len);
+	c->chunks++;
+	return ++c->queued == STORE_ENTRIES ? pass_entries(s) : 0;
+}
+
+// Chunks from the data held back, all of it once the image is in
+static int store_cut(sink *s, int last) {
+	store_ctx *c = (store_ctx*)s->ctx;
+	u32 max = c->chunking == STORE_CHUNK_CDC ? STORE_CDC_MAX : STORE_FIXED_SIZE;
+
+	while (c->filled - c->start >= max || (last && c->filled > c->start)) {
+		u32 left = c->filled - c->start;
+		u32 n = c->chunking == STORE_CHUNK_CDC ? cdc_cut(&c->buf[c->start], left) : (left < max ? left : max);
+		if (store_chunk(s, &c->buf[c->start], n)) {
+			return 1;
+		}
+		c->start += n;
+	}
+	memmove(c->buf, &c->buf[c->start], c->filled - c->start);
+	c->filled -= c->start;
+	c->start = 0;
+	return 0;
+}
+
+static int store_write(sink *s, const void *data, u32 len, u64 offset) {
+	store_ctx *c = (store_ctx*)s->ctx;
+	const u8 *p = (const u8*)data;
+
+	// chunks are cut from the image in order
+	if (offset != s->pos) {
+		return 1;
+	}
+	s->pos += len;
+	md5_append(&c->md5, (const md5_byte_t *)data, len);
+	while (len) {
+		u32 n = STORE_BUF_SIZE - c->filled;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(&c->buf[c->filled], p, n);
+		c->filled += n;
+		p += n;
+		len -= n;
+		if (store_cut(s, 0)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int store_flush(sink *s) {
+	store_ctx *c = (store_ctx*)s->ctx;
+	int ret = c->pack ? fflush(c->pack) | fflush(c->index) : 1;
+	return sink_flush(s->next[0]) | ret;
+}
+
+static int store_header(sink *s, int done) {
+	store_ctx *c = (store_ctx*)s->ctx;
+	md5_byte_t md5[16];
+
+	memset(c->hdr, 0, STORE_HEADER_SIZE);
+	memcpy(c->hdr, STORE_RECIPE_MAGIC, 4);
+	put_le32(&c->hdr[4], STORE_VERSION);
+	put_le32(&c->hdr[8], c->chunking);
+	if (done) {
+		md5_finish(&c->md5, md5);
+		put_le32(&c->hdr[12], c->chunks);
+		put_le64(&c->hdr[16], s->pos);
+		memcpy(&c->hdr[24], md5, 16);
+	}
+	return sink_write(s->next[0], c->hdr, STORE_HEADER_SIZE, 0);
+}
+
+static void free_ctx(store_ctx *c) {
+	free(c->table.slot);
+	free(c->buf);
+	free(c->entries);
+	free(c);
+}
+
+static int store_close(sink *s) {
+	store_ctx *c = (store_ctx*)s->ctx;
+	int ret = 0;
+
+	if (c) {
+		ret = store_cut(s, 1);
+		if (!ret && c->queued) {
+			ret = pass_entries(s);
+		}
+		// the chunks are in their pack before the index names them
+		ret |= c->pack ? fclose(c->pack) : 1;
+		ret |= fclose(c->index);
+		ret |= store_header(s, 1);
+		free_ctx(c);
+		s->ctx = NULL;
+	}
+	return sink_close(s->next[0]) | ret;
+}
+
+static const sink_ops store_ops = { store_write, store_flush, store_close };
+
+// next is the recipe, the chunks go into the store in dir
+int sink_store(sink *s, sink *next, const char *dir, int chunking) {
+	char path[STORE_FILE_MAX];
+	u32 packs;
+	store_ctx *c = (store_ctx*)calloc(1, sizeof(store_ctx));
+
+	if (!c) {
+		return 1;
+	}
+	gear_init();
+	snprintf(c->dir, sizeof(c->dir), "%s", dir);
+	c->chunking = chunking;
+	c->out = STORE_HEADER_SIZE;
+	md5_init(&c->md5);
+	c->buf = (u8*)malloc(STORE_BUF_SIZE);
+	c->entries = (u8*)malloc(STORE_ENTRIES * STORE_ENTRY_SIZE);
+	mkdir(dir, 0777);
+	if (!c->buf || !c->entries || load_index(dir, &c->table, &packs) || open_pack(c, packs ? packs - 1 : 0)) {
+		if (c->pack) {
+			fclose(c->pack);
+		}
+		free_ctx(c);
+		return 1;
+	}
+	store_path(path, dir, STORE_INDEX);
+	if (!(c->index = fopen(path, "ab"))) {
+		fclose(c->pack);
+		free_ctx(c);
+		return 1;
+	}
+	if (!ftell(c->index)) {
+		u8 hdr[8];
+		memcpy(hdr, STORE_INDEX_MAGIC, 4);
+		put_le32(&hdr[4], STORE_VERSION);
+		fwrite(hdr, 1, 8, c->index);
+	}
+	sink_stage(s, &store_ops, c, next);
+	// an empty recipe until the dump is done, a cancelled one has no chunks
+	return store_header(s, 0);
+}
+
+#if defined(__CYGWIN__) || defined(__linux__)
+typedef struct {
+	char dir[STORE_PATH_MAX];
+	u32 chunks;
+	u64 *start;			// where each chunk is in the image, and where the image ends
+	store_rec *where;	// and in the store
+	u32 packs;
+	FILE **pack;		// opened as a read first needs them
+	pthread_mutex_t lock;
+} store_reader;
+
+static FILE *reader_pack(store_reader *r, u32 pack) {
+	char path[STORE_FILE_MAX];
+	FILE *fp;
+
+	pthread_mutex_lock(&r->lock);
+	if (!(fp = r->pack[pack])) {
+		pack_path(path, r->dir, pack);
+		fp = r->pack[pack] = fopen(path, "rb");
+	}
+	pthread_mutex_unlock(&r->lock);
+	return fp;
+}
+
+static int store_block(archive *a, u32 block, u8 *dst, u8 *scratch) {
+	store_reader *r = (store_reader*)a->ctx;
+	u64 pos = (u64)block * a->block_size;
+	u64 end = pos + a->block_size > a->size ? a->size : pos + a->block_size;
+	u32 lo = 0, hi = r->chunks;
+
+	// the last chunk that starts at or before pos
+	while (hi - lo > 1) {
+		u32 mid = (lo + hi) / 2;
+		if (r->start[mid] <= pos) {
+			lo = mid;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	memset(dst + (end - pos), 0, a->block_size - (u32)(end - pos));
+	for (u32 i = lo; pos < end; i++) {
+		store_rec *w = &r->where[i];
+		u32 skip = (u32)(pos - r->start[i]);
+		u32 n = w->len - skip < end - pos ? w->len - skip : (u32)(end - pos);
+		FILE *fp = reader_pack(r, w->pack);
+		if (!fp || archive_pread(fp, dst, n, (u64)w->offset + skip)) {
+			return 1;
+		}
+		dst += n;
+		pos += n;
+	}
+	return 0;
+}
+
+static void store_reader_close(archive *a) {
+	store_reader *r = (store_reader*)a->ctx;
+
+	for (u32 i = 0; r->pack && i < r->packs; i++) {
+		if (r->pack[i]) {
+			fclose(r->pack[i]);
+		}
+	}
+	pthread_mutex_destroy(&r->lock);
+	free(r->pack);
+	free(r->start);
+	free(r->where);
+	free(r);
+}
+
+static int read_recipe_header(FILE *fp, u8 *hdr) {
+	return fread(hdr, 1, STORE_HEADER_SIZE, fp) != STORE_HEADER_SIZE || memcmp(hdr, STORE_RECIPE_MAGIC, 4)
+		|| get_le32(&hdr[4]) != STORE_VERSION;
+}
+
+// The store is the cleanrip-store directory next to the recipe
+int store_archive(archive *a, const char *path) {
+	u8 hdr[STORE_HEADER_SIZE], entry[STORE_ENTRY_SIZE];
+	store_table table;
+	u64 size;
+	int ret = 0;
+	store_reader *r = (store_reader*)calloc(1, sizeof(store_reader));
+	FILE *fp = fopen(path, "rb");
+
+	memset(a, 0, sizeof(archive));
+	if (!r || !fp || read_recipe_header(fp, hdr)) {
+		free(r);
+		if (fp) {
+			fclose(fp);
+		}
+		return -1;
+	}
+	pthread_mutex_init(&r->lock, NULL);
+	a->ctx = r;
+	a->close = store_reader_close;
+	a->block = store_block;
+	snprintf(r->dir, sizeof(r->dir), "%s", path);
+	char *slash = strrchr(r->dir, '/');
+	snprintf(slash ? slash + 1 : r->dir, sizeof(r->dir) - (slash ? slash + 1 - r->dir : 0), "%s", STORE_DIR);
+	r->chunks = get_le32(&hdr[12]);
+	size = get_le64(&hdr[16]);
+	r->start = (u64*)malloc(((u64)r->chunks + 1) * sizeof(u64));
+	r->where = (store_rec*)malloc(((u64)r->chunks + 1) * sizeof(store_rec));
+	if (!r->start || !r->where || load_index(r->dir, &table, &r->packs)) {
+		fclose(fp);
+		store_reader_close(a);
+		return -1;
+	}
+	// each chunk's place in the pack, one the index doesn't have means the store lost it
+	u64 pos = 0;
+	for (u32 i = 0; !ret && i < r->chunks; i++) {
+		store_rec *w;
+		if (fread(entry, 1, STORE_ENTRY_SIZE, fp) != STORE_ENTRY_SIZE
+			|| !(w = table_find(&table, entry))->len || w->len != get_le32(&entry[20])) {
+			ret = -1;
+			break;
+		}
+		r->where[i] = *w;
+		r->start[i] = pos;
+		pos += w->len;
+	}
+	r->start[r->chunks] = pos;
+	free(table.slot);
+	fclose(fp);
+	if (ret || pos != size || !(r->pack = (FILE**)calloc(r->packs ? r->packs : 1, sizeof(FILE*)))) {
+		store_reader_close(a);
+		return -1;
+	}
+	a->size = size;
+	a->size_known = 1;
+	a->block_size = STORE_READ_BLOCK;
+	a->blocks = (u32)((size + STORE_READ_BLOCK - 1) / STORE_READ_BLOCK);
+	return 0;
+}
+
+// The MD5 the recipe was written with, as the dumpinfo has it
+int store_recipe_md5(const char *path, char *md5) {
+	u8 hdr[STORE_HEADER_SIZE];
+	FILE *fp = fopen(path, "rb");
+
+	if (!fp) {
+		return 1;
+	}
+	int ret = read_recipe_header(fp, hdr);
+	fclose(fp);
+	for (int i = 0; !ret && i < 16; i++) {
+		sprintf(&md5[i * 2], "%02x", hdr[24 + i]);
+	}
+	return ret;
+}
+#endif
@@ -0,0 +1,136 @@
+/**
+ * CleanRip - stripe.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * Reads one disc from several drives holding the same pressing.
+ * Stripe n (STRIPE_SIZE bytes) belongs to drive n % readers. Every
+ * drive has its own thread that runs ahead through its stripes, and
+ * the caller takes them back in disc order. Each reader's queue is
+ * already in order, so putting the disc back together only means
+ * visiting the readers in turn.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "stripe.h"
+
+#define READER_PRIO 128 // same as the reader/writer threads
+
+static void* reader_thread(void *_worker) {
+	stripe_worker *w = (stripe_worker*)_worker;
+	stripe_reader *sr = w->owner;
+	stripe_slot *slot;
+
+	while (MQ_Receive(w->freeq, (mqmsg_t*)&slot, MQ_MSG_BLOCK)==TRUE && slot && !sr->stop) {
+		// the first stripe may start part way in, all others are whole
+		u64 stripe_end = (w->next / STRIPE_SIZE + 1) * STRIPE_SIZE;
+		slot->offset = w->next;
+		slot->length = (u32)(stripe_end - w->next);
+		slot->failed = sr->read(w->index, slot->data, slot->length, slot->offset) != 0;
+		w->next = stripe_end + (u64)(sr->readers - 1) * STRIPE_SIZE;
+		MQ_Send(w->readyq, (mqmsg_t)slot, MQ_MSG_BLOCK);
+		if (slot->failed) {
+			// bad area or the end of the disc, let the caller decide
+			break;
+		}
+	}
+	return NULL;
+}
+
+int stripe_start(stripe_reader *sr, int readers, stripe_read_fn read, u64 start) {
+	memset(sr, 0, sizeof(stripe_reader));
+	if (readers > STRIPE_MAX_READERS) {
+		readers = STRIPE_MAX_READERS;
+	}
+	sr->memory = memalign(32, (u32)readers * STRIPE_SLOTS * STRIPE_SIZE);
+	if (!sr->memory) {
+		return -1;
+	}
+	sr->read = read;
+	sr->readers = readers;
+	sr->position = start;
+	sr->current_reader = (int)((start / STRIPE_SIZE) % readers);
+
+	u64 first = start / STRIPE_SIZE;
+	for (int i = 0; i < readers; i++) {
+		stripe_worker *w = &sr->workers[i];
+		w->owner = sr;
+		w->index = i;
+		// first stripe at or after start that belongs to this reader
+		u64 stripe = first + (u64)((i - (int)(first % readers) + readers) % readers);
+		w->next = (stripe == first) ? start : stripe * STRIPE_SIZE;
+		MQ_Init(&w->freeq, STRIPE_SLOTS + 1);
+		MQ_Init(&w->readyq, STRIPE_SLOTS + 1);
+		for (int s = 0; s < STRIPE_SLOTS; s++) {
+			w->slots[s].data = sr->memory + ((u32)i * STRIPE_SLOTS + s) * STRIPE_SIZE;
+			MQ_Send(w->freeq, (mqmsg_t)&w->slots[s], MQ_MSG_BLOCK);
+		}
+		LWP_CreateThread(&w->thread, reader_thread, (void*)w, NULL, 0, READER_PRIO);
+	}
+	return 0;
+}
+
+// Copies the next bytes in disc order; fails for a read that isn't the next one
+// or that touches a stripe a drive couldn't read, the caller then reads it itself
+int stripe_read(stripe_reader *sr, void *dst, u32 len, u64 offset) {
+	u8 *out = (u8*)dst;
+
+	if (offset != sr->position) {
+		return 1;
+	}
+	while (len) {
+		if (!sr->current) {
+			MQ_Receive(sr->workers[sr->current_reader].readyq, (mqmsg_t*)&sr->current, MQ_MSG_BLOCK);
+		}
+		stripe_slot *slot = sr->current;
+		if (slot->failed) {
+			return 1;
+		}
+		u32 in_slot = (u32)(sr->position - slot->offset);
+		u32 n = (len < slot->length - in_slot) ? len : (slot->length - in_slot);
+		memcpy(out, slot->data + in_slot, n);
+		out += n;
+		len -= n;
+		sr->position += n;
+		if (sr->position == slot->offset + slot->length) {
+			// used up, back to its reader for a later stripe
+			MQ_Send(sr->workers[sr->current_reader].freeq, (mqmsg_t)slot, MQ_MSG_BLOCK);
+			sr->current = NULL;
+			sr->current_reader = (sr->current_reader + 1) % sr->readers;
+		}
+	}
+	return 0;
+}
+
+void stripe_stop(stripe_reader *sr) {
+	if (!sr->memory) {
+		return;
+	}
+	sr->stop = 1;
+	for (int i = 0; i < sr->readers; i++) {
+		MQ_Jam(sr->workers[i].freeq, (mqmsg_t)NULL, MQ_MSG_BLOCK);
+	}
+	for (int i = 0; i < sr->readers; i++) {
+		LWP_JoinThread(sr->workers[i].thread, NULL);
+		MQ_Close(sr->workers[i].freeq);
+		MQ_Close(sr->workers[i].readyq);
+	}
+	free(sr->memory);
+	sr->memory = NULL;
+}
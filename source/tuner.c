@@ -0,0 +1,200 @@
+/**
+ * CleanRip - tuner.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * Picks the read block size and pipeline depth while dumping.
+ * The first seconds are spent measuring each candidate size, then
+ * each depth with the best size; the winner is kept until the
+ * throughput collapses (layer break, damaged area), which starts
+ * the measurements over.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <string.h>
+#ifndef __CYGWIN__
+#include <ogc/lwp_watchdog.h>
+#endif
+#include "tuner.h"
+
+#define WARMUP_MS		1000	// spin-up and the first seek aren't representative
+#define TRIAL_MS		500
+#define STEADY_MS		2000
+#define SLOW_WINDOWS	2		// windows below half the settled rate before re-tuning
+#define MAX_RETUNES		8
+
+void print_gecko(const char* fmt, ...);
+
+static void start_window(tuner *t) {
+	t->window_start = gettime();
+	t->window_bytes = 0;
+	t->window_errors = 0;
+}
+
+static void start_trials(tuner *t, int state) {
+	t->state = state;
+	t->trial = 0;
+	t->best = 0;
+	t->best_score = 0;
+	if (state == TUNER_SIZES) {
+		t->size = 0;
+		t->depth = t->base_depth;
+	}
+	else {
+		t->depth = 0;
+	}
+}
+
+void tuner_init(tuner *t, u32 sector_size, u32 base_size, int base_depth, int enabled) {
+	memset(t, 0, sizeof(tuner));
+
+	// half, same, double and quadruple the built-in block size
+	for (int i = 0; i < TUNER_MAX_SIZES; i++) {
+		u32 size = (i == 0) ? (base_size >> 1) : (base_size << (i - 1));
+		size = (size / sector_size) * sector_size;
+		if (size < sector_size) {
+			size = sector_size;
+		}
+		if (t->num_sizes && t->sizes[t->num_sizes - 1] == size) {
+			continue;
+		}
+		if (size == base_size) {
+			t->base_size = t->num_sizes;
+		}
+		t->sizes[t->num_sizes++] = size;
+	}
+	// half, same and double the built-in depth
+	t->depths[0] = (base_depth > 2) ? (base_depth >> 1) : base_depth;
+	t->depths[1] = base_depth;
+	t->depths[2] = base_depth << 1;
+	t->num_depths = TUNER_MAX_DEPTHS;
+	t->base_depth = 1;
+
+	t->size = t->base_size;
+	t->depth = t->base_depth;
+	t->state = enabled ? TUNER_WARMUP : TUNER_FIXED;
+	start_window(t);
+}
+
+void tuner_update(tuner *t, u32 bytes, int error) {
+	if (t->state == TUNER_FIXED) {
+		return;
+	}
+	t->window_bytes += bytes;
+	if (error) {
+		t->window_errors++;
+	}
+
+	u32 elapsed = diff_msec(t->window_start, gettime());
+	u32 window = (t->state == TUNER_WARMUP) ? WARMUP_MS : (t->state == TUNER_STEADY ? STEADY_MS : TRIAL_MS);
+	if (elapsed < window) {
+		return;
+	}
+	u32 rate = (u32)((t->window_bytes * 1000) / elapsed);
+	// a read error costs much more than a slow window (retries, recovery)
+	u32 score = rate / (1 + 4 * t->window_errors);
+
+	switch (t->state) {
+		case TUNER_WARMUP:
+			start_trials(t, TUNER_SIZES);
+			break;
+		case TUNER_SIZES:
+		case TUNER_DEPTHS:
+			if (score > t->best_score) {
+				t->best_score = score;
+				t->best = t->trial;
+			}
+			t->trial++;
+			if (t->state == TUNER_SIZES) {
+				if (t->trial < t->num_sizes) {
+					t->size = t->trial;
+					break;
+				}
+				t->size = t->best;
+				start_trials(t, TUNER_DEPTHS);
+			}
+			else {
+				if (t->trial < t->num_depths) {
+					t->depth = t->trial;
+					break;
+				}
+				t->depth = t->best;
+				t->state = TUNER_STEADY;
+				t->steady_rate = t->best_score;
+				t->slow_windows = 0;
+				print_gecko("Tuned: %u byte reads, %i blocks in flight (%u KB/s)\r\n",
+					t->sizes[t->size], t->depths[t->depth], t->steady_rate / 1024);
+			}
+			break;
+		case TUNER_STEADY:
+			if (rate >= t->steady_rate) {
+				t->steady_rate = rate;
+			}
+			else {
+				t->steady_rate -= (t->steady_rate - rate) / 8;
+			}
+			if (rate < t->steady_rate / 2 && t->retunes < MAX_RETUNES) {
+				if (++t->slow_windows >= SLOW_WINDOWS) {
+					print_gecko("Throughput dropped to %u KB/s, re-tuning\r\n", rate / 1024);
+					t->retunes++;
+					start_trials(t, TUNER_SIZES);
+				}
+			}
+			else {
+				t->slow_windows = 0;
+			}
+			break;
+	}
+	start_window(t);
+}
+
+u32 tuner_read_size(tuner *t) {
+	return t->sizes[t->size];
+}
+
+int tuner_depth(tuner *t) {
+	return t->depths[t->depth];
+}
+
+// Sizes other than the built-in one haven't been proven on this drive yet
+int tuner_probing(tuner *t) {
+	return t->state == TUNER_SIZES || t->state == TUNER_DEPTHS;
+}
+
+u32 tuner_base_size(tuner *t) {
+	return t->sizes[t->base_size];
+}
+
+u32 tuner_max_size(tuner *t) {
+	return (t->state == TUNER_FIXED) ? t->sizes[t->base_size] : t->sizes[t->num_sizes - 1];
+}
+
+int tuner_max_depth(tuner *t) {
+	return (t->state == TUNER_FIXED) ? t->depths[t->base_depth] : t->depths[t->num_depths - 1];
+}
+
+// Ring buffer layout for the current state: room for every candidate while
+// measuring, exactly what was picked once settled
+void tuner_ring_shape(tuner *t, u32 *block_size, int *count) {
+	if (t->state == TUNER_STEADY || t->state == TUNER_FIXED) {
+		*block_size = t->sizes[t->size];
+		*count = t->depths[t->depth];
+	}
+	else {
+		*block_size = t->sizes[t->num_sizes - 1];
+		*count = t->depths[t->num_depths - 1];
+	}
+}
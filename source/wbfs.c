@@ -0,0 +1,418 @@
+/**
+ * CleanRip - wbfs.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * A sink stage that writes a Wii disc as a WBFS file while it is
+ * dumped. Only the disc header area and the partitions are kept: the
+ * partition table is read out of the first block, and each partition
+ * header, as it comes by, says how far that partition goes. Every 2MB
+ * block of the disc with any of that in it (and not all zeroes) is
+ * appended, everything else is left out of the block map and reads
+ * back as zeroes. The partitions are encrypted, so the space inside
+ * them that no file uses is kept. On FAT the file is split into
+ * .wbf1, .wbf2... the way USB loaders expect, all of them stay open
+ * so the head can be filled in at close. On a PC the first disc in a
+ * WBFS file can be read back through its block map.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wbfs.h"
+#include "bytes.h"
+
+#define WII_PART_INFO		0x40000		// four partition groups, a count and table offset each
+#define WII_HEADER_AREA		0x50000		// disc header, partition table and region info
+#define WII_PART_HEADER		0x2C0		// ticket and the offsets after it
+
+// What the loaders work out from the head, for a partition the size of a dual layer disc
+#define WBFS_HD_SECTORS		(WBFS_WII_SECTORS * (0x8000 / WBFS_HD_SECTOR))
+#define WBFS_BLOCKS			((WBFS_HD_SECTORS / 0x8000 * WBFS_HD_SECTOR) >> (WBFS_BLOCK_SHIFT - 15))
+#define WBFS_DISC_BLOCKS	(WBFS_WII_SECTORS >> (WBFS_BLOCK_SHIFT - 15))
+#define WBFS_DISC_INFO		WBFS_HD_SECTOR
+#define WBFS_FREE_MAP		((WBFS_BLOCK_SIZE - WBFS_BLOCKS / 8) / WBFS_HD_SECTOR * WBFS_HD_SECTOR)
+
+typedef struct {
+	u64 offset;
+	u64 end;			// 0 until its header has come by
+} wii_partition;
+
+typedef struct {
+	char prefix[PARTFILE_PATH_MAX];
+	u64 split;			// how big each file gets, 0 for one file
+	sink part[WBFS_MAX_PARTS];	// the first one is next[0]
+	int parts;			// files open so far
+	wii_partition partition[WBFS_MAX_PARTITIONS];
+	int partitions;
+	u32 block;			// the disc block coming in
+	u32 used;			// blocks in the file so far, after the first
+	u8 *carry;
+	u32 filled;
+	u8 *hdr;			// the first block of the file
+} wbfs_ctx;
+
+void wbfs_part_ext(int part, char *ext) {
+	if (part) {
+		sprintf(ext, ".wbf%i", part);
+	}
+	else {
+		strcpy(ext, ".wbfs");
+	}
+}
+
+static sink *wbfs_part(sink *s, int part) {
+	wbfs_ctx *c = (wbfs_ctx*)s->ctx;
+	char path[PARTFILE_PATH_MAX + 16];
+
+	if (!part) {
+		return s->next[0];
+	}
+	if (part >= WBFS_MAX_PARTS) {
+		return NULL;
+	}
+	while (c->parts <= part) {
+		strcpy(path, c->prefix);
+		wbfs_part_ext(c->parts, path + strlen(path));
+		if (sink_file_open(&c->part[c->parts], path, (u64)c->parts * c->split)) {
+			return NULL;
+		}
+		c->parts++;
+	}
+	return &c->part[part];
+}
+
+// The file as if it were one, cut where the parts go
+static int wbfs_put(sink *s, const u8 *data, u32 len, u64 offset) {
+	wbfs_ctx *c = (wbfs_ctx*)s->ctx;
+
+	while (len) {
+		int part = c->split ? (int)(offset / c->split) : 0;
+		u32 n = len;
+		if (c->split && offset + n > (u64)(part + 1) * c->split) {
+			n = (u64)(part + 1) * c->split - offset;
+		}
+		sink *file = wbfs_part(s, part);
+		if (!file || sink_write(file, data, n, offset)) {
+			return 1;
+		}
+		data += n;
+		len -= n;
+		offset += n;
+	}
+	return 0;
+}
+
+static int all_zero(const u8 *p, u32 len) {
+	while (len && !*p) {
+		p++;
+		len--;
+	}
+	return !len;
+}
+
+// The partition table is in the first block, each partition's header at its start
+static void wbfs_partitions(wbfs_ctx *c, const u8 *data, u32 len, u64 start) {
+	if (start == 0 && len >= WII_HEADER_AREA) {
+		for (int g = 0; g < 4; g++) {
+			u32 count = get_be32(data + WII_PART_INFO + g * 8);
+			u64 table = (u64)get_be32(data + WII_PART_INFO + g * 8 + 4) << 2;
+			for (u32 i = 0; i < count && c->partitions < WBFS_MAX_PARTITIONS; i++) {
+				if (table + i * 8 + 8 > len) {
+					break;
+				}
+				c->partition[c->partitions].offset = (u64)get_be32(data + table + i * 8) << 2;
+				c->partition[c->partitions].end = 0;
+				c->partitions++;
+			}
+		}
+	}
+	for (int i = 0; i < c->partitions; i++) {
+		wii_partition *p = &c->partition[i];
+		if (!p->end && p->offset >= start && p->offset + WII_PART_HEADER <= start + len) {
+			const u8 *hdr = data + (p->offset - start);
+			u64 data_offset = (u64)get_be32(hdr + 0x2B8) << 2;
+			u64 data_size = (u64)get_be32(hdr + 0x2BC) << 2;
+			// a header that makes no sense keeps the rest of the disc
+			p->end = data_size ? p->offset + data_offset + data_size : ~0ULL;
+		}
+	}
+}
+
+static int wbfs_used(wbfs_ctx *c, const u8 *data, u32 len, u64 start) {
+	if (all_zero(data, len)) {
+		return 0;
+	}
+	// not laid out like a Wii disc, keep everything
+	if (start < WII_HEADER_AREA || !c->partitions) {
+		return 1;
+	}
+	for (int i = 0; i < c->partitions; i++) {
+		wii_partition *p = &c->partition[i];
+		if (p->offset < start + len && start < p->end) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int wbfs_block(sink *s, const u8 *data, u32 len) {
+	wbfs_ctx *c = (wbfs_ctx*)s->ctx;
+	u64 start = (u64)c->block * WBFS_BLOCK_SIZE;
+	int ret = 0;
+
+	wbfs_partitions(c, data, len, start);
+	if (c->block >= WBFS_DISC_BLOCKS) {
+		return 1;
+	}
+	if (!c->block) {
+		memcpy(c->hdr + WBFS_DISC_INFO, data, 0x100);
+	}
+	if (wbfs_used(c, data, len, start)) {
+		if (++c->used >= WBFS_BLOCKS) {
+			return 1;
+		}
+		u8 *wlba = c->hdr + WBFS_DISC_INFO + 0x100 + c->block * 2;
+		wlba[0] = c->used >> 8;
+		wlba[1] = c->used & 0xFF;
+		ret = wbfs_put(s, data, len, (u64)c->used * WBFS_BLOCK_SIZE);
+	}
+	c->block++;
+	return ret;
+}
+
+static int wbfs_write(sink *s, const void *data, u32 len, u64 offset) {
+	wbfs_ctx *c = (wbfs_ctx*)s->ctx;
+	const u8 *p = (const u8*)data;
+	int ret = 0;
+
+	// the block map only works if every block comes in order
+	if (offset != s->pos) {
+		return 1;
+	}
+	s->pos += len;
+	if (c->filled) {
+		u32 n = WBFS_BLOCK_SIZE - c->filled;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(c->carry + c->filled, p, n);
+		c->filled += n;
+		p += n;
+		len -= n;
+		if (c->filled == WBFS_BLOCK_SIZE) {
+			ret |= wbfs_block(s, c->carry, WBFS_BLOCK_SIZE);
+			c->filled = 0;
+		}
+	}
+	for (; len >= WBFS_BLOCK_SIZE; p += WBFS_BLOCK_SIZE, len -= WBFS_BLOCK_SIZE) {
+		ret |= wbfs_block(s, p, WBFS_BLOCK_SIZE);
+	}
+	if (len) {
+		memcpy(c->carry, p, len);
+		c->filled = len;
+	}
+	return ret;
+}
+
+static int wbfs_flush(sink *s) {
+	wbfs_ctx *c = (wbfs_ctx*)s->ctx;
+	int ret = sink_flush(s->next[0]);
+	for (int i = 1; i < c->parts; i++) {
+		ret |= sink_flush(&c->part[i]);
+	}
+	return ret;
+}
+
+static int wbfs_header(sink *s) {
+	wbfs_ctx *c = (wbfs_ctx*)s->ctx;
+	u8 *free_map = c->hdr + WBFS_FREE_MAP;
+
+	put_be32(c->hdr, WBFS_MAGIC);
+	put_be32(c->hdr + 4, WBFS_HD_SECTORS);
+	c->hdr[8] = 9;						// 512 byte sectors
+	c->hdr[9] = WBFS_BLOCK_SHIFT;
+	c->hdr[10] = 1;						// version
+	c->hdr[12] = 1;						// the one disc is there
+	// a set bit is a free block, bit 0 of the first word is block 1
+	memset(free_map, 0xFF, WBFS_BLOCKS / 8);
+	for (u32 i = 0; i < c->used; i++) {
+		u8 *word = free_map + (i / 32) * 4;
+		put_be32(word, get_be32(word) & ~(1U << (i % 32)));
+	}
+	return wbfs_put(s, c->hdr, WBFS_BLOCK_SIZE, 0);
+}
+
+static int wbfs_close(sink *s) {
+	wbfs_ctx *c = (wbfs_ctx*)s->ctx;
+	int ret = 0;
+
+	if (c) {
+		// readers take whole blocks
+		if (c->filled) {
+			memset(c->carry + c->filled, 0, WBFS_BLOCK_SIZE - c->filled);
+			ret |= wbfs_block(s, c->carry, WBFS_BLOCK_SIZE);
+		}
+		ret |= wbfs_header(s);
+		for (int i = 1; i < c->parts; i++) {
+			ret |= sink_close(&c->part[i]);
+		}
+		free(c->carry);
+		free(c->hdr);
+		free(c);
+		s->ctx = NULL;
+	}
+	return sink_close(s->next[0]) | ret;
+}
+
+static const sink_ops wbfs_ops = { wbfs_write, wbfs_flush, wbfs_close };
+
+// next is the first file, the others are prefix.wbf1... once the file gets past split
+int sink_wbfs(sink *s, sink *next, const char *prefix, u64 split) {
+	wbfs_ctx *c = (wbfs_ctx*)calloc(1, sizeof(wbfs_ctx));
+	if (!c) {
+		return 1;
+	}
+	snprintf(c->prefix, sizeof(c->prefix), "%s", prefix);
+	c->split = split;
+	c->parts = 1;
+	c->carry = (u8*)malloc(WBFS_BLOCK_SIZE);
+	c->hdr = (u8*)calloc(1, WBFS_BLOCK_SIZE);
+	if (!c->carry || !c->hdr) {
+		free(c->carry);
+		free(c->hdr);
+		free(c);
+		return 1;
+	}
+	sink_stage(s, &wbfs_ops, c, next);
+	// an empty first block until the dump is done
+	if (sink_write(next, c->hdr, WBFS_BLOCK_SIZE, 0)) {
+		free(c->carry);
+		free(c->hdr);
+		free(c);
+		s->ctx = NULL;
+		return 1;
+	}
+	return 0;
+}
+
+#if defined(__CYGWIN__) || defined(__linux__)
+typedef struct {
+	FILE *fp[WBFS_MAX_PARTS];
+	u64 start[WBFS_MAX_PARTS];	// where each file begins in the whole
+	int parts;
+	u32 shift;			// of the block size
+	u16 *wlba;			// each disc block's block in the file, 0 if left out
+} wbfs_reader;
+
+// The files as if they were one
+static int wbfs_get(wbfs_reader *r, u8 *dst, u32 len, u64 offset) {
+	int part = r->parts - 1;
+
+	while (part > 0 && r->start[part] > offset) {
+		part--;
+	}
+	while (len) {
+		if (part >= r->parts) {
+			return 1;
+		}
+		u64 part_end = (part + 1 < r->parts) ? r->start[part + 1] : ~0ULL;
+		u32 n = (offset + len > part_end) ? (u32)(part_end - offset) : len;
+		if (archive_pread(r->fp[part], dst, n, offset - r->start[part])) {
+			return 1;
+		}
+		dst += n;
+		offset += n;
+		len -= n;
+		part++;
+	}
+	return 0;
+}
+
+static int wbfs_read_block(archive *a, u32 block, u8 *dst, u8 *scratch) {
+	wbfs_reader *r = (wbfs_reader*)a->ctx;
+
+	if (!r->wlba[block]) {
+		memset(dst, 0, a->block_size);
+		return 0;
+	}
+	return wbfs_get(r, dst, a->block_size, (u64)r->wlba[block] << r->shift);
+}
+
+static void wbfs_reader_close(archive *a) {
+	wbfs_reader *r = (wbfs_reader*)a->ctx;
+
+	for (int i = 0; i < r->parts; i++) {
+		fclose(r->fp[i]);
+	}
+	free(r->wlba);
+	free(r);
+}
+
+// path is the .wbfs, the .wbf1, .wbf2... next to it come with it
+int wbfs_archive(archive *a, const char *path) {
+	char part_path[PARTFILE_PATH_MAX + 16];
+	u8 head[WBFS_HD_SECTOR];
+	wbfs_reader *r = (wbfs_reader*)calloc(1, sizeof(wbfs_reader));
+	int prefix = strlen(path) - 5;
+
+	memset(a, 0, sizeof(archive));
+	if (!r || prefix < 0 || prefix >= PARTFILE_PATH_MAX || strcmp(path + prefix, ".wbfs")) {
+		free(r);
+		return -1;
+	}
+	a->ctx = r;
+	a->close = wbfs_reader_close;
+	a->block = wbfs_read_block;
+	for (u64 start = 0; r->parts < WBFS_MAX_PARTS; r->parts++) {
+		sprintf(part_path, "%.*s", prefix, path);
+		wbfs_part_ext(r->parts, part_path + prefix);
+		if (!(r->fp[r->parts] = fopen(part_path, "rb"))) {
+			break;
+		}
+		r->start[r->parts] = start;
+		fseeko(r->fp[r->parts], 0, SEEK_END);
+		start += (u64)ftello(r->fp[r->parts]);
+	}
+	if (!r->parts || wbfs_get(r, head, sizeof(head), 0) || get_be32(head) != WBFS_MAGIC || !head[12]
+		|| head[8] < 9 || head[8] > 12 || head[9] < 15 || head[9] > 26) {
+		wbfs_reader_close(a);
+		return -1;
+	}
+	// the first disc's info is in the second hd sector, its block map after a copy of the disc header
+	u32 hd_sector = 1 << head[8];
+	r->shift = head[9];
+	a->block_size = 1 << r->shift;
+	u32 disc_blocks = (u32)(((u64)WBFS_WII_SECTORS * 0x8000) >> r->shift);
+	u8 *map = (u8*)malloc(disc_blocks * 2);
+	r->wlba = (u16*)calloc(disc_blocks, sizeof(u16));
+	if (!map || !r->wlba || wbfs_get(r, map, disc_blocks * 2, hd_sector + 0x100)) {
+		free(map);
+		wbfs_reader_close(a);
+		return -1;
+	}
+	for (u32 i = 0; i < disc_blocks; i++) {
+		r->wlba[i] = (map[i * 2] << 8) | map[i * 2 + 1];
+		if (r->wlba[i]) {
+			a->blocks = i + 1;
+		}
+	}
+	free(map);
+	a->size = (u64)a->blocks * a->block_size;
+	return 0;
+}
+#endif
@@ -32,6 +32,24 @@
 #include "crc32.h"
 #include "sha1.h"
 #include "md5.h"
+#include "partfile.h"
+#include "tuner.h"
+#include "ring.h"
+#include "imgsrc.h"
+#include "simdrive.h"
+#include "stripe.h"
+#include "batch.h"
+#include "progress.h"
+#include "engine.h"
+#include "sink.h"
+#include "ciso.h"
+#include "gcz.h"
+#include "rvz.h"
+#include "wbfs.h"
+#include "chd.h"
+#include "zst.h"
+#include "store.h"
+#include "delta.h"
 #ifdef __CYGWIN__
 #include <windows.h>
 #include <winioctl.h>
@@ -43,18 +61,7 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <sys/stat.h>
-typedef uint8_t u8;
-typedef uint16_t u16;
-typedef uint32_t u32;
-typedef uint64_t u64;
-typedef int8_t s8;
-typedef int16_t s16;
-typedef int32_t s32;
-typedef int64_t s64;
-typedef __uint128_t u128;
-typedef __int128_t s128;
-typedef float f32;
-typedef volatile u32 vu32;
+#include "host_ogc.h"
 
 #define IOCTL_DVD_BASE                  0x00000034
 #define IOCTL_DVD_READ_STRUCTURE        CTL_CODE(IOCTL_DVD_BASE, 0x0003, METHOD_BUFFERED, FILE_READ_ACCESS)
@@ -75,12 +82,6 @@ typedef struct _DVD_READ_STRUCTURE_LOCAL {
 } DVD_READ_STRUCTURE_LOCAL, *PDVD_READ_STRUCTURE_LOCAL;
 
 typedef u32 sec_t;
-#ifndef FALSE
-#define FALSE 0
-#endif
-#ifndef TRUE
-#define TRUE 1
-#endif
 #define ATTRIBUTE_ALIGN(x)
 
 typedef struct {
@@ -104,11 +105,6 @@ typedef struct {
     char* name;
 } ntfs_md;
 
-typedef void* mqbox_t;
-typedef pthread_t lwp_t;
-typedef void* mqmsg_t;
-
-#define MQ_MSG_BLOCK 0
 #define SYS_POWEROFF 0
 #define VI_NON_INTERLACE 0
 #define GX_CULL_NONE 0
@@ -146,6 +142,14 @@ static const DISC_INTERFACE* usb = NULL;
 #define MAX_SOURCE_DRIVES 8
 static HANDLE hSourceDrives[MAX_SOURCE_DRIVES] = {INVALID_HANDLE_VALUE, INVALID_HANDLE_VALUE, INVALID_HANDLE_VALUE, INVALID_HANDLE_VALUE, INVALID_HANDLE_VALUE, INVALID_HANDLE_VALUE, INVALID_HANDLE_VALUE, INVALID_HANDLE_VALUE};
 static int numSourceDrives = 0;
+static stripe_reader stripes;			// per drive read-ahead when several drives are open
+static int striping = 0;
+static u64 last_read_end = ~0ULL;
+static int batch_mode = 0;				// one unattended job per drive
+static int batch_hashers = 2;
+static u64 batch_write_limit = 0;		// bytes per second over all jobs
+static int batch_eject = 1;
+static batch batch_jobs;
 
 #else
 #include <gccore.h>
@@ -225,6 +229,9 @@ enum {
 	WII_NEWFILE,
 	AUTO_EJECT,
 	AUDIO_OUTPUT,
+	NGC_OUTPUT,
+	WII_OUTPUT,
+	DVD_OUTPUT,
 	MAX_OPTIONS
 };
 
@@ -237,7 +244,7 @@ enum forcedDiscProfile {
 };
 
 #define MAX_NGC_OPTIONS 4
-#define MAX_WII_OPTIONS 4
+#define MAX_WII_OPTIONS 5
 
 enum {
 	AUTO_DETECT = 0,
@@ -266,9 +273,34 @@ enum {
 	AUDIO_OUT_WAV,
 	AUDIO_OUT_WAV_FAST,
 	AUDIO_OUT_WAV_BEST,
+	AUDIO_OUT_CHD,
 	AUDIO_OUT_DELIM
 };
 
+enum {
+	NGC_OUT_ISO = 0,
+	NGC_OUT_CISO,
+	NGC_OUT_GCZ,
+	NGC_OUT_RVZ,
+	NGC_OUT_STORE,
+	NGC_OUT_DELIM
+};
+
+enum {
+	WII_OUT_ISO = 0,
+	WII_OUT_WBFS,
+	WII_OUT_STORE,
+	WII_OUT_DELIM
+};
+
+enum {
+	DVD_OUT_ISO = 0,
+	DVD_OUT_CHD,
+	DVD_OUT_ZST,
+	DVD_OUT_STORE,
+	DVD_OUT_DELIM
+};
+
 enum {
 	EJECT_NO = 0,
 	EJECT_YES,
@@ -314,11 +346,17 @@ static int selected_device = 0;
 #ifdef HW_RVL
 static int selected_source = SRC_INTERNAL_DISC;
 #endif
+static char *image_path = NULL;		// dump an image file instead of a drive
+static imgsrc image_source;
+static char *sim_path = NULL;		// dump from a simulated drive (.sim script)
+static const char *delta_path = NULL;	// write the image as its differences from this one (--delta=path)
+static simdrive sim_drive;
 static int calcChecksums = 0;
 static int dumpCounter = 0;
 static char gameName[32];
 static char internalName[512];
 static char mountPath[512];
+static char mirrorPath[512];		// a second copy of the image goes here (--mirror=dir)
 static char wpadNeedScan = 0;
 static char padNeedScan = 0;
 char txtbuffer[2048];
@@ -334,6 +372,14 @@ int options_map[MAX_OPTIONS] = { 0 };
 int newProgressDisplay = 1;
 static int forced_disc_profile = 0;
 static u32 forced_audio_sector_size = 0;
+static int headless = 0;			// no prompts, every answer comes from the command line
+static int opt_checksums = -1;		// -1 ask, 0 no, 1 yes
+static int opt_datel = -1;
+static int opt_profile = -1;		// same index as the force_disc() list
+static u32 opt_audio_sector_size = 0;
+static int opt_channels = 0;		// 0 ask
+static int opt_passes = 0;
+static vu32 writer_pending = 0;		// blocks queued on the writer
 
 static char bca_data_for_display[64] = {0};
 
@@ -691,7 +737,16 @@ static int select_source_drives() {
     return 1;
 }
 
+static void stop_striping() {
+    if (striping) {
+        stripe_stop(&stripes);
+        striping = 0;
+    }
+    last_read_end = ~0ULL;
+}
+
 int init_dvd(bool prompt) {
+    stop_striping();
     for (int i = 0; i < MAX_SOURCE_DRIVES; i++) {
         if (hSourceDrives[i] != INVALID_HANDLE_VALUE) {
             CloseHandle(hSourceDrives[i]);
@@ -725,11 +780,54 @@ int init_dvd(bool prompt) {
 }
 const char* dvd_error_str() { return "No Error"; }
 u32 dvd_get_error() { return 0; }
+
+// Plain data read from one drive, used directly and by the stripe readers
+static int drive_read(int drive, void *buf, u32 len, u64 offset) {
+    HANDLE hSourceDrive = hSourceDrives[drive];
+    if (hSourceDrive == INVALID_HANDLE_VALUE) return -1;
+
+    LARGE_INTEGER li;
+    li.QuadPart = (s64)offset;
+    if (SetFilePointer(hSourceDrive, li.LowPart, &li.HighPart, FILE_BEGIN) == INVALID_SET_FILE_POINTER && GetLastError() != NO_ERROR) return -1;
+    DWORD bytesRead;
+    if (!ReadFile(hSourceDrive, buf, len, &bytesRead, NULL) || bytesRead != len) return -1;
+    return 0;
+}
+
+// With several drives every drive reads ahead through its own stripes on a
+// thread of its own, and sequential reads are served from them in disc order.
+// Anything else (a seek, a stripe a drive failed on) stops the readers and is
+// read directly; the next sequential read starts them again.
+static int striped_read(void *buf, u32 len, u64 offset) {
+    if (striping) {
+        if (stripe_read(&stripes, buf, len, offset) == 0) {
+            last_read_end = offset + len;
+            return 0;
+        }
+        stop_striping();
+    } else if (offset == last_read_end) {
+        if (stripe_start(&stripes, numSourceDrives, drive_read, offset) == 0) {
+            striping = 1;
+            if (stripe_read(&stripes, buf, len, offset) == 0) {
+                last_read_end = offset + len;
+                return 0;
+            }
+            stop_striping();
+        }
+    }
+    int ret = drive_read((int)((offset / STRIPE_SIZE) % numSourceDrives), buf, len, offset);
+    last_read_end = ret ? ~0ULL : offset + len;
+    return ret;
+}
+
 int DVD_LowRead64(void *buf, u32 len, u128 offset) {
     if (numSourceDrives == 0) return -1;
+    if (numSourceDrives > 1 && len % 2352 != 0) {
+        return striped_read(buf, len, (u64)offset);
+    }
 
     // Stripe reads across drives based on 1MB chunks
-    int drive_idx = (int)((offset / 1048576) % numSourceDrives);
+    int drive_idx = (int)((offset / STRIPE_SIZE) % numSourceDrives);
     HANDLE hSourceDrive = hSourceDrives[drive_idx];
 
     if (hSourceDrive == INVALID_HANDLE_VALUE) return -1;
@@ -760,12 +858,7 @@ int DVD_LowRead64(void *buf, u32 len, u128 offset) {
         if (done == len) return 0;
     }
 
-    LARGE_INTEGER li;
-    li.QuadPart = (s64)offset;
-    if (SetFilePointer(hSourceDrive, li.LowPart, &li.HighPart, FILE_BEGIN) == INVALID_SET_FILE_POINTER && GetLastError() != NO_ERROR) return -1;
-    DWORD bytesRead;
-    if (!ReadFile(hSourceDrive, buf, len, &bytesRead, NULL) || bytesRead != len) return -1;
-    return 0;
+    return drive_read(drive_idx, buf, len, (u64)offset);
 }
 
 /*
@@ -795,6 +888,7 @@ int init_dvd(bool prompt) {
 */
 int DVD_LowRead64Datel(void *buf, u32 len, u128 offset, int isKnown) { return 0; }
 void dvd_motor_off(int eject) {
+    stop_striping();
     if (eject && numSourceDrives > 0) {
         for (int i = 0; i < numSourceDrives; i++) {
             if (hSourceDrives[i] != INVALID_HANDLE_VALUE) {
@@ -805,13 +899,8 @@ void dvd_motor_off(int eject) {
     }
 }
 
-int dvd_read_bca(void *buf, int bufsize) {
-#ifdef __CYGWIN__
-    printf("Attempting to read BCA/MCN...\n");
-    if (numSourceDrives == 0 || hSourceDrives[0] == INVALID_HANDLE_VALUE) return 0;
-    memset(buf, 0, bufsize);
-    int data_written = 0;
-
+// The physical BCA of the disc in one drive, 0 if it has none
+static int drive_read_bca(int drive, void *buf, int bufsize) {
     DVD_READ_STRUCTURE_LOCAL read_struct;
     memset(&read_struct, 0, sizeof(read_struct));
     read_struct.Format = DvdBcaDescriptor_Local;
@@ -820,28 +909,32 @@ int dvd_read_bca(void *buf, int bufsize) {
     UCHAR out_buf[4 + 256];
     memset(out_buf, 0, sizeof(out_buf));
     DWORD bytes_returned;
-    BOOL bca_found = FALSE;
-
-    if (DeviceIoControl(hSourceDrives[0], IOCTL_DVD_READ_STRUCTURE,
-                        &read_struct, sizeof(read_struct),
-                        out_buf, sizeof(out_buf),
-                        &bytes_returned, NULL)) {
-        if (bytes_returned >= 4) {
-            USHORT data_len = (out_buf[0] << 8) | out_buf[1];
-            if (data_len >= 2) {
-                int bca_len = data_len - 2;
-                if (bca_len > 0) {
-                    if (bca_len > bufsize) bca_len = bufsize;
-                    memcpy(buf, out_buf + 4, bca_len);
-                    data_written = bca_len;
-                    bca_found = TRUE;
-                    printf("Physical BCA found.\n");
-                }
-            }
-        }
+
+    if (hSourceDrives[drive] == INVALID_HANDLE_VALUE
+        || !DeviceIoControl(hSourceDrives[drive], IOCTL_DVD_READ_STRUCTURE,
+                            &read_struct, sizeof(read_struct),
+                            out_buf, sizeof(out_buf),
+                            &bytes_returned, NULL) || bytes_returned < 4) {
+        return 0;
     }
+    USHORT data_len = (out_buf[0] << 8) | out_buf[1];
+    int bca_len = data_len >= 2 ? data_len - 2 : 0;
+    if (bca_len > bufsize) bca_len = bufsize;
+    memcpy(buf, out_buf + 4, bca_len);
+    return bca_len;
+}
+
+int dvd_read_bca(void *buf, int bufsize) {
+#ifdef __CYGWIN__
+    printf("Attempting to read BCA/MCN...\n");
+    if (numSourceDrives == 0 || hSourceDrives[0] == INVALID_HANDLE_VALUE) return 0;
+    memset(buf, 0, bufsize);
+    int data_written = drive_read_bca(0, buf, bufsize);
 
-    if (!bca_found) {
+    if (data_written) {
+        printf("Physical BCA found.\n");
+    }
+    else {
         if (forced_disc_profile == FORCED_AUDIO_CD) {
             char* p = (char*)buf;
             int space_left = bufsize;
@@ -870,19 +963,47 @@ int dvd_read_bca(void *buf, int bufsize) {
     return 0;
 }
 
-void DrawFrameStart() { printf("\033[2J\033[1;1H"); }
+// Headless runs keep the text but not the screen: every line becomes a
+// message event (or a plain line when nobody is listening for events)
+static void headless_text(const char *string) {
+    if (progress_enabled()) {
+        progress_begin("message");
+        progress_str("text", string);
+        progress_end();
+    }
+    else {
+        printf("%s\n", string);
+    }
+}
+
+// Exit codes: 0 dumped, 1 dump failed, 2 bad arguments, 3 no usable disc
+static void headless_exit(int code, const char *reason) {
+    if (progress_enabled()) {
+        progress_begin("exit");
+        progress_num("code", code);
+        progress_str("reason", reason);
+        progress_end();
+    }
+    else {
+        fprintf(stderr, "%s\n", reason);
+    }
+    exit(code);
+}
+
+void DrawFrameStart() { if (!headless) printf("\033[2J\033[1;1H"); }
 void DrawFrameFinish() { fflush(stdout); }
 void DrawEmptyBox(int x, int y, int width, int height, u32 color) {}
-void DrawSelectableButton(int x, int y, int width, int height, char *message, int selected, int id) { printf("%s %s\n", selected ? "->" : "  ", message); }
-void DrawAButton(int x, int y) { printf("[A] "); }
-void DrawBButton(int x, int y) { printf("[B] "); }
-void WriteFont(int x, int y, char *string) { printf("%s\n", string); }
-void WriteFontStyled(int x, int y, char *string, float size, bool centered, u32 color) { printf("%s\n", string); }
-void WriteCentre(int y, char *string) { printf("%s\n", string); }
+void DrawSelectableButton(int x, int y, int width, int height, char *message, int selected, int id) { if (!headless) printf("%s %s\n", selected ? "->" : "  ", message); }
+void DrawAButton(int x, int y) { if (!headless) printf("[A] "); }
+void DrawBButton(int x, int y) { if (!headless) printf("[B] "); }
+void WriteFont(int x, int y, char *string) { if (headless) headless_text(string); else printf("%s\n", string); }
+void WriteFontStyled(int x, int y, char *string, float size, bool centered, u32 color) { if (headless) headless_text(string); else printf("%s\n", string); }
+void WriteCentre(int y, char *string) { if (headless) headless_text(string); else printf("%s\n", string); }
 void init_font() {}
 void init_textures() {}
 int DrawYesNoDialog(char *message, char *message2) { return 1; }
 void DrawProgressBar(int percent, char *message, int disc_type) {
+    if (headless) return;
     printf("Progress: [");
     for (int i = 0; i < 50; i++) {
         if (i < percent / 2) printf("=");
@@ -892,6 +1013,7 @@ void DrawProgressBar(int percent, char *message, int disc_type) {
     printf("%s\n", message);
 }
 void DrawProgressDetailed(int percent, char *message, int mb_done, int mb_total, char* discTypeStr, int showChecksums, int disc_type) {
+    if (headless) return;
     printf("Ripping %s\n", discTypeStr);
     
     int bits_to_show = (percent * 512) / 100;
@@ -923,10 +1045,11 @@ void enable_raw_mode() { if (!term_setup) { tcgetattr(0, &orig_termios); atexit(
 static u32 current_pad_buttons = 0;
 static u64 last_key_time = 0;
 
-void PAD_Init() { enable_raw_mode(); }
+void PAD_Init() { if (!headless) enable_raw_mode(); }
 u32 PAD_ButtonsDown(int pad) { return current_pad_buttons; }
 void PAD_ScanPads() {
     unsigned char c;
+    if (headless) return;
     if (read(0, &c, 1) == 1) {
         current_pad_buttons = 0;
         if (c == 27) {
@@ -1093,8 +1216,43 @@ static u32 get_forced_disc_end_sectors() {
 
 static const char *get_output_extension(int disc_type) {
 	if (disc_type == IS_OTHER_DISC && forced_disc_profile == FORCED_AUDIO_CD) {
+		if (options_map[AUDIO_OUTPUT] == AUDIO_OUT_CHD) {
+			return ".chd";
+		}
 		return (options_map[AUDIO_OUTPUT] == AUDIO_OUT_WAV || options_map[AUDIO_OUTPUT] == AUDIO_OUT_WAV_FAST || options_map[AUDIO_OUTPUT] == AUDIO_OUT_WAV_BEST) ? ".wav" : ".bin";
 	}
+	if (delta_path) {
+		return ".dlt";
+	}
+	if (disc_type == IS_NGC_DISC || disc_type == IS_DATEL_DISC) {
+		if (options_map[NGC_OUTPUT] == NGC_OUT_CISO) {
+			return ".ciso";
+		}
+		if (options_map[NGC_OUTPUT] == NGC_OUT_GCZ) {
+			return ".gcz";
+		}
+		if (options_map[NGC_OUTPUT] == NGC_OUT_RVZ) {
+			return ".rvz";
+		}
+		if (options_map[NGC_OUTPUT] == NGC_OUT_STORE) {
+			return ".rcp";
+		}
+	}
+	if (disc_type == IS_WII_DISC && options_map[WII_OUTPUT] == WII_OUT_WBFS) {
+		return ".wbfs";
+	}
+	if (disc_type == IS_WII_DISC && options_map[WII_OUTPUT] == WII_OUT_STORE) {
+		return ".rcp";
+	}
+	if (disc_type == IS_OTHER_DISC && options_map[DVD_OUTPUT] == DVD_OUT_CHD) {
+		return ".chd";
+	}
+	if (disc_type == IS_OTHER_DISC && options_map[DVD_OUTPUT] == DVD_OUT_ZST) {
+		return ".zst";
+	}
+	if (disc_type == IS_OTHER_DISC && options_map[DVD_OUTPUT] == DVD_OUT_STORE) {
+		return ".rcp";
+	}
 	return ".iso";
 }
 
@@ -1136,7 +1294,7 @@ static u32 detect_audio_cd_size_sectors(u32 sector_size) {
 }
 
 enum {
-	MSG_SETFILE,
+	MSG_SETSINK,
 	MSG_WRITE,
 	MSG_FLUSH,
 };
@@ -1147,33 +1305,36 @@ typedef union _writer_msg {
 		void* data;
 		u32 length;
 		mqbox_t ret_box;
+		u64 offset;
 	};
 	uint8_t pad[32]; // pad to 32 bytes for alignment
 } writer_msg;
 
 static void* writer_thread(void* _msgq) {
-	FILE* fp = NULL;
+	sink* out = NULL;
 	mqbox_t msgq = (mqbox_t)_msgq;
 	writer_msg* msg;
 
 	// stupid libogc returns TRUE even if the message queue gets destroyed while waiting
 	while (MQ_Receive(msgq, (mqmsg_t*)&msg, MQ_MSG_BLOCK)==TRUE && msg) {
 		switch (msg->command) {
-			case MSG_SETFILE:
-				fp = (FILE*)msg->data;
+			case MSG_SETSINK:
+				out = (sink*)msg->data;
 				break;
 			case MSG_WRITE:
-				if(selected_device != TYPE_READONLY) {
-					if (fp && fwrite(msg->data, msg->length, 1, fp)!=1) {
-						// write error, signal it by pushing a NULL message to the front
-						MQ_Jam(msg->ret_box, (mqmsg_t)NULL, MQ_MSG_BLOCK);
-						return NULL;
-					}
+				if (sink_write(out, msg->data, msg->length, msg->offset)) {
+					// write error, signal it by pushing a NULL message to the front
+					MQ_Jam(msg->ret_box, (mqmsg_t)NULL, MQ_MSG_BLOCK);
+					return NULL;
 				}
 				// release the block so it can be reused
+				__sync_sub_and_fetch(&writer_pending, 1);
 				MQ_Send(msg->ret_box, (mqmsg_t)msg, MQ_MSG_BLOCK);
 				break;
 			case MSG_FLUSH:
+				if (out) {
+					sink_flush(out);
+				}
 				*(vu32*)msg->data = 1;
 				break;
 		}
@@ -1324,6 +1485,9 @@ u32 get_buttons_pressed() {
 }
 
 void wait_press_A(char* text) {
+#ifdef __CYGWIN__
+	if (headless) return;
+#endif
 	// Draw the A button
 	WriteFont(210, 315, "Press");
 	DrawAButton(285, 310);
@@ -1334,6 +1498,9 @@ void wait_press_A(char* text) {
 }
 
 void wait_press_A_exit_B(bool tryAgain) {
+#ifdef __CYGWIN__
+	if (headless) return;
+#endif
 	// Draw the A and B buttons
 	DrawAButton(195, 310);
 	DrawBButton(390, 310);
@@ -1549,6 +1716,8 @@ if (!args_provided) {
                 if (btns & PAD_BUTTON_B) exit(0);
                 usleep(100000);
             }
+        } else if (headless) {
+            return ret;
         } else {
             printf("No disc detected in specified drives. Retrying in 5 seconds...\n");
             sleep(5);
@@ -1558,8 +1727,81 @@ if (!args_provided) {
 	return ret;
 }
 
+/* Open the image file or simulated drive in place of the drives */
+static int initialise_file_source() {
+	if (sim_path) {
+		simdrive_close(&sim_drive);
+		if (simdrive_open(&sim_drive, sim_path)) {
+			printf("Failed to load drive script %s\n", sim_path);
+			return NO_DISC;
+		}
+		printf("Simulated drive: %s (%u sectors)\n", sim_path, simdrive_sectors(&sim_drive));
+		return 0;
+	}
+	imgsrc_close(&image_source);
+	if (imgsrc_open(&image_source, image_path)) {
+		printf("Failed to open image %s\n", image_path);
+		return NO_DISC;
+	}
+	printf("Image source: %s (%i part(s), %u byte sectors)\n",
+		image_path, image_source.parts, image_source.file_sector);
+	return 0;
+}
+
+static u32 file_sector_size = 2048;
+
+static int read_image(void* dst, u32 len, u64 offset, int isKnownDatel) {
+	return imgsrc_read(&image_source, dst, len, offset, file_sector_size);
+}
+
+static int read_sim(void* dst, u32 len, u64 offset, int isKnownDatel) {
+	return simdrive_read(&sim_drive, dst, len, offset, file_sector_size);
+}
+
+static int read_dvd(void* dst, u32 len, u64 offset, int isKnownDatel) {
+	return DVD_LowRead64(dst, len, offset);
+}
+
+static int read_dvd_datel(void* dst, u32 len, u64 offset, int isKnownDatel) {
+	return DVD_LowRead64Datel(dst, len, offset, isKnownDatel);
+}
+
+#ifdef HW_RVL
+static int read_usb(void* dst, u32 len, u64 offset, int isKnownDatel) {
+	if ((offset & 0x1FF) || (len & 0x1FF)) {
+		return 1;
+	}
+	return usb->readSectors((sec_t)(offset >> 9), (sec_t)(len >> 9), dst) ? 0 : 1;
+}
+#endif
+
+/* Picks the read for this disc from the selected source, the dump engine
+   then calls it for every block without looking at the disc type again */
+static engine_read_fn select_source_read(int disc_type) {
+	file_sector_size = (disc_type == IS_OTHER_DISC) ? get_forced_disc_sector_size() : 2048;
+	if (sim_path) {
+		return read_sim;
+	}
+	if (image_path) {
+		return read_image;
+	}
+#ifdef HW_RVL
+	if (selected_source == SRC_USB_DRIVE) {
+		return read_usb;
+	}
+#endif
+	return (disc_type == IS_DATEL_DISC) ? read_dvd_datel : read_dvd;
+}
+
+static int source_read(void* dst, u32 len, u128 offset, int disc_type, int isKnownDatel) {
+	return select_source_read(disc_type)(dst, len, (u64)offset, isKnownDatel);
+}
+
 #ifdef HW_RVL
 static int initialise_source(bool args_provided) {
+	if (image_path || sim_path) {
+		return initialise_file_source();
+	}
 	if (selected_source == SRC_USB_DRIVE) {
 		DrawFrameStart();
 		DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
@@ -1575,29 +1817,12 @@ static int initialise_source(bool args_provided) {
 	}
 	return initialise_dvd(args_provided);
 }
-
-static int source_read(void* dst, u32 len, u128 offset, int disc_type, int isKnownDatel) {
-	if (selected_source == SRC_USB_DRIVE) {
-		if ((offset & 0x1FF) || (len & 0x1FF)) {
-			return 1;
-		}
-		return usb->readSectors((sec_t)(offset >> 9), (sec_t)(len >> 9), dst) ? 0 : 1;
-	}
-	if (disc_type == IS_DATEL_DISC) {
-		return DVD_LowRead64Datel(dst, len, offset, isKnownDatel);
-	}
-	return DVD_LowRead64(dst, len, offset);
-}
 #else
 static int initialise_source(bool args_provided) {
-	return initialise_dvd(args_provided);
-}
-
-static int source_read(void* dst, u32 len, u128 offset, int disc_type, int isKnownDatel) {
-	if (disc_type == IS_DATEL_DISC) {
-		return DVD_LowRead64Datel(dst, len, offset, isKnownDatel);
+	if (image_path || sim_path) {
+		return initialise_file_source();
 	}
-	return DVD_LowRead64(dst, len, offset);
+	return initialise_dvd(args_provided);
 }
 #endif
 
@@ -1725,6 +1950,10 @@ static int initialise_device(int fs) {
 
 #ifdef __CYGWIN__
     if (selected_device != TYPE_READONLY) {
+        if (mountPath[0]) {
+            // output path was given on the command line
+            return 1;
+        }
         if (select_drive()) {
             sprintf(mountPath, "%c:/", selected_drive_letter - 32);
             return 1;
@@ -1892,6 +2121,8 @@ const char* const get_game_name() {
 	return gameName;
 }
 
+static int set_forced_disc(int type);
+
 /* the user must specify the disc type */
 static int force_disc() {
 	static const char *forcedTypeNames[] = {
@@ -1929,6 +2160,11 @@ static int force_disc() {
 	}
 	while ((get_buttons_pressed() & PAD_BUTTON_A))
 		;
+	return set_forced_disc(type);
+}
+
+/* apply an entry of the force_disc() list */
+static int set_forced_disc(int type) {
 	forced_disc_profile = FORCED_DISC_NONE;
 	forced_audio_sector_size = 0;
 	if (type == 0) {
@@ -2140,9 +2376,44 @@ char *getAudioOutputOption() {
 		return "WAV (fast)";
 	else if (opt == AUDIO_OUT_WAV_BEST)
 		return "WAV (best)";
+	else if (opt == AUDIO_OUT_CHD)
+		return "CHD";
 	return 0;
 }
 
+char *getNgcOutputOption() {
+	int opt = options_map[NGC_OUTPUT];
+	if (opt == NGC_OUT_CISO)
+		return "CISO";
+	else if (opt == NGC_OUT_GCZ)
+		return "GCZ";
+	else if (opt == NGC_OUT_RVZ)
+		return "RVZ";
+	else if (opt == NGC_OUT_STORE)
+		return "Store";
+	return "ISO";
+}
+
+char *getWiiOutputOption() {
+	int opt = options_map[WII_OUTPUT];
+	if (opt == WII_OUT_WBFS)
+		return "WBFS";
+	if (opt == WII_OUT_STORE)
+		return "Store";
+	return "ISO";
+}
+
+char *getDvdOutputOption() {
+	int opt = options_map[DVD_OUTPUT];
+	if (opt == DVD_OUT_CHD)
+		return "CHD";
+	if (opt == DVD_OUT_ZST)
+		return "ZST";
+	if (opt == DVD_OUT_STORE)
+		return "Store";
+	return "ISO";
+}
+
 char *getAutoEjectOption() {
 	int opt = options_map[AUTO_EJECT];
 	if (opt == EJECT_YES)
@@ -2162,6 +2433,12 @@ int getMaxPos(int option_pos) {
 		return AUDIO_OUT_DELIM;
 	case AUTO_EJECT:
 		return EJECT_DELIM;
+	case NGC_OUTPUT:
+		return NGC_OUT_DELIM;
+	case WII_OUTPUT:
+		return WII_OUT_DELIM;
+	case DVD_OUTPUT:
+		return DVD_OUT_DELIM;
 	}
 	return 0;
 }
@@ -2185,11 +2462,12 @@ static void get_settings(int disc_type) {
 		maxSettingPos = MAX_WII_OPTIONS - 1;
 	}
 	else if (disc_type == IS_OTHER_DISC) {
-		// For forced non-Nintendo profiles expose chunking + audio output mode.
-		maxSettingPos = (forced_disc_profile == FORCED_AUDIO_CD) ? 3 : 2;
+		// For forced non-Nintendo profiles expose chunking + audio output mode (or the output format).
+		maxSettingPos = 3;
 	}
 	else {
-		maxSettingPos = MAX_NGC_OPTIONS - 1;
+		// Gamecube only picks the output format
+		maxSettingPos = 0;
 	}
 
 	while ((get_buttons_pressed() & PAD_BUTTON_A));
@@ -2210,6 +2488,8 @@ static void get_settings(int disc_type) {
 			DrawSelectableButton(vmode->fbWidth - 220, 160 + (32 * 3), -1, 160 + (32 * 3) + 30, getNewFileOption(), (currentSettingPos == 2) ? B_SELECTED : B_NOSELECT, -1);
 			WriteFont(80, 160 + (32 * 4), "Auto Eject");
 			DrawSelectableButton(vmode->fbWidth - 220, 160 + (32 * 4), -1, 160 + (32 * 4) + 30, getAutoEjectOption(), (currentSettingPos == 3) ? B_SELECTED : B_NOSELECT, -1);
+			WriteFont(80, 160 + (32 * 5), "Output Format");
+			DrawSelectableButton(vmode->fbWidth - 220, 160 + (32 * 5), -1, 160 + (32 * 5) + 30, getWiiOutputOption(), (currentSettingPos == 4) ? B_SELECTED : B_NOSELECT, -1);
 		}
 		else if (disc_type == IS_OTHER_DISC) {
 			WriteFont(80, 160 + (32 * 1), "Chunk Size");
@@ -2222,6 +2502,14 @@ static void get_settings(int disc_type) {
 				WriteFont(80, 160 + (32 * 4), "Audio Output");
 				DrawSelectableButton(vmode->fbWidth - 220, 160 + (32 * 4), -1, 160 + (32 * 4) + 30, getAudioOutputOption(), (currentSettingPos == 3) ? B_SELECTED : B_NOSELECT, -1);
 			}
+			else {
+				WriteFont(80, 160 + (32 * 4), "Output Format");
+				DrawSelectableButton(vmode->fbWidth - 220, 160 + (32 * 4), -1, 160 + (32 * 4) + 30, getDvdOutputOption(), (currentSettingPos == 3) ? B_SELECTED : B_NOSELECT, -1);
+			}
+		}
+		else {
+			WriteFont(80, 160 + (32 * 1), "Output Format");
+			DrawSelectableButton(vmode->fbWidth - 220, 160 + (32 * 1), -1, 160 + (32 * 1) + 30, getNgcOutputOption(), B_SELECTED, -1);
 		}
 		WriteCentre(370,"Press  A  to continue");
 		DrawAButton(265,360);
@@ -2235,9 +2523,15 @@ static void get_settings(int disc_type) {
 				if (forced_disc_profile == FORCED_AUDIO_CD) {
 					optionPos = (currentSettingPos == 0) ? WII_CHUNK_SIZE : (currentSettingPos == 1 ? WII_NEWFILE : (currentSettingPos == 2 ? AUTO_EJECT : AUDIO_OUTPUT));
 				} else {
-					optionPos = (currentSettingPos == 0) ? WII_CHUNK_SIZE : (currentSettingPos == 1 ? WII_NEWFILE : AUTO_EJECT);
+					optionPos = (currentSettingPos == 0) ? WII_CHUNK_SIZE : (currentSettingPos == 1 ? WII_NEWFILE : (currentSettingPos == 2 ? AUTO_EJECT : DVD_OUTPUT));
 				}
 			}
+			else if (disc_type != IS_WII_DISC) {
+				optionPos = NGC_OUTPUT;
+			}
+			else if (currentSettingPos == 4) {
+				optionPos = WII_OUTPUT;
+			}
 			toggleOption(optionPos, 1);
 		}
 		if(btns & PAD_BUTTON_LEFT) {
@@ -2246,9 +2540,15 @@ static void get_settings(int disc_type) {
 				if (forced_disc_profile == FORCED_AUDIO_CD) {
 					optionPos = (currentSettingPos == 0) ? WII_CHUNK_SIZE : (currentSettingPos == 1 ? WII_NEWFILE : (currentSettingPos == 2 ? AUTO_EJECT : AUDIO_OUTPUT));
 				} else {
-					optionPos = (currentSettingPos == 0) ? WII_CHUNK_SIZE : (currentSettingPos == 1 ? WII_NEWFILE : AUTO_EJECT);
+					optionPos = (currentSettingPos == 0) ? WII_CHUNK_SIZE : (currentSettingPos == 1 ? WII_NEWFILE : (currentSettingPos == 2 ? AUTO_EJECT : DVD_OUTPUT));
 				}
 			}
+			else if (disc_type != IS_WII_DISC) {
+				optionPos = NGC_OUTPUT;
+			}
+			else if (currentSettingPos == 4) {
+				optionPos = WII_OUTPUT;
+			}
 			toggleOption(optionPos, -1);
 		}
 		if(btns & PAD_BUTTON_UP) {
@@ -2265,9 +2565,10 @@ static void get_settings(int disc_type) {
 	while(get_buttons_pressed() & PAD_BUTTON_B);
 }
 
-void prompt_new_file(FILE **fp, int chunk, int fs, int silent, int disc_type) {
+// The next chunk starts at origin in the image
+void prompt_new_file(sink *out, int chunk, u64 origin, int fs, int silent, int disc_type) {
 	// Close the file and unmount the fs
-	fclose(*fp);
+	sink_close(out);
 #ifndef __CYGWIN__
 	if(silent == ASK_USER) {
 		if (fs == TYPE_FAT) {
@@ -2367,11 +2668,9 @@ void prompt_new_file(FILE **fp, int chunk, int fs, int silent, int disc_type) {
 	}
 #endif
 
-	*fp = NULL;
 	sprintf(txtbuffer, "%s%s.part%i%s", &mountPath[0], &gameName[0], chunk, get_output_extension(disc_type));
 	remove(&txtbuffer[0]);
-	*fp = fopen(&txtbuffer[0], "wb");
-	if (*fp == NULL) {
+	if (sink_file_open(out, &txtbuffer[0], origin)) {
 		DrawFrameStart();
 		DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
 		WriteCentre(230, "Failed to create file:");
@@ -2389,33 +2688,20 @@ void prompt_new_file(FILE **fp, int chunk, int fs, int silent, int disc_type) {
 }
  
 #define BCA_DUMP_SIZE 2048
-void dump_bca() {
-	printf("dumping bca to %s%s.bca\n", &mountPath[0], &gameName[0]);
-    fflush(stdout);
-	char bca_data[BCA_DUMP_SIZE];
-	memset(bca_data, 0, sizeof(bca_data));
-	int bca_len = dvd_read_bca(bca_data, sizeof(bca_data));
-	memcpy(bca_data_for_display, bca_data, sizeof(bca_data_for_display));
-
-	if (bca_len > 0) {
-		int is_empty = 1;
-		for(int i=0; i<bca_len; i++) if(bca_data[i]) { is_empty = 0; break; }
-		if(is_empty) printf("Warning: BCA data is all zeros.\n");
-	} else {
-		printf("Warning: BCA data is empty.\n");
-	}
-
-	sprintf(txtbuffer, "%s%s.bca", &mountPath[0], &gameName[0]);
-	FILE *fp = fopen(&txtbuffer[0], "wb");
+static void write_bca(const char *mount, const char *name, const char *bca_data, int bca_len) {
+	char path[1024];
+	printf("dumping bca to %s%s.bca\n", mount, name);
+	snprintf(path, sizeof(path), "%s%s.bca", mount, name);
+	FILE *fp = fopen(path, "wb");
 	if (fp) {
 		fwrite(bca_data, 1, bca_len, fp);
 		fclose(fp);
 	} else {
-		printf("Error creating BCA file: %s (%s)\n", txtbuffer, strerror(errno));
+		printf("Error creating BCA file: %s (%s)\n", path, strerror(errno));
 	}
 
-	sprintf(txtbuffer, "%s%s.bca.txt", &mountPath[0], &gameName[0]);
-	fp = fopen(txtbuffer, "w");
+	snprintf(path, sizeof(path), "%s%s.bca.txt", mount, name);
+	fp = fopen(path, "w");
 	if (fp) {
 		for (int i = 0; i < bca_len; i++) {
 			for (int b = 7; b >= 0; b--) {
@@ -2424,11 +2710,41 @@ void dump_bca() {
 		}
 		fclose(fp);
 	} else {
-		printf("Error creating BCA text file: %s (%s)\n", txtbuffer, strerror(errno));
+		printf("Error creating BCA text file: %s (%s)\n", path, strerror(errno));
 	}
 	fflush(stdout);
 }
 
+// The BCA is read once and written next to each copy of the image, mirror may be NULL
+void dump_bca(const char *mirror) {
+	char bca_data[BCA_DUMP_SIZE];
+	memset(bca_data, 0, sizeof(bca_data));
+	int bca_len = 0;
+	if (image_path || sim_path) {
+		imgsrc *img = !sim_path ? &image_source : (sim_drive.has_image ? &sim_drive.image : NULL);
+		if (img) {
+			bca_len = imgsrc_read_bca(img, bca_data, sizeof(bca_data));
+		}
+	}
+	else {
+		bca_len = dvd_read_bca(bca_data, sizeof(bca_data));
+	}
+	memcpy(bca_data_for_display, bca_data, sizeof(bca_data_for_display));
+
+	if (bca_len > 0) {
+		int is_empty = 1;
+		for(int i=0; i<bca_len; i++) if(bca_data[i]) { is_empty = 0; break; }
+		if(is_empty) printf("Warning: BCA data is all zeros.\n");
+	} else {
+		printf("Warning: BCA data is empty.\n");
+	}
+
+	write_bca(&mountPath[0], &gameName[0], bca_data, bca_len);
+	if (mirror) {
+		write_bca(mirror, &gameName[0], bca_data, bca_len);
+	}
+}
+
 static void write_le32(FILE *fp, u32 value) {
 	fputc((int)(value & 0xFF), fp);
 	fputc((int)((value >> 8) & 0xFF), fp);
@@ -2491,19 +2807,19 @@ void write_wav_header(FILE *fp, u64 data_size, int channels, int sample_rate) {
 	}
 }
 
-void dump_audio_cue(const char *audioFileName, int isWave, const char *baseName) {
+void dump_audio_cue(const char *mount, const char *audioFileName, int isWave, const char *baseName) {
 	if (selected_device == TYPE_READONLY || !audioFileName) {
 		return;
 	}
 
-	sprintf(txtbuffer, "%s%s.cue", mountPath, baseName);
+	sprintf(txtbuffer, "%s%s.cue", mount, baseName);
 	printf("\n*** Attempting to write CUE to %s ***\n", txtbuffer);
     fflush(stdout);
 	remove(txtbuffer);
 	FILE *fp = fopen(txtbuffer, "wb");
 	if (!fp) {
 		printf("Error opening CUE file: %s\n", strerror(errno));
-        printf("MountPath: %s, BaseName: %s\n", mountPath, baseName);
+        printf("MountPath: %s, BaseName: %s\n", mount, baseName);
 		return;
 	}
 
@@ -2579,13 +2895,12 @@ void dump_audio_cue(const char *audioFileName, int isWave, const char *baseName)
 }
 
 
-void dump_info(char *md5, char *sha1, u32 crc32, int verified, u32 seconds, char* name) {
-	if(selected_device == TYPE_READONLY) {
-		return;
-	}
-	
+// The dumpinfo of one image, file names it (the game name when NULL)
+static void write_dumpinfo(const char *mount, const char *file, const char *game, const char *internal, int version,
+                           const char *md5, const char *sha1, u32 crc32, int verified, u32 seconds) {
 	char infoLine[1024];
 	char timeLine[256];
+	char path[1024];
 	memset(infoLine, 0, 1024);
 	memset(timeLine, 0, 256);
 	time_t curtime;
@@ -2593,36 +2908,38 @@ void dump_info(char *md5, char *sha1, u32 crc32, int verified, u32 seconds, char
 	strftime(timeLine, sizeof(timeLine), "%Y-%m-%d %H:%M:%S", localtime(&curtime));
 
 	if(md5 && sha1 && crc32) {
-		sprintf(infoLine, "--File Generated by CleanRip v%i.%i.%i--"
+		snprintf(infoLine, sizeof(infoLine), "--File Generated by CleanRip v%i.%i.%i--"
 						  "\r\n\r\nFilename: %s\r\nInternal Name: %s\r\nMD5: %s\r\n"
 						  "SHA-1: %s\r\nCRC32: %08X\r\nVersion: 1.0%i\r\nVerified: %s\r\nDuration: %u min. %u sec\r\nDumped at: %s.\r\n",
-				V_MAJOR,V_MID,V_MINOR,&gameName[0],&internalName[0], md5, sha1, crc32, *(u8*)0x80000007,
+				V_MAJOR,V_MID,V_MINOR,game,internal, md5, sha1, crc32, version,
 				verified ? "Yes" : "No", seconds/60, seconds%60, timeLine);
 	}
 	else {
-		sprintf(infoLine, "--File Generated by CleanRip v%i.%i.%i--"
+		snprintf(infoLine, sizeof(infoLine), "--File Generated by CleanRip v%i.%i.%i--"
 						  "\r\n\r\nFilename: %s\r\nInternal Name: %s\r\n"
 						  "CRC32: %08X\r\nVersion: 1.0%i\r\nVerified: %s\r\nDuration: %u min. %u sec\r\nDumped at: %s.\r\n"
 						  "\r\n-- DO NOT USE THIS FOR REDUMP SUBMISSIONS, ENABLE CHECKSUM CALCULATIONS FOR THAT!",
-				V_MAJOR,V_MID,V_MINOR,&gameName[0],&internalName[0], crc32, *(u8*)0x80000007,
+				V_MAJOR,V_MID,V_MINOR,game,internal, crc32, version,
 				verified ? "Yes" : "No", seconds/60, seconds%60, timeLine);
 	}
 
-	if (name != NULL) {
-		sprintf(txtbuffer, "%s%s-dumpinfo.txt", &mountPath[0], &name[0]);
-	}
-	else {
-		sprintf(txtbuffer, "%s%s-dumpinfo.txt", &mountPath[0], &gameName[0]);
-	}
-	
-	remove(&txtbuffer[0]);
-	FILE *fp = fopen(txtbuffer, "wb");
+	snprintf(path, sizeof(path), "%s%s-dumpinfo.txt", mount, file ? file : game);
+	remove(path);
+	FILE *fp = fopen(path, "wb");
 	if (fp) {
 		fwrite(infoLine, 1, strlen(&infoLine[0]), fp);
 		fclose(fp);
 	}
 }
 
+void dump_info(const char *mount, char *md5, char *sha1, u32 crc32, int verified, u32 seconds, char* name) {
+	if(selected_device == TYPE_READONLY) {
+		return;
+	}
+	write_dumpinfo(mount, name, &gameName[0], &internalName[0], *(u8*)0x80000007,
+	               md5, sha1, crc32, verified, seconds);
+}
+
 void renameFile(const char* mountPath, const char* befor, const char* after, const char* base) {
 	char tempstr[2048];
 
@@ -2788,24 +3105,161 @@ static int select_rip_passes() {
     return passes;
 }
 
+static int engine_profile(int disc_type) {
+	switch (disc_type) {
+	case IS_NGC_DISC:
+		return PROFILE_GAMECUBE;
+	case IS_WII_DISC:
+		return PROFILE_WII;
+	case IS_DATEL_DISC:
+		return PROFILE_DATEL;
+	default:
+		return (forced_disc_profile == FORCED_AUDIO_CD) ? PROFILE_AUDIO_CD : PROFILE_DVD_VIDEO;
+	}
+}
+
+// The first MB of a Datel disc was read, tell the user what it is
+static int datel_check(u32 crc100000) {
+	int isKnownDatel = datel_findCrcSum(crc100000);
+	DrawFrameStart();
+	DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
+	if(!isKnownDatel) {
+		WriteCentre(215, "(Warning: This disc will take a while to dump!)");
+	}
+	sprintf(txtbuffer, "%s CRC100000=%08X", (isKnownDatel ? "Known":"Unknown"), crc100000);
+	WriteCentre(255, txtbuffer);
+	wait_press_A_exit_B(false);
+	return isKnownDatel;
+}
+
+// One place a copy of the dump is written to
+typedef struct {
+	sink file;
+	sink wav;
+	sink wbfs;
+	partfile parts;
+} output;
+
+static int is_compressed(const char *ext) {
+	return !strcmp(ext, ".ciso") || !strcmp(ext, ".gcz") || !strcmp(ext, ".rvz") || !strcmp(ext, ".chd")
+		|| !strcmp(ext, ".zst") || !strcmp(ext, ".rcp") || !strcmp(ext, ".dlt");
+}
+
+// An audio CD's CHD is cut into the tracks in the drive's TOC, with none it is one audio track
+static int open_chd(sink *stage, sink *next, u64 total_bytes) {
+	chd_track tracks[CHD_MAX_TRACKS];
+	int count = 0;
+
+	if (forced_disc_profile != FORCED_AUDIO_CD) {
+		return sink_chd_dvd(stage, next, total_bytes);
+	}
+	if (!image_path && !sim_path && numSourceDrives > 0 && hSourceDrives[0] != INVALID_HANDLE_VALUE) {
+		CDROM_TOC_LOCAL toc;
+		DWORD bytesReturned;
+		if (DeviceIoControl(hSourceDrives[0], IOCTL_CDROM_READ_TOC_LOCAL, NULL, 0, &toc, sizeof(toc), &bytesReturned, NULL)) {
+			for (int i = toc.FirstTrack; i <= toc.LastTrack && count < CHD_MAX_TRACKS; i++) {
+				TRACK_DATA_LOCAL *tr = &toc.TrackData[i - toc.FirstTrack];
+				u32 frames = (tr->Address[1] * 60 + tr->Address[2]) * 75 + tr->Address[3];
+				// the dump starts at 00:02:00
+				tracks[count].start = frames >= 150 ? frames - 150 : 0;
+				tracks[count].data = (tr->Control & 4) != 0;
+				count++;
+			}
+		}
+	}
+	return sink_chd_cd(stage, next, tracks, count, total_bytes);
+}
+
+// The format's stage goes in front of every copy, so a block is only compressed once.
+// A store is in the directory under mount, on failure its path or the reference's is in txtbuffer
+static int open_format(sink *stage, sink **root, const char *ext, u64 total_bytes, const char *mount, int disc_type) {
+	int open_failed = 0;
+	if (!strcmp(ext, ".ciso")) {
+		open_failed = sink_ciso(stage, *root, CISO_BLOCK_SIZE);
+	}
+	else if (!strcmp(ext, ".gcz")) {
+		open_failed = sink_gcz(stage, *root, total_bytes);
+	}
+	else if (!strcmp(ext, ".rvz")) {
+		open_failed = sink_rvz(stage, *root, total_bytes);
+	}
+	else if (!strcmp(ext, ".chd")) {
+		open_failed = open_chd(stage, *root, total_bytes);
+	}
+	else if (!strcmp(ext, ".zst")) {
+		open_failed = sink_zst(stage, *root, total_bytes);
+	}
+	else if (!strcmp(ext, ".rcp")) {
+		// Wii partitions are encrypted, so only the same data at the same place dedups anyway
+		sprintf(txtbuffer, "%s%s", mount, STORE_DIR);
+		open_failed = sink_store(stage, *root, txtbuffer, disc_type == IS_WII_DISC ? STORE_CHUNK_FIXED : STORE_CHUNK_CDC);
+	}
+	else if (!strcmp(ext, ".dlt")) {
+		// the reference is hashed through here, before the first block comes
+		sprintf(txtbuffer, "%s", delta_path);
+		open_failed = sink_delta(stage, *root, delta_path);
+	}
+	if (!open_failed) {
+		*root = stage;
+	}
+	return open_failed;
+}
+
+// Opens the image under mount, *root is what the blocks for it go to. On failure the path is in txtbuffer
+static int open_output(output *o, sink **root, const char *mount, const char *ext, int auto_split, int chunked,
+					   u64 part_size, u64 total_bytes, int multipass, int wav_channels, int sample_rate, u64 wbfs_split) {
+	int open_failed;
+
+	*root = &o->file;
+	if (auto_split) {
+		// parts are sector aligned so every one but the last is exactly the chunk size
+		sprintf(txtbuffer, "%s%s", mount, &gameName[0]);
+		open_failed = partfile_open(&o->parts, txtbuffer, ext, part_size, total_bytes);
+		partfile_path(&o->parts, 0, txtbuffer);
+		sink_split(&o->file, &o->parts);
+	}
+	else {
+		if (multipass) {
+			// For multi-pass, we write to temp files first
+			sprintf(txtbuffer, "%s%s.pass0.tmp", mount, gameName);
+		} else if (chunked) {
+			sprintf(txtbuffer, "%s%s.part0%s", mount, &gameName[0], ext);
+		} else {
+			sprintf(txtbuffer, "%s%s%s", mount, &gameName[0], ext);
+		}
+		remove(txtbuffer);
+		open_failed = sink_file_open(&o->file, txtbuffer, 0);
+	}
+	if (!open_failed && wav_channels) {
+		// the header gets its size when the sink is closed
+		open_failed = sink_wav(&o->wav, &o->file, wav_channels, sample_rate);
+		*root = &o->wav;
+	}
+	if (!open_failed && !strcmp(ext, ".wbfs")) {
+		// the stage opens the .wbf1... after the first file itself
+		sprintf(txtbuffer, "%s%s", mount, &gameName[0]);
+		open_failed = sink_wbfs(&o->wbfs, &o->file, txtbuffer, wbfs_split);
+		*root = &o->wbfs;
+	}
+	return open_failed;
+}
+
 int dump_game(int disc_type, int fs) {
 
 	isDumping = 1;
-	md5_state_t state;
-	md5_byte_t digest[16];
-	SHA1Context sha;
-	u32 crc32 = 0;
-	u32 crc100000 = 0;
-	char *buffer;
+	dump_engine engine;
+	engine_ops ops;
+	block_ring ring;
+	tuner tune;
 	mqbox_t msgq, blockq;
 	lwp_t writer;
 	writer_msg *wmsg;
 	writer_msg msg;
-	int i;
 	const char *output_ext = get_output_extension(disc_type);
 
-	MQ_Init(&blockq, MSG_COUNT);
-	MQ_Init(&msgq, MSG_COUNT);
+	// room for the deepest pipeline the tuner may try
+	MQ_Init(&blockq, RING_MAX_BLOCKS);
+	MQ_Init(&msgq, RING_MAX_BLOCKS);
 
 	// since libogc is too shitty to be able to get the current thread priority, just force it to a known value
 	LWP_SetThreadPriority(pthread_self(), THREAD_PRIO);
@@ -2818,22 +3272,8 @@ int dump_game(int disc_type, int fs) {
 
 	int is_audio_profile = (disc_type == IS_OTHER_DISC && forced_disc_profile == FORCED_AUDIO_CD);
 
-	// For audio CDs, generate the CUE sheet before ripping starts.
-	if (is_audio_profile && selected_device != TYPE_READONLY) {
-		char final_audio_filename[512];
-		// No redump verification for audio, so base name is always gameName.
-		const char* base_name = gameName;
-		sprintf(final_audio_filename, "%s%s", base_name, output_ext);
-		int isWave = (strcmp(output_ext, ".wav") == 0);
-		dump_audio_cue(final_audio_filename, isWave, base_name);
-	}
-
-	// Dump the BCA (or MCN for Audio CDs)
-	if(selected_device != TYPE_READONLY) {
-		dump_bca();
-	}
-
-	if (is_audio_profile && forced_audio_sector_size == 0) {
+	// a CHD is cut into raw CD frames
+	if (is_audio_profile && (forced_audio_sector_size == 0 || !strcmp(output_ext, ".chd"))) {
 		forced_audio_sector_size = 2352;
 	}
 	u32 sector_size = (disc_type == IS_OTHER_DISC) ? get_forced_disc_sector_size() : 2048;
@@ -2846,7 +3286,9 @@ int dump_game(int disc_type, int fs) {
 	if (read_sectors == 0) {
 		read_sectors = 1;
 	}
-	u32 max_read_size = read_sectors * sector_size;
+	// Datel reads are checked at fixed offsets, keep them as they are
+	tuner_init(&tune, sector_size, read_sectors * sector_size, MSG_COUNT, disc_type != IS_DATEL_DISC);
+	u32 max_read_size = tuner_max_size(&tune);
 	u128 one_gigabyte_bytes = (u128)ONE_GIGABYTE * 2048;
 
 	u32 startLBA = 0;
@@ -2859,6 +3301,13 @@ int dump_game(int disc_type, int fs) {
 	if (disc_type == IS_OTHER_DISC && forced_disc_profile == FORCED_AUDIO_CD) {
 		endLBA = detect_audio_cd_size_sectors(sector_size);
 	}
+	if (image_path && disc_type == IS_OTHER_DISC) {
+		// the forced profile picks the geometry, the image how much of it there is
+		endLBA = imgsrc_sectors(&image_source, sector_size);
+	}
+	if (sim_path && disc_type == IS_OTHER_DISC) {
+		endLBA = simdrive_sectors(&sim_drive);
+	}
 	u128 total_bytes = (u128)endLBA * sector_size;
 
 	// Work out the chunk size
@@ -2888,20 +3337,41 @@ int dump_game(int disc_type, int fs) {
 		// Keep audio dumps as a single BIN so a single CUE can reference it.
 		opt_chunk_size = total_bytes + max_read_size;
 	}
-
-	// Create the read buffers
-	buffer = memalign(32, MSG_COUNT*(max_read_size+sizeof(writer_msg)));
-	for (i=0; i < MSG_COUNT; i++) {
-		MQ_Send(blockq, (mqmsg_t)(buffer+i*(max_read_size+sizeof(writer_msg))), MQ_MSG_BLOCK);
+	if (selected_device == TYPE_READONLY) {
+		// nothing is written, so there is never a next chunk to open
+		opt_chunk_size = total_bytes + max_read_size;
+	}
+	u64 wbfs_split = 0;
+	if (!strcmp(output_ext, ".wbfs")) {
+		// a WBFS is only split where FAT has to, into files named the way the loaders look for them
+		if (selected_device != TYPE_READONLY && fs == TYPE_FAT && pathconf("fat:/", _PC_FILESIZEBITS) <= 33) {
+			wbfs_split = WBFS_SPLIT_SIZE;
+		}
+		opt_chunk_size = total_bytes + max_read_size;
+	}
+	if (!strcmp(output_ext, ".chd") || !strcmp(output_ext, ".zst") || !strcmp(output_ext, ".rcp")
+		|| !strcmp(output_ext, ".dlt")) {
+		// the map, seek table, recipe or delta header goes in at close, so there is only ever one file
+		opt_chunk_size = total_bytes + max_read_size;
 	}
 
-	// Reset MD5/SHA-1/CRC
-	md5_init(&state);
-	SHA1Reset(&sha);
-	crc32 = 0;
+	// Create the read buffers, big enough for every candidate until the tuner settles
+	u32 ring_size;
+	int ring_count;
+	tuner_ring_shape(&tune, &ring_size, &ring_count);
+	if (ring_alloc(&ring, blockq, sizeof(writer_msg), ring_size, ring_count)) {
+		tuner_init(&tune, sector_size, read_sectors * sector_size, MSG_COUNT, 0);
+		tuner_ring_shape(&tune, &ring_size, &ring_count);
+		ring_alloc(&ring, blockq, sizeof(writer_msg), ring_size, ring_count);
+	}
 
 	// There will be chunks, name accordingly
-	FILE *fp = NULL;
+	output primary, mirror;
+	sink tee_out;
+	sink format_out;
+	sink *out = &primary.file;	// the root of where blocks go, all the loop below talks to
+	// Unless the user swaps devices per chunk, the writer rolls over to the next part by itself
+	int auto_split = (selected_device != TYPE_READONLY && silent == AUTO_CHUNK && opt_chunk_size < total_bytes);
 	int should_eject = options_map[AUTO_EJECT] == EJECT_YES;
 	FILE *badfp = NULL;
 	const int audio_max_attempts = (audio_mode == AUDIO_OUT_WAV_FAST) ? 3 : (audio_mode == AUDIO_OUT_WAV_BEST ? 10 : 6);
@@ -2910,45 +3380,81 @@ int dump_game(int disc_type, int fs) {
     int wav_channels = 2;
     int num_passes = 1;
     int sample_rate = 44100;
-    if (is_audio_profile) {
-        wav_channels = select_wav_channels();
-        num_passes = select_rip_passes();
+    // a CHD keeps the disc as it is, one pass of both channels
+    if (is_audio_profile && strcmp(output_ext, ".chd")) {
+        wav_channels = opt_channels ? opt_channels : select_wav_channels();
+        num_passes = opt_passes ? opt_passes : select_rip_passes();
         if (strcmp(output_ext, ".wav") == 0) {
             sample_rate = (88200 * num_passes) / wav_channels;
         }
     }
 
+	// A second copy goes to the mirror, but not for passes merged afterwards, chunks swapped by hand
+	// or a recipe, whose chunks are only in the store next to the first copy
+	int mirroring = (mirrorPath[0] && selected_device != TYPE_READONLY && num_passes == 1
+					 && (silent == AUTO_CHUNK || opt_chunk_size >= total_bytes) && strcmp(output_ext, ".rcp"));
+	if (mirrorPath[0] && !mirroring) {
+		printf("Not mirroring this dump to %s\n", mirrorPath);
+	}
+	const char *mounts[2] = { &mountPath[0], mirrorPath };
+	int mount_count = mirroring ? 2 : 1;
+
+	// For audio CDs, generate the CUE sheet before ripping starts. A CHD has its own track list.
+	if (is_audio_profile && selected_device != TYPE_READONLY && strcmp(output_ext, ".chd")) {
+		char final_audio_filename[512];
+		// No redump verification for audio, so base name is always gameName.
+		const char* base_name = gameName;
+		sprintf(final_audio_filename, "%s%s", base_name, output_ext);
+		int isWave = (strcmp(output_ext, ".wav") == 0);
+		for (int m = 0; m < mount_count; m++) {
+			dump_audio_cue(mounts[m], final_audio_filename, isWave, base_name);
+		}
+	}
+
+	// Dump the BCA (or MCN for Audio CDs)
 	if(selected_device != TYPE_READONLY) {
-		if (opt_chunk_size < total_bytes) {
-			sprintf(txtbuffer, "%s%s.part0%s", &mountPath[0], &gameName[0], output_ext);
-		} else {
-			sprintf(txtbuffer, "%s%s%s", &mountPath[0], &gameName[0], output_ext);
+		dump_bca(mirroring ? mirrorPath : NULL);
+	}
+
+	if(selected_device != TYPE_READONLY) {
+		u64 part_size = (u64)((opt_chunk_size / sector_size) * sector_size);
+		// passes are merged into a WAV later, only a single pass is written as one
+		int wav = is_audio_profile && strcmp(output_ext, ".wav") == 0 && num_passes == 1;
+		int open_failed = open_output(&primary, &out, &mountPath[0], output_ext, auto_split, opt_chunk_size < total_bytes,
+									  part_size, (u64)total_bytes, num_passes > 1, wav ? wav_channels : 0, sample_rate, wbfs_split);
+		if (!open_failed && mirroring) {
+			sink *mirror_root;
+			open_failed = open_output(&mirror, &mirror_root, mirrorPath, output_ext, auto_split, opt_chunk_size < total_bytes,
+									  part_size, (u64)total_bytes, 0, wav ? wav_channels : 0, sample_rate, wbfs_split);
+			if (open_failed) {
+				sink_close(out);
+			}
+			else {
+				// both get every block, the buffer is only reused once both have it
+				sink_tee(&tee_out, out, mirror_root);
+				out = &tee_out;
+			}
+		}
+		if (!open_failed && is_compressed(output_ext)) {
+			open_failed = open_format(&format_out, &out, output_ext, (u64)total_bytes, &mountPath[0], disc_type);
+			if (open_failed) {
+				sink_close(out);
+			}
 		}
         
-        if (num_passes > 1) {
-            // For multi-pass, we write to temp files first
-            sprintf(txtbuffer, "%s%s.pass0.tmp", mountPath, gameName);
-        }
-        
-		remove(txtbuffer);
-		fp = fopen(txtbuffer, "wb");
-        
-		if (fp == NULL) {
+		if (open_failed) {
 			DrawFrameStart();
 			DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
 			WriteCentre(230, "Failed to create file:");
 			WriteCentre(255, txtbuffer);
+			if (headless) {
+				headless_exit(1, "Failed to create file");
+			}
 			WriteCentre(315, "Exiting in 5 seconds");
 			DrawFrameFinish();
 			sleep(5);
 			exit(0);
 		}
-		if (is_audio_profile && strcmp(output_ext, ".wav") == 0 && num_passes == 1) {
-			write_wav_header(fp, 0, wav_channels, sample_rate);
-		}
-		msg.command = MSG_SETFILE;
-		msg.data = fp;
-		MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
 
 		if (is_audio_profile) {
 			sprintf(txtbuffer, "%s%s.bad", &mountPath[0], &gameName[0]);
@@ -2959,190 +3465,157 @@ int dump_game(int disc_type, int fs) {
 			}
 		}
 	}
+	else {
+		sink_null(&primary.file);
+	}
+	msg.command = MSG_SETSINK;
+	msg.data = out;
+	MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
+
+	// everything about this disc's reads is decided here, not per block
+	ops.read = select_source_read(disc_type);
+	ops.error = dvd_get_error;
+	ops.datel_check = datel_check;
+	engine_init(&engine, &ops, engine_profile(disc_type), sector_size, calcChecksums);
+	if (is_audio_profile) {
+		engine_set_audio(&engine, audio_max_attempts, audio_sector_recovery, badfp);
+	}
+	// when nothing is kept (a read-only scan) the blocks go straight back, not through the writer
+	mqbox_t deliverq = sink_discards(out) ? blockq : msgq;
+	u32 pending_step = (deliverq == msgq);
 
 	int ret = 0;
-	u32 audio_read_errors = 0;
-	u32 audio_blocks_total = 0;
-	u32 audio_sectors_total = 0;
-	u32 audio_sectors_failed = 0;
 	u32 lastLBA = 0;
 	u128 lastCheckedTime = gettime();
 	u128 startTime = gettime();
 	int chunk = 1;
-	int isKnownDatel = 0;
 	char *discTypeStr = getDiscTypeStr(disc_type, endLBA == WII_D9_SIZE);
 
+	writer_pending = 0;
+	progress_begin("start");
+	progress_str("game", gameName);
+	progress_str("disc_type", discTypeStr);
+	progress_num("sector_size", sector_size);
+	progress_num("end_lba", endLBA);
+	progress_num("total_bytes", (u64)total_bytes);
+	progress_num("passes", num_passes);
+	progress_num("checksums", calcChecksums);
+	progress_end();
+
     for (int pass = 0; pass < num_passes; pass++) {
         if (pass > 0) {
             // Reset for next pass
             startLBA = 0;
             lastLBA = 0;
             if (selected_device != TYPE_READONLY) {
+                // the last pass has to be written out before its file is closed
+                vu32 sema = 0;
+                msg.command = MSG_FLUSH;
+                msg.data = (void*)&sema;
+                MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
+                while (!sema)
+                    LWP_YieldThread();
+                sink_close(out);
                 sprintf(txtbuffer, "%s%s.pass%d.tmp", mountPath, gameName, pass);
                 remove(txtbuffer);
-                fp = fopen(txtbuffer, "wb");
-                if (!fp) {
+                if (sink_file_open(&primary.file, txtbuffer, 0)) {
                     printf("Error opening temp file for pass %d\n", pass);
                     ret = -1;
                     break;
                 }
-                msg.command = MSG_SETFILE;
-                msg.data = fp;
+                msg.command = MSG_SETSINK;
+                msg.data = out;
                 MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
             }
         }
 
 	while (!ret && (startLBA < endLBA)) {
-		MQ_Receive(blockq, (mqmsg_t*)&wmsg, MQ_MSG_BLOCK);
-		if(selected_device != TYPE_READONLY) {
-			if (wmsg==NULL) { // asynchronous write error
-				LWP_JoinThread(writer, NULL);
-				fclose(fp);
-				DrawFrameStart();
-				DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
-				WriteCentre(255, "Write Error!");
-				WriteCentre(315, "Exiting in 10 seconds");
-				DrawFrameFinish();
-				sleep(10);
-				exit(1);
-			}
-
-			if (((u128)startLBA * sector_size) > (opt_chunk_size * chunk)) {
-				// wait for writing to finish
-				vu32 sema = 0;
-				msg.command = MSG_FLUSH;
-				msg.data = (void*)&sema;
-				MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
-				while (!sema)
-					LWP_YieldThread();
-
-				// open new file
-				u128 wait_begin = gettime();
-				if (badfp && silent == ASK_USER) {
-					fclose(badfp);
-					badfp = NULL;
-				}
-				prompt_new_file(&fp, chunk, fs, silent, disc_type);
-				if (is_audio_profile && selected_device != TYPE_READONLY && silent == ASK_USER) {
-					sprintf(txtbuffer, "%s%s.bad", &mountPath[0], &gameName[0]);
-					badfp = fopen(&txtbuffer[0], "ab");
+		tuner_ring_shape(&tune, &ring_size, &ring_count);
+		if (ring_size != ring.block_size || ring_count != ring.count) {
+			// wait for writing to finish, then swap the buffers for ones that fit
+			vu32 sema = 0;
+			msg.command = MSG_FLUSH;
+			msg.data = (void*)&sema;
+			MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
+			while (!sema)
+				LWP_YieldThread();
+			if (ring_drain(&ring) == 0) {
+				ring_free(&ring);
+				if (ring_alloc(&ring, blockq, sizeof(writer_msg), ring_size, ring_count)) {
+					// not enough memory to measure again, stay with the defaults
+					tuner_init(&tune, sector_size, read_sectors * sector_size, MSG_COUNT, 0);
+					tuner_ring_shape(&tune, &ring_size, &ring_count);
+					ring_alloc(&ring, blockq, sizeof(writer_msg), ring_size, ring_count);
 				}
-				// pretend the wait didn't happen
-				startTime -= (gettime() - wait_begin);
+			}
+		}
+		wmsg = ring_take(&ring, tuner_depth(&tune));
+		if (wmsg==NULL) { // asynchronous write error
+			LWP_JoinThread(writer, NULL);
+			sink_close(out);
+			DrawFrameStart();
+			DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
+			WriteCentre(255, "Write Error!");
+			if (headless) {
+				headless_exit(1, "Write Error!");
+			}
+			WriteCentre(315, "Exiting in 10 seconds");
+			DrawFrameFinish();
+			sleep(10);
+			exit(1);
+		}
 
-				// set writing file
-				msg.command = MSG_SETFILE;
-				msg.data = fp;
-				MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
-				chunk++;
-			}	
+		if (!auto_split && ((u128)startLBA * sector_size) > (opt_chunk_size * chunk)) {
+			// wait for writing to finish
+			vu32 sema = 0;
+			msg.command = MSG_FLUSH;
+			msg.data = (void*)&sema;
+			MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
+			while (!sema)
+				LWP_YieldThread();
+
+			// open new file
+			u128 wait_begin = gettime();
+			if (badfp && silent == ASK_USER) {
+				fclose(badfp);
+				badfp = NULL;
+			}
+			prompt_new_file(&primary.file, chunk, (u64)startLBA * sector_size, fs, silent, disc_type);
+			if (is_audio_profile && silent == ASK_USER) {
+				sprintf(txtbuffer, "%s%s.bad", &mountPath[0], &gameName[0]);
+				badfp = fopen(&txtbuffer[0], "ab");
+			}
+			engine.badfp = badfp;
+			// pretend the wait didn't happen
+			startTime -= (gettime() - wait_begin);
+
+			// set writing file
+			msg.command = MSG_SETSINK;
+			msg.data = out;
+			MQ_Send(msgq, (mqmsg_t)&msg, MQ_MSG_BLOCK);
+			chunk++;
 		}
 
-		u32 cur_read_sectors = ((startLBA + read_sectors) <= endLBA) ? read_sectors : (endLBA - startLBA);
+		u32 tuned_sectors = tuner_read_size(&tune) / sector_size;
+		u32 cur_read_sectors = ((startLBA + tuned_sectors) <= endLBA) ? tuned_sectors : (endLBA - startLBA);
 		u32 opt_read_size = cur_read_sectors * sector_size;
-		if (is_audio_profile) {
-			audio_blocks_total++;
-			audio_sectors_total += cur_read_sectors;
-		}
 
 		wmsg->command =  MSG_WRITE;
 		wmsg->data = wmsg+1;
 		wmsg->length = opt_read_size;
 		wmsg->ret_box = blockq;
+		wmsg->offset = (u64)startLBA * sector_size;
 
 		// Read from Disc
-		if (is_audio_profile) {
-			// Audio CD mode: retry several times before zero-filling.
-			ret = 1;
-			for (int attempt = 0; attempt < audio_max_attempts; attempt++) {
-				ret = source_read(wmsg->data, (u32)opt_read_size, (u128)startLBA * sector_size, disc_type, isKnownDatel);
-				if (ret == 0) {
-					break;
-				}
-				usleep(1000 + (attempt * 500));
-			}
-		}
-		else
-			ret = source_read(wmsg->data, (u32)opt_read_size, (u128)startLBA * sector_size, disc_type, isKnownDatel);
+		ret = engine_read(&engine, &tune, wmsg->data, startLBA, cur_read_sectors);
 		if (ret != 0) {
-			if (is_audio_profile) {
-				if (audio_sector_recovery && cur_read_sectors > 1) {
-					u32 bad_run_start = 0;
-					u32 bad_run_len = 0;
-					for (u32 s = 0; s < cur_read_sectors; s++) {
-						int sec_ret = 1;
-						for (int a = 0; a < audio_max_attempts; a++) {
-							sec_ret = source_read(((u8*)wmsg->data) + (s * sector_size), sector_size, ((u128)startLBA + s) * sector_size, disc_type, isKnownDatel);
-							if (sec_ret == 0) {
-								break;
-							}
-							usleep(1000 + (a * 500));
-						}
-						if (sec_ret != 0) {
-							audio_read_errors++;
-							audio_sectors_failed++;
-							memset(((u8*)wmsg->data) + (s * sector_size), 0, sector_size);
-							if (bad_run_len == 0) {
-								bad_run_start = startLBA + s;
-							}
-							bad_run_len++;
-						}
-						else if (bad_run_len > 0) {
-							if (badfp) {
-								fprintf(badfp, "%u,%u\n", bad_run_start, bad_run_len);
-							}
-							bad_run_len = 0;
-						}
-					}
-					if (bad_run_len > 0 && badfp) {
-						fprintf(badfp, "%u,%u\n", bad_run_start, bad_run_len);
-					}
-				}
-				else {
-					audio_read_errors += cur_read_sectors;
-					audio_sectors_failed += cur_read_sectors;
-					memset(wmsg->data, 0, opt_read_size);
-					if (badfp) {
-						fprintf(badfp, "%u,%u\n", startLBA, cur_read_sectors);
-					}
-				}
-				// Keep dumping despite sporadic read errors; report every 64 failed sectors.
-				if ((audio_read_errors & 63) == 1) {
-					print_gecko("Audio CD read errors=%u sectors (last LBA %u, err=%08X)\r\n",
-						audio_read_errors, startLBA, dvd_get_error());
-				}
-				ret = 0;
-			}
-			else {
-				MQ_Send(blockq, (mqmsg_t)wmsg, MQ_MSG_BLOCK);
-				break;
-			}
+			MQ_Send(blockq, (mqmsg_t)wmsg, MQ_MSG_BLOCK);
+			break;
 		}
 		usleep(50);
-		MQ_Send(msgq, (mqmsg_t)wmsg, MQ_MSG_BLOCK);
-		if(calcChecksums) {
-			// Calculate MD5
-			md5_append(&state, (const md5_byte_t *) (wmsg+1), (u32) opt_read_size);
-			// Calculate SHA-1
-			SHA1Input(&sha, (const unsigned char *) (wmsg+1), (u32) opt_read_size);
-		}
-		// Always calculate CRC32
-		crc32 = Crc32_ComputeBuf( crc32, wmsg+1, (u32) opt_read_size);
-
-		if(disc_type == IS_DATEL_DISC && (((u128)startLBA * sector_size) + opt_read_size == 0x100000)){
-			crc100000 = crc32;
-			isKnownDatel = datel_findCrcSum(crc100000);
-			DrawFrameStart();
-			DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
-			if(!isKnownDatel) {
-				WriteCentre(215, "(Warning: This disc will take a while to dump!)");
-			}
-			sprintf(txtbuffer, "%s CRC100000=%08X", (isKnownDatel ? "Known":"Unknown"), crc100000);
-			WriteCentre(255, txtbuffer);
-			u128 waitTimeStart = gettime();
-			wait_press_A_exit_B(false);
-			startTime += (gettime() - waitTimeStart);	// Don't throw time off because we'd paused here
-		}
+		__sync_add_and_fetch(&writer_pending, pending_step);
+		MQ_Send(deliverq, (mqmsg_t)wmsg, MQ_MSG_BLOCK);
+		engine_account(&engine, wmsg->data, startLBA, cur_read_sectors);
 
 		check_exit_status();
 	
@@ -3163,6 +3636,22 @@ int dump_game(int disc_type, int fs) {
 			u32 bytes_since_last_read = (u32)((current_bytes - last_bytes) * (1000.0f/timePassed));
 			u128 remainder = (((u128)endLBA - startLBA) * sector_size) - opt_read_size;
 			u32 etaTime = bytes_since_last_read ? (remainder / bytes_since_last_read) : 0;
+			if (progress_enabled()) {
+				progress_begin("progress");
+				progress_num("lba", startLBA);
+				progress_num("end_lba", endLBA);
+				progress_real("percent", (double)startLBA * 100.0 / endLBA);
+				progress_num("bytes", (u64)current_bytes);
+				progress_num("rate", bytes_since_last_read);
+				progress_num("eta", etaTime);
+				progress_num("retries", engine.retries);
+				progress_num("read_errors", engine.sectors_failed);
+				progress_num("queue", writer_pending);
+				progress_num("queue_depth", tuner_depth(&tune));
+				progress_num("read_size", tuner_read_size(&tune));
+				progress_num("pass", pass + 1);
+				progress_end();
+			}
 			DrawFrameStart();
 			if(newProgressDisplay) {
 				sprintf(txtbuffer, "Rate: %4.2fKB/s\nETA: %02d:%02d:%02d",
@@ -3187,23 +3676,25 @@ int dump_game(int disc_type, int fs) {
 		startLBA += cur_read_sectors;
 	}
 	}
-	if(calcChecksums) {
-		md5_finish(&state, digest);
+	if (sim_path) {
+		simdrive_stats(&sim_drive);
 	}
-	if (is_audio_profile && audio_sectors_total && audio_sectors_failed == audio_sectors_total) {
+	if (engine_all_failed(&engine)) {
 		ret = -62; // all audio blocks failed
 	}
+	startTime += engine.paused;	// Don't throw time off because we'd paused for the Datel check
 
 	// signal writer to finish
 	MQ_Send(msgq, (mqmsg_t)NULL, MQ_MSG_BLOCK);
 	LWP_JoinThread(writer, NULL);
+	// the last part is flushed and closed here, anything left over is removed
+	if (sink_close(out) != 0 && !ret) {
+		ret = -63;
+	}
 	if(selected_device != TYPE_READONLY) {
-		if (fp && is_audio_profile && strcmp(output_ext, ".wav") == 0 && num_passes == 1) {
-			u64 wav_data_size = (u64)((u128)startLBA * sector_size);
-			fseek(fp, 0, SEEK_SET);
-			write_wav_header(fp, wav_data_size, wav_channels, sample_rate);
+		if (auto_split) {
+			chunk = partfile_count(&primary.parts);
 		}
-		fclose(fp);
 		if (badfp) {
 			fclose(badfp);
 		}
@@ -3303,7 +3794,7 @@ int dump_game(int disc_type, int fs) {
 		}
 	}
 
-	free(buffer);
+	ring_free(&ring);
 	MQ_Close(blockq);
 	MQ_Close(msgq);
 
@@ -3313,11 +3804,20 @@ int dump_game(int disc_type, int fs) {
 		if (ret == -62) {
 			sprintf(txtbuffer, "Audio read failed (all blocks)");
 		}
+		else if (ret == -63) {
+			sprintf(txtbuffer, "Write Error!");
+		}
 		else {
 			sprintf(txtbuffer, "%s",dvd_error_str());
 		}
 		print_gecko("Error: %s\r\n",txtbuffer);
 		WriteCentre(255,txtbuffer);
+		progress_begin("done");
+		progress_str("result", "error");
+		progress_str("error", txtbuffer);
+		progress_num("lba", startLBA);
+		progress_num("retries", engine.retries);
+		progress_end();
 		dvd_motor_off(should_eject ? 1 : 0);
 		wait_press_A("to continue");
 		return 0;
@@ -3328,6 +3828,10 @@ int dump_game(int disc_type, int fs) {
 		sprintf(txtbuffer, "Copy Cancelled");
 		print_gecko("%s\r\n",txtbuffer);
 		WriteCentre(255,txtbuffer);
+		progress_begin("done");
+		progress_str("result", "cancelled");
+		progress_num("lba", startLBA);
+		progress_end();
 		dvd_motor_off(0);
 		wait_press_A("to continue");
 		return 0;
@@ -3345,21 +3849,13 @@ int dump_game(int disc_type, int fs) {
 		char tempstr[64];
 
 		if ((disc_type == IS_DATEL_DISC)) {
-				dump_skips(&mountPath[0], crc100000);
+			for (int m = 0; m < mount_count; m++) {
+				dump_skips((char*)mounts[m], engine.crc100000);
+			}
 		}
 		char md5sum[64];
 		char sha1sum[64];
-		memset(&md5sum[0], 0, 64);
-		memset(&sha1sum[0], 0, 64);
-		if (calcChecksums) {
-			int i; for (i=0; i<16; i++) sprintf(&md5sum[i*2],"%02x",digest[i]);
-			if(SHA1Result(&sha)) {
-				for (i=0; i<5; i++) sprintf(&sha1sum[i*8],"%08x",sha.Message_Digest[i]);
-			}
-			else {
-				sprintf(sha1sum, "Error computing SHA-1");
-			}
-		}
+		engine_finish(&engine, md5sum, sha1sum);
 		char* name = NULL;
 		int canVerifyWithDat = (disc_type == IS_NGC_DISC || disc_type == IS_WII_DISC || disc_type == IS_DATEL_DISC);
 		int availableVerificationType = canVerifyWithDat ? verify_is_available(disc_type) : -1;
@@ -3368,38 +3864,60 @@ int dump_game(int disc_type, int fs) {
 				verified = verify_findMD5Sum(&md5sum[0], disc_type);
 			}
 			else {
-				verified = verify_findCrc32(crc32, disc_type);
+				verified = verify_findCrc32(engine.crc32, disc_type);
 			}
 		}
-		if (verified && availableVerificationType != VERIFY_INTERNAL_CRC) {
-			if (opt_chunk_size < total_bytes) {
-				for (int i = 0; i < chunk; i++) {
-					sprintf(tempstr, ".part%i%s", i, output_ext);
-					renameFile(&mountPath[0], &gameName[0], verify_get_name(0), &tempstr[0]);
-				}
-			}
-			else {
-				renameFile(&mountPath[0], &gameName[0], verify_get_name(0), output_ext);
-			}
-#ifdef HW_RVL
-			renameFile(&mountPath[0], &gameName[0], verify_get_name(0), ".bca");
-#endif
-
+		int redump_named = (verified && availableVerificationType != VERIFY_INTERNAL_CRC);
+		if (redump_named) {
 			name = verify_get_name(0);
 		}
+		int datel_named = 0;
 		if ((disc_type == IS_DATEL_DISC)) {
 			verified = datel_findMD5Sum(&md5sum[0]);
 			if (verified) {
-				renameFile(&mountPath[0], &gameName[0], datel_get_name(0), ".iso");
-				renameFile(&mountPath[0], &gameName[0], datel_get_name(0), ".skp");
+				datel_named = 1;
+				name = datel_get_name(0);
+			}
+		}
+		// the mirror holds the same bytes, so it's named and logged the same way
+		for (int m = 0; m < mount_count; m++) {
+			const char *mount = mounts[m];
+			if (redump_named) {
+				if (opt_chunk_size < total_bytes) {
+					for (int i = 0; i < chunk; i++) {
+						sprintf(tempstr, ".part%i%s", i, output_ext);
+						renameFile(mount, &gameName[0], verify_get_name(0), &tempstr[0]);
+					}
+				}
+				else {
+					renameFile(mount, &gameName[0], verify_get_name(0), output_ext);
+				}
+				// a WBFS split for FAT goes on in .wbf1, .wbf2...
+				if (!strcmp(output_ext, ".wbfs")) {
+					for (int i = 1; i < WBFS_MAX_PARTS; i++) {
+						wbfs_part_ext(i, tempstr);
+						renameFile(mount, &gameName[0], verify_get_name(0), tempstr);
+					}
+				}
 #ifdef HW_RVL
-				renameFile(&mountPath[0], &gameName[0], datel_get_name(0), ".bca");
+				renameFile(mount, &gameName[0], verify_get_name(0), ".bca");
+#endif
+			}
+			if (datel_named) {
+				renameFile(mount, &gameName[0], datel_get_name(0), output_ext);
+				renameFile(mount, &gameName[0], datel_get_name(0), ".skp");
+#ifdef HW_RVL
+				renameFile(mount, &gameName[0], datel_get_name(0), ".bca");
 #endif
-				name = datel_get_name(0);
+			}
+			if (calcChecksums) {
+				dump_info(mount, &md5sum[0], &sha1sum[0], engine.crc32, verified, diff_sec(startTime, gettime()), name);
+			}
+			else {
+				dump_info(mount, NULL, NULL, engine.crc32, verified, diff_sec(startTime, gettime()), NULL);
 			}
 		}
 		if(calcChecksums) {
-			dump_info(&md5sum[0], &sha1sum[0], crc32, verified, diff_sec(startTime, gettime()), name);
 			if (canVerifyWithDat) {
 				print_gecko("MD5: %s\r\n", verified ? "Verified OK" : "Not Verified ");
 			}
@@ -3412,7 +3930,7 @@ int dump_game(int disc_type, int fs) {
 			sprintf(txtbuffer, "%s: %s", (availableVerificationType != VERIFY_INTERNAL_CRC) ? "MD5" : "CRC32", verified ? "Verified OK" : "");
 		}
 		else {
-			sprintf(txtbuffer, "CRC32: %08X", crc32);
+			sprintf(txtbuffer, "CRC32: %08X", engine.crc32);
 		}
 		WriteCentre(230, txtbuffer);
 		if (!canVerifyWithDat) {
@@ -3429,29 +3947,41 @@ int dump_game(int disc_type, int fs) {
 				WriteCentre(255, "Not verified with redump DAT");
 			}
 		}
-		if (is_audio_profile && audio_read_errors) {
-			sprintf(txtbuffer, "Audio CD had %u read errors (zero-filled)", audio_read_errors);
+		if (is_audio_profile && engine.sectors_failed) {
+			sprintf(txtbuffer, "Audio CD had %u read errors (zero-filled)", engine.sectors_failed);
 			WriteCentre(305, txtbuffer);
 			sprintf(txtbuffer, "%s%s.bad", &mountPath[0], &gameName[0]);
 			WriteCentre(330, txtbuffer);
 		}
 		WriteCentre(280, &md5sum[0]);
-		if(!calcChecksums) {
-			dump_info(NULL, NULL, crc32, verified, diff_sec(startTime, gettime()), NULL);
-		}
+		progress_begin("done");
+		progress_str("result", "ok");
+		progress_str("game", gameName);
+		progress_str("name", name ? name : "");
+		progress_num("verified", verified ? 1 : 0);
+		progress_str("md5", md5sum);
+		progress_str("sha1", sha1sum);
+		sprintf(tempstr, "%08x", engine.crc32);
+		progress_str("crc32", tempstr);
+		progress_num("bytes", (u64)((u128)startLBA * sector_size));
+		progress_num("seconds", diff_sec(startTime, gettime()));
+		progress_num("retries", engine.retries);
+		progress_num("read_errors", engine.sectors_failed);
+		progress_end();
         printf("Debug: Checking audio profile. is_audio_profile=%d, disc_type=%d, forced_disc_profile=%d\n", is_audio_profile, disc_type, forced_disc_profile);
         fflush(stdout);
 		if ((disc_type == IS_DATEL_DISC) && !(verified)) {
-			dump_skips(&mountPath[0], crc100000);
-			
 			char tempstr[64];
-			sprintf(tempstr, "datel_%08x", crc100000);
-			renameFile(&mountPath[0], &gameName[0], &tempstr[0], output_ext);
-			renameFile(&mountPath[0], &gameName[0], &tempstr[0], "-dumpinfo.txt");
-			renameFile(&mountPath[0], &gameName[0], &tempstr[0], ".skp");
+			sprintf(tempstr, "datel_%08x", engine.crc100000);
+			for (int m = 0; m < mount_count; m++) {
+				dump_skips((char*)mounts[m], engine.crc100000);
+				renameFile(mounts[m], &gameName[0], &tempstr[0], output_ext);
+				renameFile(mounts[m], &gameName[0], &tempstr[0], "-dumpinfo.txt");
+				renameFile(mounts[m], &gameName[0], &tempstr[0], ".skp");
 #ifdef HW_RVL
-			renameFile(&mountPath[0], &gameName[0], &tempstr[0], ".bca");
+				renameFile(mounts[m], &gameName[0], &tempstr[0], ".bca");
 #endif
+			}
 		}
 		dvd_motor_off(should_eject ? 1 : 0);
 		wait_press_A_exit_B(false);
@@ -3459,6 +3989,209 @@ int dump_game(int disc_type, int fs) {
 	return 1;
 }
 
+static int batch_present(int drive) {
+    DWORD bytesReturned;
+    return DeviceIoControl(hSourceDrives[drive], IOCTL_STORAGE_CHECK_VERIFY, NULL, 0, NULL, 0, &bytesReturned, NULL) ? 1 : 0;
+}
+
+static void batch_eject_drive(int drive) {
+    DWORD bytesReturned;
+    DeviceIoControl(hSourceDrives[drive], IOCTL_STORAGE_EJECT_MEDIA, NULL, 0, NULL, 0, &bytesReturned, NULL);
+}
+
+static int batch_verify(const char *md5, int disc_type, char *name, int name_size) {
+    if (verify_is_available(disc_type) == VERIFY_INTERNAL_CRC || !verify_findMD5Sum((char*)md5, disc_type)) {
+        return 0;
+    }
+    snprintf(name, name_size, "%s", verify_get_name(0));
+    return 1;
+}
+
+static void batch_bca(int drive, const char *out_path, const char *name) {
+    char bca_data[BCA_DUMP_SIZE];
+    memset(bca_data, 0, sizeof(bca_data));
+    write_bca(out_path, name, bca_data, drive_read_bca(drive, bca_data, sizeof(bca_data)));
+}
+
+static void batch_info(const char *out_path, const char *name, const u8 *header, const char *md5, const char *sha1,
+                       u32 crc32, int verified, u32 seconds) {
+    char internal[0x60 + 1];
+    memcpy(internal, header + 0x20, 0x60);
+    internal[0x60] = 0;
+    write_dumpinfo(out_path, NULL, name, internal, header[7], md5, sha1, crc32, verified, seconds);
+}
+
+static const batch_drive_ops batch_ops = {
+    batch_present,
+    drive_read,
+    batch_eject_drive,
+    batch_verify,
+    batch_bca,
+    batch_info
+};
+
+// Dumps whatever gets put in any of the drives until B is pressed
+static int run_batch() {
+    char names[MAX_SOURCE_DRIVES];
+    int drives = 0;
+
+    for (int i = 0; i < MAX_SOURCE_DRIVES && selected_source_drive_letters[i]; i++) {
+        char path[32];
+        sprintf(path, "\\\\.\\%c:", selected_source_drive_letters[i]);
+        // empty drives are fine here, the jobs wait for a disc
+        HANDLE h = CreateFile(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+        if (h == INVALID_HANDLE_VALUE) {
+            printf("Can't open drive %c:, skipping it\n", selected_source_drive_letters[i]);
+            continue;
+        }
+        names[drives] = selected_source_drive_letters[i];
+        hSourceDrives[drives++] = h;
+    }
+    numSourceDrives = drives;
+    verify_init(&mountPath[0]);
+    if (!drives || batch_start(&batch_jobs, &batch_ops, mountPath, names, drives, batch_hashers, batch_write_limit, batch_eject)) {
+        printf("Batch mode needs at least one drive\n");
+        return 1;
+    }
+
+    int stopping = 0;
+    while (1) {
+        DrawFrameStart();
+        sprintf(txtbuffer, "CleanRip batch: %i drive(s), %i hashing thread(s)", batch_jobs.job_count, batch_jobs.hasher_count);
+        WriteFont(0, 0, txtbuffer);
+        for (int i = 0; i < batch_jobs.job_count; i++) {
+            batch_job *job = &batch_jobs.jobs[i];
+            int percent = job->total ? (int)(job->done * 100 / job->total) : 0;
+            sprintf(txtbuffer, "%s %-9s %3i%% [%u done] %s", job->drive_name, batch_state_str(job->state),
+                    percent, job->discs, job->message);
+            WriteFont(0, 0, txtbuffer);
+        }
+        WriteFont(0, 0, stopping ? "Stopping after the discs being dumped..." : "Press B to stop");
+        DrawFrameFinish();
+        if (stopping && !batch_busy(&batch_jobs)) {
+            break;
+        }
+        // each scan waits 10ms
+        for (int t = 0; t < 50; t++) {
+            if ((get_buttons_pressed() & PAD_BUTTON_B) || shutdown) {
+                stopping = 1;
+                batch_stop(&batch_jobs);
+            }
+        }
+    }
+    batch_end(&batch_jobs);
+    return 0;
+}
+
+// Every setting a prompt would ask for, index in the list is the option value
+static const char *const dump_size_values[] = { "auto", "mini", "single", "dual", NULL };
+static const char *const chunk_size_values[] = { "1g", "2g", "3g", "max", NULL };
+static const char *const new_device_values[] = { "yes", "no", NULL };
+static const char *const eject_values[] = { "no", "yes", NULL };
+static const char *const audio_output_values[] = { "bin", "wav", "wav-fast", "wav-best", "chd", NULL };
+static const char *const profile_values[] = { "gc", "wii", "dvd", "dvd-dl", "minidvd", "audio", NULL };
+static const char *const yes_no_values[] = { "no", "yes", NULL };
+static const char *const gc_output_values[] = { "iso", "ciso", "gcz", "rvz", "store", NULL };
+static const char *const wii_output_values[] = { "iso", "wbfs", "store", NULL };
+static const char *const dvd_output_values[] = { "iso", "chd", "zst", "store", NULL };
+
+static const struct {
+	const char *flag;
+	int option;
+	const char *const *values;
+} option_flags[] = {
+	{ "--dump-size=", WII_DUAL_LAYER, dump_size_values },
+	{ "--chunk-size=", WII_CHUNK_SIZE, chunk_size_values },
+	{ "--new-device-per-chunk=", WII_NEWFILE, new_device_values },
+	{ "--eject=", AUTO_EJECT, eject_values },
+	{ "--audio-output=", AUDIO_OUTPUT, audio_output_values },
+	{ "--gc-output=", NGC_OUTPUT, gc_output_values },
+	{ "--wii-output=", WII_OUTPUT, wii_output_values },
+	{ "--dvd-output=", DVD_OUTPUT, dvd_output_values },
+};
+
+static int flag_value(const char *value, const char *const *values) {
+	for (int i = 0; values[i]; i++) {
+		if (!strcasecmp(value, values[i])) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static const char *flag_arg(const char *arg, const char *flag) {
+	int len = strlen(flag);
+	return strncmp(arg, flag, len) ? NULL : arg + len;
+}
+
+/* returns 0 if the argument was a valid option */
+static int parse_option(const char *arg) {
+	const char *value;
+
+	for (int i = 0; i < sizeof(option_flags) / sizeof(option_flags[0]); i++) {
+		if ((value = flag_arg(arg, option_flags[i].flag))) {
+			int v = flag_value(value, option_flags[i].values);
+			if (v < 0) {
+				return -1;
+			}
+			options_map[option_flags[i].option] = v;
+			return 0;
+		}
+	}
+	if (!strcmp(arg, "--headless")) {
+		headless = 1;
+	}
+	else if ((value = flag_arg(arg, "--checksums="))) {
+		opt_checksums = flag_value(value, yes_no_values);
+		return opt_checksums < 0 ? -1 : 0;
+	}
+	else if ((value = flag_arg(arg, "--datel="))) {
+		opt_datel = flag_value(value, yes_no_values);
+		return opt_datel < 0 ? -1 : 0;
+	}
+	else if ((value = flag_arg(arg, "--profile="))) {
+		opt_profile = flag_value(value, profile_values);
+		return opt_profile < 0 ? -1 : 0;
+	}
+	else if ((value = flag_arg(arg, "--audio-sector-size="))) {
+		opt_audio_sector_size = atoi(value);
+		return (opt_audio_sector_size == 2048 || opt_audio_sector_size == 2352) ? 0 : -1;
+	}
+	else if ((value = flag_arg(arg, "--channels="))) {
+		opt_channels = atoi(value);
+		return opt_channels < 1 ? -1 : 0;
+	}
+	else if ((value = flag_arg(arg, "--passes="))) {
+		opt_passes = atoi(value);
+		return (opt_passes < 1 || opt_passes > 32) ? -1 : 0;
+	}
+	else if ((value = flag_arg(arg, "--mirror="))) {
+		// a directory, like the output path
+		int len = snprintf(mirrorPath, sizeof(mirrorPath) - 1, "%s", value);
+		if (len <= 0 || len >= sizeof(mirrorPath) - 1) {
+			mirrorPath[0] = 0;
+			return -1;
+		}
+		if (mirrorPath[len-1] != '/' && mirrorPath[len-1] != '\\') {
+			strcat(mirrorPath, "/");
+		}
+	}
+	else if ((value = flag_arg(arg, "--delta="))) {
+		// an image of another release of the disc, in any format that can be read
+		delta_path = value;
+	}
+	else if ((value = flag_arg(arg, "--progress-fd="))) {
+		if (progress_open(atoi(value))) {
+			fprintf(stderr, "Can't write progress to fd %s\n", value);
+			return -1;
+		}
+	}
+	else {
+		return -1;
+	}
+	return 0;
+}
+
 int main(int argc, char **argv) {
 	    bool args_provided = false;
     if (argc > 2) {
@@ -3474,19 +4207,45 @@ int main(int argc, char **argv) {
             }
         }
 
+        // Set sane non-interactive defaults, the options below may change them
+        options_map[WII_NEWFILE] = AUTO_CHUNK;
+        options_map[WII_CHUNK_SIZE] = CHUNK_MAX;
+
         // Subsequent args are source drives
         memset(selected_source_drive_letters, 0, sizeof(selected_source_drive_letters));
         int drive_count = 0;
         for (int i = 2; i < argc && drive_count < MAX_SOURCE_DRIVES; i++) {
-            // argv[i] is something like "g:\" or "g:"
-            if (strlen(argv[i]) > 0) {
+            // argv[i] is something like "g:\" or "g:", anything longer is an image file
+            // or a simulated drive script
+            int arg_len = strlen(argv[i]);
+            if (!strcmp(argv[i], "--batch")) {
+                batch_mode = 1;
+            }
+            else if (!strncmp(argv[i], "--hash-threads=", 15)) {
+                batch_hashers = atoi(argv[i] + 15);
+            }
+            else if (!strncmp(argv[i], "--write-limit=", 14)) {
+                batch_write_limit = (u64)atoi(argv[i] + 14) * 1024 * 1024;
+            }
+            else if (!strcmp(argv[i], "--no-eject")) {
+                batch_eject = 0;
+            }
+            else if (!strncmp(argv[i], "--", 2)) {
+                if (parse_option(argv[i])) {
+                    fprintf(stderr, "Bad option %s\n", argv[i]);
+                    return 2;
+                }
+            }
+            else if (arg_len > 4 && !strcasecmp(argv[i] + arg_len - 4, ".sim")) {
+                sim_path = argv[i];
+            }
+            else if (arg_len > 3) {
+                image_path = argv[i];
+            }
+            else if (strlen(argv[i]) > 0) {
                 selected_source_drive_letters[drive_count++] = toupper(argv[i][0]);
             }
         }
-        
-        // Set sane non-interactive defaults
-        options_map[WII_NEWFILE] = AUTO_CHUNK;
-        options_map[WII_CHUNK_SIZE] = CHUNK_MAX;
     }
 #ifdef HW_RVL
 	// disable ahbprot and reload IOS to clear up memory
@@ -3504,6 +4263,9 @@ int main(int argc, char **argv) {
 	}
 #endif
 	print_gecko("CleanRip Version %i.%i.%i\r\n",V_MAJOR, V_MID, V_MINOR);
+	if (batch_mode) {
+		return run_batch();
+	}
 #if defined(HW_RVL) || defined(HW_DOL)
 	print_gecko("Arena Size: %iKb\r\n",(SYS_GetArena1Hi()-SYS_GetArena1Lo())/1024);
 #endif
@@ -3511,14 +4273,21 @@ int main(int argc, char **argv) {
 #ifdef HW_RVL
 	print_gecko("Running on IOS ver: %i\r\n", iosversion);
 #endif
-	show_disclaimer();
+	if (!headless) {
+		show_disclaimer();
+	}
 #ifdef HW_RVL
 	hardware_checks();
 #endif
 
 	// Ask the user if they want checksum calculations enabled this time?
-	calcChecksums = DrawYesNoDialog("Enable checksum calculations?",
-									"(Enabling will add about 3 minutes)");
+	if (opt_checksums >= 0 || headless) {
+		calcChecksums = (opt_checksums != 0);
+	}
+	else {
+		calcChecksums = DrawYesNoDialog("Enable checksum calculations?",
+										"(Enabling will add about 3 minutes)");
+	}
 
 	int reuseSettings = NOT_ASKED;
 	while (1) {
@@ -3571,6 +4340,9 @@ int main(int argc, char **argv) {
 		while (ret == NO_DISC) {
 			ret = initialise_source(args_provided);
 			if (ret == NO_DISC) {
+				if (headless) {
+					headless_exit(3, "No disc detected");
+				}
 				if (DrawYesNoDialog("Disc init reports no disc",
 									"Continue anyway and force type?")) {
 					ret = 0;
@@ -3583,26 +4355,36 @@ int main(int argc, char **argv) {
 		forced_audio_sector_size = 0;
 		int disc_type = identify_disc();
 
-		if (disc_type == IS_UNK_DISC) {
+		if (opt_profile >= 0) {
+			// the name still comes from the disc
+			disc_type = set_forced_disc(opt_profile);
+		}
+		else if (disc_type == IS_UNK_DISC) {
+			if (headless) {
+				headless_exit(3, "Unknown disc type, pass --profile");
+			}
 			disc_type = force_disc();
 		}
+		if (forced_disc_profile == FORCED_AUDIO_CD && opt_audio_sector_size) {
+			forced_audio_sector_size = opt_audio_sector_size;
+		}
 
 		if (disc_type == IS_OTHER_DISC && forced_disc_profile == FORCED_AUDIO_CD) {
 			display_cd_info_and_wait();
 		}
 
 		if(reuseSettings == NOT_ASKED || reuseSettings == ANSWER_NO) {
-			if ((disc_type == IS_WII_DISC || disc_type == IS_OTHER_DISC) && selected_device != TYPE_READONLY) {
+			if (selected_device != TYPE_READONLY && !headless) {
 				get_settings(disc_type);
 			}
 		
 			// Ask the user if they want to force Datel check this time?
-			if(disc_type != IS_OTHER_DISC && selected_device != TYPE_READONLY
+			if(disc_type != IS_OTHER_DISC && selected_device != TYPE_READONLY && !image_path
 #ifdef HW_RVL
 				&& selected_source == SRC_INTERNAL_DISC
 #endif
-				&& DrawYesNoDialog("Is this a unlicensed datel disc?",
-								 "(Will attempt auto-detect if no)")) {
+				&& ((opt_datel >= 0 || headless) ? (opt_datel == 1) : DrawYesNoDialog("Is this a unlicensed datel disc?",
+								 "(Will attempt auto-detect if no)"))) {
 				disc_type = IS_DATEL_DISC;
 				datel_init(&mountPath[0]);
 #ifdef HW_RVL
@@ -3613,7 +4395,7 @@ int main(int argc, char **argv) {
 			}
 		}
 		
-		if(reuseSettings == NOT_ASKED) {
+		if(reuseSettings == NOT_ASKED && !headless) {
 			if(DrawYesNoDialog("Remember settings?",
 								 "Will only ask again next session")) {
 				reuseSettings = ANSWER_YES;
@@ -3625,6 +4407,9 @@ int main(int argc, char **argv) {
 		isDumping = 0;
 		verify_type_in_use = 0;
 		dumpCounter += (ret ? 1 : 0);
+		if (headless) {
+			headless_exit(ret ? 0 : 1, ret ? "Dumped" : "Dump failed");
+		}
 		
 		DrawFrameStart();
 		DrawEmptyBox(30, 180, vmode->fbWidth - 38, 350, COLOR_BLACK);
@@ -0,0 +1,362 @@
+/**
+ * CleanRip - zst.c
+ * Copyright (C) 2010-2026 emu_kidid
+ *
+ * A sink stage that writes the image in zstd's seekable format while
+ * it is dumped, and the reader for it. Every 128KB of the image is a
+ * zstd frame of its own, compressed by a pool of worker threads, one
+ * per core on a PC, and appended in order as they finish; the sizes
+ * of the frames go in a seek table at the end of the file, which the
+ * zstd tool skips over. On a PC the reader finds a frame through that
+ * table and decompresses it on its own. There is no zstd for the
+ * console, so there each frame holds its data in a raw block, which
+ * every zstd reader takes all the same.
+ *
+ * CleanRip homepage: https://github.com/emukidid/cleanrip
+ * email address: emukidid@gmail.com
+ *
+ *
+ * This program is free software; you can redistribute it and/
+ * or modify it under the terms of the GNU General Public Li-
+ * cence as published by the Free Software Foundation; either
+ * version 2 of the Licence, or any later version.
+ *
+ * This program is distributed in the hope that it will be use-
+ * ful, but WITHOUT ANY WARRANTY; without even the implied war-
+ * ranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public Licence for more details.
+ *
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include "zst.h"
+#include "bytes.h"
+#include "pool.h"
+
+#if defined(__CYGWIN__) || defined(__linux__)
+#include <zstd.h>
+#define ZST_LEVEL 5
+#endif
+
+#define ZST_OUT_SIZE (1024*1024)	// frames are passed on in writes of up to this
+#define ZST_RAW_HEADER 12			// a frame header and the header of its one raw block
+#define ZST_ENTRY_SIZE 8
+
+typedef struct {
+#ifdef ZST_LEVEL
+	ZSTD_CCtx *cctx;
+#endif
+} zst_worker;
+
+typedef struct {
+	u8 *in;				// copied out of the writes it came in
+	u32 len;
+	u8 *out;			// the frame
+	u32 size;
+} zst_job;
+
+typedef struct {
+	u32 num_frames;
+	u32 frame;			// the next frame to go out
+	u64 out;			// where it goes in the file
+	u8 *table;			// the seek table, a skippable frame
+	u32 table_size;
+	u32 fill;			// of the frame being put together
+	u8 *obuf;			// frames not passed on yet
+	u32 ofill;
+	zst_worker self;	// when there are no workers
+	zst_worker worker[POOL_MAX_WORKERS];
+	int workers;		// set up
+	int slots;
+	zst_job *jobs;
+	job_pool pool;
+} zst_ctx;
+
+// A frame with the data as it is in one raw block, the content size says how much
+static u32 zst_raw_frame(u8 *p, const u8 *data, u32 len) {
+	put_le32(p, ZST_FRAME_MAGIC);
+	p[4] = 0xA0;						// single segment, 4 byte content size
+	put_le32(p + 5, len);
+	p[9] = ((len << 3) | 1) & 0xFF;		// the last block, raw
+	p[10] = (len >> 5) & 0xFF;
+	p[11] = (len >> 13) & 0xFF;
+	memcpy(p + ZST_RAW_HEADER, data, len);
+	return ZST_RAW_HEADER + len;
+}
+
+static void zst_compress(void *_worker, void *_job) {
+	zst_worker *w = (zst_worker*)_worker;
+	zst_job *job = (zst_job*)_job;
+
+#ifdef ZST_LEVEL
+	size_t size = ZSTD_compressCCtx(w->cctx, job->out, ZSTD_compressBound(ZST_FRAME_SIZE),
+		job->in, job->len, ZST_LEVEL);
+	if (!ZSTD_isError(size)) {
+		job->size = size;
+		return;
+	}
+#endif
+	job->size = zst_raw_frame(job->out, job->in, job->len);
+}
+
+static int zst_pass_on(sink *s) {
+	zst_ctx *c = (zst_ctx*)s->ctx;
+	int ret = 0;
+
+	if (c->ofill) {
+		ret = sink_write(s->next[0], c->obuf, c->ofill, c->out - c->ofill);
+		c->ofill = 0;
+	}
+	return ret;
+}
+
+static int zst_append(sink *s, const u8 *data, u32 len) {
+	zst_ctx *c = (zst_ctx*)s->ctx;
+	int ret = 0;
+
+	if (c->ofill + len > ZST_OUT_SIZE) {
+		ret = zst_pass_on(s);
+	}
+	memcpy(c->obuf + c->ofill, data, len);
+	c->ofill += len;
+	c->out += len;
+	return ret;
+}
+
+// Appends a frame and notes it in the seek table
+static int zst_emit(sink *s, void *_job) {
+	zst_ctx *c = (zst_ctx*)s->ctx;
+	zst_job *job = (zst_job*)_job;
+	u8 *entry = c->table + 8 + c->frame * ZST_ENTRY_SIZE;
+
+	if (c->frame >= c->num_frames) {
+		return 1;
+	}
+	put_le32(entry, job->size);
+	put_le32(entry + 4, job->len);
+	c->frame++;
+	return zst_append(s, job->out, job->size);
+}
+
+static int zst_write(sink *s, const void *data, u32 len, u64 offset) {
+	zst_ctx *c = (zst_ctx*)s->ctx;
+	const u8 *p = (const u8*)data;
+	int ret = 0;
+
+	// the seek table only works if every block comes in order
+	if (offset != s->pos) {
+		return 1;
+	}
+	s->pos += len;
+	while (len) {
+		zst_job *job = (zst_job*)pool_next(&c->pool, &ret);
+		u32 n = ZST_FRAME_SIZE - c->fill;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(job->in + c->fill, p, n);
+		c->fill += n;
+		p += n;
+		len -= n;
+		if (c->fill == ZST_FRAME_SIZE) {
+			job->len = ZST_FRAME_SIZE;
+			ret |= pool_submit(&c->pool);
+			c->fill = 0;
+		}
+	}
+	return ret;
+}
+
+static int zst_flush(sink *s) {
+	zst_ctx *c = (zst_ctx*)s->ctx;
+
+	return pool_drain(&c->pool) | zst_pass_on(s) | sink_flush(s->next[0]);
+}
+
+static void zst_worker_free(zst_worker *w) {
+#ifdef ZST_LEVEL
+	ZSTD_freeCCtx(w->cctx);
+#endif
+}
+
+static int zst_worker_init(zst_worker *w) {
+#ifdef ZST_LEVEL
+	w->cctx = ZSTD_createCCtx();
+	if (!w->cctx) {
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+static void zst_free(zst_ctx *c) {
+	pool_close(&c->pool);
+	for (int i = 0; i < c->workers; i++) {
+		zst_worker_free(&c->worker[i]);
+	}
+	for (int i = 0; c->jobs && i < c->slots; i++) {
+		free(c->jobs[i].in);
+		free(c->jobs[i].out);
+	}
+	zst_worker_free(&c->self);
+	free(c->jobs);
+	free(c->obuf);
+	free(c->table);
+	free(c);
+}
+
+static int zst_close(sink *s) {
+	zst_ctx *c = (zst_ctx*)s->ctx;
+	int ret = 0;
+
+	if (c) {
+		if (c->fill) {
+			zst_job *job = (zst_job*)pool_next(&c->pool, &ret);
+			job->len = c->fill;
+			ret |= pool_submit(&c->pool);
+		}
+		ret |= pool_drain(&c->pool);
+		// a dump cut short has fewer frames than the table was made for
+		u8 *footer = c->table + 8 + c->frame * ZST_ENTRY_SIZE;
+		put_le32(c->table, ZST_SKIPPABLE_MAGIC);
+		put_le32(c->table + 4, c->frame * ZST_ENTRY_SIZE + ZST_FOOTER_SIZE);
+		put_le32(footer, c->frame);
+		footer[4] = 0;
+		put_le32(footer + 5, ZST_SEEKABLE_MAGIC);
+		ret |= zst_pass_on(s);
+		ret |= sink_write(s->next[0], c->table, footer + ZST_FOOTER_SIZE - c->table, c->out);
+		zst_free(c);
+		s->ctx = NULL;
+	}
+	return sink_close(s->next[0]) | ret;
+}
+
+static const sink_ops zst_ops = { zst_write, zst_flush, zst_close };
+
+int sink_zst(sink *s, sink *next, u64 data_size) {
+	zst_ctx *c = (zst_ctx*)calloc(1, sizeof(zst_ctx));
+	if (!c) {
+		return 1;
+	}
+	c->num_frames = (data_size + ZST_FRAME_SIZE - 1) / ZST_FRAME_SIZE;
+	c->table_size = 8 + c->num_frames * ZST_ENTRY_SIZE + ZST_FOOTER_SIZE;
+	c->table = (u8*)malloc(c->table_size);
+	c->obuf = (u8*)malloc(ZST_OUT_SIZE);
+	int workers = pool_cores();
+	c->slots = pool_slots(workers);
+	c->jobs = (zst_job*)calloc(c->slots, sizeof(zst_job));
+	int failed = !c->table || !c->obuf || !c->jobs || zst_worker_init(&c->self);
+	for (int i = 0; !failed && i < c->slots; i++) {
+		c->jobs[i].in = (u8*)malloc(ZST_FRAME_SIZE);
+#ifdef ZST_LEVEL
+		c->jobs[i].out = (u8*)malloc(ZSTD_compressBound(ZST_FRAME_SIZE));
+#else
+		c->jobs[i].out = (u8*)malloc(ZST_RAW_HEADER + ZST_FRAME_SIZE);
+#endif
+		failed = !c->jobs[i].in || !c->jobs[i].out;
+	}
+	if (failed) {
+		zst_free(c);
+		return 1;
+	}
+	pool_init(&c->pool, s, c->jobs, sizeof(zst_job), c->slots, zst_compress, zst_emit, &c->self);
+	// fewer workers is fine, with none the writer thread compresses
+	for (; c->workers < workers; c->workers++) {
+		zst_worker *w = &c->worker[c->workers];
+		if (zst_worker_init(w)) {
+			zst_worker_free(w);
+			break;
+		}
+		pool_start(&c->pool, w);
+	}
+	sink_stage(s, &zst_ops, c, next);
+	return 0;
+}
+
+#if defined(__CYGWIN__) || defined(__linux__)
+typedef struct {
+	FILE *fp;
+	u64 *where;			// each frame in the file, and where the last one ends
+} zst_reader;
+
+static int zst_read_frame(archive *a, u32 frame, u8 *dst, u8 *scratch) {
+	zst_reader *r = (zst_reader*)a->ctx;
+	u64 in = r->where[frame + 1] - r->where[frame];
+	u64 start = (u64)frame * a->block_size;
+	u32 out = (a->size - start < a->block_size) ? (u32)(a->size - start) : a->block_size;
+
+	if (in > a->scratch_size || archive_pread(r->fp, scratch, in, r->where[frame])
+		|| ZSTD_decompress(dst, a->block_size, scratch, in) != out) {
+		return 1;
+	}
+	return 0;
+}
+
+static void zst_reader_close(archive *a) {
+	zst_reader *r = (zst_reader*)a->ctx;
+
+	fclose(r->fp);
+	free(r->where);
+	free(r);
+}
+
+// The seek table is read from the end of the file. Every frame but the
+// last has to be the same size, as CleanRip and zstd's own tools make them.
+int zst_archive(archive *a, const char *path) {
+	u8 footer[ZST_FOOTER_SIZE];
+	zst_reader *r = (zst_reader*)calloc(1, sizeof(zst_reader));
+
+	memset(a, 0, sizeof(archive));
+	if (!r || !(r->fp = fopen(path, "rb"))) {
+		free(r);
+		return -1;
+	}
+	a->ctx = r;
+	a->close = zst_reader_close;
+	a->block = zst_read_frame;
+	fseeko(r->fp, 0, SEEK_END);
+	u64 file_size = (u64)ftello(r->fp);
+	if (file_size < 8 + ZST_FOOTER_SIZE || archive_pread(r->fp, footer, ZST_FOOTER_SIZE, file_size - ZST_FOOTER_SIZE)
+		|| get_le32(footer + 5) != ZST_SEEKABLE_MAGIC) {
+		zst_reader_close(a);
+		return -1;
+	}
+	a->blocks = get_le32(footer);
+	u32 entry_size = (footer[4] & ZST_CHECKSUMS) ? 12 : 8;
+	u64 table_size = (u64)a->blocks * entry_size;
+	if (!a->blocks || table_size + 8 + ZST_FOOTER_SIZE > file_size) {
+		zst_reader_close(a);
+		return -1;
+	}
+	u64 table_start = file_size - ZST_FOOTER_SIZE - table_size - 8;
+	u8 *table = (u8*)malloc(table_size + 8);
+	r->where = (u64*)calloc(a->blocks + 1, sizeof(u64));
+	if (!table || !r->where || archive_pread(r->fp, table, table_size + 8, table_start)
+		|| get_le32(table) != ZST_SKIPPABLE_MAGIC || get_le32(table + 4) != table_size + ZST_FOOTER_SIZE) {
+		free(table);
+		zst_reader_close(a);
+		return -1;
+	}
+	a->block_size = get_le32(table + 8 + 4);
+	for (u32 i = 0; i < a->blocks; i++) {
+		u32 in = get_le32(table + 8 + i * entry_size);
+		u32 out = get_le32(table + 8 + i * entry_size + 4);
+		r->where[i + 1] = r->where[i] + in;
+		a->size += out;
+		a->scratch_size = in > a->scratch_size ? in : a->scratch_size;
+		if (out != a->block_size && (i + 1 < a->blocks || out > a->block_size)) {
+			a->block_size = 0;
+		}
+	}
+	free(table);
+	a->size_known = 1;
+	// the frames have to end where the seek table starts
+	if (!a->block_size || r->where[a->blocks] != table_start) {
+		zst_reader_close(a);
+		return -1;
+	}
+	return 0;
+}
+#endif